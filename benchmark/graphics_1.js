@@ -0,0 +1,10 @@
+// 2000 small Graphics draw calls on an offscreen buffer, as a UI redraw would make
+
+var g = Graphics.createArrayBuffer(128,64,1);
+for (var i = 0; i < 400; i++) {
+  g.setColor(i&1);
+  g.fillRect(i&63, i&31, (i&63)+8, (i&31)+8);
+  g.drawLine(0, i&63, 127, 63-(i&63));
+  g.setPixel(i&127, i&63);
+  g.drawString("A", i&127, i&63);
+}
@@ -0,0 +1,11 @@
+// Drawing images and text into an offscreen buffer, as a watch face redraw would
+
+var g = Graphics.createArrayBuffer(120,80,8);
+var img = E.toString("\x20\x20\x08" + "\x12\x34\x56\x78".repeat(256)); // 32x32, 8 bit
+var icon = E.toString("\x18\x18\x01" + "\xAA\x55\xF0".repeat(24)); // 24x24, 1 bit
+for (var i = 0; i < 100; i++) {
+  g.drawImage(img, i&63, i&31);
+  g.drawImage(icon, 90-(i&63), i&31);
+  g.setFont("6x8",1);
+  g.drawString("12:34 Hello", i&63, 70);
+}
@@ -0,0 +1,17 @@
+// Filling polygons and drawing vector font text, as a watch face redraw would
+
+var g = Graphics.createArrayBuffer(240,160,8);
+var star = [];
+for (var i=0;i<64;i++) {
+  var a = i*Math.PI/32, r = (i&1) ? 70 : 30;
+  star.push(120+r*Math.sin(a), 80+r*Math.cos(a));
+}
+for (var i = 0; i < 20; i++) {
+  g.clear();
+  g.fillPoly(star);
+  g.fillPolyAA([10,10,60,20,30,70]);
+  g.setFontVector(24);
+  g.drawString("12:34", 10, 100);
+  g.setFontVector(12);
+  g.drawString("Wednesday " + i, 10, 130);
+}
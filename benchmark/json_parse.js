@@ -0,0 +1,12 @@
+// Parse a ~20kB JSON payload (objects, arrays, strings and numbers) a few times
+var items = [];
+for (var i=0;i<220;i++)
+  items.push({id:i, name:"Item number "+i, price:i*1.25, tags:["a","bb","ccc"], ok:(i&1)==0, n:null});
+var json = JSON.stringify({items:items, total:items.length, note:"Escaped \"quotes\"\n and \\ slashes"});
+
+var t = getTime();
+for (var j=0;j<10;j++) {
+  var o = JSON.parse(json);
+  if (o.items.length!=220 || o.items[219].price!=273.75) throw new Error("Bad parse");
+}
+print(json.length+" bytes, "+(Math.round((getTime()-t)*1000)/10)+" ms per parse");
@@ -0,0 +1,26 @@
+// Function-heavy code - pretokenised functions store literals and block lengths
+// pre-parsed, so compare times with and without this line
+E.setFlags({pretokenise:1});
+
+function classify(n) {
+  if (n % 3 == 0) {
+    return "fizz";
+  } else {
+    var s = "";
+    for (var i=0;i<3;i++) {
+      if (i == n) { s += "a"; s += "b"; s += "c"; s += "d"; }
+      else { s += "-"; }
+    }
+    return s;
+  }
+}
+
+function run() {
+  var count = 0;
+  for (var n=0;n<2000;n++) {
+    if (classify(n) == "fizz") count++;
+  }
+  return count;
+}
+
+print(run());
@@ -0,0 +1,12 @@
+// RegExp matching speed - the same expressions used over and over on a medium-length string
+var text = "";
+for (var i=0;i<20;i++) text += "The quick brown fox "+i+" jumps over the lazy dog, ";
+var t = getTime();
+var n = 0;
+for (var i=0;i<50;i++) {
+  if (/lazy cat/.test(text)) n++;
+  n += text.match(/\d+/g).length;
+  n += text.split(/,\s*/).length;
+  n += text.replace(/(\w+) (dog)/g, "$2 $1").length;
+}
+print(n, "in", getTime()-t, "s");
@@ -0,0 +1,5 @@
+// Built-in Array.sort on random numbers with the common numeric compare function
+
+var a = [];
+for (var i = 0; i < 500; i++) a.push((i * 7919) % 1000);
+a.sort(function (x, y) { return x - y; });
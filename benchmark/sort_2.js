@@ -0,0 +1,5 @@
+// Built-in Array.sort on an already sorted array (eg. timestamped data)
+
+var a = [];
+for (var i = 0; i < 500; i++) a.push(i);
+a.sort(function (x, y) { return x - y; });
@@ -0,0 +1,5 @@
+// Built-in Array.sort on a reverse-sorted array, with a compare function that can't be optimised
+
+var a = [];
+for (var i = 0; i < 500; i++) a.push({ t: 500 - i });
+a.sort(function (x, y) { return x.t - y.t; });
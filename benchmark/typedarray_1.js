@@ -0,0 +1,8 @@
+// Sorting, searching and filling a 4096-sample Int16Array (eg. audio/sensor data)
+
+var a = new Int16Array(4096);
+for (var i = 0; i < 4096; i++) a[i] = (i * 7919) % 4096 - 2048;
+a.sort();
+var found = 0;
+for (var i = 0; i < 20; i++) if (a.indexOf(2000 - i) >= 0) found++;
+a.fill(0, 1024, 3072);
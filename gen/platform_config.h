@@ -0,0 +1,98 @@
+
+// Automatically generated header file for LINUX
+// Generated by scripts/build_platform_config.py
+
+#ifndef _PLATFORM_CONFIG_H
+#define _PLATFORM_CONFIG_H
+
+
+#define PC_BOARD_ID "LINUX"
+#define PC_BOARD_CHIP "LINUX"
+#define PC_BOARD_CHIP_FAMILY "LINUX"
+
+#define LINKER_END_VAR _end
+#define LINKER_ETEXT_VAR _etext
+
+
+// SYSTICK is the counter that counts up and that we use as the real-time clock
+// The smaller this is, the longer we spend in interrupts, but also the more we can sleep!
+#define SYSTICK_RANGE 0x1000000 // the Maximum (it is a 24 bit counter) - on Olimexino this is about 0.6 sec
+#define SYSTICKS_BEFORE_USB_DISCONNECT 2
+
+// When to send the message that the IO buffer is getting full
+#define IOBUFFER_XOFF ((TXBUFFERMASK)*6/8)
+// When to send the message that we can start receiving again
+#define IOBUFFER_XON ((TXBUFFERMASK)*3/8)
+#define DEFAULT_BUSY_PIN_INDICATOR (Pin)-1 // no indicator
+#define DEFAULT_SLEEP_PIN_INDICATOR (Pin)-1 // no indicator
+
+
+#define RAM_TOTAL (0*1024)
+#define FLASH_TOTAL (256*1024)
+
+#define RESIZABLE_JSVARS // Allocate variables in blocks using malloc - slow, and linux-only
+#define FLASH_START                     0x10000000
+#define FLASH_PAGE_SIZE                 1024
+#define FLASH_SAVED_CODE_START            (FLASH_START + FLASH_TOTAL - FLASH_SAVED_CODE_LENGTH)
+#define FLASH_SAVED_CODE_LENGTH           262144
+
+#define CLOCK_SPEED_MHZ                      -1
+#define USART_COUNT                          6
+#define SPI_COUNT                            3
+#define I2C_COUNT                            3
+#define ADC_COUNT                            0
+#define DAC_COUNT                            0
+#define EXTI_COUNT                           16
+
+#define DEFAULT_CONSOLE_DEVICE              EV_USBSERIAL
+
+#define IOBUFFERMASK 255 // (max 255) amount of items in event buffer - events take 5 bytes each
+#define TXBUFFERMASK 255 // (max 255) amount of items in the transmit buffer - 2 bytes each
+#define IOBULKBUFFERMASK 4095 // (max 65535) amount of characters in the bulk receive buffer
+#define UTILTIMERTASK_TASKS (16) // Must be power of 2 - and max 256
+#define JSP_INLINE_CACHE_SIZE 64 // Must be power of 2 - amount of property lookups cached by the interpreter
+#define JSP_LOCAL_CACHE_SIZE 64 // Must be power of 2 - amount of local variable slots cached by the interpreter
+#define JSF_INDEX_SIZE 512 // amount of entries in the index of files in Storage (it's only filled to 3/4)
+#define JSI_EVENT_RING_SIZE 16 // amount of events that can be queued without allocating JsVars
+
+#define D0_PININDEX 0/* D0 */
+#define D1_PININDEX 1/* D1 */
+#define D2_PININDEX 2/* D2 */
+#define D3_PININDEX 3/* D3 */
+#define D4_PININDEX 4/* D4 */
+#define D5_PININDEX 5/* D5 */
+#define D6_PININDEX 6/* D6 */
+#define D7_PININDEX 7/* D7 */
+#define D8_PININDEX 8/* D8 */
+#define D9_PININDEX 9/* D9 */
+#define D10_PININDEX 10/* D10 */
+#define D11_PININDEX 11/* D11 */
+#define D12_PININDEX 12/* D12 */
+#define D13_PININDEX 13/* D13 */
+#define D14_PININDEX 14/* D14 */
+#define D15_PININDEX 15/* D15 */
+#define D16_PININDEX 16/* D16 */
+#define D17_PININDEX 17/* D17 */
+#define D18_PININDEX 18/* D18 */
+#define D19_PININDEX 19/* D19 */
+#define D20_PININDEX 20/* D20 */
+#define D21_PININDEX 21/* D21 */
+#define D22_PININDEX 22/* D22 */
+#define D23_PININDEX 23/* D23 */
+#define D24_PININDEX 24/* D24 */
+#define D25_PININDEX 25/* D25 */
+#define D26_PININDEX 26/* D26 */
+#define D27_PININDEX 27/* D27 */
+#define D28_PININDEX 28/* D28 */
+#define D29_PININDEX 29/* D29 */
+#define D30_PININDEX 30/* D30 */
+#define D31_PININDEX 31/* D31 */
+#define D32_PININDEX 32/* D32 */
+
+// definition to avoid compilation when Pin/platform config is not defined
+#define IS_PIN_USED_INTERNALLY(PIN) ((false))
+#define IS_PIN_A_LED(PIN) ((false))
+#define IS_PIN_A_BUTTON(PIN) ((false))
+
+#endif // _PLATFORM_CONFIG_H
+
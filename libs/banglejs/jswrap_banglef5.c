@@ -252,12 +252,8 @@ JsBangleTasks bangleTasks;
 void lcd_flip(JsVar *parent, bool all) {
   JsGraphics gfx; 
   if (!graphicsGetFromVar(&gfx, parent)) return;
-  if (all) {
-    gfx.data.modMinX = 0;
-    gfx.data.modMinY = 0;
-    gfx.data.modMaxX = LCD_WIDTH-1;
-    gfx.data.modMaxY = LCD_HEIGHT-1;
-  }
+  if (all)
+    graphicsSetModified(&gfx, 0, 0, LCD_WIDTH-1, LCD_HEIGHT-1);
   if (lcdPowerTimeout && !lcdPowerOn) {
     // LCD was turned off, turn it back on
     jswrap_banglejs_setLCDPower(1);
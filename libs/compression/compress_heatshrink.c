@@ -47,110 +47,105 @@ int heatshrink_var_input_cb(uint32_t *cbdata) {
   return d;
 }
 
-/** gets data from callback, writes to callback if nonzero. Returns total length. */
-uint32_t heatshrink_encode_cb(int (*in_callback)(uint32_t *cbdata), uint32_t *in_cbdata, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata) {
-  heatshrink_encoder hse;
-  uint8_t inBuf[BUFFERSIZE];
+/** Feed data into an encoder, sending any output to out_callback if nonzero.
+ * If 'finish' is set, all remaining output is flushed. Returns the amount of data output */
+uint32_t heatshrink_encoder_stream(heatshrink_encoder *hse, const unsigned char *data, size_t len, bool finish, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata) {
   uint8_t outBuf[BUFFERSIZE];
-  heatshrink_encoder_reset(&hse);
-
-  size_t i;
-  size_t count = 0;
-  size_t sunk = 0;
-  size_t polled = 0;
-  int lastByte = 0;
-  size_t inBufCount = 0;
-  size_t inBufOffset = 0;
-  while (lastByte >= 0 || inBufCount>0) {
-    // Read data from input
-    if (inBufCount==0) {
-      inBufOffset = 0;
-      while (inBufCount<BUFFERSIZE && lastByte>=0) {
-        lastByte = in_callback(in_cbdata);
-        if (lastByte >= 0)
-          inBuf[inBufCount++] = (uint8_t)lastByte;
-      }
-    }
-    // encode
-    bool ok = heatshrink_encoder_sink(&hse, &inBuf[inBufOffset], inBufCount, &count) >= 0;
-    assert(ok);NOT_USED(ok);
-    inBufCount -= count;
-    inBufOffset += count;
-    sunk += count;
-    if ((inBufCount==0) && (lastByte < 0)) {
-      heatshrink_encoder_finish(&hse);
+  size_t i, count;
+  uint32_t polled = 0;
+  while (true) {
+    if (len) {
+      bool ok = heatshrink_encoder_sink(hse, (uint8_t*)data, len, &count) >= 0;
+      assert(ok);NOT_USED(ok);
+      data += count;
+      len -= count;
     }
-
+    if (!len && finish)
+      heatshrink_encoder_finish(hse);
     HSE_poll_res pres;
     do {
-      pres = heatshrink_encoder_poll(&hse, outBuf, sizeof(outBuf), &count);
+      pres = heatshrink_encoder_poll(hse, outBuf, sizeof(outBuf), &count);
       assert(pres >= 0);
       if (out_callback)
         for (i=0;i<count;i++)
           out_callback(outBuf[i], out_cbdata);
-      polled += count;
+      polled += (uint32_t)count;
     } while (pres == HSER_POLL_MORE);
     assert(pres == HSER_POLL_EMPTY);
-    if ((inBufCount==0) && (lastByte < 0)) {
-      heatshrink_encoder_finish(&hse);
+    if (!len && (!finish || heatshrink_encoder_finish(hse)==HSER_FINISH_DONE))
+      break;
+  }
+  return polled;
+}
+
+/** Feed data into a decoder, sending any output to out_callback if nonzero. Returns the amount of data output */
+uint32_t heatshrink_decoder_stream(heatshrink_decoder *hsd, const unsigned char *data, size_t len, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata) {
+  uint8_t outBuf[BUFFERSIZE];
+  size_t i, count;
+  uint32_t polled = 0;
+  do {
+    bool ok = heatshrink_decoder_sink(hsd, (uint8_t*)data, len, &count) >= 0;
+    assert(ok);NOT_USED(ok);
+    data += count;
+    len -= count;
+    // the decoder outputs everything it can as soon as it has the data
+    HSD_poll_res pres;
+    do {
+      pres = heatshrink_decoder_poll(hsd, outBuf, sizeof(outBuf), &count);
+      assert(pres >= 0);
+      if (out_callback)
+        for (i=0;i<count;i++)
+          out_callback(outBuf[i], out_cbdata);
+      polled += (uint32_t)count;
+    } while (pres == HSDR_POLL_MORE);
+  } while (len);
+  return polled;
+}
+
+/** gets data from callback, writes to callback if nonzero. Returns total length. */
+uint32_t heatshrink_encode_cb(int (*in_callback)(uint32_t *cbdata), uint32_t *in_cbdata, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata) {
+  heatshrink_encoder hse;
+  uint8_t inBuf[BUFFERSIZE];
+  heatshrink_encoder_reset(&hse);
+
+  uint32_t polled = 0;
+  int lastByte = 0;
+  while (lastByte >= 0) {
+    // Read data from input
+    size_t inBufCount = 0;
+    while (inBufCount<BUFFERSIZE && lastByte>=0) {
+      lastByte = in_callback(in_cbdata);
+      if (lastByte >= 0)
+        inBuf[inBufCount++] = (uint8_t)lastByte;
     }
+    // encode
+    polled += heatshrink_encoder_stream(&hse, inBuf, inBufCount, lastByte<0, out_callback, out_cbdata);
   }
-  return (uint32_t)polled;
+  return polled;
 }
 
 /** gets data from callback, writes it into callback if nonzero. Returns total length */
 uint32_t heatshrink_decode_cb(int (*in_callback)(uint32_t *cbdata), uint32_t *in_cbdata, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata) {
   heatshrink_decoder hsd;
   uint8_t inBuf[BUFFERSIZE];
-  uint8_t outBuf[BUFFERSIZE];
   heatshrink_decoder_reset(&hsd);
 
-  size_t i;
-  size_t count = 0;
-  size_t sunk = 0;
-  size_t polled = 0;
+  uint32_t polled = 0;
   int lastByte = 0;
-  size_t inBufCount = 0;
-  size_t inBufOffset = 0;
-  while (lastByte >= 0 || inBufCount>0) {
+  while (lastByte >= 0) {
     // Read data from input
-    if (inBufCount==0) {
-      inBufOffset = 0;
-      while (inBufCount<BUFFERSIZE && lastByte>=0) {
-        lastByte = in_callback(in_cbdata);
-        if (lastByte >= 0)
-          inBuf[inBufCount++] = (uint8_t)lastByte;
-      }
+    size_t inBufCount = 0;
+    while (inBufCount<BUFFERSIZE && lastByte>=0) {
+      lastByte = in_callback(in_cbdata);
+      if (lastByte >= 0)
+        inBuf[inBufCount++] = (uint8_t)lastByte;
     }
     // decode
-    bool ok = heatshrink_decoder_sink(&hsd, &inBuf[inBufOffset], inBufCount, &count) >= 0;
-    assert(ok);NOT_USED(ok);
-    inBufCount -= count;
-    inBufOffset += count;
-    sunk += count;
-    if ((inBufCount==0) && (lastByte < 0)) {
-      heatshrink_decoder_finish(&hsd);
-    }
-
-    HSE_poll_res pres;
-    do {
-      pres = heatshrink_decoder_poll(&hsd, outBuf, sizeof(outBuf), &count);
-      assert(pres >= 0);
-      if (out_callback)
-        for (i=0;i<count;i++)
-          out_callback(outBuf[i], out_cbdata);
-      polled += count;
-    } while (pres == HSER_POLL_MORE);
-    assert(pres == HSER_POLL_EMPTY);
-    if (lastByte < 0) {
-      heatshrink_decoder_finish(&hsd);
-    }
+    polled += heatshrink_decoder_stream(&hsd, inBuf, inBufCount, out_callback, out_cbdata);
   }
-  return (uint32_t)polled;
+  return polled;
 }
 
-
-
 /** gets data from array, writes to callback if nonzero. Returns total length. */
 uint32_t heatshrink_encode(unsigned char *in_data, size_t in_len, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata) {
   HeatShrinkPtrInputCallbackInfo cbi;
@@ -12,6 +12,9 @@
  * ----------------------------------------------------------------------------
  */
 
+#include "heatshrink_encoder.h"
+#include "heatshrink_decoder.h"
+
 typedef struct {
   unsigned char *ptr;
   size_t len;
@@ -22,6 +25,13 @@ int heatshrink_ptr_input_cb(uint32_t *cbdata); // takes *HeatShrinkPtrInputCallb
 void heatshrink_var_output_cb(unsigned char ch, uint32_t *cbdata); // takes *JsvStringIterator
 int heatshrink_var_input_cb(uint32_t *cbdata); // takes *JsvIterator
 
+/** Feed data into an encoder, sending any output to out_callback if nonzero.
+ * If 'finish' is set, all remaining output is flushed. Returns the amount of data output */
+uint32_t heatshrink_encoder_stream(heatshrink_encoder *hse, const unsigned char *data, size_t len, bool finish, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata);
+
+/** Feed data into a decoder, sending any output to out_callback if nonzero. Returns the amount of data output */
+uint32_t heatshrink_decoder_stream(heatshrink_decoder *hsd, const unsigned char *data, size_t len, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata);
+
 /** gets data from callback, writes to callback if nonzero. Returns total length. */
 uint32_t heatshrink_encode_cb(int (*in_callback)(uint32_t *cbdata), uint32_t *in_cbdata, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata);
 
@@ -17,7 +17,9 @@
 #include "jsvariterator.h"
 #include "compress_heatshrink.h"
 #include "jswrap_heatshrink.h"
+#include "jswrap_stream.h"
 #include "jsparse.h"
+#include "jsinteractive.h"
 
 
 /*JSON{
@@ -29,52 +31,123 @@ Simple library for compression/decompression using [heatshrink](https://github.c
 
 Espruino uses heatshrink internally to compress RAM down to fit in Flash memory when `save()` is used. This just exposes that functionality.
 
-Functions here take and return buffers of data. There is no support for streaming, so both the compressed and decompressed data must be able to fit in memory at the same time.
+`compress` and `decompress` take and return buffers of data, so both the compressed
+and decompressed data must be able to fit in memory at the same time. To handle more
+data than that, use `createCompressor`/`createDecompressor`, which work on a chunk
+at a time:
+
+```
+var c = require("heatshrink").createCompressor();
+c.on('data', function(d) { ... }); // compressed data
+c.write("Hello ");
+c.write("World");
+c.end();
+```
 */
 
 
-/*JSON{
-  "type" : "staticmethod",
-  "class" : "heatshrink",
-  "name" : "compress",
-  "generate" : "jswrap_heatshrink_compress",
-  "params" : [
-    ["data","JsVar","The data to compress"]
-  ],
-  "return" : ["JsVar","Returns the result as an ArrayBuffer"],
-  "return_object" : "ArrayBuffer",
-  "ifndef" : "SAVE_ON_FLASH"
+/// A flat string that grows as heatshrink writes into it, so we only have to run the codec once
+typedef struct {
+  JsVar *str;
+  unsigned char *ptr;
+  size_t len, size;
+  bool failed; ///< We couldn't allocate a bigger flat string
+} HeatshrinkFlatOutput;
+
+static void heatshrink_flat_output_cb(unsigned char ch, uint32_t *cbdata) {
+  HeatshrinkFlatOutput *out = (HeatshrinkFlatOutput*)cbdata;
+  if (out->len >= out->size) {
+    if (out->failed) return;
+    size_t size = out->size*2;
+    JsVar *str = jsvNewFlatStringOfLength((unsigned int)size);
+    if (!str) {
+      out->failed = true;
+      return;
+    }
+    unsigned char *ptr = (unsigned char*)jsvGetFlatStringPointer(str);
+    memcpy(ptr, out->ptr, out->len);
+    jsvUnLock(out->str);
+    out->str = str;
+    out->ptr = ptr;
+    out->size = size;
+  }
+  out->ptr[out->len++] = ch;
 }
-*/
-JsVar *jswrap_heatshrink_compress(JsVar *data) {
+
+typedef uint32_t (*HeatshrinkCodecFn)(int (*in_callback)(uint32_t *cbdata), uint32_t *in_cbdata, void (*out_callback)(unsigned char ch, uint32_t *cbdata), uint32_t *out_cbdata);
+
+/// Run data through the compressor or decompressor, returning an ArrayBuffer. sizeGuess is the expected output size
+static JsVar *jswrap_heatshrink_codec(JsVar *data, HeatshrinkCodecFn codec, size_t sizeGuess) {
   if (!jsvIsIterable(data)) {
     jsExceptionHere(JSET_TYPEERROR,"Expecting something iterable, got %t",data);
     return 0;
   }
   JsvIterator in_it;
-  JsvStringIterator out_it;
+  JsVar *outVar = 0;
 
-  jsvIteratorNew(&in_it, data, JSIF_EVERY_ARRAY_ELEMENT);
-  uint32_t compressedSize = heatshrink_encode_cb(heatshrink_var_input_cb, (uint32_t*)&in_it, NULL, NULL);
-  jsvIteratorFree(&in_it);
+  // Try and do it in one pass, into a flat string
+  HeatshrinkFlatOutput out;
+  out.len = 0;
+  out.size = sizeGuess;
+  out.failed = false;
+  out.str = jsvNewFlatStringOfLength((unsigned int)out.size);
+  if (out.str) {
+    out.ptr = (unsigned char*)jsvGetFlatStringPointer(out.str);
+    jsvIteratorNew(&in_it, data, JSIF_EVERY_ARRAY_ELEMENT);
+    codec(heatshrink_var_input_cb, (uint32_t*)&in_it, heatshrink_flat_output_cb, (uint32_t*)&out);
+    jsvIteratorFree(&in_it);
+    if (out.failed) {
+      jsvUnLock(out.str);
+    } else {
+      jsvTruncateFlatString(out.str, out.len);
+      outVar = out.str;
+    }
+  }
 
-  JsVar *outVar = jsvNewStringOfLength((unsigned int)compressedSize, NULL);
   if (!outVar) {
-    jsError("Not enough memory for result");
-    return 0;
-  }
+    // Not enough contiguous memory - work out the size first, then write into a normal string
+    JsvStringIterator out_it;
+    jsvIteratorNew(&in_it, data, JSIF_EVERY_ARRAY_ELEMENT);
+    uint32_t size = codec(heatshrink_var_input_cb, (uint32_t*)&in_it, NULL, NULL);
+    jsvIteratorFree(&in_it);
 
-  jsvIteratorNew(&in_it, data, JSIF_EVERY_ARRAY_ELEMENT);
-  jsvStringIteratorNew(&out_it,outVar,0);
-  heatshrink_encode_cb(heatshrink_var_input_cb, (uint32_t*)&in_it, heatshrink_var_output_cb, (uint32_t*)&out_it);
-  jsvStringIteratorFree(&out_it);
-  jsvIteratorFree(&in_it);
+    outVar = jsvNewStringOfLength((unsigned int)size, NULL);
+    if (!outVar) {
+      jsError("Not enough memory for result");
+      return 0;
+    }
+
+    jsvIteratorNew(&in_it, data, JSIF_EVERY_ARRAY_ELEMENT);
+    jsvStringIteratorNew(&out_it,outVar,0);
+    codec(heatshrink_var_input_cb, (uint32_t*)&in_it, heatshrink_var_output_cb, (uint32_t*)&out_it);
+    jsvStringIteratorFree(&out_it);
+    jsvIteratorFree(&in_it);
+  }
 
   JsVar *ab = jsvNewArrayBufferFromString(outVar, 0);
   jsvUnLock(outVar);
   return ab;
 }
 
+/*JSON{
+  "type" : "staticmethod",
+  "class" : "heatshrink",
+  "name" : "compress",
+  "generate" : "jswrap_heatshrink_compress",
+  "params" : [
+    ["data","JsVar","The data to compress"]
+  ],
+  "return" : ["JsVar","Returns the result as an ArrayBuffer"],
+  "return_object" : "ArrayBuffer",
+  "ifndef" : "SAVE_ON_FLASH"
+}
+*/
+JsVar *jswrap_heatshrink_compress(JsVar *data) {
+  // Heatshrink's worst case is 9 bits per byte, so we never need to grow the output
+  size_t len = (size_t)jsvGetLength(data);
+  return jswrap_heatshrink_codec(data, heatshrink_encode_cb, len + len/8 + 16);
+}
+
 
 /*JSON{
   "type" : "staticmethod",
@@ -90,30 +163,192 @@ JsVar *jswrap_heatshrink_compress(JsVar *data) {
 }
 */
 JsVar *jswrap_heatshrink_decompress(JsVar *data) {
-  if (!jsvIsIterable(data)) {
-    jsExceptionHere(JSET_TYPEERROR,"Expecting something iterable, got %t",data);
-    return 0;
-  }
-  JsvIterator in_it;
-  JsvStringIterator out_it;
+  size_t len = (size_t)jsvGetLength(data);
+  return jswrap_heatshrink_codec(data, heatshrink_decode_cb, len*2 + 16);
+}
 
-  jsvIteratorNew(&in_it, data, JSIF_EVERY_ARRAY_ELEMENT);
-  uint32_t decompressedSize = heatshrink_decode(heatshrink_var_input_cb, (uint32_t*)&in_it, NULL);
-  jsvIteratorFree(&in_it);
 
-  JsVar *outVar = jsvNewStringOfLength((unsigned int)decompressedSize, NULL);
-  if (!outVar) {
-    jsError("Not enough memory for result");
+/*JSON{
+  "type" : "class",
+  "library" : "heatshrink",
+  "class" : "HeatshrinkStream",
+  "ifndef" : "SAVE_ON_FLASH"
+}
+A stream that compresses or decompresses data a chunk at a time, created with
+`require("heatshrink").createCompressor()` or `createDecompressor()`.
+
+Write data with `write` and call `end` when done. The output is
+emitted as Strings with `data` events, and `end` is emitted once
+all output has been sent. This can be used as the destination of
+`E.pipe`.
+*/
+/*JSON{
+  "type" : "event",
+  "class" : "HeatshrinkStream",
+  "name" : "data",
+  "params" : [
+    ["data","JsVar","A string containing compressed (or decompressed) data"]
+  ],
+  "ifndef" : "SAVE_ON_FLASH"
+}
+Called with output data as it becomes available
+*/
+/*JSON{
+  "type" : "event",
+  "class" : "HeatshrinkStream",
+  "name" : "end",
+  "ifndef" : "SAVE_ON_FLASH"
+}
+Called after `end()` once all the output has been sent
+*/
+
+#define HEATSHRINK_STREAM_STATE JS_HIDDEN_CHAR_STR"hs"
+
+/// State for a HeatshrinkStream - stored in a flat string
+typedef struct {
+  bool compress;
+  union {
+    heatshrink_encoder hse;
+    heatshrink_decoder hsd;
+  };
+} HeatshrinkStreamState;
+
+static JsVar *jswrap_heatshrink_createStream(bool compress) {
+  JsVar *stream = jspNewObject(0, "HeatshrinkStream");
+  if (!stream) return 0;
+  JsVar *stateVar = jsvNewFlatStringOfLength(sizeof(HeatshrinkStreamState));
+  if (!stateVar) {
+    jsError("Not enough memory for stream");
+    jsvUnLock(stream);
     return 0;
   }
+  HeatshrinkStreamState *state = (HeatshrinkStreamState*)jsvGetFlatStringPointer(stateVar);
+  state->compress = compress;
+  if (compress) heatshrink_encoder_reset(&state->hse);
+  else heatshrink_decoder_reset(&state->hsd);
+  jsvObjectSetChildAndUnLock(stream, HEATSHRINK_STREAM_STATE, stateVar);
+  return stream;
+}
+
+/*JSON{
+  "type" : "staticmethod",
+  "class" : "heatshrink",
+  "name" : "createCompressor",
+  "generate" : "jswrap_heatshrink_createCompressor",
+  "return" : ["JsVar","A HeatshrinkStream that compresses the data written to it"],
+  "return_object" : "HeatshrinkStream",
+  "ifndef" : "SAVE_ON_FLASH"
+}
+*/
+JsVar *jswrap_heatshrink_createCompressor() {
+  return jswrap_heatshrink_createStream(true);
+}
+
+/*JSON{
+  "type" : "staticmethod",
+  "class" : "heatshrink",
+  "name" : "createDecompressor",
+  "generate" : "jswrap_heatshrink_createDecompressor",
+  "return" : ["JsVar","A HeatshrinkStream that decompresses the data written to it"],
+  "return_object" : "HeatshrinkStream",
+  "ifndef" : "SAVE_ON_FLASH"
+}
+*/
+JsVar *jswrap_heatshrink_createDecompressor() {
+  return jswrap_heatshrink_createStream(false);
+}
 
-  jsvIteratorNew(&in_it, data, JSIF_EVERY_ARRAY_ELEMENT);
-  jsvStringIteratorNew(&out_it,outVar,0);
-  heatshrink_decode_cb(heatshrink_var_input_cb, (uint32_t*)&in_it, heatshrink_var_output_cb, (uint32_t*)&out_it);
+static void heatshrink_stream_output_cb(unsigned char ch, uint32_t *cbdata) {
+  jsvStringIteratorAppend((JsvStringIterator *)cbdata, (char)ch);
+}
+
+/// Feed data (which may be undefined) into the stream, emitting any output
+static void jswrap_heatshrinkstream_process(JsVar *parent, JsVar *data, bool finish) {
+  JsVar *stateVar = jsvObjectGetChild(parent, HEATSHRINK_STREAM_STATE, 0);
+  if (!jsvIsFlatString(stateVar)) {
+    jsExceptionHere(JSET_ERROR, "Stream has ended");
+    jsvUnLock(stateVar);
+    return;
+  }
+  if (!jsvIsUndefined(data) && !jsvIsIterable(data)) {
+    jsExceptionHere(JSET_TYPEERROR,"Expecting something iterable, got %t",data);
+    jsvUnLock(stateVar);
+    return;
+  }
+  // flat strings don't move, so this is safe while we have it locked
+  HeatshrinkStreamState *state = (HeatshrinkStreamState*)jsvGetFlatStringPointer(stateVar);
+  JsVar *output = jsvNewFromEmptyString();
+  if (!output) {
+    jsvUnLock(stateVar);
+    return;
+  }
+  JsvStringIterator out_it;
+  jsvStringIteratorNew(&out_it, output, 0);
+  // Feed data in, a chunk at a time
+  unsigned char buf[64];
+  size_t len = 0;
+  JsvIterator it;
+  if (!jsvIsUndefined(data)) {
+    jsvIteratorNew(&it, data, JSIF_EVERY_ARRAY_ELEMENT);
+    while (jsvIteratorHasElement(&it)) {
+      buf[len++] = (unsigned char)jsvIteratorGetIntegerValue(&it);
+      jsvIteratorNext(&it);
+      if (len==sizeof(buf)) {
+        if (state->compress)
+          heatshrink_encoder_stream(&state->hse, buf, len, false, heatshrink_stream_output_cb, (uint32_t*)&out_it);
+        else
+          heatshrink_decoder_stream(&state->hsd, buf, len, heatshrink_stream_output_cb, (uint32_t*)&out_it);
+        len = 0;
+      }
+    }
+    jsvIteratorFree(&it);
+  }
+  if (len || finish) {
+    if (state->compress)
+      heatshrink_encoder_stream(&state->hse, buf, len, finish, heatshrink_stream_output_cb, (uint32_t*)&out_it);
+    else
+      heatshrink_decoder_stream(&state->hsd, buf, len, heatshrink_stream_output_cb, (uint32_t*)&out_it);
+  }
   jsvStringIteratorFree(&out_it);
-  jsvIteratorFree(&in_it);
+  jsvUnLock(stateVar);
+  if (finish) // free the codec's state
+    jsvObjectRemoveChild(parent, HEATSHRINK_STREAM_STATE);
+  if (jsvGetStringLength(output))
+    jswrap_stream_pushData(parent, output, true);
+  jsvUnLock(output);
+  if (finish)
+    jsiQueueObjectCallbacks(parent, JS_EVENT_PREFIX"end", 0, 0);
+}
 
-  JsVar *ab = jsvNewArrayBufferFromString(outVar, 0);
-  jsvUnLock(outVar);
-  return ab;
+/*JSON{
+  "type" : "method",
+  "class" : "HeatshrinkStream",
+  "name" : "write",
+  "generate" : "jswrap_heatshrinkstream_write",
+  "params" : [
+    ["data","JsVar","The data to compress or decompress"]
+  ],
+  "ifndef" : "SAVE_ON_FLASH"
+}
+Add data to the stream. Any output is emitted with the `data` event.
+*/
+void jswrap_heatshrinkstream_write(JsVar *parent, JsVar *data) {
+  jswrap_heatshrinkstream_process(parent, data, false);
+}
+
+/*JSON{
+  "type" : "method",
+  "class" : "HeatshrinkStream",
+  "name" : "end",
+  "generate" : "jswrap_heatshrinkstream_end",
+  "params" : [
+    ["data","JsVar","[optional] Any final data to add to the stream"]
+  ],
+  "ifndef" : "SAVE_ON_FLASH"
+}
+Finish the stream, emitting any remaining output followed by the `end` event.
+The stream can't be written to afterwards.
+*/
+void jswrap_heatshrinkstream_end(JsVar *parent, JsVar *data) {
+  jswrap_heatshrinkstream_process(parent, data, true);
 }
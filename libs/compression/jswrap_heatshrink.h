@@ -15,3 +15,7 @@
 
 JsVar *jswrap_heatshrink_compress(JsVar *data);
 JsVar *jswrap_heatshrink_decompress(JsVar *data);
+JsVar *jswrap_heatshrink_createCompressor();
+JsVar *jswrap_heatshrink_createDecompressor();
+void jswrap_heatshrinkstream_write(JsVar *parent, JsVar *data);
+void jswrap_heatshrinkstream_end(JsVar *parent, JsVar *data);
@@ -414,15 +414,9 @@ void graphicsDrawChar6x8(JsGraphics *gfx, int x1, int y1, char ch, unsigned shor
   int cidx = idx % 6;
   idx = (idx/6)*8;
   int y;
-  int s = size-1;
   for (y=0;y<8;y++) {
     unsigned int line = LCD_FONT_6X8[idx + y] >> (cidx*5);
-    int ly = y*size + y1;
-    if (solidBackground || (line&16)) graphicsFillRect(gfx, x1+0*size, ly, x1+s+0*size, ly+s, (line&16) ? gfx->data.fgColor : gfx->data.bgColor);
-    if (solidBackground || (line&8)) graphicsFillRect(gfx, x1+1*size, ly, x1+s+1*size, ly+s, (line&8) ? gfx->data.fgColor : gfx->data.bgColor);
-    if (solidBackground || (line&4)) graphicsFillRect(gfx, x1+2*size, ly, x1+s+2*size, ly+s, (line&4) ? gfx->data.fgColor : gfx->data.bgColor);
-    if (solidBackground || (line&2)) graphicsFillRect(gfx, x1+3*size, ly, x1+s+3*size, ly+s, (line&2) ? gfx->data.fgColor : gfx->data.bgColor);
-    if (solidBackground || (line&1)) graphicsFillRect(gfx, x1+4*size, ly, x1+s+4*size, ly+s, (line&1) ? gfx->data.fgColor : gfx->data.bgColor);
+    graphicsDrawGlyphRow(gfx, x1, y*size + y1, line&31, 5, size, solidBackground);
   }
 }
 
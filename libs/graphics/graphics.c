@@ -22,6 +22,9 @@
 #include "jsutils.h"
 #include "jsvar.h"
 #include "jsparse.h"
+#ifdef GRAPHICS_PALETTED_IMAGES
+#include "jswrap_graphics.h" // for PALETTE_4BIT/PALETTE_8BIT
+#endif
 
 #include "lcd_arraybuffer.h"
 #include "lcd_js.h"
@@ -63,6 +66,48 @@ void graphicsFallbackFillRect(JsGraphics *gfx, int x1, int y1, int x2, int y2, u
       graphicsSetPixelDevice(gfx,x,y, col);
 }
 
+void graphicsFallbackSetPixels(JsGraphics *gfx, int x, int y, int count, unsigned int col) {
+  while (count--)
+    gfx->setPixel(gfx, x++, y, col);
+}
+
+unsigned int graphicsBlitGetPixel(const JsGraphicsBlitSource *src, unsigned int bit) {
+  const unsigned char *p = &src->data[bit>>3];
+  unsigned int b = bit&7;
+  if (src->bpp==8 && !b) return *p;
+  // read just enough bytes to cover this pixel
+  unsigned int n = (b+src->bpp+7)>>3;
+  uint64_t v = 0;
+  for (unsigned int i=0;i<n;i++)
+    v = (v<<8) | p[i];
+  return (unsigned int)((v >> (n*8-b-src->bpp)) & ((1ULL<<src->bpp)-1));
+}
+
+void graphicsFallbackBlit(JsGraphics *gfx, int x, int y, int count, const JsGraphicsBlitSource *src) {
+  unsigned int bit = src->bitOffset;
+  int runStart = 0, runLength = 0;
+  unsigned int runCol = 0;
+  for (int i=0;i<count;i++) {
+    unsigned int col = graphicsBlitGetPixel(src, bit);
+    bit += src->bpp;
+    if (col==src->transparentCol) {
+      if (runLength) gfx->setPixels(gfx, x+runStart, y, runLength, runCol);
+      runLength = 0;
+      continue;
+    }
+    if (src->palette) col = src->palette[col&src->paletteMask];
+    if (runLength && col==runCol) {
+      runLength++;
+    } else {
+      if (runLength) gfx->setPixels(gfx, x+runStart, y, runLength, runCol);
+      runStart = i;
+      runLength = 1;
+      runCol = col;
+    }
+  }
+  if (runLength) gfx->setPixels(gfx, x+runStart, y, runLength, runCol);
+}
+
 void graphicsFallbackScrollX(JsGraphics *gfx, int xdir, int yfrom, int yto) {
   int x;
   if (xdir<=0) {
@@ -89,10 +134,7 @@ void graphicsFallbackScroll(JsGraphics *gfx, int xdir, int ydir) {
       graphicsFallbackScrollX(gfx, xdir, y, y+ydir);
   }
 #ifndef SAVE_ON_FLASH
-  gfx->data.modMinX=0;
-  gfx->data.modMinY=0;
-  gfx->data.modMaxX=(short)(gfx->data.width-1);
-  gfx->data.modMaxY=(short)(gfx->data.height-1);
+  graphicsSetModified(gfx, 0, 0, gfx->data.width-1, gfx->data.height-1);
 #endif
 }
 
@@ -123,60 +165,52 @@ void graphicsStructInit(JsGraphics *gfx, int width, int height, int bpp) {
   gfx->data.bpp = (unsigned char)bpp;
   graphicsStructResetState(gfx);
 #ifndef SAVE_ON_FLASH
-  gfx->data.modMaxX = -32768;
-  gfx->data.modMaxY = -32768;
-  gfx->data.modMinX = 32767;
-  gfx->data.modMinY = 32767;
+  graphicsClearModified(gfx);
 #endif
-
 }
 
-bool graphicsGetFromVar(JsGraphics *gfx, JsVar *parent) {
-  gfx->graphicsVar = parent;
-  JsVar *data = jsvObjectGetChild(parent, JS_HIDDEN_CHAR_STR"gfx", 0);
-  assert(data);
-  if (data) {
-    jsvGetString(data, (char*)&gfx->data, sizeof(JsGraphicsData)+1/*trailing zero*/);
-    jsvUnLock(data);
-    gfx->setPixel = graphicsFallbackSetPixel;
-    gfx->getPixel = graphicsFallbackGetPixel;
-    gfx->fillRect = graphicsFallbackFillRect;
-    gfx->scroll = graphicsFallbackScroll;
+/// Set up the backend callbacks in 'gfx' based on gfx->data.type. True on success
+static bool graphicsSetCallbacks(JsGraphics *gfx) {
+  gfx->setPixel = graphicsFallbackSetPixel;
+  gfx->getPixel = graphicsFallbackGetPixel;
+  gfx->fillRect = graphicsFallbackFillRect;
+  gfx->scroll = graphicsFallbackScroll;
+  gfx->setPixels = graphicsFallbackSetPixels;
+  gfx->blit = graphicsFallbackBlit;
 #ifdef USE_LCD_SDL
-    if (gfx->data.type == JSGRAPHICSTYPE_SDL) {
-      lcdSetCallbacks_SDL(gfx);
-    } else
+  if (gfx->data.type == JSGRAPHICSTYPE_SDL) {
+    lcdSetCallbacks_SDL(gfx);
+  } else
 #endif
 #ifdef USE_LCD_FSMC
-    if (gfx->data.type == JSGRAPHICSTYPE_FSMC) {
-      lcdSetCallbacks_FSMC(gfx);
-    } else
+  if (gfx->data.type == JSGRAPHICSTYPE_FSMC) {
+    lcdSetCallbacks_FSMC(gfx);
+  } else
 #endif
-    if (gfx->data.type == JSGRAPHICSTYPE_ARRAYBUFFER) {
-      lcdSetCallbacks_ArrayBuffer(gfx);
+  if (gfx->data.type == JSGRAPHICSTYPE_ARRAYBUFFER) {
+    lcdSetCallbacks_ArrayBuffer(gfx);
 #ifndef SAVE_ON_FLASH
-    } else if (gfx->data.type == JSGRAPHICSTYPE_JS) {
-      lcdSetCallbacks_JS(gfx);
+  } else if (gfx->data.type == JSGRAPHICSTYPE_JS) {
+    lcdSetCallbacks_JS(gfx);
 #endif
 #ifdef USE_LCD_SPI
-    } else if (gfx->data.type == JSGRAPHICSTYPE_SPILCD) {
-      lcdSetCallbacks_SPILCD(gfx);
+  } else if (gfx->data.type == JSGRAPHICSTYPE_SPILCD) {
+    lcdSetCallbacks_SPILCD(gfx);
 #endif
 #ifdef USE_LCD_ST7789_8BIT
-    } else if (gfx->data.type == JSGRAPHICSTYPE_ST7789_8BIT) {
-      lcdST7789_setCallbacks(gfx);
+  } else if (gfx->data.type == JSGRAPHICSTYPE_ST7789_8BIT) {
+    lcdST7789_setCallbacks(gfx);
 #endif
-    } else {
-      jsExceptionHere(JSET_INTERNALERROR, "Unknown graphics type\n");
-      assert(0);
-    }
-
-    return true;
-  } else
+  } else {
+    jsExceptionHere(JSET_INTERNALERROR, "Unknown graphics type\n");
+    assert(0);
     return false;
+  }
+  return true;
 }
 
-void graphicsSetVar(JsGraphics *gfx) {
+/// Write gfx->data into the Graphics instance's hidden state string
+static void graphicsWriteVar(JsGraphics *gfx) {
   JsVar *dataname = jsvFindChildFromString(gfx->graphicsVar, JS_HIDDEN_CHAR_STR"gfx", true);
   JsVar *data = jsvSkipName(dataname);
   if (!data) {
@@ -189,6 +223,111 @@ void graphicsSetVar(JsGraphics *gfx) {
   jsvUnLock(data);
 }
 
+#ifndef SAVE_ON_FLASH
+/* Loading the state of a Graphics instance means finding and reading its
+ * hidden string and working out the backend's callbacks, and saving it means
+ * writing the string back. A redraw may call hundreds of Graphics methods in
+ * one go, so we keep the state of the most recently used instances here.
+ * graphicsGetFromVar and graphicsSetVar just copy to and from this, and the
+ * hidden string is only written when an entry is evicted, or from
+ * graphicsIdle/graphicsKill. Each entry keeps its Graphics instance locked so
+ * it can't be freed or moved by GC or defrag while cached. Backends may keep
+ * pointers to other vars (like 'buffer'), so their callbacks are worked out
+ * again if the property epoch changes (which includes GC and defrag) or if
+ * 'buffer' is set to something else. */
+#define GRAPHICS_CACHE_SIZE 2
+typedef struct {
+  JsGraphics gfx; ///< gfx.graphicsVar is locked while the entry is in use
+  JsVar *bufferName; ///< The name of the instance's 'buffer' (if any), locked
+  JsVarRef bufferRef; ///< What bufferName pointed to when the callbacks were set up
+  unsigned int epoch; ///< jsvGetPropertyEpoch() when the callbacks were set up
+  bool modified; ///< gfx.data has changed since it was written to the hidden string
+} GraphicsCacheEntry;
+static GraphicsCacheEntry graphicsCache[GRAPHICS_CACHE_SIZE];
+
+/// Write back (if modified) and release a cache entry
+static void graphicsCacheFree(GraphicsCacheEntry *e) {
+  if (!e->gfx.graphicsVar) return;
+  if (e->modified) graphicsWriteVar(&e->gfx);
+  jsvUnLock2(e->gfx.graphicsVar, e->bufferName);
+  e->gfx.graphicsVar = 0;
+  e->bufferName = 0;
+  e->modified = false;
+}
+
+/// Write back and release everything in the cache
+static void graphicsCacheFreeAll() {
+  for (int i=0;i<GRAPHICS_CACHE_SIZE;i++)
+    graphicsCacheFree(&graphicsCache[i]);
+}
+
+static GraphicsCacheEntry *graphicsCacheFind(JsVar *parent) {
+  for (int i=0;i<GRAPHICS_CACHE_SIZE;i++)
+    if (graphicsCache[i].gfx.graphicsVar == parent)
+      return &graphicsCache[i];
+  return 0;
+}
+
+/// What an entry's 'buffer' currently points to
+static JsVarRef graphicsCacheGetBufferRef(GraphicsCacheEntry *e) {
+  if (!e->bufferName || jsvIsNameWithValue(e->bufferName)) return 0;
+  return jsvGetFirstChild(e->bufferName);
+}
+#endif
+
+bool graphicsGetFromVar(JsGraphics *gfx, JsVar *parent) {
+#ifndef SAVE_ON_FLASH
+  GraphicsCacheEntry *e = graphicsCacheFind(parent);
+  if (e) {
+    JsVarRef bufferRef = graphicsCacheGetBufferRef(e);
+    if (e->epoch != jsvGetPropertyEpoch() || e->bufferRef != bufferRef) {
+      if (!graphicsSetCallbacks(&e->gfx)) return false;
+      e->epoch = jsvGetPropertyEpoch();
+      e->bufferRef = bufferRef;
+    }
+    *gfx = e->gfx;
+    return true;
+  }
+#endif
+  gfx->graphicsVar = parent;
+  JsVar *data = jsvObjectGetChild(parent, JS_HIDDEN_CHAR_STR"gfx", 0);
+  assert(data);
+  if (data) {
+    jsvGetString(data, (char*)&gfx->data, sizeof(JsGraphicsData)+1/*trailing zero*/);
+    jsvUnLock(data);
+    if (!graphicsSetCallbacks(gfx)) return false;
+#ifndef SAVE_ON_FLASH
+    // Most recently used goes first - so evict the last entry
+    graphicsCacheFree(&graphicsCache[GRAPHICS_CACHE_SIZE-1]);
+    memmove(&graphicsCache[1], &graphicsCache[0], sizeof(GraphicsCacheEntry)*(GRAPHICS_CACHE_SIZE-1));
+    e = &graphicsCache[0];
+    e->gfx = *gfx;
+    e->gfx.graphicsVar = jsvLockAgain(parent);
+    e->bufferName = jsvFindChildFromString(parent, "buffer", false);
+    e->bufferRef = graphicsCacheGetBufferRef(e);
+    e->epoch = jsvGetPropertyEpoch();
+    e->modified = false;
+#endif
+    return true;
+  } else
+    return false;
+}
+
+void graphicsSetVar(JsGraphics *gfx) {
+#ifndef SAVE_ON_FLASH
+  GraphicsCacheEntry *e = graphicsCacheFind(gfx->graphicsVar);
+  if (e) {
+    // the type may have changed, in which case we need new callbacks
+    if (e->gfx.data.type != gfx->data.type)
+      e->epoch = jsvGetPropertyEpoch()-1;
+    e->gfx.data = gfx->data;
+    e->modified = true;
+    return;
+  }
+#endif
+  graphicsWriteVar(gfx);
+}
+
 /// Get the memory requires for this graphics's pixels if everything was packed as densely as possible
 size_t graphicsGetMemoryRequired(const JsGraphics *gfx) {
   return (size_t)(gfx->data.width * gfx->data.height * gfx->data.bpp + 7) >> 3;
@@ -207,6 +346,110 @@ void graphicsToDeviceCoordinates(const JsGraphics *gfx, int *x, int *y) {
   if (gfx->data.flags & JSGRAPHICSFLAGS_INVERT_Y) *y = (int)(gfx->data.height - (*y+1));
 }
 
+#ifndef SAVE_ON_FLASH
+/* If merging a new area into an existing one adds fewer than this many
+ * unmodified pixels, we merge rather than using up a new slot. Sending a
+ * few extra pixels is cheaper than the per-area overhead of a flip */
+#ifndef GRAPHICS_DIRTY_MERGE_AREA
+#define GRAPHICS_DIRTY_MERGE_AREA 256
+#endif
+
+static int graphicsRectArea(int x1, int y1, int x2, int y2) {
+  return (x2+1-x1)*(y2+1-y1);
+}
+
+/// How many unmodified pixels would be included if x1,y1,x2,y2 were merged into 'r'
+static int graphicsDirtyMergeCost(const JsGraphicsClipRect *r, int x1, int y1, int x2, int y2) {
+  int ux1 = (r->x1<x1) ? r->x1 : x1;
+  int uy1 = (r->y1<y1) ? r->y1 : y1;
+  int ux2 = (r->x2>x2) ? r->x2 : x2;
+  int uy2 = (r->y2>y2) ? r->y2 : y2;
+  return graphicsRectArea(ux1,uy1,ux2,uy2) -
+         graphicsRectArea(r->x1,r->y1,r->x2,r->y2) -
+         graphicsRectArea(x1,y1,x2,y2);
+}
+
+static void graphicsDirtyMerge(JsGraphicsClipRect *r, int x1, int y1, int x2, int y2) {
+  if (x1 < r->x1) r->x1 = (unsigned short)x1;
+  if (y1 < r->y1) r->y1 = (unsigned short)y1;
+  if (x2 > r->x2) r->x2 = (unsigned short)x2;
+  if (y2 > r->y2) r->y2 = (unsigned short)y2;
+}
+
+void graphicsAddDirtyRect(JsGraphicsClipRect *rects, unsigned char *rectCount, int x1, int y1, int x2, int y2) {
+  int count = *rectCount;
+  int i;
+  // Usually we're drawing inside an area that's already modified
+  for (i=0;i<count;i++)
+    if (x1>=rects[i].x1 && y1>=rects[i].y1 &&
+        x2<=rects[i].x2 && y2<=rects[i].y2) return;
+  // Otherwise find the area that grows the least if we merge into it
+  int best = -1, bestCost = 0;
+  for (i=0;i<count;i++) {
+    int cost = graphicsDirtyMergeCost(&rects[i],x1,y1,x2,y2);
+    if (best<0 || cost<bestCost) {
+      best = i;
+      bestCost = cost;
+    }
+  }
+  if ((best<0 || bestCost>GRAPHICS_DIRTY_MERGE_AREA) && count<GRAPHICS_DIRTY_RECTS) {
+    // it's cheaper to keep this area separate, and we have space
+    rects[count].x1 = (unsigned short)x1;
+    rects[count].y1 = (unsigned short)y1;
+    rects[count].x2 = (unsigned short)x2;
+    rects[count].y2 = (unsigned short)y2;
+    *rectCount = (unsigned char)(count+1);
+    return;
+  }
+  graphicsDirtyMerge(&rects[best],x1,y1,x2,y2);
+  // The area we grew may now overlap others - if so, absorb them
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (i=0;i<count;i++) {
+      if (i==best) continue;
+      if (graphicsDirtyMergeCost(&rects[best],rects[i].x1,rects[i].y1,rects[i].x2,rects[i].y2) <= GRAPHICS_DIRTY_MERGE_AREA) {
+        graphicsDirtyMerge(&rects[best],rects[i].x1,rects[i].y1,rects[i].x2,rects[i].y2);
+        count--;
+        rects[i] = rects[count];
+        if (best==count) best = i;
+        merged = true;
+        break;
+      }
+    }
+  }
+  *rectCount = (unsigned char)count;
+}
+
+void graphicsSetModified(JsGraphics *gfx, int x1, int y1, int x2, int y2) {
+  if (x1>x2 || y1>y2 || x2<0 || y2<0) return;
+  if (x1<0) x1=0;
+  if (y1<0) y1=0;
+  if (x1 < gfx->data.modMinX) gfx->data.modMinX=(short)x1;
+  if (x2 > gfx->data.modMaxX) gfx->data.modMaxX=(short)x2;
+  if (y1 < gfx->data.modMinY) gfx->data.modMinY=(short)y1;
+  if (y2 > gfx->data.modMaxY) gfx->data.modMaxY=(short)y2;
+  graphicsAddDirtyRect(gfx->data.dirtyRects, &gfx->data.dirtyRectCount, x1, y1, x2, y2);
+}
+
+void graphicsClearModified(JsGraphics *gfx) {
+  gfx->data.modMaxX = -32768;
+  gfx->data.modMaxY = -32768;
+  gfx->data.modMinX = 32767;
+  gfx->data.modMinY = 32767;
+  gfx->data.dirtyRectCount = 0;
+}
+
+void graphicsFlipModified(JsGraphics *gfx, JsGraphicsFlipCallback callback) {
+  int i;
+  for (i=0;i<gfx->data.dirtyRectCount;i++) {
+    JsGraphicsClipRect *r = &gfx->data.dirtyRects[i];
+    callback(gfx, r->x1, r->y1, r->x2, r->y2);
+  }
+  graphicsClearModified(gfx);
+}
+#endif
+
 // ----------------------------------------------------------------------------------------------
 
 static void graphicsSetPixelDevice(JsGraphics *gfx, int x, int y, unsigned int col) {
@@ -219,10 +462,7 @@ static void graphicsSetPixelDevice(JsGraphics *gfx, int x, int y, unsigned int c
       y>gfx->data.clipRect.y2) return;
 #endif
 #ifndef SAVE_ON_FLASH
-  if (x < gfx->data.modMinX) gfx->data.modMinX=(short)x;
-  if (x > gfx->data.modMaxX) gfx->data.modMaxX=(short)x;
-  if (y < gfx->data.modMinY) gfx->data.modMinY=(short)y;
-  if (y > gfx->data.modMaxY) gfx->data.modMaxY=(short)y;
+  graphicsSetModified(gfx, x, y, x, y);
 #endif
   gfx->setPixel(gfx,(int)x,(int)y,col & (unsigned int)((1L<<gfx->data.bpp)-1));
 }
@@ -256,10 +496,7 @@ static void graphicsFillRectDevice(JsGraphics *gfx, int x1, int y1, int x2, int
 #endif
   if (x2<x1 || y2<y1) return; // nope
 #ifndef SAVE_ON_FLASH
-  if (x1 < gfx->data.modMinX) gfx->data.modMinX=(short)x1;
-  if (x2 > gfx->data.modMaxX) gfx->data.modMaxX=(short)x2;
-  if (y1 < gfx->data.modMinY) gfx->data.modMinY=(short)y1;
-  if (y2 > gfx->data.modMaxY) gfx->data.modMaxY=(short)y2;
+  graphicsSetModified(gfx, x1, y1, x2, y2);
 #endif
   if (x1==x2 && y1==y2) {
     gfx->setPixel(gfx,(int)x1,(int)y1,col);
@@ -287,6 +524,38 @@ void graphicsFillRect(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned
   graphicsFillRectDevice(gfx, x1, y1, x2, y2, col);
 }
 
+void graphicsBlitRow(JsGraphics *gfx, int x, int y, int count, JsGraphicsBlitSource *src) {
+#ifdef SAVE_ON_FLASH
+  int minX = 0, minY = 0, maxX = gfx->data.width-1, maxY = gfx->data.height-1;
+#else
+  int minX = gfx->data.clipRect.x1, minY = gfx->data.clipRect.y1;
+  int maxX = gfx->data.clipRect.x2, maxY = gfx->data.clipRect.y2;
+#endif
+  if (y<minY || y>maxY) return;
+  JsGraphicsBlitSource clipped = *src;
+  if (x<minX) {
+    int skip = minX-x;
+    clipped.bitOffset += (unsigned int)(skip*src->bpp);
+    count -= skip;
+    x = minX;
+  }
+  if (x+count-1 > maxX) count = maxX+1-x;
+  if (count<=0) return;
+  gfx->blit(gfx, x, y, count, &clipped);
+}
+
+void graphicsDrawGlyphRow(JsGraphics *gfx, int x, int y, unsigned int bits, int width, int scale, bool solidBackground) {
+  int i = 0;
+  while (i<width) {
+    // find a run of pixels that are all set or all clear
+    bool set = (bits >> (width-1-i)) & 1;
+    int start = i;
+    while (i<width && (bool)((bits >> (width-1-i)) & 1) == set) i++;
+    if (set || solidBackground)
+      graphicsFillRect(gfx, x+start*scale, y, x+i*scale-1, y+scale-1, set ? gfx->data.fgColor : gfx->data.bgColor);
+  }
+}
+
 void graphicsClear(JsGraphics *gfx) {
   graphicsFillRectDevice(gfx,0,0,(int)(gfx->data.width-1),(int)(gfx->data.height-1), gfx->data.bgColor);
 }
@@ -406,26 +675,110 @@ void graphicsDrawLine(JsGraphics *gfx, int x1, int y1, int x2, int y2) {
 
 
 
-void graphicsFillPoly(JsGraphics *gfx, int points, short *vertices) {
-  typedef struct {
-    short x,y;
-  } VertXY;
-  VertXY *v = (VertXY*)vertices;
+/// One edge of a polygon, from vertex i (x1,y1) to the vertex before it (x2,y2)
+typedef struct {
+  short x1,y1,x2,y2;
+  short yStart, yEnd; ///< the scanlines this edge crosses
+  short x; ///< where this edge crosses the current scanline
+  unsigned char idx; ///< position in the polygon - crossings at the same x are kept in this order
+  bool slope;
+} GraphicsPolyEdge;
 
+/// Called for each horizontal span of a polygon by graphicsScanPoly (inclusive)
+typedef void (*GraphicsPolySpanCallback)(JsGraphics *gfx, int x1, int x2, int y, void *data);
+
+/* Scan-convert a polygon (vertices in DEVICE coordinates) between scanlines
+ * miny and maxy, calling 'span' for each run of pixels inside it. Edges are
+ * sorted by the scanline they start on, and only the edges crossing the
+ * current scanline (the 'active edge table') are looked at. */
+static void graphicsScanPoly(JsGraphics *gfx, int points, const short *vertices, int miny, int maxy, GraphicsPolySpanCallback span, void *data) {
+  if (points<2 || points>255) return;
+  GraphicsPolyEdge *edges = (GraphicsPolyEdge*)alloca(sizeof(GraphicsPolyEdge)*(size_t)points);
+  GraphicsPolyEdge **active = (GraphicsPolyEdge**)alloca(sizeof(GraphicsPolyEdge*)*(size_t)points);
+  int edgeCount = 0, activeCount = 0;
   int i,j,y;
+  // Build the edge table, sorted by first scanline
+  j = points-1;
+  for (i=0;i<points;i++) {
+    short x1 = vertices[i*2], y1 = vertices[i*2+1];
+    short x2 = vertices[j*2], y2 = vertices[j*2+1];
+    int l = y2 - y1;
+    j = i;
+    if (!l) continue; // don't do horiz lines - rely on the ends of the lines that join onto them
+    GraphicsPolyEdge e;
+    e.x1 = x1; e.y1 = y1; e.x2 = x2; e.y2 = y2;
+    int ymin = (y1<y2) ? y1 : y2;
+    int ymax = (y1<y2) ? y2 : y1;
+    // an edge covers (ymin,ymax], but the top line is special-cased so it's included
+    int yStart = (ymin==miny) ? ymin : ymin+1;
+    if (yStart<miny) yStart = miny;
+    if (ymax<yStart || yStart>maxy) continue;
+    e.yStart = (short)yStart;
+    e.yEnd = (short)ymax;
+    e.idx = (unsigned char)i;
+    e.slope = l>1;
+    int k = edgeCount++;
+    while (k>0 && edges[k-1].yStart>e.yStart) {
+      edges[k] = edges[k-1];
+      k--;
+    }
+    edges[k] = e;
+  }
+
+  int nextEdge = 0;
+  for (y=miny;y<=maxy;y++) {
+    // add edges starting on this line, remove ones that have finished
+    while (nextEdge<edgeCount && edges[nextEdge].yStart<=y)
+      active[activeCount++] = &edges[nextEdge++];
+    for (i=0;i<activeCount;) {
+      if (active[i]->yEnd<y) active[i] = active[--activeCount];
+      else i++;
+    }
+    if (!activeCount) {
+      if (nextEdge>=edgeCount) break;
+      continue;
+    }
+    // work out where the active edges cross this scanline
+    for (i=0;i<activeCount;i++) {
+      GraphicsPolyEdge *e = active[i];
+      e->x = (short)(e->x1 + ((y - e->y1) * (e->x2-e->x1)) / (e->y2 - e->y1));
+    }
+    // insertion sort - the order barely changes between scanlines
+    for (i=1;i<activeCount;i++) {
+      GraphicsPolyEdge *e = active[i];
+      j = i;
+      while (j>0 && (active[j-1]->x>e->x || (active[j-1]->x==e->x && active[j-1]->idx>e->idx))) {
+        active[j] = active[j-1];
+        j--;
+      }
+      active[j] = e;
+    }
+    //  Fill the pixels between node pairs.
+    int x = 0,s = 0;
+    for (i=0;i<activeCount;i++) {
+      if (s==0) x=active[i]->x;
+      if (active[i]->slope) s++; else s--;
+      if (!s || i==activeCount-1) span(gfx, x, active[i]->x, y, data);
+    }
+    if (jspIsInterrupted()) break;
+  }
+}
+
+/// Convert vertices to device coordinates and work out the scanlines to draw (clipped)
+static void graphicsPolyToDevice(JsGraphics *gfx, int points, short *vertices, int *pminy, int *pmaxy) {
+  int i;
   int miny = (int)(gfx->data.height-1);
   int maxy = 0;
   for (i=0;i<points;i++) {
     // convert into device coordinates...
-    int vx = v[i].x;
-    int vy = v[i].y;
+    int vx = vertices[i*2];
+    int vy = vertices[i*2+1];
     graphicsToDeviceCoordinates(gfx, &vx, &vy);
-    v[i].x = (short)vx;
-    v[i].y = (short)vy;
+    vertices[i*2] = (short)vx;
+    vertices[i*2+1] = (short)vy;
     // work out min and max
-    short y = v[i].y;
-    if (y<miny) miny=y;
-    if (y>maxy) maxy=y;
+    if (vy<miny) miny=vy;
+    if (vy>maxy) maxy=vy;
   }
 #ifndef SAVE_ON_FLASH
   if (miny < gfx->data.clipRect.y1) miny=gfx->data.clipRect.y1;
@@ -434,62 +787,185 @@ void graphicsFillPoly(JsGraphics *gfx, int points, short *vertices) {
   if (miny<0) miny=0;
   if (maxy>=gfx->data.height) maxy=(int)(gfx->data.height-1);
 #endif
+  *pminy = miny;
+  *pmaxy = maxy;
+}
 
-  const int MAX_CROSSES = 64;
+static void graphicsFillPolySpan(JsGraphics *gfx, int x1, int x2, int y, void *data) {
+  NOT_USED(data);
+  graphicsFillRectDevice(gfx,x1,y,x2,y,gfx->data.fgColor);
+}
 
-  // for each scanline
-  for (y=miny;y<=maxy;y++) {
-    short cross[MAX_CROSSES];
-    bool slopes[MAX_CROSSES];
-    int crosscnt = 0;
-    // work out all the times lines cross the scanline
-    j = points-1;
-    for (i=0;i<points;i++) {
-      if ((y==miny && (v[i].y==y || v[j].y==y)) || // special-case top line
-          (v[i].y<y && v[j].y>=y) ||
-          (v[j].y<y && v[i].y>=y)) {
-        if (crosscnt < MAX_CROSSES) {
-          int l = v[j].y - v[i].y;
-          if (l) { // don't do horiz lines - rely on the ends of the lines that join onto them
-            cross[crosscnt] = (short)(v[i].x + ((y - v[i].y) * (v[j].x-v[i].x)) / l);
-            slopes[crosscnt] = (l>1)?1:0;
-            crosscnt++;
-          }
-        }
-      }
-      j = i;
+void graphicsFillPoly(JsGraphics *gfx, int points, short *vertices) {
+  int miny, maxy;
+  graphicsPolyToDevice(gfx, points, vertices, &miny, &maxy);
+  graphicsScanPoly(gfx, points, vertices, miny, maxy, graphicsFillPolySpan, 0);
+}
+
+#ifndef SAVE_ON_FLASH
+/// Mix 'amt' sixteenths of the 'bits' bit channel at 'shift' in 'fg' into 'bg'
+static unsigned int graphicsBlendChannel(unsigned int bg, unsigned int fg, int amt, int shift, int bits) {
+  int mask = (1<<bits)-1;
+  int b = (int)(bg>>shift)&mask, f = (int)(fg>>shift)&mask;
+  return (unsigned int)(b + ((f-b)*amt)/16) << shift;
+}
+
+static unsigned int graphicsBlendRGB565(unsigned int bg, unsigned int fg, int amt) {
+  return graphicsBlendChannel(bg, fg, amt, 11, 5) |
+         graphicsBlendChannel(bg, fg, amt, 5, 6) |
+         graphicsBlendChannel(bg, fg, amt, 0, 5);
+}
+
+#ifdef GRAPHICS_PALETTED_IMAGES
+/// Find the closest color in an RGB565 palette
+static unsigned int graphicsPaletteFindColor(const uint16_t *palette, unsigned int count, unsigned int col) {
+  int r = (int)(col>>11)&31, g = (int)(col>>5)&63, b = (int)col&31;
+  int best = 0x7FFFFFFF;
+  unsigned int bestIdx = 0;
+  for (unsigned int i=0;i<count;i++) {
+    int p = palette[i];
+    // red and blue are only 5 bits, so double them to match green
+    int dr = (((p>>11)&31)-r)*2, dg = ((p>>5)&63)-g, db = ((p&31)-b)*2;
+    int d = dr*dr + dg*dg + db*db;
+    if (d<best) {
+      best = d;
+      bestIdx = i;
     }
+  }
+  return bestIdx;
+}
+#endif
+
+/** Mix 'amt' sixteenths of 'fg' into 'bg'. 16 bit is RGB565 and 24/32 bit is
+ * RGB888, with each channel blended separately. Paletted 4/8 bit colors are
+ * blended as RGB565 and then matched to the palette. Anything else is treated
+ * as a brightness level */
+static unsigned int graphicsBlendColor(JsGraphics *gfx, unsigned int bg, unsigned int fg, int amt) {
+  int bpp = gfx->data.bpp;
+  if (bpp==16)
+    return graphicsBlendRGB565(bg, fg, amt);
+  if (bpp==24 || bpp==32) // keep the alpha (if any) of fg
+    return (fg & ~0xFFFFFFU) |
+           graphicsBlendChannel(bg, fg, amt, 16, 8) |
+           graphicsBlendChannel(bg, fg, amt, 8, 8) |
+           graphicsBlendChannel(bg, fg, amt, 0, 8);
+#ifdef GRAPHICS_PALETTED_IMAGES
+  if (bpp==4 || bpp==8) {
+    const uint16_t *palette = (bpp==4) ? PALETTE_4BIT : PALETTE_8BIT;
+    unsigned int count = 1U<<bpp;
+    unsigned int col = graphicsBlendRGB565(palette[bg&(count-1)], palette[fg&(count-1)], amt);
+    return graphicsPaletteFindColor(palette, count, col);
+  }
+#endif
+  return graphicsBlendChannel(bg, fg, amt, 0, bpp);
+}
 
-    // bubble sort
-    for (i=0;i<crosscnt-1;) {
-      if (cross[i]>cross[i+1]) {
-        short t=cross[i];
-        cross[i]=cross[i+1];
-        cross[i+1]=t;
-        bool ts=slopes[i];
-        slopes[i]=slopes[i+1];
-        slopes[i+1]=ts;
-        if (i) i--;
-      } else i++;
+/// State for the anti-aliased polygon fill - coverage of each pixel in the current row
+typedef struct {
+  unsigned char *coverage; ///< 0..16 for each pixel from x1 to x2
+  int x1, x2; ///< pixels (device coordinates) that coverage applies to
+  int row; ///< the pixel row we're accumulating coverage for
+  int minIdx, maxIdx; ///< range of 'coverage' that has been written to
+} GraphicsPolyAA;
+
+/// Draw the coverage we have for one row of pixels, and reset it
+static void graphicsFillPolyAAFlush(JsGraphics *gfx, GraphicsPolyAA *aa) {
+  int i, runStart = -1;
+  for (i=aa->minIdx;i<=aa->maxIdx+1;i++) {
+    int c = (i<=aa->maxIdx) ? aa->coverage[i] : 0;
+    if (c>=16) {
+      if (runStart<0) runStart = i;
+    } else {
+      // draw fully covered pixels in one go
+      if (runStart>=0) graphicsFillRectDevice(gfx, aa->x1+runStart, aa->row, aa->x1+i-1, aa->row, gfx->data.fgColor);
+      runStart = -1;
+      if (c) {
+        int x = aa->x1+i;
+        unsigned int bg = graphicsGetPixelDevice(gfx, x, aa->row);
+        graphicsSetPixelDevice(gfx, x, aa->row, graphicsBlendColor(gfx, bg, gfx->data.fgColor, c));
+      }
     }
+    if (i<=aa->maxIdx) aa->coverage[i] = 0;
+  }
+  aa->minIdx = aa->x2+1-aa->x1;
+  aa->maxIdx = -1;
+}
 
-    //  Fill the pixels between node pairs.
-    int x = 0,s = 0;
-    for (i=0;i<crosscnt;i++) {
-      if (s==0) x=cross[i];
-      if (slopes[i]) s++; else s--;
-      if (!s || i==crosscnt-1) graphicsFillRectDevice(gfx,x,y,cross[i],y,gfx->data.fgColor);
-      if (jspIsInterrupted()) break;
+/// x1,x2,y are in quarter-pixels
+static void graphicsFillPolyAASpan(JsGraphics *gfx, int x1, int x2, int y, void *data) {
+  GraphicsPolyAA *aa = (GraphicsPolyAA*)data;
+  x2--; // samples are at the centre of each quarter-pixel, so the span's last one is outside
+  if ((y>>2) != aa->row) {
+    if (aa->maxIdx>=0) graphicsFillPolyAAFlush(gfx, aa);
+    aa->row = y>>2;
+  }
+  if (x1 < aa->x1*4) x1 = aa->x1*4;
+  if (x2 > aa->x2*4+3) x2 = aa->x2*4+3;
+  if (x1>x2) return;
+  int p1 = (x1>>2) - aa->x1, p2 = (x2>>2) - aa->x1;
+  if (p1<aa->minIdx) aa->minIdx = p1;
+  if (p2>aa->maxIdx) aa->maxIdx = p2;
+  if (p1==p2) {
+    aa->coverage[p1] = (unsigned char)(aa->coverage[p1] + x2+1-x1);
+    return;
+  }
+  aa->coverage[p1] = (unsigned char)(aa->coverage[p1] + 4-(x1&3));
+  for (int p=p1+1;p<p2;p++)
+    aa->coverage[p] = (unsigned char)(aa->coverage[p] + 4);
+  aa->coverage[p2] = (unsigned char)(aa->coverage[p2] + (x2&3)+1);
+}
+
+void graphicsFillPolyAA(JsGraphics *gfx, int points, short *vertices) {
+  if (gfx->data.bpp<2) {
+    graphicsFillPoly(gfx, points, vertices);
+    return;
+  }
+  int i, miny, maxy;
+  graphicsPolyToDevice(gfx, points, vertices, &miny, &maxy);
+  if (miny>maxy) return;
+  GraphicsPolyAA aa;
+  aa.x1 = 32767;
+  aa.x2 = -32768;
+  for (i=0;i<points;i++) {
+    short x = vertices[i*2], y = vertices[i*2+1];
+    if (x<-8000 || x>8000 || y<-8000 || y>8000) {
+      // too big to work in quarter-pixels - just draw it normally
+      graphicsScanPoly(gfx, points, vertices, miny, maxy, graphicsFillPolySpan, 0);
+      return;
     }
+    if (x<aa.x1) aa.x1 = x;
+    if (x>aa.x2) aa.x2 = x;
+    /* work in quarter-pixels, with vertices at the centre of the pixel. Scanlines
+     * include the bottom of each edge but not the top, so shift Y up by one to
+     * sample the centre of each quarter-pixel row */
+    vertices[i*2] = (short)(x*4+2);
+    vertices[i*2+1] = (short)(y*4+1);
   }
+  if (aa.x1 < gfx->data.clipRect.x1) aa.x1 = gfx->data.clipRect.x1;
+  if (aa.x2 > gfx->data.clipRect.x2) aa.x2 = gfx->data.clipRect.x2;
+  if (aa.x1>aa.x2) return;
+  aa.coverage = (unsigned char*)alloca((size_t)(aa.x2+1-aa.x1));
+  memset(aa.coverage, 0, (size_t)(aa.x2+1-aa.x1));
+  aa.row = miny;
+  aa.minIdx = aa.x2+1-aa.x1;
+  aa.maxIdx = -1;
+  graphicsScanPoly(gfx, points, vertices, miny*4, maxy*4+3, graphicsFillPolyAASpan, &aa);
+  if (aa.maxIdx>=0) graphicsFillPolyAAFlush(gfx, &aa);
 }
+#endif
 
 #ifndef NO_VECTOR_FONT
-// prints character, returns width
-unsigned int graphicsFillVectorChar(JsGraphics *gfx, int x1, int y1, int size, char ch) {
-  // no need to modify coordinates as graphicsFillPoly does that
-  if (size<0) return 0;
-  if (ch<vectorFontOffset || ch-vectorFontOffset>=vectorFontCount) return 0;
+#if defined(LINUX) || defined(BANGLEJS)
+#define GRAPHICS_GLYPH_CACHE // keep recently drawn vector font characters as bitmaps
+#endif
+
+/// Called for each polygon of a vector font character by graphicsVectorCharPolys
+typedef void (*GraphicsVectorPolyCallback)(JsGraphics *gfx, int points, short *verts, void *data);
+
+/// Work out the polygons that make up a vector font character at x1,y1, and call 'poly' for each. Returns false if the character doesn't exist
+static bool graphicsVectorCharPolys(JsGraphics *gfx, int x1, int y1, int size, char ch, GraphicsVectorPolyCallback poly, void *data) {
+  if (size<0) return false;
+  if (ch<vectorFontOffset || ch-vectorFontOffset>=vectorFontCount) return false;
   int vertOffset = 0;
   int i;
   /* compute offset (I figure a ~50 iteration FOR loop is preferable to
@@ -497,22 +973,175 @@ unsigned int graphicsFillVectorChar(JsGraphics *gfx, int x1, int y1, int size, c
   int fontOffset = ch-vectorFontOffset;
   for (i=0;i<fontOffset;i++)
     vertOffset += READ_FLASH_UINT8(&vectorFonts[i].vertCount);
-  VectorFontChar vector;
-  vector.vertCount = READ_FLASH_UINT8(&vectorFonts[fontOffset].vertCount);
-  vector.width = READ_FLASH_UINT8(&vectorFonts[fontOffset].width);
+  int vertCount = READ_FLASH_UINT8(&vectorFonts[fontOffset].vertCount);
   short verts[VECTOR_FONT_MAX_POLY_SIZE*2];
   int idx=0;
-  for (i=0;i<vector.vertCount;i+=2) {
+  for (i=0;i<vertCount;i+=2) {
     verts[idx+0] = (short)(x1 + (((READ_FLASH_UINT8(&vectorFontPolys[vertOffset+i+0])&0x7F)*size + (VECTOR_FONT_POLY_SIZE/2)) / VECTOR_FONT_POLY_SIZE));
     verts[idx+1] = (short)(y1 + (((READ_FLASH_UINT8(&vectorFontPolys[vertOffset+i+1])&0x7F)*size + (VECTOR_FONT_POLY_SIZE/2)) / VECTOR_FONT_POLY_SIZE));
     idx+=2;
     if (READ_FLASH_UINT8(&vectorFontPolys[vertOffset+i+1]) & VECTOR_FONT_POLY_SEPARATOR) {
-      graphicsFillPoly(gfx,idx/2, verts);
+      poly(gfx, idx/2, verts, data);
       if (jspIsInterrupted()) break;
       idx=0;
     }
   }
-  return (vector.width * (unsigned int)size)/(VECTOR_FONT_POLY_SIZE*2);
+  return true;
+}
+
+static void graphicsFillVectorPoly(JsGraphics *gfx, int points, short *verts, void *data) {
+  NOT_USED(data);
+  graphicsFillPoly(gfx, points, verts);
+}
+
+#ifdef GRAPHICS_GLYPH_CACHE
+#define GRAPHICS_GLYPH_CACHE_ENTRIES 16
+#ifndef GRAPHICS_GLYPH_CACHE_BYTES
+#define GRAPHICS_GLYPH_CACHE_BYTES 2048
+#endif
+
+/// A vector font character at one size, rendered as a 1bpp bitmap (rows padded to bytes)
+typedef struct {
+  char ch;
+  unsigned short size;
+  unsigned char width, height;
+  unsigned short offset; ///< where the bitmap is in graphicsGlyphData
+} GraphicsGlyphCacheEntry;
+
+static GraphicsGlyphCacheEntry graphicsGlyphCache[GRAPHICS_GLYPH_CACHE_ENTRIES];
+static unsigned char graphicsGlyphData[GRAPHICS_GLYPH_CACHE_BYTES];
+static int graphicsGlyphCount = 0;
+static int graphicsGlyphDataUsed = 0;
+
+/// Used when rendering a glyph - the size of the glyph, or the bitmap we're drawing into
+typedef struct {
+  int width, height;
+  unsigned char *bitmap;
+} GraphicsGlyphRender;
+
+static void graphicsGlyphBounds(JsGraphics *gfx, int points, short *verts, void *data) {
+  NOT_USED(gfx);
+  GraphicsGlyphRender *r = (GraphicsGlyphRender*)data;
+  for (int i=0;i<points;i++) {
+    if (verts[i*2] >= r->width) r->width = verts[i*2]+1;
+    if (verts[i*2+1] >= r->height) r->height = verts[i*2+1]+1;
+  }
+}
+
+static void graphicsGlyphSpan(JsGraphics *gfx, int x1, int x2, int y, void *data) {
+  NOT_USED(gfx);
+  GraphicsGlyphRender *r = (GraphicsGlyphRender*)data;
+  if (x1<0) x1=0;
+  if (x2>=r->width) x2=r->width-1;
+  unsigned char *row = &r->bitmap[y*((r->width+7)>>3)];
+  for (int x=x1;x<=x2;x++)
+    row[x>>3] |= (unsigned char)(128>>(x&7));
+}
+
+static void graphicsGlyphPoly(JsGraphics *gfx, int points, short *verts, void *data) {
+  GraphicsGlyphRender *r = (GraphicsGlyphRender*)data;
+  // each polygon is scanned over just the lines it covers, exactly as graphicsFillPoly would
+  int i, miny = r->height-1, maxy = 0;
+  for (i=0;i<points;i++) {
+    if (verts[i*2+1]<miny) miny = verts[i*2+1];
+    if (verts[i*2+1]>maxy) maxy = verts[i*2+1];
+  }
+  graphicsScanPoly(gfx, points, verts, miny, maxy, graphicsGlyphSpan, r);
+}
+
+/// Find a character in the glyph cache, rendering it if it isn't there. Returns 0 if it can't be cached
+static GraphicsGlyphCacheEntry *graphicsGlyphCacheGet(JsGraphics *gfx, int size, char ch) {
+  int i;
+  for (i=0;i<graphicsGlyphCount;i++)
+    if (graphicsGlyphCache[i].ch==ch && graphicsGlyphCache[i].size==size)
+      return &graphicsGlyphCache[i];
+  GraphicsGlyphRender r;
+  r.width = 0;
+  r.height = 0;
+  r.bitmap = 0;
+  if (!graphicsVectorCharPolys(gfx, 0, 0, size, ch, graphicsGlyphBounds, &r)) return 0;
+  int bytes = ((r.width+7)>>3)*r.height;
+  // don't let a few big characters push everything else out
+  if (r.width>255 || r.height>255 || bytes>GRAPHICS_GLYPH_CACHE_BYTES/4) return 0;
+  if (graphicsGlyphCount>=GRAPHICS_GLYPH_CACHE_ENTRIES ||
+      graphicsGlyphDataUsed+bytes>GRAPHICS_GLYPH_CACHE_BYTES) {
+    // full - just start again
+    graphicsGlyphCount = 0;
+    graphicsGlyphDataUsed = 0;
+  }
+  GraphicsGlyphCacheEntry *e = &graphicsGlyphCache[graphicsGlyphCount];
+  r.bitmap = &graphicsGlyphData[graphicsGlyphDataUsed];
+  memset(r.bitmap, 0, (size_t)bytes);
+  graphicsVectorCharPolys(gfx, 0, 0, size, ch, graphicsGlyphPoly, &r);
+  if (jspIsInterrupted()) return 0;
+  e->ch = ch;
+  e->size = (unsigned short)size;
+  e->width = (unsigned char)r.width;
+  e->height = (unsigned char)r.height;
+  e->offset = (unsigned short)graphicsGlyphDataUsed;
+  graphicsGlyphDataUsed += bytes;
+  graphicsGlyphCount++;
+  return e;
+}
+
+/// Try and draw a vector font character from the glyph cache. Returns false if it must be drawn as polygons
+static bool graphicsDrawCachedGlyph(JsGraphics *gfx, int x1, int y1, int size, char ch) {
+  // the bitmap is in user coordinates, so only use it if they're the same as device coordinates
+  if (gfx->data.flags & (JSGRAPHICSFLAGS_SWAP_XY|JSGRAPHICSFLAGS_INVERT_X|JSGRAPHICSFLAGS_INVERT_Y))
+    return false;
+  if (size>65535) return false;
+  GraphicsGlyphCacheEntry *e = graphicsGlyphCacheGet(gfx, size, ch);
+  if (!e) return false;
+  // polygons clipped at the top are scanned differently, so draw those directly to match
+  if (y1<gfx->data.clipRect.y1 || y1+e->height-1>gfx->data.clipRect.y2)
+    return false;
+  int stride = (e->width+7)>>3;
+  const unsigned char *row = &graphicsGlyphData[e->offset];
+  if (gfx->blit!=graphicsFallbackBlit && gfx->data.fgColor<=0xFFFF) {
+    // the driver can draw whole rows - set bits are the foreground color, clear bits are transparent
+    uint16_t palette[2] = { 0, (uint16_t)gfx->data.fgColor };
+    JsGraphicsBlitSource src;
+    src.data = row;
+    src.bpp = 1;
+    src.palette = palette;
+    src.paletteMask = 1;
+    src.transparentCol = 0;
+    for (int y=0;y<e->height;y++) {
+      src.bitOffset = (unsigned int)(y*stride*8);
+      graphicsBlitRow(gfx, x1, y1+y, e->width, &src);
+    }
+    int mx1 = x1, mx2 = x1+e->width-1;
+    if (mx1<gfx->data.clipRect.x1) mx1 = gfx->data.clipRect.x1;
+    if (mx2>gfx->data.clipRect.x2) mx2 = gfx->data.clipRect.x2;
+    graphicsSetModified(gfx, mx1, y1, mx2, y1+e->height-1);
+    return true;
+  }
+  // otherwise draw each run of set pixels
+  for (int y=0;y<e->height;y++,row+=stride) {
+    int x = 0;
+    while (x<e->width) {
+      if (!(row[x>>3] & (128>>(x&7)))) {
+        x++;
+        continue;
+      }
+      int runStart = x;
+      while (x<e->width && (row[x>>3] & (128>>(x&7)))) x++;
+      graphicsFillRectDevice(gfx, x1+runStart, y1+y, x1+x-1, y1+y, gfx->data.fgColor);
+    }
+  }
+  return true;
+}
+#endif
+
+// prints character, returns width
+unsigned int graphicsFillVectorChar(JsGraphics *gfx, int x1, int y1, int size, char ch) {
+  // no need to modify coordinates as graphicsFillPoly does that
+#ifdef GRAPHICS_GLYPH_CACHE
+  if (!graphicsDrawCachedGlyph(gfx, x1, y1, size, ch))
+#endif
+  if (!graphicsVectorCharPolys(gfx, x1, y1, size, ch, graphicsFillVectorPoly, 0))
+    return 0;
+  return graphicsVectorCharWidth(gfx, (unsigned int)size, ch);
 }
 
 // returns the width of a character
@@ -572,8 +1201,17 @@ void graphicsSplash(JsGraphics *gfx) {
 }
 
 void graphicsIdle() {
+#ifndef SAVE_ON_FLASH
+  graphicsCacheFreeAll();
+#endif
 #ifdef USE_LCD_SDL
   lcdIdle_SDL();
 #endif
 }
 
+void graphicsKill() {
+#ifndef SAVE_ON_FLASH
+  graphicsCacheFreeAll();
+#endif
+}
+
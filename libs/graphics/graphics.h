@@ -73,6 +73,11 @@ typedef struct {
   unsigned short x2,y2;
 } PACKED_FLAGS JsGraphicsClipRect;
 
+#ifndef GRAPHICS_DIRTY_RECTS
+/// How many separate modified areas we keep track of for partial flips
+#define GRAPHICS_DIRTY_RECTS 4
+#endif
+
 typedef struct {
   JsGraphicsType type;
   JsGraphicsFlags flags;
@@ -89,9 +94,21 @@ typedef struct {
 #ifndef SAVE_ON_FLASH
   JsGraphicsClipRect clipRect;
   short modMinX, modMinY, modMaxX, modMaxY; ///< area that has been modified
+  JsGraphicsClipRect dirtyRects[GRAPHICS_DIRTY_RECTS]; ///< modified areas (in device coordinates) for partial flips - always inside modMin/Max
+  unsigned char dirtyRectCount; ///< how many entries of dirtyRects are used
 #endif
 } PACKED_FLAGS JsGraphicsData;
 
+/// A row of pixels to be drawn from an image (see JsGraphics.blit)
+typedef struct {
+  const unsigned char *data; ///< Image data, with pixels packed MSB first
+  unsigned int bitOffset; ///< Offset in bits of the first pixel in 'data'
+  unsigned char bpp; ///< Bits per pixel
+  const uint16_t *palette; ///< If set, colors are looked up in this
+  unsigned int paletteMask; ///< Mask applied to colors before looking them up in palette
+  unsigned int transparentCol; ///< Pixels of this color (before the palette) aren't drawn. 0xFFFFFFFF for none
+} PACKED_FLAGS JsGraphicsBlitSource;
+
 typedef struct JsGraphics {
   JsVar *graphicsVar; // this won't be locked again - we just know that it is already locked by something else
   JsGraphicsData data;
@@ -102,6 +119,8 @@ typedef struct JsGraphics {
   void (*fillRect)(struct JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col);
   unsigned int (*getPixel)(struct JsGraphics *gfx, int x, int y);
   void (*scroll)(struct JsGraphics *gfx, int xdir, int ydir); // scroll - leave unscrolled area undefined
+  void (*setPixels)(struct JsGraphics *gfx, int x, int y, int count, unsigned int col); ///< set 'count' pixels in a row, starting at x,y
+  void (*blit)(struct JsGraphics *gfx, int x, int y, int count, const JsGraphicsBlitSource *src); ///< draw 'count' pixels from 'src' in a row, starting at x,y
 } PACKED_FLAGS JsGraphics;
 
 // ---------------------------------- these are in graphics.c
@@ -118,17 +137,39 @@ void graphicsSetVar(JsGraphics *gfx);
 size_t graphicsGetMemoryRequired(const JsGraphics *gfx);
 // If graphics is flipped or rotated then the coordinates need modifying
 void graphicsToDeviceCoordinates(const JsGraphics *gfx, int *x, int *y);
+#ifndef SAVE_ON_FLASH
+/// Add x1,y1,x2,y2 (inclusive, all >=0) to a list of up to GRAPHICS_DIRTY_RECTS areas, merging it with nearby areas
+void graphicsAddDirtyRect(JsGraphicsClipRect *rects, unsigned char *rectCount, int x1, int y1, int x2, int y2);
+/// Mark an area (in DEVICE coordinates, inclusive) as modified, merging it into the list of modified areas
+void graphicsSetModified(JsGraphics *gfx, int x1, int y1, int x2, int y2);
+/// Reset the modified area, so nothing is marked as modified
+void graphicsClearModified(JsGraphics *gfx);
+/// Called for each modified area by graphicsFlipModified (DEVICE coordinates, inclusive)
+typedef void (*JsGraphicsFlipCallback)(JsGraphics *gfx, int x1, int y1, int x2, int y2);
+/// Call 'callback' for each separate area that has been modified, then reset the modified area
+void graphicsFlipModified(JsGraphics *gfx, JsGraphicsFlipCallback callback);
+#endif
 // drawing functions - all coordinates are in USER coordinates, not DEVICE coordinates
 void         graphicsSetPixel(JsGraphics *gfx, int x, int y, unsigned int col);
 unsigned int graphicsGetPixel(JsGraphics *gfx, int x, int y);
 void         graphicsClear(JsGraphics *gfx);
 void         graphicsFillRect(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col);
 void graphicsFallbackFillRect(JsGraphics *gfx, int x1, int y1, int x2, int y2, unsigned int col); // Simple fillrect - doesn't call device-specific FR
+void graphicsFallbackBlit(JsGraphics *gfx, int x, int y, int count, const JsGraphicsBlitSource *src); // Simple blit - draws runs of pixels with setPixels
+/// Read the pixel at 'bit' in a blit source (before the palette is applied)
+unsigned int graphicsBlitGetPixel(const JsGraphicsBlitSource *src, unsigned int bit);
+/// Draw a row of an image at x,y (in USER coordinates, which must be the same as DEVICE coordinates), clipped to the clip rect
+void graphicsBlitRow(JsGraphics *gfx, int x, int y, int count, JsGraphicsBlitSource *src);
+/// Draw a row of a 1bpp font glyph: 'width' pixels from 'bits' (MSB leftmost), each 'scale' pixels square
+void graphicsDrawGlyphRow(JsGraphics *gfx, int x, int y, unsigned int bits, int width, int scale, bool solidBackground);
 void graphicsDrawRect(JsGraphics *gfx, int x1, int y1, int x2, int y2);
 void graphicsDrawEllipse(JsGraphics *gfx, int x, int y, int x2, int y2);
 void graphicsFillEllipse(JsGraphics *gfx, int x, int y, int x2, int y2);
 void graphicsDrawLine(JsGraphics *gfx, int x1, int y1, int x2, int y2);
 void graphicsFillPoly(JsGraphics *gfx, int points, short *vertices); // may overwrite vertices...
+#ifndef SAVE_ON_FLASH
+void graphicsFillPolyAA(JsGraphics *gfx, int points, short *vertices); // anti-aliased with 4x4 supersampling (>=2bpp only), may overwrite vertices...
+#endif
 #ifndef NO_VECTOR_FONT
 unsigned int graphicsFillVectorChar(JsGraphics *gfx, int x1, int y1, int size, char ch); ///< prints character, returns width
 unsigned int graphicsVectorCharWidth(JsGraphics *gfx, unsigned int size, char ch); ///< returns the width of a character
@@ -141,5 +182,6 @@ void graphicsScroll(JsGraphics *gfx, int xdir, int ydir);
 void graphicsSplash(JsGraphics *gfx); ///< splash screen
 
 void graphicsIdle(); ///< called when idling
+void graphicsKill(); ///< called when Espruino is being reset or saved
 
 #endif // GRAPHICS_H
@@ -104,7 +104,10 @@ to inactivity.
 
 On some devices, this command will attempt to
 only update the areas of the screen that have
-changed in order to increase speed. If you have
+changed in order to increase speed. Up to 4 separate
+areas are tracked (see `Graphics.getModifiedRects`),
+so small changes in different corners of the screen
+don't cause everything in between to be sent. If you have
 accessed the `Graphics.buffer` directly then you
 may need to use `Graphics.flip(true)` to force
 a full update of the screen.
@@ -143,6 +146,14 @@ bool jswrap_graphics_idle() {
   return false;
 }
 
+/*JSON{
+  "type" : "kill",
+  "generate" : "jswrap_graphics_kill"
+}*/
+void jswrap_graphics_kill() {
+  graphicsKill();
+}
+
 /*JSON{
   "type" : "init",
   "generate" : "jswrap_graphics_init"
@@ -1429,20 +1440,30 @@ JsVar *jswrap_graphics_drawString(JsVar *parent, JsVar *var, int x, int y, bool
         bmpOffset &= 7;
         int cx,cy;
         for (cx=0;cx<width;cx++) {
-          for (cy=0;cy<ch;cy++) {
-            bool set = (jsvStringIteratorGetChar(&cit)<<bmpOffset)&128;
-            if (solidBackground || set)
-              graphicsFillRect(&gfx,
-                  (x + cx*scale),
-                  (y + cy*scale),
-                  (x + cx*scale + scale-1),
-                  (y + cy*scale + scale-1),
-                  set ? gfx.data.fgColor : gfx.data.bgColor);
-            bmpOffset++;
-            if (bmpOffset==8) {
-              bmpOffset=0;
-              jsvStringIteratorNext(&cit);
+          // glyphs are stored in columns - draw runs of set or clear pixels
+          int runStart = 0;
+          bool runSet = false;
+          for (cy=0;cy<=ch;cy++) {
+            bool set = false;
+            if (cy<ch) {
+              set = (jsvStringIteratorGetChar(&cit)<<bmpOffset)&128;
+              bmpOffset++;
+              if (bmpOffset==8) {
+                bmpOffset=0;
+                jsvStringIteratorNext(&cit);
+              }
+            }
+            if (cy && (cy==ch || set!=runSet)) {
+              if (solidBackground || runSet)
+                graphicsFillRect(&gfx,
+                    (x + cx*scale),
+                    (y + runStart*scale),
+                    (x + cx*scale + scale-1),
+                    (y + cy*scale - 1),
+                    runSet ? gfx.data.fgColor : gfx.data.bgColor);
+              runStart = cy;
             }
+            runSet = set;
           }
         }
         jsvStringIteratorFree(&cit);
@@ -1657,7 +1678,7 @@ JsVar *jswrap_graphics_drawPoly(JsVar *parent, JsVar *poly, bool closed) {
 }
 Draw a filled polygon in the current foreground color
 */
-JsVar *jswrap_graphics_fillPoly(JsVar *parent, JsVar *poly) {
+static JsVar *_jswrap_graphics_fillPoly(JsVar *parent, JsVar *poly, bool antiAlias) {
   JsGraphics gfx; if (!graphicsGetFromVar(&gfx, parent)) return 0;
   if (!jsvIsIterable(poly)) return 0;
   const int maxVerts = 128;
@@ -1673,11 +1694,43 @@ JsVar *jswrap_graphics_fillPoly(JsVar *parent, JsVar *poly) {
   if (idx==maxVerts) {
     jsWarn("Maximum number of points (%d) exceeded for fillPoly", maxVerts/2);
   }
-  graphicsFillPoly(&gfx, idx/2, verts);
+  if (antiAlias)
+    graphicsFillPolyAA(&gfx, idx/2, verts);
+  else
+    graphicsFillPoly(&gfx, idx/2, verts);
 
   graphicsSetVar(&gfx); // gfx data changed because modified area
   return jsvLockAgain(parent);
 }
+JsVar *jswrap_graphics_fillPoly(JsVar *parent, JsVar *poly) {
+  return _jswrap_graphics_fillPoly(parent, poly, false);
+}
+
+/*JSON{
+  "type" : "method",
+  "class" : "Graphics",
+  "name" : "fillPolyAA",
+  "ifndef" : "SAVE_ON_FLASH",
+  "generate" : "jswrap_graphics_fillPolyAA",
+  "params" : [
+    ["poly","JsVar","An array of vertices, of the form ```[x1,y1,x2,y2,x3,y3,etc]```"]
+  ],
+  "return" : ["JsVar","The instance of Graphics this was called on, to allow call chaining"],
+  "return_object" : "Graphics"
+}
+Draw a filled polygon in the current foreground color, with smooth anti-aliased
+edges. Each pixel is sampled 16 times (4x4) and pixels on the edge of the polygon
+are blended with what was there before.
+
+Colors are blended per channel on 16 bit (RGB565) and 24/32 bit (RGB888)
+Graphics. 4 and 8 bit Graphics use a palette for colors, so they are blended
+as RGB and the closest color in the palette is used. At 2 bits the color is
+assumed to be a brightness level (eg. for greyscale displays). 1 bit Graphics
+can't be anti-aliased, so this is the same as `Graphics.fillPoly`.
+*/
+JsVar *jswrap_graphics_fillPolyAA(JsVar *parent, JsVar *poly) {
+  return _jswrap_graphics_fillPoly(parent, poly, true);
+}
 
 /*JSON{
   "type" : "method",
@@ -1724,6 +1777,29 @@ JsVar *jswrap_graphics_setRotation(JsVar *parent, int rotation, bool reflect) {
   return jsvLockAgain(parent);
 }
 
+#ifdef GRAPHICS_FAST_PATHS
+/** Draw an image a row at a time with gfx->blit, if we can get a pointer to
+ * its data. Only for when USER and DEVICE coordinates are the same. Returns
+ * false if the image couldn't be drawn this way. */
+static bool _jswrap_graphics_blitImage(JsGraphics *gfx, int xPos, int yPos, JsVar *imageBufferString, int imageBufferOffset, int imageWidth, int imageHeight, int imageBpp, const uint16_t *palettePtr, uint32_t paletteMask, unsigned int imageTransparentCol) {
+  size_t imageLen = 0;
+  const unsigned char *imagePtr = (const unsigned char*)jsvGetDataPointer(imageBufferString, &imageLen);
+  if (!imagePtr || (size_t)imageBufferOffset + (((size_t)imageWidth*(size_t)imageHeight*(size_t)imageBpp + 7)>>3) > imageLen)
+    return false;
+  JsGraphicsBlitSource src;
+  src.data = imagePtr + imageBufferOffset;
+  src.bpp = (unsigned char)imageBpp;
+  src.palette = palettePtr;
+  src.paletteMask = paletteMask;
+  src.transparentCol = imageTransparentCol;
+  for (int y=0;y<imageHeight;y++) {
+    src.bitOffset = (unsigned int)(y*imageWidth*imageBpp);
+    graphicsBlitRow(gfx, xPos, yPos+y, imageWidth, &src);
+  }
+  return true;
+}
+#endif
+
 /*JSON{
   "type" : "method",
   "class" : "Graphics",
@@ -1900,29 +1976,31 @@ JsVar *jswrap_graphics_drawImage(JsVar *parent, JsVar *image, int xPos, int yPos
     bool fastPath =
         (gfx.data.flags & (JSGRAPHICSFLAGS_SWAP_XY|JSGRAPHICSFLAGS_INVERT_X|JSGRAPHICSFLAGS_INVERT_Y))==0; // no messing with coordinates
     if (fastPath) { // fast path for standard blit
-      int yp = yPos;
-      for (y=0;y<imageHeight;y++) {
-        int xp = xPos;
-        for (x=0;x<imageWidth;x++) {
-          // Get the data we need...
-          while (bits < imageBpp) {
-            colData = (colData<<8) | ((unsigned char)jsvStringIteratorGetChar(&it));
-            jsvStringIteratorNext(&it);
-            bits += 8;
-          }
-          // extract just the bits we want
-          unsigned int col = (colData>>(bits-imageBpp))&imageBitMask;
-          bits -= imageBpp;
-          // Try and write pixel!
-          if (imageTransparentCol!=col) {
-            if (palettePtr) col = palettePtr[col&paletteMask];
-            if (xp>=gfx.data.clipRect.x1 && xp<=gfx.data.clipRect.x2 &&
-                yp>=gfx.data.clipRect.y1 && yp<=gfx.data.clipRect.y2)
-              gfx.setPixel(&gfx, xp, yp, col);
+      if (!_jswrap_graphics_blitImage(&gfx, xPos, yPos, imageBufferString, imageBufferOffset, imageWidth, imageHeight, imageBpp, palettePtr, paletteMask, imageTransparentCol)) {
+        int yp = yPos;
+        for (y=0;y<imageHeight;y++) {
+          int xp = xPos;
+          for (x=0;x<imageWidth;x++) {
+            // Get the data we need...
+            while (bits < imageBpp) {
+              colData = (colData<<8) | ((unsigned char)jsvStringIteratorGetChar(&it));
+              jsvStringIteratorNext(&it);
+              bits += 8;
+            }
+            // extract just the bits we want
+            unsigned int col = (colData>>(bits-imageBpp))&imageBitMask;
+            bits -= imageBpp;
+            // Try and write pixel!
+            if (imageTransparentCol!=col) {
+              if (palettePtr) col = palettePtr[col&paletteMask];
+              if (xp>=gfx.data.clipRect.x1 && xp<=gfx.data.clipRect.x2 &&
+                  yp>=gfx.data.clipRect.y1 && yp<=gfx.data.clipRect.y2)
+                gfx.setPixel(&gfx, xp, yp, col);
+            }
+            xp++;
           }
-          xp++;
+          yp++;
         }
-        yp++;
       }
       // update modified area since we went direct
       int x1=xPos, y1=yPos, x2=xPos+imageWidth, y2=yPos+imageHeight;
@@ -1930,10 +2008,7 @@ JsVar *jswrap_graphics_drawImage(JsVar *parent, JsVar *image, int xPos, int yPos
       if (y1<gfx.data.clipRect.y1) y1 = gfx.data.clipRect.y1;
       if (x2>gfx.data.clipRect.x2) x2 = gfx.data.clipRect.x2;
       if (y2>gfx.data.clipRect.y2) y2 = gfx.data.clipRect.y2;
-      if (x1 < gfx.data.modMinX) gfx.data.modMinX=(short)x1;
-      if (x2 > gfx.data.modMaxX) gfx.data.modMaxX=(short)x2;
-      if (y1 < gfx.data.modMinY) gfx.data.modMinY=(short)y1;
-      if (y2 > gfx.data.modMaxY) gfx.data.modMaxY=(short)y2;
+      graphicsSetModified(&gfx, x1, y1, x2, y2);
     } else { // handle rotation, and default to center the image
 #else
     if (true) {
@@ -1981,43 +2056,44 @@ JsVar *jswrap_graphics_drawImage(JsVar *parent, JsVar *image, int xPos, int yPos
        * that on direct-coupled displays we can optimise away
        * coordinate setting
        */
-
-      int yp = yPos;
-      for (y=0;y<imageHeight;y++) {
-        // Store current pos as we need to rewind
-        size_t lastIt = jsvStringIteratorGetIndex(&it);
-        int lastBits = bits;
-        unsigned int lastColData = colData;
-        // do a new iteration for each line we're scaling
-        for (int iy=0;iy<s;iy++) {
-          if (iy) { // rewind for all but the first line of scaling
-            jsvStringIteratorGoto(&it, imageBufferString, lastIt);
-            bits = lastBits;
-            colData = lastColData;
-          }
-          // iterate over x
-          int xp = xPos;
-          for (x=0;x<imageWidth;x++) {
-            // Get the data we need...
-            while (bits < imageBpp) {
-              colData = (colData<<8) | ((unsigned char)jsvStringIteratorGetChar(&it));
-              jsvStringIteratorNext(&it);
-              bits += 8;
+      if (s!=1 || !_jswrap_graphics_blitImage(&gfx, xPos, yPos, imageBufferString, imageBufferOffset, imageWidth, imageHeight, imageBpp, palettePtr, paletteMask, imageTransparentCol)) {
+        int yp = yPos;
+        for (y=0;y<imageHeight;y++) {
+          // Store current pos as we need to rewind
+          size_t lastIt = jsvStringIteratorGetIndex(&it);
+          int lastBits = bits;
+          unsigned int lastColData = colData;
+          // do a new iteration for each line we're scaling
+          for (int iy=0;iy<s;iy++) {
+            if (iy) { // rewind for all but the first line of scaling
+              jsvStringIteratorGoto(&it, imageBufferString, lastIt);
+              bits = lastBits;
+              colData = lastColData;
             }
-            // extract just the bits we want
-            unsigned int col = (colData>>(bits-imageBpp))&imageBitMask;
-            bits -= imageBpp;
-            // Try and write pixel!
-            if (imageTransparentCol!=col && yp>=gfx.data.clipRect.y1 && yp<=gfx.data.clipRect.y2) {
-              if (palettePtr) col = palettePtr[col&paletteMask];
-              for (int ix=0;ix<s;ix++) {
-                if (xp>=gfx.data.clipRect.x1 && xp<=gfx.data.clipRect.x2)
-                  gfx.setPixel(&gfx, xp, yp, col);
-                xp++;
+            // iterate over x
+            int xp = xPos;
+            for (x=0;x<imageWidth;x++) {
+              // Get the data we need...
+              while (bits < imageBpp) {
+                colData = (colData<<8) | ((unsigned char)jsvStringIteratorGetChar(&it));
+                jsvStringIteratorNext(&it);
+                bits += 8;
               }
-            } else xp += s;
+              // extract just the bits we want
+              unsigned int col = (colData>>(bits-imageBpp))&imageBitMask;
+              bits -= imageBpp;
+              // Try and write pixel!
+              if (imageTransparentCol!=col && yp>=gfx.data.clipRect.y1 && yp<=gfx.data.clipRect.y2) {
+                if (palettePtr) col = palettePtr[col&paletteMask];
+                for (int ix=0;ix<s;ix++) {
+                  if (xp>=gfx.data.clipRect.x1 && xp<=gfx.data.clipRect.x2)
+                    gfx.setPixel(&gfx, xp, yp, col);
+                  xp++;
+                }
+              } else xp += s;
+            }
+            yp++;
           }
-          yp++;
         }
       }
       // update modified area since we went direct
@@ -2026,10 +2102,7 @@ JsVar *jswrap_graphics_drawImage(JsVar *parent, JsVar *image, int xPos, int yPos
       if (y1<gfx.data.clipRect.y1) y1 = gfx.data.clipRect.y1;
       if (x2>gfx.data.clipRect.x2) x2 = gfx.data.clipRect.x2;
       if (y2>gfx.data.clipRect.y2) y2 = gfx.data.clipRect.y2;
-      if (x1 < gfx.data.modMinX) gfx.data.modMinX=(short)x1;
-      if (x2 > gfx.data.modMaxX) gfx.data.modMaxX=(short)x2;
-      if (y1 < gfx.data.modMinY) gfx.data.modMinY=(short)y1;
-      if (y2 > gfx.data.modMaxY) gfx.data.modMaxY=(short)y2;
+      graphicsSetModified(&gfx, x1, y1, x2, y2);
     } else { // handle rotation, and default to center the image
 #else
     if (true) {
@@ -2176,10 +2249,7 @@ JsVar *jswrap_graphics_getModified(JsVar *parent, bool reset) {
     }
   }
   if (reset) {
-    gfx.data.modMaxX = -32768;
-    gfx.data.modMaxY = -32768;
-    gfx.data.modMinX = 32767;
-    gfx.data.modMinY = 32767;
+    graphicsClearModified(&gfx);
     graphicsSetVar(&gfx);
   }
   return obj;
@@ -2188,6 +2258,58 @@ JsVar *jswrap_graphics_getModified(JsVar *parent, bool reset) {
 #endif
 }
 
+/*JSON{
+  "type" : "method",
+  "class" : "Graphics",
+  "name" : "getModifiedRects",
+  "ifndef" : "SAVE_ON_FLASH",
+  "generate" : "jswrap_graphics_getModifiedRects",
+  "params" : [
+    ["reset","bool","Whether to reset the modified area or not"]
+  ],
+  "return" : ["JsVar","An array of {x1,y1,x2,y2} objects for each separate area that has been modified"]
+}
+Like `Graphics.getModified`, but rather than one rectangle surrounding everything
+that has changed, this returns a list of (up to 4) smaller rectangles that
+together cover all modified pixels. Nearby areas are merged.
+
+This is handy when writing a `flip` function in JavaScript for a display
+driven from an offscreen buffer, as only the pixels that have changed need sending:
+
+```
+g.flip = function() {
+  g.getModifiedRects(true).forEach(function(r) {
+    // send pixels r.x1..r.x2, r.y1..r.y2 to the display
+  });
+};
+```
+*/
+JsVar *jswrap_graphics_getModifiedRects(JsVar *parent, bool reset) {
+#ifndef SAVE_ON_FLASH
+  JsGraphics gfx; if (!graphicsGetFromVar(&gfx, parent)) return 0;
+  JsVar *arr = jsvNewEmptyArray();
+  if (!arr) return 0;
+  int i;
+  for (i=0;i<gfx.data.dirtyRectCount;i++) {
+    JsGraphicsClipRect *r = &gfx.data.dirtyRects[i];
+    JsVar *obj = jsvNewObject();
+    if (!obj) break;
+    jsvObjectSetChildAndUnLock(obj, "x1", jsvNewFromInteger(r->x1));
+    jsvObjectSetChildAndUnLock(obj, "y1", jsvNewFromInteger(r->y1));
+    jsvObjectSetChildAndUnLock(obj, "x2", jsvNewFromInteger(r->x2));
+    jsvObjectSetChildAndUnLock(obj, "y2", jsvNewFromInteger(r->y2));
+    jsvArrayPushAndUnLock(arr, obj);
+  }
+  if (reset) {
+    graphicsClearModified(&gfx);
+    graphicsSetVar(&gfx);
+  }
+  return arr;
+#else
+  return 0;
+#endif
+}
+
 /*JSON{
   "type" : "method",
   "class" : "Graphics",
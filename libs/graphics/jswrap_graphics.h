@@ -25,6 +25,7 @@ extern const uint16_t PALETTE_8BIT[256];
 #endif
 
 bool jswrap_graphics_idle();
+void jswrap_graphics_kill();
 void jswrap_graphics_init();
 
 JsVar *jswrap_graphics_getInstance();
@@ -68,10 +69,12 @@ JsVar *jswrap_graphics_lineTo(JsVar *parent, int x, int y);
 JsVar *jswrap_graphics_moveTo(JsVar *parent, int x, int y);
 JsVar *jswrap_graphics_drawPoly(JsVar *parent, JsVar *poly, bool closed);
 JsVar *jswrap_graphics_fillPoly(JsVar *parent, JsVar *poly);
+JsVar *jswrap_graphics_fillPolyAA(JsVar *parent, JsVar *poly);
 JsVar *jswrap_graphics_setRotation(JsVar *parent, int rotation, bool reflect);
 JsVar *jswrap_graphics_drawImage(JsVar *parent, JsVar *image, int xPos, int yPos, JsVar *options);
 JsVar *jswrap_graphics_asImage(JsVar *parent);
 JsVar *jswrap_graphics_getModified(JsVar *parent, bool reset);
+JsVar *jswrap_graphics_getModifiedRects(JsVar *parent, bool reset);
 JsVar *jswrap_graphics_scroll(JsVar *parent, int x, int y);
 JsVar *jswrap_graphics_asBMP(JsVar *parent);
 JsVar *jswrap_graphics_asURL(JsVar *parent);
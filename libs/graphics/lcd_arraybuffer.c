@@ -129,7 +129,7 @@ void  lcdFillRect_ArrayBuffer(struct JsGraphics *gfx, int x1, int y1, int x2, in
     lcdSetPixels_ArrayBuffer(gfx, x1, y, 1+x2-x1, col);
 }
 
-#ifndef GRAPHICS_ARRAYBUFFER_OPTIMISATIONS
+#ifdef GRAPHICS_ARRAYBUFFER_OPTIMISATIONS
 // Faster implementation for where we have a flat memory area
 unsigned int lcdGetPixel_ArrayBuffer_flat(JsGraphics *gfx, int x, int y) {
   unsigned int col = 0;
@@ -175,7 +175,7 @@ void lcdSetPixels_ArrayBuffer_flat(JsGraphics *gfx, int x, int y, int pixelCount
         // then we can go really quickly and can just fill
         int wholeBytes = (gfx->data.bpp*(pixelCount+1)) >> 3;
         if (wholeBytes) {
-          char c = (char)(col?0xFF:0);
+          unsigned char c = (unsigned char)(col?0xFF:0);
           pixelCount = pixelCount+1 - (wholeBytes*8/gfx->data.bpp);
           while (wholeBytes--) {
             *ptr = c;
@@ -188,17 +188,17 @@ void lcdSetPixels_ArrayBuffer_flat(JsGraphics *gfx, int x, int y, int pixelCount
       unsigned int existing = (unsigned int)*ptr;
       unsigned int bitIdx = (gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_MSB) ? 8-(idx+gfx->data.bpp) : idx;
       assert(ptr>=(unsigned char*)gfx->backendData && ptr<((unsigned char*)gfx->backendData + graphicsGetMemoryRequired(gfx)));
-      *ptr = (char)((existing&~(mask<<bitIdx)) | ((col&mask)<<bitIdx));
+      *ptr = (unsigned char)((existing&~(mask<<bitIdx)) | ((col&mask)<<bitIdx));
       if (gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_VERTICAL_BYTE) {
         ptr++;
       } else {
-        idx += bppStride;
+        idx += (unsigned int)bppStride;
         if (idx>=8) ptr++;
       }
     } else { // we're writing whole bytes
       int i;
       for (i=0;i<gfx->data.bpp;i+=8) {
-        *ptr = (char)(col >> i);
+        *ptr = (unsigned char)(col >> i);
         ptr++;
       }
     }
@@ -216,6 +216,50 @@ void  lcdFillRect_ArrayBuffer_flat(struct JsGraphics *gfx, int x1, int y1, int x
   for (y=y1;y<=y2;y++)
     lcdSetPixels_ArrayBuffer_flat(gfx, x1, y, 1+x2-x1, col);
 }
+
+// Draw a row of an image straight into a flat memory area
+void lcdBlit_ArrayBuffer_flat(JsGraphics *gfx, int x, int y, int count, const JsGraphicsBlitSource *src) {
+  unsigned int bpp = gfx->data.bpp;
+  if (!(gfx->data.flags & (JSGRAPHICSFLAGS_ARRAYBUFFER_ZIGZAG|JSGRAPHICSFLAGS_ARRAYBUFFER_VERTICAL_BYTE|JSGRAPHICSFLAGS_ARRAYBUFFER_INTERLEAVEX))) {
+    unsigned char *ptr = (unsigned char*)gfx->backendData;
+    unsigned int idx = (unsigned int)((x + y*gfx->data.width)*(int)bpp);
+    unsigned int bit = src->bitOffset;
+    // If the image is in the same format as us we can just copy it
+    bool sameFormat = src->bpp==bpp && src->transparentCol==0xFFFFFFFF &&
+        (bpp==8 || (bpp<8 && (gfx->data.flags & JSGRAPHICSFLAGS_ARRAYBUFFER_MSB)));
+    if (sameFormat && src->palette) { // the palette may not actually change anything (eg. 1bpp with fg=1, bg=0)
+      unsigned int mask = (1U<<bpp)-1;
+      for (unsigned int c=0;c<=src->paletteMask && c<=mask;c++)
+        if ((src->palette[c]&mask)!=c) sameFormat = false;
+    }
+    if (sameFormat && !(idx&7) && !(bit&7)) {
+      unsigned int bytes = ((unsigned int)count*bpp)>>3;
+      memcpy(&ptr[idx>>3], &src->data[bit>>3], bytes);
+      // any leftover pixels that don't fill a byte are done below
+      unsigned int done = (bytes<<3)/bpp;
+      if ((int)done==count) return;
+      JsGraphicsBlitSource rest = *src;
+      rest.bitOffset = bit + done*bpp;
+      graphicsFallbackBlit(gfx, x+(int)done, y, count-(int)done, &rest);
+      return;
+    }
+    if (bpp==8 || bpp==16) { // convert pixel by pixel, with a lookup if there's a palette
+      ptr += idx>>3;
+      for (int i=0;i<count;i++) {
+        unsigned int col = graphicsBlitGetPixel(src, bit);
+        bit += src->bpp;
+        if (col!=src->transparentCol) {
+          if (src->palette) col = src->palette[col&src->paletteMask];
+          ptr[0] = (unsigned char)col;
+          if (bpp==16) ptr[1] = (unsigned char)(col>>8);
+        }
+        ptr += bpp>>3;
+      }
+      return;
+    }
+  }
+  graphicsFallbackBlit(gfx, x, y, count, src);
+}
 #endif // GRAPHICS_ARRAYBUFFER_OPTIMISATIONS
 
 void lcdInit_ArrayBuffer(JsGraphics *gfx) {
@@ -226,18 +270,20 @@ void lcdInit_ArrayBuffer(JsGraphics *gfx) {
 
 void lcdSetCallbacks_ArrayBuffer(JsGraphics *gfx) {
   JsVar *buf = jsvObjectGetChild(gfx->graphicsVar, "buffer", 0);
-#ifndef GRAPHICS_ARRAYBUFFER_OPTIMISATIONS
+#ifdef GRAPHICS_ARRAYBUFFER_OPTIMISATIONS
   size_t len = 0;
   char *dataPtr = jsvGetDataPointer(buf, &len);
 #endif
   jsvUnLock(buf);
-#ifndef GRAPHICS_ARRAYBUFFER_OPTIMISATIONS
+#ifdef GRAPHICS_ARRAYBUFFER_OPTIMISATIONS
   if (dataPtr && len>=graphicsGetMemoryRequired(gfx)) {
     // nice fast mode
     gfx->backendData = dataPtr;
     gfx->setPixel = lcdSetPixel_ArrayBuffer_flat;
     gfx->getPixel = lcdGetPixel_ArrayBuffer_flat;
     gfx->fillRect = lcdFillRect_ArrayBuffer_flat;
+    gfx->setPixels = lcdSetPixels_ArrayBuffer_flat;
+    gfx->blit = lcdBlit_ArrayBuffer_flat;
 #else
   if (false) {
 #endif
@@ -248,5 +294,6 @@ void lcdSetCallbacks_ArrayBuffer(JsGraphics *gfx) {
     gfx->setPixel = lcdSetPixel_ArrayBuffer;
     gfx->getPixel = lcdGetPixel_ArrayBuffer;
     gfx->fillRect = lcdFillRect_ArrayBuffer;
+    gfx->setPixels = lcdSetPixels_ArrayBuffer;
   }
 }
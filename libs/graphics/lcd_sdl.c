@@ -21,7 +21,9 @@
 #define DEPTH 32
 
 SDL_Surface *screen = 0;
-bool needsFlip = false;
+// Areas of the screen that have changed since we last updated the window
+JsGraphicsClipRect dirtyRects[GRAPHICS_DIRTY_RECTS];
+unsigned char dirtyRectCount = 0;
 
 uint32_t palette_web[256] = {
     0x000000,0x000033,0x000066,0x000099,0x0000cc,0x0000ff,0x003300,0x003333,0x003366,0x003399,0x0033cc,
@@ -71,7 +73,7 @@ void lcdSetPixel_SDL(JsGraphics *gfx, int x, int y, unsigned int col) {
   unsigned int *pixmem32 = ((unsigned int*)screen->pixels) + y*gfx->data.width + x;
   *pixmem32 = col;
   if(SDL_MUSTLOCK(screen)) SDL_UnlockSurface(screen);
-  needsFlip = true;
+  graphicsAddDirtyRect(dirtyRects, &dirtyRectCount, x, y, x, y);
 }
 
 void lcdInit_SDL(JsGraphics *gfx) {
@@ -88,10 +90,13 @@ void lcdInit_SDL(JsGraphics *gfx) {
 }
 
 void lcdIdle_SDL() {
-  if (needsFlip) {
-    needsFlip = false;
-    SDL_Flip(screen);
+  // Only copy the areas that have changed to the window
+  int i;
+  for (i=0;i<dirtyRectCount;i++) {
+    JsGraphicsClipRect *r = &dirtyRects[i];
+    SDL_UpdateRect(screen, r->x1, r->y1, r->x2+1-r->x1, r->y2+1-r->y1);
   }
+  dirtyRectCount = 0;
 }
 
 void lcdSetCallbacks_SDL(JsGraphics *gfx) {
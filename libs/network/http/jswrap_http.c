@@ -407,6 +407,39 @@ JsVar *jswrap_http_get(JsVar *options, JsVar *callback) {
   return cliReq;
 }
 
+/*JSON{
+  "type" : "staticmethod",
+  "class" : "http",
+  "name" : "setKeepAlive",
+  "generate" : "jswrap_http_setKeepAlive",
+  "params" : [
+    ["options","JsVar","`false` to disable keep-alive (the default), or an object `{ maxSockets : int=2, timeout : int=5000 }`"]
+  ]
+}
+Enable or disable HTTP persistent connections ('keep-alive').
+
+When enabled, `http.request` and `http.get` ask the server to keep the connection
+open, and once the response has been received the socket is kept in a pool so
+it can be used for the next request to the same host and port - saving the time
+taken to open a new connection. Up to `maxSockets` idle sockets are kept for
+each host, and they are closed if they're not used within `timeout` milliseconds.
+
+HTTP servers also keep connections open if the client asks (as browsers do),
+closing them if no new request arrives within `timeout` milliseconds. Responses
+that don't have a `Content-Length` header are then sent with `Transfer-Encoding: chunked`
+so the client knows where they end.
+
+```
+require("http").setKeepAlive({ maxSockets : 1, timeout : 10000 });
+setInterval(function() {
+  require("http").get("http://192.168.1.10/status", function(res) { ... });
+}, 1000);
+```
+*/
+void jswrap_http_setKeepAlive(JsVar *options) {
+  httpSetKeepAlive(options);
+}
+
 // ---------------------------------------------------------------------------------
 // ---------------------------------------------------------------------------------
 // ---------------------------------------------------------------------------------
@@ -466,15 +499,14 @@ The default contents are:
   "params" : [
     ["data","JsVar","A string containing data to send"]
   ],
-  "return" : ["bool","For node.js compatibility, returns the boolean false. When the send buffer is empty, a `drain` event will be sent"]
+  "return" : ["bool","`false` if there is so much data waiting to be sent that you should wait for the `drain` event before writing more, or `true` otherwise (as in node.js). When the send buffer is empty, a `drain` event will be sent"]
 }
 This function writes the `data` argument as a string. Data that is passed in
 (including arrays) will be converted to a string with the normal JavaScript 
 `toString` method. For more information about sending binary data see `Socket.write`
 */
 bool jswrap_httpSRs_write(JsVar *parent, JsVar *data) {
-  serverResponseWrite(parent, data);
-  return false;
+  return serverResponseWrite(parent, data);
 }
 
 /*JSON{
@@ -545,7 +577,7 @@ void jswrap_httpSRs_setHeader(JsVar *parent, JsVar *name, JsVar *value) {
   "params" : [
     ["data","JsVar","A string containing data to send"]
   ],
-  "return" : ["bool","For node.js compatibility, returns the boolean false. When the send buffer is empty, a `drain` event will be sent"]
+  "return" : ["bool","`false` if there is so much data waiting to be sent that you should wait for the `drain` event before writing more, or `true` otherwise (as in node.js). When the send buffer is empty, a `drain` event will be sent"]
 }
 This function writes the `data` argument as a string. Data that is passed in
 (including arrays) will be converted to a string with the normal JavaScript 
@@ -17,6 +17,7 @@ JsVar *jswrap_http_createServer(JsVar *callback);
 
 JsVar *jswrap_http_request(JsVar *options, JsVar *callback);
 JsVar *jswrap_http_get(JsVar *options, JsVar *callback);
+void jswrap_http_setKeepAlive(JsVar *options);
 
 // for HTTP
 void jswrap_httpSRs_setHeader(JsVar *parent, JsVar *name, JsVar *value);
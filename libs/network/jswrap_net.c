@@ -19,6 +19,9 @@
 #include "jsparse.h"
 #include "socketserver.h"
 #include "network.h"
+#if defined(LINUX)
+#include "network_linux.h"
+#endif
 
 /*JSON{
   "type" : "idle",
@@ -29,6 +32,12 @@ bool jswrap_net_idle() {
   if (!networkGetFromVar(&net)) return false;
   net.idle(&net);
   bool b = socketIdle(&net);
+#if defined(LINUX)
+  /* Linux sockets can wake us up from jshSleep, so we only need to say we're
+   * busy (and stop the device sleeping) if something actually happened */
+  if (b && net.data.type==JSNETWORKTYPE_SOCKET)
+    b = net_linux_had_activity();
+#endif
   networkFree(&net);
   return b;
 }
@@ -712,7 +721,7 @@ void jswrap_net_server_close(JsVar *parent) {
   "params" : [
     ["data","JsVar","A string containing data to send"]
   ],
-  "return" : ["bool","For node.js compatibility, returns the boolean false. When the send buffer is empty, a `drain` event will be sent"]
+  "return" : ["bool","`false` if there is so much data waiting to be sent that you should wait for the `drain` event before writing more, or `true` otherwise (as in node.js). When the send buffer is empty, a `drain` event will be sent"]
 }
 This function writes the `data` argument as a string. Data that is passed in
 (including arrays) will be converted to a string with the normal JavaScript 
@@ -740,9 +749,9 @@ socket.write(E.toString(d.buffer))
 bool jswrap_net_socket_write(JsVar *parent, JsVar *data) {
   JsNetwork net;
   if (!networkGetFromVarIfOnline(&net)) return false;
-  clientRequestWrite(&net, parent, data, NULL, 0);
+  bool canWriteMore = clientRequestWrite(&net, parent, data, NULL, 0);
   networkFree(&net);
-  return false;
+  return canWriteMore;
 }
 
 /*JSON{
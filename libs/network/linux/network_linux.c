@@ -42,6 +42,12 @@
 
 #define closesocket(SOCK) close(SOCK)
 
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+#define NET_LINUX_EPOLL
+#include <sys/epoll.h>
+#include <stdlib.h>
+#endif
+
 #if NET_DBG > 0
  #include "jsinteractive.h"
  #define DBG(format, ...) jsiConsolePrintf(format, ## __VA_ARGS__)
@@ -50,6 +56,110 @@
 #endif
 
 
+#ifdef NET_LINUX_EPOLL
+/* All sockets are non-blocking and registered (edge-triggered) with one epoll
+ * instance. net_linux_poll collects readiness for every socket with a single
+ * syscall and stores it in netReady[socket], and each flag stays set until a
+ * call on that socket returns EAGAIN. This means we don't have to call select()
+ * on each socket every time around the idle loop, and jshSleep can wait for I/O. */
+#define NET_READY_READ  1
+#define NET_READY_WRITE 2
+
+static int netEpollFd = -1;
+static unsigned char *netReady = 0; ///< readiness flags, indexed by socket
+static int netReadySize = 0;
+static int netSocketCount = 0;
+static bool netHadActivity = false; ///< Did anything happen since the last net_linux_idle?
+
+/// Add a socket to our epoll instance, and make it non-blocking
+static void net_linux_register(int sckt) {
+  int flags = fcntl(sckt, F_GETFL, 0);
+  if (flags>=0) fcntl(sckt, F_SETFL, flags | O_NONBLOCK);
+  if (netEpollFd<0) {
+    netEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (netEpollFd<0) return; // we'll just try calling recv/send on every socket
+  }
+  if (sckt >= netReadySize) {
+    int newSize = sckt+32;
+    unsigned char *newReady = (unsigned char*)realloc(netReady, (size_t)newSize);
+    if (!newReady) return;
+    memset(&newReady[netReadySize], 0, (size_t)(newSize-netReadySize));
+    netReady = newReady;
+    netReadySize = newSize;
+  }
+  netReady[sckt] = 0;
+  struct epoll_event evt;
+  evt.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  evt.data.fd = sckt;
+  if (epoll_ctl(netEpollFd, EPOLL_CTL_ADD, sckt, &evt)==0)
+    netSocketCount++;
+}
+
+/// Remove a socket from our epoll instance
+static void net_linux_unregister(int sckt) {
+  if (netEpollFd<0) return;
+  if (epoll_ctl(netEpollFd, EPOLL_CTL_DEL, sckt, 0)==0)
+    netSocketCount--;
+  if (sckt < netReadySize) netReady[sckt] = 0;
+}
+
+/// Has epoll said that this socket is ready for the given operation?
+static bool net_linux_isready(int sckt, unsigned char flag) {
+  if (netEpollFd<0 || sckt<0 || sckt>=netReadySize) return true; // not tracked, just try
+  return (netReady[sckt] & flag)!=0;
+}
+
+/// The last call on this socket would have blocked - wait for epoll to tell us it's ready again
+static void net_linux_notready(int sckt, unsigned char flag) {
+  if (sckt>=0 && sckt<netReadySize) netReady[sckt] &= (unsigned char)~flag;
+}
+
+/// Collect readiness for all sockets, waiting up to timeoutMs. Returns true if anything became ready
+static bool net_linux_poll(int timeoutMs) {
+  struct epoll_event evts[64];
+  bool ready = false;
+  int n;
+  do {
+    n = epoll_wait(netEpollFd, evts, sizeof(evts)/sizeof(evts[0]), timeoutMs);
+    int i;
+    for (i=0;i<n;i++) {
+      int sckt = evts[i].data.fd;
+      if (sckt<0 || sckt>=netReadySize) continue;
+      // errors and hangups are reported by recv, so just flag them as readable
+      if (evts[i].events & (EPOLLIN|EPOLLRDHUP|EPOLLHUP|EPOLLERR))
+        netReady[sckt] |= NET_READY_READ;
+      if (evts[i].events & (EPOLLOUT|EPOLLERR))
+        netReady[sckt] |= NET_READY_WRITE;
+      ready = true;
+    }
+    timeoutMs = 0; // only wait the first time
+  } while (n == (int)(sizeof(evts)/sizeof(evts[0])));
+  return ready;
+}
+#endif
+
+/** Wait for up to timeoutMs for one of our sockets to become ready. Returns
+ * false if there are no sockets to wait for (so the caller should sleep instead) */
+bool net_linux_wait(int timeoutMs) {
+#ifdef NET_LINUX_EPOLL
+  if (netEpollFd<0 || !netSocketCount) return false;
+  net_linux_poll(timeoutMs);
+  return true;
+#else
+  NOT_USED(timeoutMs);
+  return false;
+#endif
+}
+
+/** Did we send or receive anything (or open/close a socket) since the last
+ * idle? If not there's no need to keep polling, as jshSleep can wake on I/O */
+bool net_linux_had_activity() {
+#ifdef NET_LINUX_EPOLL
+  if (netEpollFd>=0) return netHadActivity;
+#endif
+  return true;
+}
+
 /// Get an IP address from a name. Sets out_ip_addr to 0 on failure
 void net_linux_gethostbyname(JsNetwork *net, char * hostName, uint32_t* out_ip_addr) {
   NOT_USED(net);
@@ -61,6 +171,11 @@ void net_linux_gethostbyname(JsNetwork *net, char * hostName, uint32_t* out_ip_a
 /// Called on idle. Do any checks required for this device
 void net_linux_idle(JsNetwork *net) {
   NOT_USED(net);
+#ifdef NET_LINUX_EPOLL
+  netHadActivity = false;
+  if (netEpollFd>=0 && netSocketCount)
+    net_linux_poll(0);
+#endif
 }
 
 /// Call just before returning to idle loop. This checks for errors and tries to recover. Returns true if no errors.
@@ -89,6 +204,9 @@ int net_linux_createsocket(JsNetwork *net, SocketType socketType, uint32_t host,
     u_long n = 1;
     ioctlsocket(sckt,FIONBIO,&n);
     #endif
+    #ifdef NET_LINUX_EPOLL
+    net_linux_register(sckt);
+    #endif
 
     if (scktType == SOCK_DGRAM) { // only for UDP
       // set broadcast
@@ -112,6 +230,9 @@ int net_linux_createsocket(JsNetwork *net, SocketType socketType, uint32_t host,
        if (err != EINPROGRESS &&
            err != EWOULDBLOCK) {
          jsError("Connect failed (err %d)", err);
+         #ifdef NET_LINUX_EPOLL
+         net_linux_unregister(sckt);
+         #endif
          closesocket(sckt);
          return -1;
        }
@@ -174,11 +295,18 @@ int net_linux_createsocket(JsNetwork *net, SocketType socketType, uint32_t host,
         setsockopt (sckt, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
     }
 
+#ifdef NET_LINUX_EPOLL
+    net_linux_register(sckt);
+#endif
+
     if (scktType == SOCK_STREAM) { // only for TCP
       // Make the socket listen
       nret = listen(sckt, 10); // 10 connections (but this ignored on CC30000)
       if (nret == SOCKET_ERROR) {
         jsError("Socket listen failed");
+#ifdef NET_LINUX_EPOLL
+        net_linux_unregister(sckt);
+#endif
         closesocket(sckt);
         return -1;
       }
@@ -205,9 +333,91 @@ int net_linux_createsocket(JsNetwork *net, SocketType socketType, uint32_t host,
 /// destroys the given socket
 void net_linux_closesocket(JsNetwork *net, int sckt) {
   NOT_USED(net);
+#ifdef NET_LINUX_EPOLL
+  net_linux_unregister(sckt);
+  netHadActivity = true;
+#endif
   closesocket(sckt);
 }
 
+#ifdef NET_LINUX_EPOLL
+/// If the given server socket can accept a connection, return it (or return < 0)
+int net_linux_accept(JsNetwork *net, int sckt) {
+  NOT_USED(net);
+  if (!net_linux_isready(sckt, NET_READY_READ)) return -1;
+  int theClient = accept(sckt,0,0);
+  if (theClient<0) {
+    if (errno==EAGAIN || errno==EWOULDBLOCK)
+      net_linux_notready(sckt, NET_READY_READ);
+    return -1;
+  }
+  net_linux_register(theClient);
+  netHadActivity = true;
+  return theClient;
+}
+
+/// Receive data if possible. returns nBytes on success, 0 on no data, or -1 on failure
+int net_linux_recv(JsNetwork *net, SocketType socketType, int sckt, void *buf, size_t len) {
+  NOT_USED(net);
+  if (!net_linux_isready(sckt, NET_READY_READ)) return 0;
+  struct sockaddr_in fromAddr;
+  int fromAddrLen = sizeof(fromAddr);
+  int num;
+  if (socketType & ST_UDP) {
+    JsNetUDPPacketHeader *header = (JsNetUDPPacketHeader*)buf;
+    num = (int)recvfrom(sckt,buf+sizeof(JsNetUDPPacketHeader),len-sizeof(JsNetUDPPacketHeader),0,(struct sockaddr *)&fromAddr,(socklen_t*)&fromAddrLen);
+    if (num>0) {
+      *(in_addr_t*)&header->host = fromAddr.sin_addr.s_addr;
+      header->port = ntohs(fromAddr.sin_port);
+      header->length = (uint16_t)num;
+      DBG("Recv %d %x:%d", num, *(uint32_t*)&header->host, header->port);
+    }
+  } else {
+    num = (int)recv(sckt,buf,len,0);
+  }
+  if (num<0) {
+    if (errno==EAGAIN || errno==EWOULDBLOCK) {
+      net_linux_notready(sckt, NET_READY_READ);
+      return 0; // no data
+    }
+    return -1; // we probably disconnected
+  }
+  netHadActivity = true;
+  if (num==0) return -1; // epoll says data, but recv says 0 means connection is closed
+  if (socketType & ST_UDP) num += (int)sizeof(JsNetUDPPacketHeader);
+  return num;
+}
+
+/// Send data if possible. returns nBytes on success, 0 on no data, or -1 on failure
+int net_linux_send(JsNetwork *net, SocketType socketType, int sckt, const void *buf, size_t len) {
+  NOT_USED(net);
+  if (!net_linux_isready(sckt, NET_READY_WRITE)) return 0; // just not ready
+  int flags = 0;
+#if !defined(SO_NOSIGPIPE) && defined(MSG_NOSIGNAL)
+  flags |= MSG_NOSIGNAL;
+#endif
+  int n;
+  if (socketType & ST_UDP) {
+    JsNetUDPPacketHeader *header = (JsNetUDPPacketHeader*)buf;
+    sockaddr_in sin;
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = *(in_addr_t*)&header->host;
+    sin.sin_port = htons(header->port);
+
+    DBG("Send %d %x:%d", len - sizeof(JsNetUDPPacketHeader), header->host, header->port);
+    n = (int)sendto(sckt, buf + sizeof(JsNetUDPPacketHeader), header->length, flags, (struct sockaddr *)&sin, sizeof(sockaddr_in));
+    if (n>=0) n += (int)sizeof(JsNetUDPPacketHeader);
+  } else {
+    n = (int)send(sckt, buf, len, flags);
+  }
+  if (n<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) {
+    net_linux_notready(sckt, NET_READY_WRITE);
+    return 0; // just not ready
+  }
+  netHadActivity = true;
+  return n;
+}
+#else
 /// If the given server socket can accept a connection, return it (or return < 0)
 int net_linux_accept(JsNetwork *net, int sckt) {
   NOT_USED(net);
@@ -301,6 +511,7 @@ int net_linux_send(JsNetwork *net, SocketType socketType, int sckt, const void *
   } else
     return 0; // just not ready
 }
+#endif // NET_LINUX_EPOLL
 
 void netSetCallbacks_linux(JsNetwork *net) {
   net->idle = net_linux_idle;
@@ -14,3 +14,10 @@
 #include "network.h"
 
 void netSetCallbacks_linux(JsNetwork *net);
+
+/** Wait for up to timeoutMs for one of our sockets to become ready. Returns
+ * false if there are no sockets to wait for (so the caller should sleep instead) */
+bool net_linux_wait(int timeoutMs);
+/** Did we send or receive anything (or open/close a socket) since the last
+ * idle? If not there's no need to keep polling, as jshSleep can wake on I/O */
+bool net_linux_had_activity();
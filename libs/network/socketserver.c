@@ -29,6 +29,8 @@
 #define HTTP_NAME_RECEIVE_DATA "dRcv"
 #define HTTP_NAME_RECEIVE_COUNT "cRcv"
 #define HTTP_NAME_SEND_DATA "dSnd"
+#define HTTP_NAME_SEND_OFFSET "oSnd" // how much of dSnd has already been sent
+#define HTTP_NAME_HEADER_SCAN "hScn" // how far through dRcv we've looked for the end of the headers
 #define HTTP_NAME_RESPONSE_VAR "res"
 #define HTTP_NAME_OPTIONS_VAR "opt"
 #define HTTP_NAME_SERVER_VAR "svr"
@@ -37,6 +39,9 @@
 #define HTTP_NAME_CLOSENOW "clsNow"  // boolean: gotta close
 #define HTTP_NAME_CONNECTED "conn"     // boolean: we are connected
 #define HTTP_NAME_CLOSE "cls"        // close after sending
+#define HTTP_NAME_KEEP_ALIVE "ka"    // boolean: keep the socket open for another request after this one
+#define HTTP_NAME_POOL_KEY "pKey"    // client: which sockets in the pool this connection could use
+#define HTTP_NAME_IDLE_SINCE "tIdl"  // time a kept-alive socket became idle
 #define HTTP_NAME_ON_CONNECT JS_EVENT_PREFIX"connect"
 #define HTTP_NAME_ON_CLOSE JS_EVENT_PREFIX"close"
 #define HTTP_NAME_ON_END JS_EVENT_PREFIX"end"
@@ -48,6 +53,13 @@
 #define HTTP_ARRAY_HTTP_CLIENT_CONNECTIONS "HttpCC"
 #define HTTP_ARRAY_HTTP_SERVERS "HttpS"
 #define HTTP_ARRAY_HTTP_SERVER_CONNECTIONS "HttpSC"
+#define HTTP_ARRAY_HTTP_CLIENT_POOL "HttpCP" // idle kept-alive client sockets
+#define HTTP_KEEP_ALIVE_OPTIONS "HttpKA" // settings from http.setKeepAlive
+
+// If there's more than this waiting to be sent, 'write' returns false and the writer should wait for 'drain'
+#define SOCKET_SEND_HIGH_WATER 1024
+// If there's more than this received but not yet handled, stop receiving until it has been
+#define SOCKET_RECEIVE_HIGH_WATER STREAM_MAX_BUFFER_SIZE
 
 #ifdef ESP8266
 // esp8266 debugging, need to remove this eventually
@@ -93,12 +105,14 @@ static void httpAppendHeaders(JsVar *string, JsVar *headerObject) {
 // httpParseHeaders(&receiveData, reqVar, true) // server
 // httpParseHeaders(&receiveData, resVar, false) // client
 bool httpParseHeaders(JsVar **receiveData, JsVar *objectForData, bool isServer) {
-  // find /r/n/r/n
+  /* find /r/n/r/n - headers may arrive over several packets, so start from
+   * where we got to last time (less 3 in case /r/n/r/n spans packets) */
   int newlineIdx = 0;
-  int strIdx = 0;
+  int strIdx = (int)jsvGetIntegerAndUnLock(jsvObjectGetChild(objectForData, HTTP_NAME_HEADER_SCAN, 0)) - 3;
+  if (strIdx<0) strIdx = 0;
   int headerEnd = -1;
   JsvStringIterator it;
-  jsvStringIteratorNew(&it, *receiveData, 0);
+  jsvStringIteratorNew(&it, *receiveData, (size_t)strIdx);
   while (jsvStringIteratorHasChar(&it)) {
     char ch = jsvStringIteratorGetChar(&it);
     if (ch == '\r') {
@@ -116,7 +130,11 @@ bool httpParseHeaders(JsVar **receiveData, JsVar *objectForData, bool isServer)
   }
   jsvStringIteratorFree(&it);
   // skip if we have no header
-  if (headerEnd<0) return false;
+  if (headerEnd<0) {
+    jsvObjectSetChildAndUnLock(objectForData, HTTP_NAME_HEADER_SCAN, jsvNewFromInteger(strIdx));
+    return false;
+  }
+  jsvObjectRemoveChild(objectForData, HTTP_NAME_HEADER_SCAN);
   // Now parse the header
   JsVar *vHeaders = jsvNewObject();
   if (!vHeaders) return true;
@@ -177,6 +195,8 @@ bool httpParseHeaders(JsVar **receiveData, JsVar *objectForData, bool isServer)
   if (isServer) {
     jsvObjectSetChildAndUnLock(objectForData, "method", jsvNewFromStringVar(*receiveData, 0, (size_t)firstSpace));
     jsvObjectSetChildAndUnLock(objectForData, "url", jsvNewFromStringVar(*receiveData, (size_t)(firstSpace+1), (size_t)(secondSpace-(firstSpace+1))));
+    if (firstEOL > secondSpace+6) // skip 'HTTP/'
+      jsvObjectSetChildAndUnLock(objectForData, "httpVersion", jsvNewFromStringVar(*receiveData, (size_t)(secondSpace+6), (size_t)(firstEOL-(secondSpace+6))));
   } else {
     jsvObjectSetChildAndUnLock(objectForData, "httpVersion", jsvNewFromStringVar(*receiveData, 5, (size_t)firstSpace-5));
     jsvObjectSetChildAndUnLock(objectForData, "statusCode", jsvNewFromStringVar(*receiveData, (size_t)(firstSpace+1), (size_t)(secondSpace-(firstSpace+1))));
@@ -189,10 +209,10 @@ bool httpParseHeaders(JsVar **receiveData, JsVar *objectForData, bool isServer)
   return true;
 }
 
-size_t httpStringGet(JsVar *v, char *str, size_t len) {
+size_t httpStringGet(JsVar *v, size_t offset, char *str, size_t len) {
   size_t l = len;
   JsvStringIterator it;
-  jsvStringIteratorNew(&it, v, 0);
+  jsvStringIteratorNew(&it, v, offset);
   while (jsvStringIteratorHasChar(&it)) {
     if (l--==0) {
       jsvStringIteratorFree(&it);
@@ -238,6 +258,163 @@ bool _socketConnectionOpen(JsVar *connection) {
 
 // -----------------------------
 
+/// Get a setting from http.setKeepAlive, or 0 if keep-alive is disabled
+static JsVarInt httpKeepAliveGet(const char *name) {
+  JsVar *options = jsvObjectGetChild(execInfo.hiddenRoot, HTTP_KEEP_ALIVE_OPTIONS, 0);
+  if (!options) return 0;
+  JsVarInt v = jsvGetIntegerAndUnLock(jsvObjectGetChild(options, name, 0));
+  jsvUnLock(options);
+  return v;
+}
+
+void httpSetKeepAlive(JsVar *options) {
+  if (!jsvGetBool(options)) {
+    jsvObjectRemoveChild(execInfo.hiddenRoot, HTTP_KEEP_ALIVE_OPTIONS);
+    return;
+  }
+  JsVarInt maxSockets = 2;
+  JsVarInt timeout = 5000;
+  if (jsvIsObject(options)) {
+    JsVar *v = jsvObjectGetChild(options, "maxSockets", 0);
+    if (jsvIsNumeric(v)) maxSockets = jsvGetInteger(v);
+    jsvUnLock(v);
+    v = jsvObjectGetChild(options, "timeout", 0);
+    if (jsvIsNumeric(v)) timeout = jsvGetInteger(v);
+    jsvUnLock(v);
+  }
+  JsVar *ka = jsvNewObject();
+  if (!ka) return; // out of memory
+  jsvObjectSetChildAndUnLock(ka, "max", jsvNewFromInteger(maxSockets));
+  jsvObjectSetChildAndUnLock(ka, "timeout", jsvNewFromInteger(timeout));
+  jsvObjectSetChildAndUnLock(execInfo.hiddenRoot, HTTP_KEEP_ALIVE_OPTIONS, ka);
+}
+
+/// Mark a kept-alive socket as idle from now
+static void httpKeepAliveSetIdle(JsVar *var) {
+  jsvObjectSetChildAndUnLock(var, HTTP_NAME_IDLE_SINCE, jsvNewFromFloat(jshGetMillisecondsFromTime(jshGetSystemTime())));
+}
+
+/// Has a kept-alive socket been idle for longer than the keep-alive timeout?
+static bool httpKeepAliveTimedOut(JsVar *var) {
+  JsVar *idleSince = jsvObjectGetChild(var, HTTP_NAME_IDLE_SINCE, 0);
+  if (!idleSince) return false;
+  JsVarFloat idleTime = jshGetMillisecondsFromTime(jshGetSystemTime()) - jsvGetFloatAndUnLock(idleSince);
+  return idleTime > (JsVarFloat)httpKeepAliveGet("timeout");
+}
+
+/// Having parsed the headers in 'reader', do they allow us to keep the connection open afterwards?
+static bool httpHeadersAllowKeepAlive(JsVar *reader, bool isServer) {
+  JsVar *headers = jsvObjectGetChild(reader, HTTP_NAME_HEADERS, 0);
+  JsVar *connection = jsvObjectGetChildI(headers, "Connection");
+  bool keepAlive;
+  if (connection) // HTTP/1.0 has to ask explicitly
+    keepAlive = jsvIsStringIEqualAndUnLock(connection, "keep-alive");
+  else // HTTP/1.1 is persistent unless told otherwise
+    keepAlive = jsvIsStringIEqualAndUnLock(jsvObjectGetChild(reader, "httpVersion", 0), "1.1");
+  // A response with no length and no chunks is ended by closing the connection
+  if (!isServer && !jsvGetBoolAndUnLock(jsvObjectGetChild(reader, HTTP_NAME_CHUNKED, 0))) {
+    JsVar *contentLength = jsvObjectGetChildI(headers, "Content-Length");
+    if (!contentLength) keepAlive = false;
+    jsvUnLock(contentLength);
+  }
+  jsvUnLock(headers);
+  return keepAlive;
+}
+
+/// Take an idle socket to the host described by 'key' out of the client pool, or return -1
+static int socketPoolTake(JsVar *key) {
+  JsVar *pool = socketGetArray(HTTP_ARRAY_HTTP_CLIENT_POOL, false);
+  if (!pool) return -1;
+  int sckt = -1;
+  JsVar *entryName = 0;
+  JsvObjectIterator it;
+  jsvObjectIteratorNew(&it, pool);
+  while (!entryName && jsvObjectIteratorHasValue(&it)) {
+    JsVar *entry = jsvObjectIteratorGetValue(&it);
+    JsVar *entryKey = jsvObjectGetChild(entry, HTTP_NAME_POOL_KEY, 0);
+    if (jsvIsBasicVarEqual(entryKey, key)) {
+      sckt = (int)jsvGetIntegerAndUnLock(jsvObjectGetChild(entry,HTTP_NAME_SOCKET,0))-1;
+      entryName = jsvObjectIteratorGetKey(&it);
+    }
+    jsvUnLock2(entryKey, entry);
+    jsvObjectIteratorNext(&it);
+  }
+  jsvObjectIteratorFree(&it);
+  if (entryName) {
+    jsvRemoveChild(pool, entryName);
+    jsvUnLock(entryName);
+  }
+  jsvUnLock(pool);
+  return sckt;
+}
+
+/** Put this client connection's socket in the pool rather than closing it, if
+ * there's space. Returns true if it was added (and removed from the connection) */
+static bool socketPoolAdd(JsVar *connection) {
+  JsVar *key = jsvObjectGetChild(connection, HTTP_NAME_POOL_KEY, 0);
+  JsVar *pool = socketGetArray(HTTP_ARRAY_HTTP_CLIENT_POOL, true);
+  if (!key || !pool) {
+    jsvUnLock2(key, pool);
+    return false;
+  }
+  // how many sockets to this host do we have already?
+  JsVarInt count = 0;
+  JsvObjectIterator it;
+  jsvObjectIteratorNew(&it, pool);
+  while (jsvObjectIteratorHasValue(&it)) {
+    JsVar *entry = jsvObjectIteratorGetValue(&it);
+    JsVar *entryKey = jsvObjectGetChild(entry, HTTP_NAME_POOL_KEY, 0);
+    if (jsvIsBasicVarEqual(entryKey, key)) count++;
+    jsvUnLock2(entryKey, entry);
+    jsvObjectIteratorNext(&it);
+  }
+  jsvObjectIteratorFree(&it);
+  JsVar *entry = 0;
+  if (count < httpKeepAliveGet("max"))
+    entry = jsvNewObject();
+  if (entry) {
+    jsvObjectSetChildAndUnLock(entry, HTTP_NAME_SOCKET, jsvObjectGetChild(connection, HTTP_NAME_SOCKET, 0));
+    socketSetType(entry, socketGetType(connection));
+    jsvObjectSetChild(entry, HTTP_NAME_POOL_KEY, key);
+    httpKeepAliveSetIdle(entry);
+    jsvArrayPush(pool, entry);
+    jsvObjectRemoveChild(connection, HTTP_NAME_SOCKET); // so it doesn't get closed
+  }
+  jsvUnLock3(key, pool, entry);
+  return entry!=0;
+}
+
+/// Close any idle sockets in the client pool that have timed out or been closed by the other end
+static bool socketPoolIdle(JsNetwork *net, char *buf) {
+  JsVar *pool = socketGetArray(HTTP_ARRAY_HTTP_CLIENT_POOL, false);
+  if (!pool) return false;
+  bool hadSockets = false;
+  JsvObjectIterator it;
+  jsvObjectIteratorNew(&it, pool);
+  while (jsvObjectIteratorHasValue(&it)) {
+    hadSockets = true;
+    JsVar *entry = jsvObjectIteratorGetValue(&it);
+    int sckt = (int)jsvGetIntegerAndUnLock(jsvObjectGetChild(entry,HTTP_NAME_SOCKET,0))-1;
+    // we're not expecting anything, so anything received (or an error) means we can't use it
+    bool closeNow = httpKeepAliveTimedOut(entry) ||
+                    netRecv(net, socketGetType(entry), sckt, buf, (size_t)net->chunkSize)!=0;
+    if (closeNow) {
+      _socketConnectionKill(net, entry);
+      JsVar *entryName = jsvObjectIteratorGetKey(&it);
+      jsvObjectIteratorNext(&it);
+      jsvRemoveChild(pool, entryName);
+      jsvUnLock(entryName);
+    } else
+      jsvObjectIteratorNext(&it);
+    jsvUnLock(entry);
+  }
+  jsvObjectIteratorFree(&it);
+  jsvUnLock(pool);
+  return hadSockets;
+}
+
+// -----------------------------
+
 NO_INLINE static void _socketCloseAllConnectionsFor(JsNetwork *net, char *name) {
   JsVar *arr = socketGetArray(name, false);
   if (!arr) return;
@@ -258,18 +435,49 @@ NO_INLINE static void _socketCloseAllConnections(JsNetwork *net) {
   // shut down connections
   _socketCloseAllConnectionsFor(net, HTTP_ARRAY_HTTP_SERVER_CONNECTIONS);
   _socketCloseAllConnectionsFor(net, HTTP_ARRAY_HTTP_CLIENT_CONNECTIONS);
+  _socketCloseAllConnectionsFor(net, HTTP_ARRAY_HTTP_CLIENT_POOL);
   _socketCloseAllConnectionsFor(net, HTTP_ARRAY_HTTP_SERVERS);
 }
 
+/// How much of this connection's sendData has already been sent?
+static size_t socketGetSendOffset(JsVar *connection) {
+  return (size_t)jsvGetIntegerAndUnLock(jsvObjectGetChild(connection, HTTP_NAME_SEND_OFFSET, 0));
+}
+
+/** Remove data that has already been sent from the start of sendData, so more
+ * can be appended without it growing forever. Returns the new sendData (which
+ * may be the same) */
+static JsVar *socketCompactSendData(JsVar *connection, JsVar *sendData) {
+  size_t offset = socketGetSendOffset(connection);
+  // only bother if it'll at least halve the size, so we're not copying on every write
+  if (!offset || offset < jsvGetStringLength(sendData)-offset) return sendData;
+  JsVar *newSendData = jsvNewFromStringVar(sendData, offset, JSVAPPENDSTRINGVAR_MAXLENGTH);
+  if (!newSendData) return sendData; // out of memory - keep what we had
+  jsvObjectRemoveChild(connection, HTTP_NAME_SEND_OFFSET);
+  jsvObjectSetChild(connection, HTTP_NAME_SEND_DATA, newSendData);
+  jsvUnLock(sendData);
+  return newSendData;
+}
+
+/// Is there little enough data waiting to be sent that the writer can carry on writing?
+static bool socketCanWriteMore(JsVar *connection, JsVar *sendData) {
+  if (!sendData) return true;
+  return jsvGetStringLength(sendData) - socketGetSendOffset(connection) < SOCKET_SEND_HIGH_WATER;
+}
+
 // returns 0 on success and a (negative) error number on failure
 int socketSendData(JsNetwork *net, JsVar *connection, int sckt, JsVar **sendData) {
   SocketType socketType = socketGetType(connection);
 
   assert(!jsvIsEmptyString(*sendData));
 
+  /* Rather than cutting what was sent off the front of sendData each time (which
+   * copies all the data that is left), keep track of how far we have got */
+  size_t offset = socketGetSendOffset(connection);
+  size_t sendDataLen = jsvGetStringLength(*sendData);
   size_t sndBufLen;
   if ((socketType&ST_TYPE_MASK)==ST_UDP) {
-      sndBufLen = (size_t)jsvGetStringLength(*sendData);
+      sndBufLen = sendDataLen - offset;
       if (sndBufLen+1024 > jsuGetFreeStack()) {
           jsExceptionHere(JSET_ERROR, "Not enough free stack to send this amount of data");
           return -1;
@@ -279,16 +487,16 @@ int socketSendData(JsNetwork *net, JsVar *connection, int sckt, JsVar **sendData
   }
   char *buf = alloca(sndBufLen); // allocate on stack
 
-  size_t bufLen = httpStringGet(*sendData, buf, sndBufLen);
+  size_t bufLen = httpStringGet(*sendData, offset, buf, sndBufLen);
   int num = netSend(net, socketType, sckt, buf, bufLen);
   DBG("socketSendData %x:%d (%d -> %d)\n", *(uint32_t*)buf, *(unsigned short*)(buf+sizeof(uint32_t)), bufLen, num);
   if (num < 0) return num; // an error occurred
-  // Now cut what we managed to send off the beginning of sendData
+  // Now mark what we managed to send as sent
   if (num > 0) {
-    JsVar *newSendData = 0;
-    if (num < (int)jsvGetStringLength(*sendData)) {
-      // we didn't send all of it... cut out what we did send
-      newSendData = jsvNewFromStringVar(*sendData, (size_t)num, JSVAPPENDSTRINGVAR_MAXLENGTH);
+    offset += (size_t)num;
+    if (offset < sendDataLen) {
+      // we didn't send all of it... remember where we got to
+      jsvObjectSetChildAndUnLock(connection, HTTP_NAME_SEND_OFFSET, jsvNewFromInteger((JsVarInt)offset));
     } else {
       // we sent all of it! Issue a drain event, unless we want to close, then we shouldn't
       // callback for more data
@@ -296,15 +504,20 @@ int socketSendData(JsNetwork *net, JsVar *connection, int sckt, JsVar **sendData
       if (!wantClose) {
         jsiQueueObjectCallbacks(connection, HTTP_NAME_ON_DRAIN, &connection, 1);
       }
-      newSendData = jsvNewFromEmptyString();
+      jsvObjectRemoveChild(connection, HTTP_NAME_SEND_OFFSET);
+      jsvUnLock(*sendData);
+      *sendData = jsvNewFromEmptyString();
     }
-    jsvUnLock(*sendData);
-    *sendData = newSendData;
   }
 
   return 0;
 }
 
+/// Is there so much received data waiting to be handled that we should stop receiving for now?
+static bool socketIsReceiveFull(JsVar *receiveData) {
+  return receiveData && jsvGetStringLength(receiveData) >= SOCKET_RECEIVE_HIGH_WATER;
+}
+
 void socketPushReceiveData(JsVar *reader, JsVar **receiveData, bool isHttp, bool force) {
   if (!*receiveData || jsvIsEmptyString(*receiveData)) {
     // no data available (after headers)
@@ -313,6 +526,7 @@ void socketPushReceiveData(JsVar *reader, JsVar **receiveData, bool isHttp, bool
 
   JsVar *nextChunk = 0;
   JsVar *partialChunk = 0;
+  size_t pushedLen = 0; // if not chunked, the amount of content we're handling
 
   // Keep track of how much we received (so we can close once we have it)
   if (isHttp) {
@@ -362,18 +576,22 @@ void socketPushReceiveData(JsVar *reader, JsVar **receiveData, bool isHttp, bool
       jsvUnLock(*receiveData);
       *receiveData = chunkData;
     } else {
-      jsvObjectSetChildAndUnLock(reader, HTTP_NAME_RECEIVE_COUNT,
-        jsvNewFromInteger(
-          jsvGetIntegerAndUnLock(jsvObjectGetChild(reader, HTTP_NAME_RECEIVE_COUNT, JSV_INTEGER)) - (JsVarInt)len)
-        );
+      pushedLen = len;
     }
   }
 
   // execute 'data' callback or save data
   if (!jswrap_stream_pushData(reader, *receiveData, force)) {
+    // not handled - we'll try again next time around the idle loop
     jsvUnLock2(nextChunk, partialChunk);
     return;
   }
+  if (pushedLen) {
+    jsvObjectSetChildAndUnLock(reader, HTTP_NAME_RECEIVE_COUNT,
+      jsvNewFromInteger(
+        jsvGetIntegerAndUnLock(jsvObjectGetChild(reader, HTTP_NAME_RECEIVE_COUNT, JSV_INTEGER)) - (JsVarInt)pushedLen)
+      );
+  }
 
   // clear received data
   jsvUnLock(*receiveData);
@@ -426,6 +644,19 @@ void socketReceived(JsVar *connection, JsVar *socket, SocketType socketType, JsV
     } else if (httpParseHeaders(receiveData, reader, isServer)) {
       hadHeaders = true;
 
+      if (isServer) {
+        if (httpKeepAliveGet("timeout")>0 && httpHeadersAllowKeepAlive(reader, true)) {
+          // client wants to keep the connection open - tell it we will
+          jsvObjectSetChildAndUnLock(socket, HTTP_NAME_KEEP_ALIVE, jsvNewFromBool(true));
+          JsVar *name = jsvNewFromString("Connection");
+          JsVar *value = jsvNewFromString("keep-alive");
+          serverResponseSetHeader(socket, name, value);
+          jsvUnLock2(name, value);
+        }
+      } else if (!httpHeadersAllowKeepAlive(reader, false)) {
+        jsvObjectRemoveChild(connection, HTTP_NAME_KEEP_ALIVE);
+      }
+
       // on connect only when just parsed the HTTP headers
       if (isServer) {
         JsVar *server = jsvObjectGetChild(connection,HTTP_NAME_SERVER_VAR,0);
@@ -487,6 +718,32 @@ static bool fireErrorEvent(int error, JsVar *obj1, JsVar *obj2) {
 
 // -----------------------------
 
+/// Create the request and response objects for a new HTTP server connection on 'sckt', and return the request
+static JsVar *socketServerNewHttpConnection(JsVar *server, int sckt) {
+  JsVar *req = jspNewObject(0, "httpSRq");
+  JsVar *res = jspNewObject(0, "httpSRs");
+  if (res && req) { // out of memory?
+    socketSetType(req, ST_HTTP);
+    JsVar *arr = socketGetArray(HTTP_ARRAY_HTTP_SERVER_CONNECTIONS, true);
+    if (arr) {
+      jsvArrayPush(arr, req);
+      jsvUnLock(arr);
+    }
+    jsvObjectSetChild(req, HTTP_NAME_RESPONSE_VAR, res);
+    jsvObjectSetChild(req, HTTP_NAME_SERVER_VAR, server);
+    jsvObjectSetChildAndUnLock(req, HTTP_NAME_SOCKET, jsvNewFromInteger(sckt+1));
+    jsvObjectSetChildAndUnLock(res, HTTP_NAME_SOCKET, jsvNewFromInteger(sckt+1));
+    // Auto-add connection close header (in HTTP/1.0 this seemed implicit, now it must be explicit)
+    // This can always be overwritten with setHeader or writeHead
+    JsVar *name = jsvNewFromString("Connection");
+    JsVar *value = jsvNewFromString("close");
+    serverResponseSetHeader(res, name, value);
+    jsvUnLock2(name, value);
+  }
+  jsvUnLock(res);
+  return req;
+}
+
 bool socketServerConnectionsIdle(JsNetwork *net) {
   char *buf = alloca((size_t)net->chunkSize); // allocate on stack
 
@@ -507,16 +764,32 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
 
     int sckt = (int)jsvGetIntegerAndUnLock(jsvObjectGetChild(connection,HTTP_NAME_SOCKET,0))-1; // so -1 if undefined
     bool closeConnectionNow = jsvGetBoolAndUnLock(jsvObjectGetChild(connection, HTTP_NAME_CLOSENOW, false));
+    bool keepAlive = false; // rather than closing, keep the socket open for the next request
     int error = 0;
 
     if (!closeConnectionNow) {
-      int num = netRecv(net, socketType, sckt, buf, (size_t)net->chunkSize);
+      /* If data from last time hasn't been handled yet (eg. no 'data' handler and
+       * the stream buffer is full) then push it again, and don't receive any more
+       * until there's space - so the sender has to wait rather than us buffering
+       * the whole thing */
+      bool receiveFull = false;
+      if (jsvGetBoolAndUnLock(jsvObjectGetChild(connection,HTTP_NAME_HAD_HEADERS,0))) {
+        JsVar *receiveData = jsvObjectGetChild(connection,HTTP_NAME_RECEIVE_DATA,0);
+        if (receiveData && !jsvIsEmptyString(receiveData)) {
+          socketPushReceiveData(connection, &receiveData, isHttp, false);
+          jsvObjectSetChild(connection,HTTP_NAME_RECEIVE_DATA,receiveData);
+          receiveFull = socketIsReceiveFull(receiveData);
+        }
+        jsvUnLock(receiveData);
+      }
+      int num = receiveFull ? 0 : netRecv(net, socketType, sckt, buf, (size_t)net->chunkSize);
       if (num<0) {
         // we probably disconnected so just get rid of this
         closeConnectionNow = true;
         error = num;
       } else {
         if (num>0) {
+          jsvObjectRemoveChild(connection, HTTP_NAME_IDLE_SINCE);
           JsVar *receiveData = jsvObjectGetChild(connection,HTTP_NAME_RECEIVE_DATA,0);
           if (!receiveData) receiveData = jsvNewFromEmptyString();
           if (receiveData) {
@@ -550,12 +823,16 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
           bool hadHeaders = jsvGetBoolAndUnLock(jsvObjectGetChild(connection,HTTP_NAME_HAD_HEADERS,0));
           JsVarInt contentToReceive = jsvGetIntegerAndUnLock(jsvObjectGetChild(connection, HTTP_NAME_RECEIVE_COUNT, 0));
           if (contentToReceive > 0 || !hadHeaders) {
-            reallyCloseNow = false;
+            // kept-alive connection waiting for a request that never came?
+            reallyCloseNow = !hadHeaders && httpKeepAliveTimedOut(connection);
           } else if (!jsvGetBoolAndUnLock(jsvObjectGetChild(connection,HTTP_NAME_ENDED,0))) {
             jsvObjectSetChildAndUnLock(connection, HTTP_NAME_ENDED, jsvNewFromBool(true));
             jsiQueueObjectCallbacks(connection, HTTP_NAME_ON_END, NULL, 0);
             DBG("ONEND %d (%d)\n", contentToReceive, reallyCloseNow);
           }
+          // response sent and request received - can we wait for another request?
+          if (reallyCloseNow && hadHeaders && num==0 && !error)
+            keepAlive = jsvGetBoolAndUnLock(jsvObjectGetChild(socket,HTTP_NAME_KEEP_ALIVE,0));
         }
         closeConnectionNow = reallyCloseNow;
       } else if (num > 0)
@@ -587,6 +864,16 @@ bool socketServerConnectionsIdle(JsNetwork *net) {
       jsiQueueObjectCallbacks(socket, HTTP_NAME_ON_CLOSE, params, 1);
       jsvUnLock(params[0]);
 
+      if (keepAlive) {
+        // move the socket over to a new request, and stop it being closed
+        JsVar *server = jsvObjectGetChild(connection,HTTP_NAME_SERVER_VAR,0);
+        JsVar *req = socketServerNewHttpConnection(server, sckt);
+        if (req) {
+          httpKeepAliveSetIdle(req);
+          jsvObjectRemoveChild(connection, HTTP_NAME_SOCKET);
+        }
+        jsvUnLock2(req, server);
+      }
       _socketConnectionKill(net, connection);
       JsVar *connectionName = jsvObjectIteratorGetKey(&it);
       jsvObjectIteratorNext(&it);
@@ -624,6 +911,7 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
     JsVar *receiveData = 0;
 
     bool hadHeaders = false;
+    bool keepAlive = false; // rather than closing, put the socket in the pool for the next request
     int error = 0; // error code received from netXxxx functions
     bool closeConnectionNow = jsvGetBoolAndUnLock(jsvObjectGetChild(connection, HTTP_NAME_CLOSENOW, false));
     bool alreadyConnected = jsvGetBoolAndUnLock(jsvObjectGetChild(connection, HTTP_NAME_CONNECTED, false));
@@ -672,10 +960,15 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
               jsiQueueObjectCallbacks(socket, HTTP_NAME_ON_END, NULL, 0);
               DBG("onEnd %d (%d) %d\n", contentToReceive, closeConnectionNow, hadHeaders);
             }
+            // request sent and response received - can the socket be used again?
+            if (closeConnectionNow)
+              keepAlive = jsvGetBoolAndUnLock(jsvObjectGetChild(connection,HTTP_NAME_KEEP_ALIVE,0));
           }
         }
         // Now read data if possible (and we have space for it)
-        int num = netRecv(net, socketType, sckt, buf, (size_t)net->chunkSize);
+        int num = (hadHeaders && socketIsReceiveFull(receiveData)) ? 0 :
+                  netRecv(net, socketType, sckt, buf, (size_t)net->chunkSize);
+        if (num) keepAlive = false; // closed, or more data than we expected
         if (!alreadyConnected && num == SOCKET_ERR_NO_CONN) {
           ; // ignore... it's just telling us we're not connected yet
         } else if (num < 0) {
@@ -727,6 +1020,8 @@ bool socketClientConnectionsIdle(JsNetwork *net) {
           error = SOCKET_ERR_UNSENT_DATA;
         jsvUnLock(sendData);
 
+        if (keepAlive && !error)
+          socketPoolAdd(connection); // if this works, _socketConnectionKill won't close the socket
         _socketConnectionKill(net, connection);
         JsVar *connectionName = jsvObjectIteratorGetKey(&it);
         jsvObjectIteratorNext(&it);
@@ -788,27 +1083,7 @@ bool socketIdle(JsNetwork *net) {
       }
       if (theClient >= 0) { // We have a new connection
         if ((socketType&ST_TYPE_MASK) == ST_HTTP) {
-          JsVar *req = jspNewObject(0, "httpSRq");
-          JsVar *res = jspNewObject(0, "httpSRs");
-          if (res && req) { // out of memory?
-            socketSetType(req, ST_HTTP);
-            JsVar *arr = socketGetArray(HTTP_ARRAY_HTTP_SERVER_CONNECTIONS, true);
-            if (arr) {
-              jsvArrayPush(arr, req);
-              jsvUnLock(arr);
-            }
-            jsvObjectSetChild(req, HTTP_NAME_RESPONSE_VAR, res);
-            jsvObjectSetChild(req, HTTP_NAME_SERVER_VAR, server);
-            jsvObjectSetChildAndUnLock(req, HTTP_NAME_SOCKET, jsvNewFromInteger(theClient+1));
-            jsvObjectSetChildAndUnLock(res, HTTP_NAME_SOCKET, jsvNewFromInteger(theClient+1));
-            // Auto-add connection close header (in HTTP/1.0 this seemed implicit, now it must be explicit)
-            // This can always be overwritten with setHeader or writeHead
-            JsVar *name = jsvNewFromString("Connection");
-            JsVar *value = jsvNewFromString("close");
-            serverResponseSetHeader(res, name, value);
-            jsvUnLock2(name, value);
-          }
-          jsvUnLock2(req, res);
+          jsvUnLock(socketServerNewHttpConnection(server, theClient));
         } else {
           // Normal sockets
           JsVar *sock = jspNewObject(0, "Socket");
@@ -835,6 +1110,8 @@ bool socketIdle(JsNetwork *net) {
 
   if (socketServerConnectionsIdle(net)) hadSockets = true;
   if (socketClientConnectionsIdle(net)) hadSockets = true;
+  char *buf = alloca((size_t)net->chunkSize); // allocate on stack
+  if (socketPoolIdle(net, buf)) hadSockets = true;
   netCheckError(net);
   return hadSockets;
 }
@@ -934,10 +1211,10 @@ JsVar *clientRequestNew(SocketType socketType, JsVar *options, JsVar *callback)
   return req;
 }
 
-void clientRequestWrite(JsNetwork *net, JsVar *httpClientReqVar, JsVar *data, JsVar *host, unsigned short portNumber) {
+bool clientRequestWrite(JsNetwork *net, JsVar *httpClientReqVar, JsVar *data, JsVar *host, unsigned short portNumber) {
   if (!_socketConnectionOpen(httpClientReqVar)) {
     jsExceptionHere(JSET_ERROR, "This socket is closed.");
-    return;
+    return false;
   }
   SocketType socketType = socketGetType(httpClientReqVar);
 
@@ -953,9 +1230,18 @@ void clientRequestWrite(JsNetwork *net, JsVar *httpClientReqVar, JsVar *data, Js
       // We're an HTTP client - make a header
       JsVar *method = jsvObjectGetChild(options, "method", 0);
       JsVar *path = jsvObjectGetChild(options, "path", 0);
-      sendData = jsvVarPrintf("%v %v HTTP/1.1\r\nUser-Agent: Espruino "JS_VERSION"\r\nConnection: close\r\n", method, path);
-      jsvUnLock2(method, path);
       JsVar *headers = jsvObjectGetChild(options, HTTP_NAME_HEADERS, 0);
+      // Keep the connection open afterwards if we have a pool, and weren't told not to
+      bool keepAlive = httpKeepAliveGet("max")>0;
+      JsVar *connectionHeader = jsvIsObject(headers) ? jsvObjectGetChildI(headers, "Connection") : 0;
+      if (connectionHeader)
+        keepAlive = keepAlive && jsvIsStringIEqualAndUnLock(jsvLockAgain(connectionHeader), "keep-alive");
+      if (keepAlive)
+        jsvObjectSetChildAndUnLock(httpClientReqVar, HTTP_NAME_KEEP_ALIVE, jsvNewFromBool(true));
+      sendData = jsvVarPrintf("%v %v HTTP/1.1\r\nUser-Agent: Espruino "JS_VERSION"\r\n", method, path);
+      if (!connectionHeader)
+        jsvAppendPrintf(sendData, "Connection: %s\r\n", keepAlive ? "keep-alive" : "close");
+      jsvUnLock3(method, path, connectionHeader);
       bool hasHostHeader = false;
       if (jsvIsObject(headers)) {
         JsVar *hostHeader = jsvObjectGetChildI(headers, "Host");
@@ -988,6 +1274,7 @@ void clientRequestWrite(JsNetwork *net, JsVar *httpClientReqVar, JsVar *data, Js
   }
   // We have data and aren't out of memory...
   if (data && sendData) {
+    sendData = socketCompactSendData(httpClientReqVar, sendData);
     // append the data to what we want to send
     JsVar *s = jsvAsString(data);
     if (s) {
@@ -1010,11 +1297,13 @@ void clientRequestWrite(JsNetwork *net, JsVar *httpClientReqVar, JsVar *data, Js
       jsvUnLock(s);
     }
   }
+  bool canWriteMore = socketCanWriteMore(httpClientReqVar, sendData);
   jsvUnLock(sendData);
   if ((socketType&ST_TYPE_MASK) != ST_NORMAL) {
     // on HTTP/UDP we connect on-demand with the first write/send
     clientRequestConnect(net, httpClientReqVar);
   }
+  return canWriteMore;
 }
 
 // Connect this connection/socket
@@ -1028,9 +1317,30 @@ void clientRequestConnect(JsNetwork *net, JsVar *httpClientReqVar) {
 
   JsVar *options = jsvObjectGetChild(httpClientReqVar, HTTP_NAME_OPTIONS_VAR, 0);
   unsigned short port = (unsigned short)jsvGetIntegerAndUnLock(jsvObjectGetChild(options, "port", 0));
+#ifdef USE_TLS
+  if (socketType & ST_TLS) {
+    if (port==0) port = 443;
+  }
+#endif
+  if ((socketType&ST_TYPE_MASK) == ST_HTTP) {
+    if (port==0) port = 80;
+  }
 
   uint32_t host_addr = 0;
   JsVar *hostNameVar = jsvObjectGetChild(options, "host", 0);
+  if (jsvGetBoolAndUnLock(jsvObjectGetChild(httpClientReqVar, HTTP_NAME_KEEP_ALIVE, 0))) {
+    // If we have an idle socket to this host in the pool, use that
+    JsVar *key = jsvVarPrintf("%d:%v:%d", socketType, hostNameVar, port);
+    jsvObjectSetChild(httpClientReqVar, HTTP_NAME_POOL_KEY, key);
+    int sckt = socketPoolTake(key);
+    jsvUnLock(key);
+    if (sckt>=0) {
+      DBG("clientRequestConnect reusing %d\n", sckt);
+      jsvObjectSetChildAndUnLock(httpClientReqVar, HTTP_NAME_SOCKET, jsvNewFromInteger(sckt+1));
+      jsvUnLock2(hostNameVar, options);
+      return;
+    }
+  }
   if (jsvIsUndefined(hostNameVar)) {
     host_addr = 0x0100007F; // 127.0.0.1
   } else {
@@ -1052,15 +1362,6 @@ void clientRequestConnect(JsNetwork *net, JsVar *httpClientReqVar) {
     return;
   }
 
-#ifdef USE_TLS
-  if (socketType & ST_TLS) {
-    if (port==0) port = 443;
-  }
-#endif
-  if ((socketType&ST_TYPE_MASK) == ST_HTTP) {
-    if (port==0) port = 80;
-  }
-
   int sckt =  netCreateSocket(net, socketType, host_addr, port, options);
   if (sckt<0) {
     jsExceptionHere(JSET_INTERNALERROR, "Unable to create socket\n");
@@ -1130,6 +1431,19 @@ void serverResponseWriteHead(JsVar *httpServerResponseVar, int statusCode, JsVar
   if (jsvIsObject(implicitHeaders)) jsvObjectAppendAll(headers, implicitHeaders);
   jsvUnLock(implicitHeaders);
   if (jsvIsObject(explicitHeaders)) jsvObjectAppendAll(headers, explicitHeaders);
+  if (headers && jsvGetBoolAndUnLock(jsvObjectGetChild(httpServerResponseVar, HTTP_NAME_KEEP_ALIVE, 0))) {
+    if (!jsvIsStringIEqualAndUnLock(jsvObjectGetChildI(headers, "Connection"), "keep-alive")) {
+      // we were told to close the connection after all
+      jsvObjectRemoveChild(httpServerResponseVar, HTTP_NAME_KEEP_ALIVE);
+    } else {
+      // If we don't know the length, the client can't tell where the response ends unless it's chunked
+      JsVar *contentLength = jsvObjectGetChildI(headers, "Content-Length");
+      JsVar *transferEncoding = jsvObjectGetChildI(headers, "Transfer-Encoding");
+      if (!contentLength && !transferEncoding)
+        jsvObjectSetChildAndUnLock(headers, "Transfer-Encoding", jsvNewFromString("chunked"));
+      jsvUnLock2(contentLength, transferEncoding);
+    }
+  }
 
 
   sendData = jsvVarPrintf("HTTP/1.1 %d OK\r\nServer: Espruino "JS_VERSION"\r\n", statusCode);
@@ -1147,10 +1461,10 @@ void serverResponseWriteHead(JsVar *httpServerResponseVar, int statusCode, JsVar
 }
 
 
-void serverResponseWrite(JsVar *httpServerResponseVar, JsVar *data) {
+bool serverResponseWrite(JsVar *httpServerResponseVar, JsVar *data) {
   if (!_socketConnectionOpen(httpServerResponseVar)) {
     jsExceptionHere(JSET_ERROR, "This socket is closed.");
-    return;
+    return false;
   }
   // Append data to sendData
   JsVar *sendData = jsvObjectGetChild(httpServerResponseVar, HTTP_NAME_SEND_DATA, 0);
@@ -1163,6 +1477,7 @@ void serverResponseWrite(JsVar *httpServerResponseVar, JsVar *data) {
   }
   // check, just in case!
   if (sendData && !jsvIsUndefined(data)) {
+    sendData = socketCompactSendData(httpServerResponseVar, sendData);
     JsVar *s = jsvAsString(data);
     if (s) {
       if (jsvGetBoolAndUnLock(jsvObjectGetChild(httpServerResponseVar, HTTP_NAME_CHUNKED, 0))) {
@@ -1176,7 +1491,9 @@ void serverResponseWrite(JsVar *httpServerResponseVar, JsVar *data) {
     jsvUnLock(s);
   }
   DBG("serverResponseWrite %v\n", sendData);
+  bool canWriteMore = socketCanWriteMore(httpServerResponseVar, sendData);
   jsvUnLock(sendData);
+  return canWriteMore;
 }
 
 void serverResponseEnd(JsVar *httpServerResponseVar) {
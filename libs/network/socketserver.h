@@ -31,13 +31,15 @@ void serverListen(JsNetwork *net, JsVar *httpServerVar, unsigned short port, Soc
 void serverClose(JsNetwork *net, JsVar *server);
 
 JsVar *clientRequestNew(SocketType socketType, JsVar *options, JsVar *callback);
-void clientRequestWrite(JsNetwork *net, JsVar *httpClientReqVar, JsVar *data, JsVar *host, unsigned short port);
+bool clientRequestWrite(JsNetwork *net, JsVar *httpClientReqVar, JsVar *data, JsVar *host, unsigned short port);
 void clientRequestConnect(JsNetwork *net, JsVar *httpClientReqVar);
 void clientRequestEnd(JsNetwork *net, JsVar *httpClientReqVar);
 
 void serverResponseSetHeader(JsVar *parent, JsVar *name, JsVar *value); // for HTTP
 void serverResponseWriteHead(JsVar *httpServerResponseVar, int statusCode, JsVar *headers); // for HTTP
-void serverResponseWrite(JsVar *httpServerResponseVar, JsVar *data);
+bool serverResponseWrite(JsVar *httpServerResponseVar, JsVar *data);
 void serverResponseEnd(JsVar *httpServerResponseVar);
 
+void httpSetKeepAlive(JsVar *options); // for HTTP
+
 #endif // SOCKETSERVER_H
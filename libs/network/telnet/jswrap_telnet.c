@@ -282,12 +282,43 @@ void telnetSendChar(char ch) {
   networkFree(&net);
 }
 
+// Queue a block of characters to send, copying as much as will fit into the buffer at a time
+void telnetSendBuffer(const char *data, size_t len) {
+  if (tnSrv.sock == 0 || tnSrv.cliSock == 0) return;
+  while (true) {
+    size_t space = (size_t)(TX_CHUNK - tnSrv.txBufLen);
+    size_t n = (len < space) ? len : space;
+    memcpy(tnSrv.txBuf+tnSrv.txBufLen, data, n);
+    tnSrv.txBufLen = (uint16_t)(tnSrv.txBufLen + n);
+    data += n;
+    len -= n;
+    // if it's all buffered and there's not much, it'll be sent at idle time
+    if (!len && tnSrv.txBufLen < TX_CHUNK/4) break;
+    // otherwise try and send, which makes space for the rest
+    JsNetwork net;
+    if (!networkGetFromVarIfOnline(&net)) break;
+    bool sent = telnetSendBuf(&net);
+    networkFree(&net);
+    // stop if we're done, or if we couldn't send anything
+    if (!len || !sent || tnSrv.cliSock == 0) break;
+  }
+  if (len) {
+    // buffer overflow :-(
+    if (!ovf) {
+      printf("tnSrv: send overflow!\n");
+      ovf = true;
+    }
+  } else {
+    ovf = false;
+  }
+}
+
 // Attempt to receive on an established client connection, returns true if it received something
 bool telnetRecv(JsNetwork *net) {
   if (tnSrv.sock == 0 || tnSrv.cliSock == 0) return false;
 
   char buff[64];
-  if (!jshHasEventSpaceForChars(sizeof(buff))) return false;
+  if (!jshHasEventSpaceForCharEvents(sizeof(buff))) return false;
   int r = netRecv(net, ST_NORMAL, tnSrv.cliSock-1, buff, sizeof(buff));
   if (r > 0) {
     jshPushIOCharEvents(EV_TELNET, buff, (unsigned int)r);
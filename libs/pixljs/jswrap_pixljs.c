@@ -94,23 +94,25 @@ void lcd_wr(int data) {
   }
 }
 
-void lcd_flip_gfx(JsGraphics *gfx) {
-  if (gfx->data.modMinX > gfx->data.modMaxX) return; // nothing to do!
-
+/// Send one modified area of the offscreen buffer to the screen
+static void lcd_flip_rect(JsGraphics *gfx, int x1, int y1, int x2, int y2) {
   JsVar *buf = jsvObjectGetChild(gfx->graphicsVar,"buffer",0);
   if (!buf) return;
   JSV_GET_AS_CHAR_ARRAY(bPtr, bLen, buf);
-  if (!bPtr || bLen<128*8) return;
+  if (!bPtr || bLen<128*8) {
+    jsvUnLock(buf);
+    return;
+  }
 
-  int xcoord = gfx->data.modMinX&~7;
-  int xlen = gfx->data.modMaxX+1-xcoord;
+  int xcoord = x1&~7;
+  int xlen = x2+1-xcoord;
 
   jshPinSetValue(LCD_SPI_CS,0);
   for (int y=0;y<8;y++) {
     // skip any lines that don't need updating
     int ycoord = y*8;
-    if (ycoord > gfx->data.modMaxY ||
-        ycoord+7 < gfx->data.modMinY) continue;
+    if (ycoord > y2 ||
+        ycoord+7 < y1) continue;
     // Send only what we need
     jshPinSetValue(LCD_SPI_DC,0);
     lcd_wr(0xB0|y/* page */);
@@ -135,11 +137,11 @@ void lcd_flip_gfx(JsGraphics *gfx) {
   }
   jshPinSetValue(LCD_SPI_CS,1);
   jsvUnLock(buf);
-  // Reset modified-ness
-  gfx->data.modMaxX = -32768;
-  gfx->data.modMaxY = -32768;
-  gfx->data.modMinX = 32767;
-  gfx->data.modMinY = 32767;
+}
+
+void lcd_flip_gfx(JsGraphics *gfx) {
+  // Only send the separate areas that have changed, then reset modified-ness
+  graphicsFlipModified(gfx, lcd_flip_rect);
 }
 
 
@@ -147,12 +149,8 @@ void lcd_flip_gfx(JsGraphics *gfx) {
 void lcd_flip(JsVar *parent, bool all) {
   JsGraphics gfx; 
   if (!graphicsGetFromVar(&gfx, parent)) return;
-  if (all) {
-    gfx.data.modMinX = 0;
-    gfx.data.modMinY = 0;
-    gfx.data.modMaxX = 127;
-    gfx.data.modMaxY = 63;
-  }
+  if (all)
+    graphicsSetModified(&gfx, 0, 0, 127, 63);
   lcd_flip_gfx(&gfx);
   graphicsSetVar(&gfx);
 }
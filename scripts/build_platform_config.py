@@ -325,11 +325,21 @@ codeOut("");
 if LINUX:
   bufferSizeIO = 256
   bufferSizeTX = 256
+  bufferSizeIOBulk = 4096
   bufferSizeTimer = 16
+  inlineCacheSize = 64
+  localCacheSize = 64
+  storageIndexSize = 512
+  eventRingSize = 16
 elif EMSCRIPTEN:
   bufferSizeIO = 256
   bufferSizeTX = 256
+  bufferSizeIOBulk = 1024
   bufferSizeTimer = 16
+  inlineCacheSize = 64
+  localCacheSize = 64
+  storageIndexSize = 64
+  eventRingSize = 16
 else:
   # IO buffer - for received chars, setWatch, etc
   bufferSizeIO = 64
@@ -341,13 +351,39 @@ else:
   bufferSizeTX = 32 
   if board.chip["ram"]>=20: bufferSizeTX = 128
   bufferSizeTimer = 4 if board.chip["ram"]<20 else 16
+  # Bulk IO buffer - for blocks of received chars (USB/Bluetooth/etc) that only take one event
+  bufferSizeIOBulk = 0
+  if board.chip["family"]=="NRF52": bufferSizeIOBulk = 256
+  if board.chip["ram"]>=96: bufferSizeIOBulk = 512
+  # Inline cache for property lookups in the interpreter
+  inlineCacheSize = 8
+  if board.chip["ram"]>=20: inlineCacheSize = 16
+  if board.chip["ram"]>=96: inlineCacheSize = 32
+  # Cache of which identifiers are local variable slots in the interpreter
+  localCacheSize = 8
+  if board.chip["ram"]>=20: localCacheSize = 16
+  if board.chip["ram"]>=96: localCacheSize = 32
+  # In-RAM index of the files in Storage - 8 bytes each
+  storageIndexSize = 16
+  if board.chip["ram"]>=20: storageIndexSize = 32
+  if board.chip["ram"]>=96: storageIndexSize = 64
+  # Events that can be queued without allocating JsVars
+  eventRingSize = 4
+  if board.chip["ram"]>=20: eventRingSize = 8
+  if board.chip["ram"]>=96: eventRingSize = 16
 
 if 'util_timer_tasks' in board.info:
   bufferSizeTimer = board.info['util_timer_tasks']
 
 codeOut("#define IOBUFFERMASK "+str(bufferSizeIO-1)+" // (max 255) amount of items in event buffer - events take 5 bytes each")
 codeOut("#define TXBUFFERMASK "+str(bufferSizeTX-1)+" // (max 255) amount of items in the transmit buffer - 2 bytes each")
+if bufferSizeIOBulk>0:
+  codeOut("#define IOBULKBUFFERMASK "+str(bufferSizeIOBulk-1)+" // (max 65535) amount of characters in the bulk receive buffer")
 codeOut("#define UTILTIMERTASK_TASKS ("+str(bufferSizeTimer)+") // Must be power of 2 - and max 256")
+codeOut("#define JSP_INLINE_CACHE_SIZE "+str(inlineCacheSize)+" // Must be power of 2 - amount of property lookups cached by the interpreter")
+codeOut("#define JSP_LOCAL_CACHE_SIZE "+str(localCacheSize)+" // Must be power of 2 - amount of local variable slots cached by the interpreter")
+codeOut("#define JSF_INDEX_SIZE "+str(storageIndexSize)+" // amount of entries in the index of files in Storage (it's only filled to 3/4)")
+codeOut("#define JSI_EVENT_RING_SIZE "+str(eventRingSize)+" // amount of events that can be queued without allocating JsVars")
 
 codeOut("");
 
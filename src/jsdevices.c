@@ -75,6 +75,16 @@ Pin jshSerialDeviceCTSPins[JSHSERIALDEVICESTATUSES];
 //                                                              IO EVENT BUFFER
 volatile IOEvent ioBuffer[IOBUFFERMASK+1];
 volatile unsigned char ioHead=0, ioTail=0;
+#ifdef IOBULKBUFFERMASK
+/// Characters for bulk IO events (see IOEVENTFLAGS_ISBULK)
+volatile char ioBulkBuffer[IOBULKBUFFERMASK+1];
+volatile unsigned short ioBulkHead=0, ioBulkTail=0;
+
+/// How many more characters can we put in the bulk buffer?
+static unsigned int jshGetIOBulkSpace() {
+  return (unsigned int)((ioBulkTail+IOBULKBUFFERMASK-ioBulkHead)&IOBULKBUFFERMASK);
+}
+#endif
 
 // ----------------------------------------------------------------------------
 
@@ -158,6 +168,38 @@ void jshResetDevices() {
 
 // ----------------------------------------------------------------------------
 
+/** Wait for there to be space in the transmit buffer. This may change `device`
+ * if the console moved away from Limbo while we were waiting. Returns false if
+ * we couldn't wait (because we're in an IRQ) */
+static bool jshTransmitWaitForSpace(IOEventFlags *device) {
+  jsiSetBusy(BUSY_TRANSMIT, true);
+  bool wasConsoleLimbo = *device==EV_LIMBO && jsiGetConsoleDevice()==EV_LIMBO;
+  while (((txHead+1)&TXBUFFERMASK)==txTail) {
+    // wait for send to finish as buffer is about to overflow
+    if (jshIsInInterrupt()) {
+      // if we're printing from an IRQ, don't wait - it's unlikely TX will ever finish
+      jsErrorFlags |= JSERR_BUFFER_FULL;
+      return false;
+    }
+    jshBusyIdle();
+#ifdef USB
+    // just in case USB was unplugged while we were waiting!
+    if (!jshIsUSBSERIALConnected()) jshTransmitClearDevice(EV_USBSERIAL);
+#endif
+  }
+  if (wasConsoleLimbo && jsiGetConsoleDevice()!=EV_LIMBO) {
+    /* It was 'Limbo', but now it's not - see jsiOneSecondAfterStartup.
+    Basically we must have printed a bunch of stuff to LIMBO and blocked
+    with our output buffer full. But then jsiOneSecondAfterStartup
+    switches to the right console device and swaps everything we wrote
+    over to that device too. Only we're now here, still writing to the
+    old device when really we should be writing to the new one. */
+    *device = jsiGetConsoleDevice();
+  }
+  jsiSetBusy(BUSY_TRANSMIT, false);
+  return true;
+}
+
 /**
  * Queue a character for transmission.
  */
@@ -212,31 +254,7 @@ void jshTransmit(
   // we have filled the array backing the list.  What we do next is to wait for space to free up.
   unsigned char txHeadNext = (unsigned char)((txHead+1)&TXBUFFERMASK);
   if (txHeadNext==txTail) {
-    jsiSetBusy(BUSY_TRANSMIT, true);
-    bool wasConsoleLimbo = device==EV_LIMBO && jsiGetConsoleDevice()==EV_LIMBO;
-    while (txHeadNext==txTail) {
-      // wait for send to finish as buffer is about to overflow
-      if (jshIsInInterrupt()) {
-        // if we're printing from an IRQ, don't wait - it's unlikely TX will ever finish
-        jsErrorFlags |= JSERR_BUFFER_FULL;
-        return;
-      }
-      jshBusyIdle();
-#ifdef USB
-      // just in case USB was unplugged while we were waiting!
-      if (!jshIsUSBSERIALConnected()) jshTransmitClearDevice(EV_USBSERIAL);
-#endif
-    }
-    if (wasConsoleLimbo && jsiGetConsoleDevice()!=EV_LIMBO) {
-      /* It was 'Limbo', but now it's not - see jsiOneSecondAfterStartup.
-      Basically we must have printed a bunch of stuff to LIMBO and blocked
-      with our output buffer full. But then jsiOneSecondAfterStartup
-      switches to the right console device and swaps everything we wrote
-      over to that device too. Only we're now here, still writing to the
-      old device when really we should be writing to the new one. */
-      device = jsiGetConsoleDevice();
-    }
-    jsiSetBusy(BUSY_TRANSMIT, false);
+    if (!jshTransmitWaitForSpace(&device)) return;
   }
   // Save the device and data for the new character to be transmitted.
   txBuffer[txHead].flags = device;
@@ -246,9 +264,80 @@ void jshTransmit(
   jshUSARTKick(device); // set up interrupts if required
 }
 
+/**
+ * Queue a buffer of characters for transmission. This reserves as much
+ * contiguous space in the transmit buffer as it can and copies into it in one
+ * go, kicking the device once per span rather than once per character.
+ */
+void jshTransmitBuffer(
+    IOEventFlags device,        //!< The device to be used for transmission.
+    const unsigned char *data,  //!< The data to transmit.
+    size_t len                  //!< The amount of data
+  ) {
+  if (!len) return;
+  if (device==EV_LOOPBACKA || device==EV_LOOPBACKB) {
+    jshPushIOCharEvents(device==EV_LOOPBACKB ? EV_LOOPBACKA : EV_LOOPBACKB, (char*)data, (unsigned int)len);
+    return;
+  }
+  bool bufferedDevice = true;
+#ifdef USE_TELNET
+  if (device == EV_TELNET) {
+    extern void telnetSendBuffer(const char *data, size_t len);
+    telnetSendBuffer((const char *)data, len);
+    return;
+  }
+#endif
+#ifdef USE_TERMINAL
+  if (device == EV_TERMINAL) bufferedDevice = false;
+#endif
+#ifndef LINUX
+#ifdef USB
+  if (device==EV_USBSERIAL && !jshIsUSBSERIALConnected()) bufferedDevice = false;
+#endif
+#ifdef BLUETOOTH
+  if (device==EV_BLUETOOTH && !jsble_has_peripheral_connection()) bufferedDevice = false;
+#endif
+#else // if PC, just put to stdout in one write
+  if (device==DEFAULT_CONSOLE_DEVICE) {
+    fwrite(data, 1, len, stdout);
+    fflush(stdout);
+    return;
+  }
+#endif
+  if (!bufferedDevice) {
+    // Devices that don't use the transmit buffer - just handle them a character at a time
+    while (len--) jshTransmit(device, *(data++));
+    return;
+  }
+  // If the device is EV_NONE then there is nowhere to send the data.
+  if (device==EV_NONE) return;
+
+  while (len) {
+    // how many items can we add before we catch up with the tail?
+    unsigned int space = (unsigned int)((txTail+TXBUFFERMASK-txHead)&TXBUFFERMASK);
+    if (!space) {
+      if (!jshTransmitWaitForSpace(&device)) return;
+      continue;
+    }
+    if (space > len) space = (unsigned int)len;
+    // Fill in the items before moving txHead, so an IRQ never sees a half-written item
+    unsigned char head = txHead;
+    unsigned int i;
+    for (i=0;i<space;i++) {
+      txBuffer[head].flags = device;
+      txBuffer[head].data = data[i];
+      head = (unsigned char)((head+1)&TXBUFFERMASK);
+    }
+    txHead = head;
+    data += space;
+    len -= space;
+    jshUSARTKick(device); // set up interrupts if required
+  }
+}
+
 static void jshTransmitPrintfCallback(const char *str, void *user_data) {
   IOEventFlags device = (IOEventFlags)user_data;
-  while (*str) jshTransmit(device, (unsigned char)*(str++));
+  jshTransmitBuffer(device, (const unsigned char *)str, strlen(str));
 }
 
 void jshTransmitPrintf(IOEventFlags device, const char *fmt, ...) {
@@ -386,6 +475,19 @@ static bool jshPushIOCharEventAppend(IOEventFlags channel, char charData) {
   if (ioHead!=ioTail && lastHead!=ioTail) {
     // we can do this because we only read in main loop, and we're in an interrupt here
     if (IOEVENTFLAGS_GETTYPE(ioBuffer[lastHead].flags) == channel) {
+#ifdef IOBULKBUFFERMASK
+      if (IOEVENTFLAGS_ISBULK(ioBuffer[lastHead].flags)) {
+        // If the last event's characters are right at the end of the bulk buffer, we can just add to it
+        unsigned int len = ioBuffer[lastHead].data.bulk.len;
+        if (((ioBuffer[lastHead].data.bulk.start+len)&IOBULKBUFFERMASK)!=ioBulkHead ||
+            len>=0xFFFF || !jshGetIOBulkSpace())
+          return false;
+        ioBulkBuffer[ioBulkHead] = charData;
+        ioBulkHead = (unsigned short)((ioBulkHead+1)&IOBULKBUFFERMASK);
+        ioBuffer[lastHead].data.bulk.len = (unsigned short)(len+1);
+        return true;
+      }
+#endif
       unsigned char c = (unsigned char)IOEVENTFLAGS_GETCHARS(ioBuffer[lastHead].flags);
       if (c < IOEVENT_MAXCHARS) {
         // last event was for this event type, and it has chars left
@@ -393,6 +495,25 @@ static bool jshPushIOCharEventAppend(IOEventFlags channel, char charData) {
         IOEVENTFLAGS_SETCHARS(ioBuffer[lastHead].flags, c+1);
         return true; // char added, job done
       }
+#ifdef IOBULKBUFFERMASK
+      /* The last event is full - move its characters to the bulk buffer, so
+      characters arriving one at a time (eg. USART RX) go on using one event */
+      if (DEVICE_IS_SERIAL(channel) && jshGetIOBulkSpace() > c) {
+        IOEvent *evt = &ioBuffer[lastHead];
+        unsigned short start = ioBulkHead;
+        unsigned char i;
+        for (i=0;i<c;i++) {
+          ioBulkBuffer[ioBulkHead] = evt->data.chars[i];
+          ioBulkHead = (unsigned short)((ioBulkHead+1)&IOBULKBUFFERMASK);
+        }
+        ioBulkBuffer[ioBulkHead] = charData;
+        ioBulkHead = (unsigned short)((ioBulkHead+1)&IOBULKBUFFERMASK);
+        evt->data.bulk.start = start;
+        evt->data.bulk.len = (unsigned short)(c+1);
+        IOEVENTFLAGS_SETBULK(evt->flags);
+        return true;
+      }
+#endif
     }
   }
   return false;
@@ -435,8 +556,37 @@ void jshPushIOCharEvent(
 }
 
 void jshPushIOCharEvents(IOEventFlags channel, char *data, unsigned int count) {
-  // TODO: optimise me!
   unsigned int i;
+#ifdef IOBULKBUFFERMASK
+  /* If there are more characters than will fit in one event, put them in the
+  bulk buffer so they only use up a single event */
+  if (count>IOEVENT_MAXCHARS && count<=jshGetIOBulkSpace() &&
+      jshGetEventsUsed()<IOBUFFERMASK-1) {
+    unsigned short start = ioBulkHead;
+    unsigned int len = 0;
+    for (i=0;i<count;i++) {
+      if (jshPushIOCharEventHandler(channel, data[i])) continue;
+      // Check if we can add to a bulk event that's already there
+      if (len==0 && jshPushIOCharEventAppend(channel, data[i])) {
+        start = ioBulkHead;
+        continue;
+      }
+      ioBulkBuffer[ioBulkHead] = data[i];
+      ioBulkHead = (unsigned short)((ioBulkHead+1)&IOBULKBUFFERMASK);
+      len++;
+    }
+    if (len) {
+      IOEvent evt;
+      evt.flags = channel;
+      IOEVENTFLAGS_SETBULK(evt.flags);
+      evt.data.bulk.start = start;
+      evt.data.bulk.len = (unsigned short)len;
+      jshPushEvent(&evt);
+    }
+    jshPushIOCharEventFlowControl(channel);
+    return;
+  }
+#endif
   for (i=0;i<count;i++) jshPushIOCharEvent(channel, data[i]);
 }
 
@@ -488,6 +638,42 @@ void CALLED_FROM_INTERRUPT jshPushIOEvent(
   jshPushEvent(&evt);
 }
 
+unsigned int jshGetIOEventChars(IOEvent *evt, unsigned int offset, char **data) {
+#ifdef IOBULKBUFFERMASK
+  if (IOEVENTFLAGS_ISBULK(evt->flags)) {
+    if (offset >= evt->data.bulk.len) return 0;
+    unsigned int idx = (evt->data.bulk.start + offset) & IOBULKBUFFERMASK;
+    unsigned int len = evt->data.bulk.len - offset;
+    // don't go past the end of the buffer - the rest is at the start
+    if (idx+len > IOBULKBUFFERMASK+1) len = IOBULKBUFFERMASK+1-idx;
+    *data = (char*)&ioBulkBuffer[idx];
+    return len;
+  }
+#endif
+  unsigned int chars = (unsigned int)IOEVENTFLAGS_GETCHARS(evt->flags);
+  if (offset >= chars) return 0;
+  *data = &evt->data.chars[offset];
+  return chars - offset;
+}
+
+void jshFreeIOEventChars(IOEvent *evt) {
+#ifdef IOBULKBUFFERMASK
+  if (!IOEVENTFLAGS_ISBULK(evt->flags)) return;
+  jshInterruptOff();
+  if (evt->data.bulk.start == ioBulkTail) {
+    ioBulkTail = (unsigned short)((ioBulkTail + evt->data.bulk.len) & IOBULKBUFFERMASK);
+  }
+  evt->data.bulk.len = 0; // so freeing twice is harmless
+  /* If events were taken out of order (jshPopIOEventOfType) the tail won't
+  have moved on - but if there are no events left we know nothing is using
+  the bulk buffer so can free it all */
+  if (ioHead==ioTail) ioBulkTail = ioBulkHead;
+  jshInterruptOn();
+#else
+  NOT_USED(evt);
+#endif
+}
+
 // returns true on success
 bool jshPopIOEvent(IOEvent *result) {
   if (ioHead==ioTail) return false;
@@ -543,16 +729,35 @@ bool jshIsTopEvent(IOEventFlags eventType) {
 
 int jshGetEventsUsed() {
   int spaceUsed = (ioHead >= ioTail) ? ((int)ioHead-(int)ioTail) : /*or rolled*/((int)ioHead+IOBUFFERMASK+1-(int)ioTail);
+#ifdef IOBULKBUFFERMASK
+  /* If the bulk buffer is fuller than the event buffer, report that instead
+  (scaled to the event buffer size) so flow control still works */
+  int bulkUsed = (int)((IOBULKBUFFERMASK - jshGetIOBulkSpace()) * (IOBUFFERMASK+1) / (IOBULKBUFFERMASK+1));
+  if (bulkUsed > spaceUsed) spaceUsed = bulkUsed;
+#endif
   return spaceUsed;
 }
 
-bool jshHasEventSpaceForChars(int n) {
-  int spacesNeeded = 4 + (n/IOEVENT_MAXCHARS); // be sensible - leave a little spare
+static bool jshHasEventSpaceFor(int events) {
+  int spacesNeeded = 4 + events; // be sensible - leave a little spare
   int spaceUsed = jshGetEventsUsed();
   int spaceLeft = IOBUFFERMASK+1-spaceUsed;
   return spaceLeft > spacesNeeded;
 }
 
+bool jshHasEventSpaceForChars(int n) {
+  return jshHasEventSpaceFor(n/IOEVENT_MAXCHARS);
+}
+
+bool jshHasEventSpaceForCharEvents(int n) {
+#ifdef IOBULKBUFFERMASK
+  // if it'll fit in the bulk buffer, it'll only need one event
+  if (n>IOEVENT_MAXCHARS && n+IOEVENT_MAXCHARS<=(int)jshGetIOBulkSpace())
+    return jshHasEventSpaceFor(1);
+#endif
+  return jshHasEventSpaceForChars(n);
+}
+
 // ----------------------------------------------------------------------------
 //                                                                      DEVICES
 
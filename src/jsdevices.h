@@ -156,11 +156,28 @@ typedef enum {
 #define IOEVENTFLAGS_GETTYPE(X) ((X)&EV_TYPE_MASK)
 #define IOEVENTFLAGS_GETCHARS(X) ((((X)&EV_CHARS_MASK)>>EV_CHARS_SHIFT)+1)
 #define IOEVENTFLAGS_SETCHARS(X,CHARS) ((X)=(((X)&(IOEventFlags)~EV_CHARS_MASK) | (((CHARS)-1)<<EV_CHARS_SHIFT)))
+#ifdef IOBULKBUFFERMASK
+/* If all the character bits are set on a serial event, the characters aren't
+ * in the event itself but are in the bulk buffer (see IOEventData.bulk). When
+ * characters arrive one at a time, a full event is moved to the bulk buffer so
+ * it can keep growing */
+#define IOEVENT_MAXCHARS 3 // See EV_CHARS_MASK
+#define IOEVENTFLAGS_ISBULK(X) (DEVICE_IS_SERIAL(IOEVENTFLAGS_GETTYPE(X)) && ((X)&EV_CHARS_MASK)==EV_CHARS_MASK)
+#define IOEVENTFLAGS_SETBULK(X) ((X)=(X)|EV_CHARS_MASK)
+#else
 #define IOEVENT_MAXCHARS 4 // See EV_CHARS_MASK
+#define IOEVENTFLAGS_ISBULK(X) (false)
+#endif
 
 typedef union {
   unsigned int time; ///< BOTTOM 32 BITS of time the event occurred
   char chars[IOEVENT_MAXCHARS]; ///< Characters received
+#ifdef IOBULKBUFFERMASK
+  struct {
+    unsigned short start; ///< Index of the first character in the bulk buffer
+    unsigned short len;   ///< Number of characters
+  } PACKED_FLAGS bulk; ///< Characters received, if IOEVENTFLAGS_ISBULK
+#endif
 } PACKED_FLAGS IOEventData;
 
 // IO Events - these happen when a pin changes
@@ -184,6 +201,12 @@ void jshPushIOCharEvents(IOEventFlags channel, char *data, unsigned int count);
 
 bool jshPopIOEvent(IOEvent *result); ///< returns true on success
 bool jshPopIOEventOfType(IOEventFlags eventType, IOEvent *result); ///< returns true on success
+/** Get the characters in a character event - returns the number of characters
+ * in a contiguous block starting `offset` characters in, and sets `data` to point to it */
+unsigned int jshGetIOEventChars(IOEvent *evt, unsigned int offset, char **data);
+/** Free any characters an event had stored in the bulk buffer. Must be called
+ * after the event is popped and its characters read, before popping another */
+void jshFreeIOEventChars(IOEvent *evt);
 /// Do we have any events pending? Will jshPopIOEvent return true?
 bool jshHasEvents();
 /// Check if the top event is for the given device
@@ -192,8 +215,10 @@ bool jshIsTopEvent(IOEventFlags eventType);
 /// How many event blocks are left? compare this to IOBUFFERMASK
 int jshGetEventsUsed();
 
-/// Do we have enough space for N characters?
+/// Do we have enough space for N characters, pushed as separate events?
 bool jshHasEventSpaceForChars(int n);
+/// Do we have enough space for N characters pushed with jshPushIOCharEvents (which can use the bulk buffer)?
+bool jshHasEventSpaceForCharEvents(int n);
 
 const char *jshGetDeviceString(IOEventFlags device);
 IOEventFlags jshFromDeviceString(const char *device);
@@ -205,6 +230,8 @@ JsVar *jshGetDeviceObject(IOEventFlags device);
 //                                                         DATA TRANSMIT BUFFER
 /// Queue a character for transmission
 void jshTransmit(IOEventFlags device, unsigned char data);
+/// Queue a buffer of characters for transmission
+void jshTransmitBuffer(IOEventFlags device, const unsigned char *data, size_t len);
 // Queue a formatted string for transmission
 void jshTransmitPrintf(IOEventFlags device, const char *fmt, ...);
 /// Wait for transmit to finish
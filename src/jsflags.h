@@ -19,7 +19,7 @@
 typedef enum {
   JSF_NONE,
   JSF_DEEP_SLEEP          = 1<<0, ///< Allow deep sleep modes (also set by setDeepSleep)
-  JSF_PRETOKENISE         = 1<<1, ///< When adding functions, pre-minify them and tokenise reserved words
+  JSF_PRETOKENISE         = 1<<1, ///< When adding functions, pre-minify them, tokenise reserved words and pre-parse literals/block lengths
   JSF_UNSAFE_FLASH        = 1<<2, ///< Some platforms stop writes/erases to interpreter memory to stop you bricking the device accidentally - this removes that protection
   JSF_UNSYNC_FILES        = 1<<3, ///< When accessing files, *don't* flush all data to the SD card after each command. Faster, but risky if power is lost
 } PACKED_FLAGS JsFlags;
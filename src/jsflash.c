@@ -53,6 +53,83 @@ static uint32_t jsfAlignAddress(uint32_t addr) {
   return (addr + (JSF_ALIGNMENT-1)) & (uint32_t)~(JSF_ALIGNMENT-1);
 }
 
+#ifndef SAVE_ON_FLASH
+/* In-RAM index of the files in Storage, so jsfFindFile doesn't have to walk
+ * every header in flash. It's an open-addressed hash table keyed on the first
+ * 4 chars of the filename (which is all a header walk reads), built by one
+ * full walk and then kept up to date as files are created and erased. Entries
+ * are only ever candidates - the full header is always checked in flash. */
+#ifndef JSF_INDEX_SIZE // normally set for each board in build_platform_config.py
+#define JSF_INDEX_SIZE 64
+#endif
+#define JSF_INDEX_DELETED 1 ///< 'addr' value for an entry whose file was erased
+
+typedef struct {
+  uint32_t firstChars; ///< First 4 chars of the filename
+  uint32_t addr;       ///< Address of the file's header, 0 if unused, or JSF_INDEX_DELETED
+} JsfIndexEntry;
+
+typedef enum {
+  JSFI_EMPTY,    ///< Index needs building
+  JSFI_COMPLETE, ///< Index contains every file in Storage
+  JSFI_OVERFLOW  ///< Too many files for the index - scan flash instead
+} JsfIndexState;
+
+static JsfIndexEntry jsfIndex[JSF_INDEX_SIZE];
+static JsfIndexState jsfIndexState = JSFI_EMPTY;
+static uint32_t jsfIndexUsed; ///< Entries that aren't 0 (including deleted ones)
+static uint32_t jsfIndexHits, jsfIndexNotFound, jsfIndexMisses;
+
+/// Clear the file index - call if flash in the Storage area was modified without using jsf* functions
+void jsfIndexClear() {
+  jsfIndexState = JSFI_EMPTY;
+}
+
+static uint32_t jsfIndexHash(uint32_t firstChars) {
+  return (firstChars * 2654435761U) >> 7;
+}
+
+/// Add the file whose header is at addr to the index. Keep the table under 3/4 full so probes stay short
+static void jsfIndexAdd(uint32_t firstChars, uint32_t addr) {
+  if (jsfIndexState!=JSFI_COMPLETE) return;
+  if (jsfIndexUsed >= JSF_INDEX_SIZE*3/4) {
+    jsfIndexState = JSFI_OVERFLOW;
+    return;
+  }
+  uint32_t i = jsfIndexHash(firstChars) % JSF_INDEX_SIZE;
+  while (jsfIndex[i].addr) i = (i+1) % JSF_INDEX_SIZE;
+  jsfIndex[i].firstChars = firstChars;
+  jsfIndex[i].addr = addr;
+  jsfIndexUsed++;
+}
+
+/// Remove the file whose header is at addr from the index
+static void jsfIndexRemove(uint32_t firstChars, uint32_t addr) {
+  if (jsfIndexState!=JSFI_COMPLETE) return;
+  uint32_t i = jsfIndexHash(firstChars) % JSF_INDEX_SIZE;
+  while (jsfIndex[i].addr) {
+    if (jsfIndex[i].addr == addr) {
+      jsfIndex[i].addr = JSF_INDEX_DELETED; // keep the probe chain intact
+      return;
+    }
+    i = (i+1) % JSF_INDEX_SIZE;
+  }
+}
+
+void jsfGetIndexStats(JsfIndexStats *stats) {
+  stats->size = JSF_INDEX_SIZE;
+  stats->used = 0;
+  if (jsfIndexState==JSFI_COMPLETE) {
+    int i;
+    for (i=0;i<JSF_INDEX_SIZE;i++)
+      if (jsfIndex[i].addr > JSF_INDEX_DELETED) stats->used++;
+  }
+  stats->hits = jsfIndexHits;
+  stats->notFound = jsfIndexNotFound;
+  stats->misses = jsfIndexMisses;
+}
+#endif
+
 JsfFileName jsfNameFromString(const char *name) {
   assert(strlen(name)<=sizeof(JsfFileName));
   char nameBuf[sizeof(JsfFileName)+1];
@@ -130,6 +207,9 @@ static bool jsfIsEqual(uint32_t addr, const unsigned char *data, uint32_t len) {
 
 /// Erase the entire contents of the memory store
 static bool jsfEraseFrom(uint32_t startAddr) {
+#ifndef SAVE_ON_FLASH
+  jsfIndexClear();
+#endif
   uint32_t addr, len;
   if (!jshFlashGetPage(startAddr, &addr, &len))
     return false;
@@ -155,6 +235,9 @@ static void jsfEraseFileInternal(uint32_t addr, JsfFileHeader *header) {
   DBG("EraseFile 0x%08x\n", addr);
 
   addr -= (uint32_t)sizeof(JsfFileHeader);
+#ifndef SAVE_ON_FLASH
+  jsfIndexRemove(header->name.firstChars, addr);
+#endif
   addr += (uint32_t)((char*)&header->name.firstChars - (char*)header);
   header->name.firstChars = 0;
   jshFlashWrite(&header->name.firstChars,addr,(uint32_t)sizeof(header->name.firstChars));
@@ -422,31 +505,73 @@ static uint32_t jsfCreateFile(JsfFileName name, uint32_t size, JsfFileFlags flag
   DBG("CreateFile write header\n");
   jshFlashWrite(&header,addr,(uint32_t)sizeof(JsfFileHeader));
   DBG("CreateFile written header\n");
+#ifndef SAVE_ON_FLASH
+  jsfIndexAdd(name.firstChars, addr);
+#endif
   if (returnedHeader) *returnedHeader = header;
   return addr+(uint32_t)sizeof(JsfFileHeader);
 }
 
+/// Load the full header at addr and see if it's the file we want. Returns the address of data start, or 0
+static uint32_t jsfCheckFileHeader(uint32_t addr, JsfFileName name, JsfFileHeader *header, JsfFileHeader *returnedHeader) {
+  // Now load the whole header (with name) and check properly
+  jsfGetFileHeader(addr, header, true);
+  if (memcmp(header->name.c, name.c, sizeof(name.c))!=0)
+    return 0;
+  uint32_t endOfFile = addr + (uint32_t)sizeof(JsfFileHeader) + jsfGetFileSize(header);
+  if (endOfFile<addr || endOfFile>JSF_END_ADDRESS)
+    return 0; // corrupt - file too long
+  if (returnedHeader)
+    *returnedHeader = *header;
+  return addr+(uint32_t)sizeof(JsfFileHeader);
+}
+
 /// Find a 'file' in the memory store. Return the address of data start (and header if returnedHeader!=0). Returns 0 if not found
 uint32_t jsfFindFile(JsfFileName name, JsfFileHeader *returnedHeader) {
   uint32_t addr = JSF_START_ADDRESS;
+  uint32_t found = 0;
   JsfFileHeader header;
   memset(&header,0,sizeof(JsfFileHeader));
+#ifndef SAVE_ON_FLASH
+  if (jsfIndexState==JSFI_COMPLETE) {
+    uint32_t i = jsfIndexHash(name.firstChars) % JSF_INDEX_SIZE;
+    while (jsfIndex[i].addr) {
+      if (jsfIndex[i].addr!=JSF_INDEX_DELETED && jsfIndex[i].firstChars==name.firstChars) {
+        found = jsfCheckFileHeader(jsfIndex[i].addr, name, &header, returnedHeader);
+        if (found) {
+          jsfIndexHits++;
+          return found;
+        }
+      }
+      i = (i+1) % JSF_INDEX_SIZE;
+    }
+    jsfIndexNotFound++;
+    return 0;
+  }
+  jsfIndexMisses++;
+  // No index - walk all the files, and (re)build the index while we're at it
+  bool buildIndex = jsfIndexState==JSFI_EMPTY;
+  if (buildIndex) {
+    memset(jsfIndex, 0, sizeof(jsfIndex));
+    jsfIndexUsed = 0;
+    jsfIndexState = JSFI_COMPLETE;
+  }
+#endif
   if (jsfGetFileHeader(addr, &header, false)) do {
+#ifndef SAVE_ON_FLASH
+    if (buildIndex && header.name.firstChars)
+      jsfIndexAdd(header.name.firstChars, addr);
+#endif
     // check for something with the same first 4 chars of name that hasn't been replaced.
-    if (header.name.firstChars == name.firstChars) {
-      // Now load the whole header (with name) and check properly
-      jsfGetFileHeader(addr, &header, true);
-      if (memcmp(header.name.c, name.c, sizeof(name.c))==0) {
-        uint32_t endOfFile = addr + (uint32_t)sizeof(JsfFileHeader) + jsfGetFileSize(&header);
-        if (endOfFile<addr || endOfFile>JSF_END_ADDRESS)
-          return 0; // corrupt - file too long
-        if (returnedHeader)
-          *returnedHeader = header;
-        return addr+(uint32_t)sizeof(JsfFileHeader);
-      }
+    if (!found && header.name.firstChars == name.firstChars) {
+      found = jsfCheckFileHeader(addr, name, &header, returnedHeader);
+#ifndef SAVE_ON_FLASH
+      if (!buildIndex || jsfIndexState!=JSFI_COMPLETE)
+#endif
+        if (found) return found;
     }
   } while (jsfGetNextFileHeader(&addr, &header, GNFH_GET_ALL|GNFH_READ_ONLY_FILENAME_START)); // still only get first 4 chars of name
-  return 0;
+  return found;
 }
 
 
@@ -540,16 +665,17 @@ JsVar *jsfReadFile(JsfFileName name, int offset, int length) {
   }
 #endif
 #ifdef LINUX
-  // linux fakes flash with a file, so we can't just return a pointer to it!
-  uint32_t alignedSize = jsfAlignAddress((uint32_t)length);
-  char *d = (char*)malloc(alignedSize);
-  jshFlashRead(d, addr, alignedSize);
-  JsVar *v = jsvNewStringOfLength((uint32_t)length, d);
-  free(d);
-  return v;
-#else
-  return jsvNewNativeString((char*)mappedAddr, length);
+  if (!mappedAddr) {
+    // linux fakes flash with a file - if it couldn't be memory-mapped we have to copy it
+    uint32_t alignedSize = jsfAlignAddress((uint32_t)length);
+    char *d = (char*)malloc(alignedSize);
+    jshFlashRead(d, addr, alignedSize);
+    JsVar *v = jsvNewStringOfLength((uint32_t)length, d);
+    free(d);
+    return v;
+  }
 #endif
+  return jsvNewNativeString((char*)mappedAddr, (size_t)length);
 }
 
 bool jsfWriteFile(JsfFileName name, JsVar *data, JsfFileFlags flags, JsVarInt offset, JsVarInt _size) {
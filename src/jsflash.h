@@ -72,6 +72,21 @@ bool jsfIsStorageValid();
 // Get the amount of space free in this page (or all pages). addr=0 uses start page
 uint32_t jsfGetFreeSpace(uint32_t addr, bool allPages);
 
+#ifndef SAVE_ON_FLASH
+/// Statistics for the in-RAM index of files used by jsfFindFile
+typedef struct {
+  uint32_t size;   ///< How many entries the index has
+  uint32_t used;   ///< How many files are currently in the index
+  uint32_t hits;   ///< Lookups where the index found the file
+  uint32_t notFound; ///< Lookups where the index showed the file doesn't exist
+  uint32_t misses; ///< Lookups that had to scan flash
+} JsfIndexStats;
+/// Get statistics for the file index
+void jsfGetIndexStats(JsfIndexStats *stats);
+/// Clear the file index - call if flash in the Storage area was modified without using jsf* functions
+void jsfIndexClear();
+#endif
+
 // ------------------------------------------------------------------------ For loading/saving code to flash
 /// Save contents of JsVars into Flash.
 void jsfSaveToFlash();
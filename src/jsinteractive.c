@@ -69,6 +69,7 @@ Pin pinSleepIndicator = DEFAULT_SLEEP_PIN_INDICATOR;
 #endif
 JsiStatus jsiStatus = 0;
 JsSysTime jsiLastIdleTime;  ///< The last time we went around the idle loop - use this for timers
+JsSysTime jsiTimerBaseTime; ///< Timers' 'time' values are relative to this
 uint32_t jsiTimeSinceCtrlC;
 // ----------------------------------------------------------------------------
 JsVar *inputLine = 0; ///< The current input line
@@ -224,8 +225,15 @@ NO_INLINE void jsiConsolePrintChar(char data) {
  */
 NO_INLINE void jsiConsolePrintString(const char *str) {
   while (*str) {
-    if (*str == '\n') jsiConsolePrintChar('\r');
-    jsiConsolePrintChar(*(str++));
+    // send everything up to the next newline in one go
+    const char *end = str;
+    while (*end && *end!='\n') end++;
+    jshTransmitBuffer(consoleDevice, (const unsigned char*)str, (size_t)(end-str));
+    str = end;
+    if (*str == '\n') {
+      jshTransmitBuffer(consoleDevice, (const unsigned char*)"\r\n", 2);
+      str++;
+    }
   }
 }
 
@@ -285,16 +293,24 @@ void jsiConsolePrintStringVarUntilEOL(JsVar *v, size_t fromCharacter, size_t max
 /** Print the contents of a string var - directly - starting from the given character, and
  * using newLineCh to prefix new lines (if it is not 0). */
 void jsiConsolePrintStringVarWithNewLineChar(JsVar *v, size_t fromCharacter, char newLineCh) {
+  // gather characters up so they can be sent with jshTransmitBuffer
+  unsigned char buf[64];
+  size_t bufLen = 0;
   JsvStringIterator it;
   jsvStringIteratorNew(&it, v, fromCharacter);
   while (jsvStringIteratorHasChar(&it)) {
+    if (bufLen+3 > sizeof(buf)) {
+      jshTransmitBuffer(consoleDevice, buf, bufLen);
+      bufLen = 0;
+    }
     char ch = jsvStringIteratorGetChar(&it);
-    if (ch == '\n') jsiConsolePrintChar('\r');
-    jsiConsolePrintChar(ch);
-    if (ch == '\n' && newLineCh) jsiConsolePrintChar(newLineCh);
+    if (ch == '\n') buf[bufLen++] = '\r';
+    buf[bufLen++] = (unsigned char)ch;
+    if (ch == '\n' && newLineCh) buf[bufLen++] = (unsigned char)newLineCh;
     jsvStringIteratorNext(&it);
   }
   jsvStringIteratorFree(&it);
+  jshTransmitBuffer(consoleDevice, buf, bufLen);
 }
 
 /**
@@ -435,6 +451,246 @@ static JsVarRef _jsiInitNamedArray(const char *name) {
   return arrayRef;
 }
 
+/* Timers are kept in a binary heap ordered by when they are due, so the idle
+ * loop only has to look at the first one to see if anything needs doing. The
+ * heap is stored in a flat string and has each timer's 'time' (which is
+ * relative to jsiTimerBaseTime) along with the ref of its name in timerArray.
+ * timerArray is still what's used for IDs, dump() and save() - the heap can
+ * always be rebuilt from it. */
+typedef struct {
+  JsSysTime time;
+  JsVarRef name;
+} PACKED_FLAGS JsiTimerHeapEntry;
+static JsVar *timerHeapVar = 0; ///< Flat string containing the heap (locked while we have it)
+static JsiTimerHeapEntry *timerHeap = 0;
+static unsigned int timerHeapCount = 0; ///< Number of timers in the heap
+static unsigned int timerHeapSize = 0; ///< Number of timers there's space for in the heap
+static bool timerHeapInvalid = false; ///< Set if we ran out of memory and have to rebuild the heap from timerArray
+
+static void jsiTimerHeapSwap(unsigned int a, unsigned int b) {
+  JsiTimerHeapEntry t = timerHeap[a];
+  timerHeap[a] = timerHeap[b];
+  timerHeap[b] = t;
+}
+
+static void jsiTimerHeapSiftUp(unsigned int i) {
+  while (i) {
+    unsigned int parent = (i-1)>>1;
+    if (timerHeap[parent].time <= timerHeap[i].time) return;
+    jsiTimerHeapSwap(i, parent);
+    i = parent;
+  }
+}
+
+static void jsiTimerHeapSiftDown(unsigned int i) {
+  while (true) {
+    unsigned int l = i*2+1, r = l+1, smallest = i;
+    if (l<timerHeapCount && timerHeap[l].time < timerHeap[smallest].time) smallest = l;
+    if (r<timerHeapCount && timerHeap[r].time < timerHeap[smallest].time) smallest = r;
+    if (smallest==i) return;
+    jsiTimerHeapSwap(i, smallest);
+    i = smallest;
+  }
+}
+
+/// Set the time of the given heap entry, and move it to the right place
+static void jsiTimerHeapSetTime(unsigned int i, JsSysTime time) {
+  timerHeap[i].time = time;
+  jsiTimerHeapSiftDown(i);
+  jsiTimerHeapSiftUp(i);
+}
+
+/// Return the index in the heap of the timer with the given name, or -1
+static int jsiTimerHeapFind(JsVarRef name) {
+  for (unsigned int i=0;i<timerHeapCount;i++)
+    if (timerHeap[i].name == name) return (int)i;
+  return -1;
+}
+
+static void jsiTimerHeapFree() {
+  jsvUnLock(timerHeapVar);
+  timerHeapVar = 0;
+  timerHeap = 0;
+  timerHeapCount = 0;
+  timerHeapSize = 0;
+}
+
+static void jsiTimerHeapPush(JsVarRef name, JsSysTime time) {
+  if (timerHeapCount >= timerHeapSize) {
+    unsigned int newSize = timerHeapSize ? timerHeapSize*2 : 4;
+    JsVar *newVar = jsvNewFlatStringOfLength((unsigned int)(newSize*sizeof(JsiTimerHeapEntry)));
+    if (!newVar) {
+      timerHeapInvalid = true;
+      return;
+    }
+    JsiTimerHeapEntry *newHeap = (JsiTimerHeapEntry*)jsvGetFlatStringPointer(newVar);
+    if (timerHeapCount) memcpy(newHeap, timerHeap, timerHeapCount*sizeof(JsiTimerHeapEntry));
+    jsvUnLock(timerHeapVar);
+    timerHeapVar = newVar;
+    timerHeap = newHeap;
+    timerHeapSize = newSize;
+  }
+  unsigned int i = timerHeapCount++;
+  timerHeap[i].name = name;
+  timerHeap[i].time = time;
+  jsiTimerHeapSiftUp(i);
+}
+
+static void jsiTimerHeapRemove(unsigned int i) {
+  timerHeapCount--;
+  if (i<timerHeapCount) {
+    timerHeap[i] = timerHeap[timerHeapCount];
+    jsiTimerHeapSiftDown(i);
+    jsiTimerHeapSiftUp(i);
+  }
+  if (!timerHeapCount) jsiTimerHeapFree();
+}
+
+/// Get the 'time' of the timer with the given name in timerArray
+static JsSysTime jsiTimerGetTime(JsVar *timerName) {
+  JsVar *timerPtr = jsvSkipName(timerName);
+  JsSysTime time = (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timerPtr, "time", 0));
+  jsvUnLock(timerPtr);
+  return time;
+}
+
+/// Build the timer heap from scratch using timerArray
+void jsiTimerHeapRebuild() {
+  jsiTimerHeapFree();
+  timerHeapInvalid = false;
+  if (!timerArray) return;
+  JsVar *timerArrayPtr = jsvLock(timerArray);
+  JsvObjectIterator it;
+  jsvObjectIteratorNew(&it, timerArrayPtr);
+  while (jsvObjectIteratorHasValue(&it)) {
+    JsVar *timerName = jsvObjectIteratorGetKey(&it);
+    jsiTimerHeapPush(jsvGetRef(timerName), jsiTimerGetTime(timerName));
+    jsvUnLock(timerName);
+    jsvObjectIteratorNext(&it);
+  }
+  jsvObjectIteratorFree(&it);
+  jsvUnLock(timerArrayPtr);
+}
+
+#ifndef SAVE_ON_FLASH
+/* Most events have a callback, 'this' and a couple of arguments, so rather
+ * than creating an object and args array for each one (and then searching
+ * them again when we execute it) we keep them in a small fixed-size ring of
+ * refs. The refs (not locks) keep the vars alive, jsiGarbageCollectMarkEvents
+ * marks them for the GC and jsiEventsRefMoved updates them after a defrag.
+ * If the ring is full or an event doesn't fit, we fall back to 'events' - and
+ * while anything is in 'events' new events go there too so order is kept. */
+typedef struct {
+  JsVarRef func;
+  JsVarRef thisVar;
+  JsVarRef args[JSI_EVENT_RING_ARGS];
+  unsigned char argCount;
+} PACKED_FLAGS JsiEventRingEntry;
+static JsiEventRingEntry eventRing[JSI_EVENT_RING_SIZE];
+static unsigned int eventRingHead = 0; ///< Index of the next event to execute
+static unsigned int eventRingCount = 0; ///< Number of events in the ring
+static unsigned int eventArrayCount = 0; ///< Number of events in 'events'
+JsiEventStats jsiEventStats;
+
+/// Can this var be kept in the event ring?
+static bool jsiEventRingCanStore(JsVar *v) {
+  return !v || (jsvHasRef(v) && !jsvIsName(v));
+}
+
+/// Try and add an event to the ring, return false if it won't fit
+static bool jsiEventRingPush(JsVar *object, JsVar *callback, JsVar **args, int argCount) {
+  if (eventRingCount>=JSI_EVENT_RING_SIZE || argCount>JSI_EVENT_RING_ARGS ||
+      !jsvArrayIsEmpty(events))
+    return false;
+  if (!callback || !jsiEventRingCanStore(callback) || !jsiEventRingCanStore(object))
+    return false;
+  int i;
+  for (i=0;i<argCount;i++)
+    if (!jsiEventRingCanStore(args[i])) return false;
+  JsiEventRingEntry *e = &eventRing[(eventRingHead+eventRingCount) % JSI_EVENT_RING_SIZE];
+  e->func = jsvGetRef(jsvRef(callback));
+  e->thisVar = object ? jsvGetRef(jsvRef(object)) : 0;
+  for (i=0;i<argCount;i++)
+    e->args[i] = args[i] ? jsvGetRef(jsvRef(args[i])) : 0;
+  e->argCount = (unsigned char)argCount;
+  eventRingCount++;
+  return true;
+}
+
+/// Lock a ref that was stored in the event ring, and remove the ring's reference to it
+static JsVar *jsiEventRingTake(JsVarRef ref) {
+  if (!ref) return 0;
+  JsVar *v = jsvLock(ref);
+  jsvUnRef(v);
+  return v;
+}
+
+/// Remove the first event from the ring and execute it
+static void jsiEventRingExecuteFirst() {
+  JsiEventRingEntry e = eventRing[eventRingHead];
+  eventRingHead = (eventRingHead+1) % JSI_EVENT_RING_SIZE;
+  eventRingCount--;
+  JsVar *func = jsiEventRingTake(e.func);
+  JsVar *thisVar = jsiEventRingTake(e.thisVar);
+  JsVar *args[JSI_EVENT_RING_ARGS];
+  unsigned int i;
+  for (i=0;i<e.argCount;i++)
+    args[i] = jsiEventRingTake(e.args[i]);
+  jsiExecuteEventCallback(thisVar, func, e.argCount, args);
+  jsvUnLockMany(e.argCount, args);
+  jsvUnLock2(func, thisVar);
+}
+
+/// Remove all events from the ring without executing them
+static void jsiEventRingClear() {
+  while (eventRingCount) {
+    JsiEventRingEntry *e = &eventRing[eventRingHead];
+    jsvUnRefRef(e->func);
+    if (e->thisVar) jsvUnRefRef(e->thisVar);
+    for (unsigned int i=0;i<e->argCount;i++)
+      if (e->args[i]) jsvUnRefRef(e->args[i]);
+    eventRingHead = (eventRingHead+1) % JSI_EVENT_RING_SIZE;
+    eventRingCount--;
+  }
+  eventRingHead = 0;
+}
+
+/// Mark everything in the event ring as used (called by the garbage collector)
+void jsiGarbageCollectMarkEvents() {
+  for (unsigned int n=0;n<eventRingCount;n++) {
+    JsiEventRingEntry *e = &eventRing[(eventRingHead+n) % JSI_EVENT_RING_SIZE];
+    jsvGarbageCollectMarkRef(e->func);
+    jsvGarbageCollectMarkRef(e->thisVar);
+    for (unsigned int i=0;i<e->argCount;i++)
+      jsvGarbageCollectMarkRef(e->args[i]);
+  }
+}
+
+/// A var has been moved from one ref to another (called when defragmenting)
+void jsiEventsRefMoved(JsVarRef from, JsVarRef to) {
+  for (unsigned int n=0;n<eventRingCount;n++) {
+    JsiEventRingEntry *e = &eventRing[(eventRingHead+n) % JSI_EVENT_RING_SIZE];
+    if (e->func==from) e->func = to;
+    if (e->thisVar==from) e->thisVar = to;
+    for (unsigned int i=0;i<e->argCount;i++)
+      if (e->args[i]==from) e->args[i] = to;
+  }
+}
+
+/// The number of events waiting to be executed
+unsigned int jsiGetEventQueueDepth() {
+  return eventRingCount + eventArrayCount;
+}
+#endif
+
+/// Are there any events waiting to be executed?
+static bool jsiHasEvents() {
+#ifndef SAVE_ON_FLASH
+  if (eventRingCount) return true;
+#endif
+  return !jsvArrayIsEmpty(events);
+}
+
 // Used when recovering after being flashed
 // 'claim' anything we are using
 void jsiSoftInit(bool hasBeenReset) {
@@ -460,6 +716,9 @@ void jsiSoftInit(bool hasBeenReset) {
   // Make sure we set up lastIdleTime, as this could be used
   // when adding an interval from onInit (called below)
   jsiLastIdleTime = jshGetSystemTime();
+  // Saved timers' times are relative to when they were saved
+  jsiTimerBaseTime = jsiLastIdleTime;
+  jsiTimerHeapRebuild();
   jsiTimeSinceCtrlC = 0xFFFFFFFF;
 
   // Set up interpreter flags and remove
@@ -733,14 +992,35 @@ void jsiSoftKill() {
   // Stop all active timer tasks
   jstReset();
   // Unref Watches/etc
+#ifndef SAVE_ON_FLASH
+  jsiEventRingClear();
+#endif
   if (events) {
     jsvUnLock(events);
     events=0;
   }
+#ifndef SAVE_ON_FLASH
+  eventArrayCount = 0;
+#endif
   if (timerArray) {
+    // Make timers' times relative to now, so they're right when they're loaded again
+    JsSysTime timePassed = jshGetSystemTime() - jsiTimerBaseTime;
+    JsVar *timerArrayPtr = jsvLock(timerArray);
+    JsvObjectIterator it;
+    jsvObjectIteratorNew(&it, timerArrayPtr);
+    while (jsvObjectIteratorHasValue(&it)) {
+      JsVar *timerPtr = jsvObjectIteratorGetValue(&it);
+      JsSysTime time = (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timerPtr, "time", 0));
+      jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger(time - timePassed));
+      jsvUnLock(timerPtr);
+      jsvObjectIteratorNext(&it);
+    }
+    jsvObjectIteratorFree(&it);
+    jsvUnLock(timerArrayPtr);
     jsvUnRefRef(timerArray);
     timerArray=0;
   }
+  jsiTimerHeapFree();
   if (watchArray) {
     // Check any existing watches and disable interrupts for them
     JsVar *watchArrayPtr = jsvLock(watchArray);
@@ -1625,6 +1905,15 @@ void jsiHandleChar(char ch) {
 void jsiQueueEvents(JsVar *object, JsVar *callback, JsVar **args, int argCount) { // an array of functions, a string, or a single function
   assert(argCount<10);
 
+#ifndef SAVE_ON_FLASH
+  jsiEventStats.queued++;
+  if (jsiEventRingPush(object, callback, args, argCount)) {
+    if (eventRingCount > jsiEventStats.maxDepth)
+      jsiEventStats.maxDepth = eventRingCount;
+    return;
+  }
+  jsiEventStats.overflows++;
+#endif
   JsVar *event = jsvNewObject();
   if (event) { // Could be out of memory error!
     jsvUnLock(jsvAddNamedChild(event, callback, "func"));
@@ -1638,6 +1927,14 @@ void jsiQueueEvents(JsVar *object, JsVar *callback, JsVar **args, int argCount)
     if (object) jsvUnLock(jsvAddNamedChild(event, object, "this"));
 
     jsvArrayPushAndUnLock(events, event);
+#ifndef SAVE_ON_FLASH
+    eventArrayCount++;
+    unsigned int depth = jsiGetEventQueueDepth();
+    if (depth > jsiEventStats.maxDepth)
+      jsiEventStats.maxDepth = depth;
+  } else {
+    jsiEventStats.dropped++;
+#endif
   }
 }
 
@@ -1663,10 +1960,23 @@ void jsiExecuteObjectCallbacks(JsVar *object, const char *callbackName, JsVar **
 }
 
 void jsiExecuteEvents() {
-  bool hasEvents = !jsvArrayIsEmpty(events);
+  bool hasEvents = jsiHasEvents();
   if (hasEvents) jsiSetBusy(BUSY_INTERACTIVE, true);
+#ifndef SAVE_ON_FLASH
+  /* Anything in the ring was queued before anything in 'events', but events
+   * we execute may queue more - so keep going until both are empty */
+  while (eventRingCount || !jsvArrayIsEmpty(events)) {
+    if (eventRingCount) {
+      jsiEventRingExecuteFirst();
+      continue;
+    }
+#else
   while (!jsvArrayIsEmpty(events)) {
+#endif
     JsVar *event = jsvSkipNameAndUnLock(jsvArrayPopFirst(events));
+#ifndef SAVE_ON_FLASH
+    if (eventArrayCount) eventArrayCount--;
+#endif
     // Get function to execute
     JsVar *func = jsvObjectGetChild(event, "func", 0);
     JsVar *thisVar = jsvObjectGetChild(event, "this", 0);
@@ -1810,24 +2120,24 @@ static JsVar *jsiExtractIOEventData(IOEvent *event, int *eventsHandled) {
   *eventsHandled = 0;
 
   JsVar *stringData = jsvNewFromEmptyString();
-  if (stringData) {
-    JsvStringIterator it;
-    jsvStringIteratorNew(&it, stringData, 0);
-
-    int i, chars = IOEVENTFLAGS_GETCHARS(event->flags);
-    while (chars) {
-      for (i=0;i<chars;i++) {
-        jsvStringIteratorAppend(&it, event->data.chars[i]);
+  bool hasData = true;
+  while (hasData) {
+    // append the event's characters a block at a time
+    if (stringData) {
+      char *data;
+      unsigned int offset = 0, len;
+      while ((len = jshGetIOEventChars(event, offset, &data))) {
+        jsvAppendStringBuf(stringData, data, len);
+        offset += len;
       }
-      // look down the stack and see if there is more data
-      if (jshIsTopEvent(IOEVENTFLAGS_GETTYPE(event->flags))) {
-        jshPopIOEvent(event);
-        (*eventsHandled)++;
-        chars = IOEVENTFLAGS_GETCHARS(event->flags);
-      } else
-        chars = 0;
     }
-    jsvStringIteratorFree(&it);
+    jshFreeIOEventChars(event);
+    // look down the stack and see if there is more data
+    hasData = jshIsTopEvent(IOEVENTFLAGS_GETTYPE(event->flags));
+    if (hasData) {
+      jshPopIOEvent(event);
+      (*eventsHandled)++;
+    }
   }
   return stringData;
 }
@@ -1847,9 +2157,28 @@ int jsiHandleIOEventForUSART(JsVar *usartClass, IOEvent *event) {
 }
 
 void jsiHandleIOEventForConsole(IOEvent *event) {
-  int i, c = IOEVENTFLAGS_GETCHARS(event->flags);
   jsiSetBusy(BUSY_INTERACTIVE, true);
-  for (i=0;i<c;i++) jsiHandleChar(event->data.chars[i]);
+  if (IOEVENTFLAGS_ISBULK(event->flags)) {
+    /* Handling characters can execute code, so copy them out of the bulk
+    buffer and free it first */
+    int eventsHandled;
+    JsVar *stringData = jsiExtractIOEventData(event, &eventsHandled);
+    NOT_USED(eventsHandled);
+    if (stringData) {
+      JsvStringIterator it;
+      jsvStringIteratorNew(&it, stringData, 0);
+      while (jsvStringIteratorHasChar(&it)) {
+        char ch = jsvStringIteratorGetChar(&it);
+        jsvStringIteratorNext(&it);
+        jsiHandleChar(ch);
+      }
+      jsvStringIteratorFree(&it);
+      jsvUnLock(stringData);
+    }
+  } else {
+    int i, c = IOEVENTFLAGS_GETCHARS(event->flags);
+    for (i=0;i<c;i++) jsiHandleChar(event->data.chars[i]);
+  }
   jsiSetBusy(BUSY_INTERACTIVE, false);
 }
 
@@ -1937,8 +2266,9 @@ void jsiIdle() {
 
             JsVar *timeout = jsvObjectGetChild(watchPtr, "timeout", 0);
             if (timeout) { // if we had a timeout, update the callback time
-              JsSysTime timeoutTime = jsiLastIdleTime + (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timeout, "time", 0));
-              jsvUnLock(jsvObjectSetChild(timeout, "time", jsvNewFromLongInteger((JsSysTime)(eventTime - jsiLastIdleTime) + debounce)));
+              JsSysTime timeoutTime = jsiTimerBaseTime + (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timeout, "time", 0));
+              jsvUnLock(jsvObjectSetChild(timeout, "time", jsvNewFromLongInteger((JsSysTime)(eventTime - jsiTimerBaseTime) + debounce)));
+              jsiTimerUpdated(timeout);
               if (eventTime > timeoutTime) {
                 // timeout should have fired, but we didn't get around to executing it!
                 // Do it now (with the old timeout time)
@@ -1950,7 +2280,7 @@ void jsiIdle() {
               timeout = jsvNewObject();
               if (timeout) {
                 jsvObjectSetChild(timeout, "watch", watchPtr); // no unlock
-                jsvObjectSetChildAndUnLock(timeout, "time", jsvNewFromLongInteger((JsSysTime)(eventTime - jsiLastIdleTime) + debounce));
+                jsvObjectSetChildAndUnLock(timeout, "time", jsvNewFromLongInteger((JsSysTime)(eventTime - jsiTimerBaseTime) + debounce));
                 jsvObjectSetChildAndUnLock(timeout, "callback", jsvObjectGetChild(watchPtr, "callback", 0));
                 jsvObjectSetChildAndUnLock(timeout, "lastTime", jsvObjectGetChild(watchPtr, "lastTime", 0));
                 jsvObjectSetChildAndUnLock(timeout, "pin", jsvNewFromPin(pin));
@@ -2006,6 +2336,8 @@ void jsiIdle() {
       jsvObjectIteratorFree(&it);
       jsvUnLock(watchArrayPtr);
     }
+    // If characters weren't used (eg. no handler), make sure we free them
+    jshFreeIOEventChars(&event);
   }
 
   // Reset Flow control if it was set...
@@ -2025,107 +2357,107 @@ void jsiIdle() {
     jsiTimeSinceCtrlC = 0xFFFFFFFF;
 
   jsiStatus = jsiStatus & ~JSIS_TIMERS_CHANGED;
+  if (timerHeapInvalid) jsiTimerHeapRebuild();
+  JsSysTime timerNow = time - jsiTimerBaseTime;
+  // Only ever run as many timers as there were to start with - so an interval that's behind can't stop us returning
+  unsigned int timersToRun = timerHeapCount;
   JsVar *timerArrayPtr = jsvLock(timerArray);
-  JsvObjectIterator it;
-  jsvObjectIteratorNew(&it, timerArrayPtr);
-  while (jsvObjectIteratorHasValue(&it) && !(jsiStatus & JSIS_TIMERS_CHANGED)) {
-    bool hasDeletedTimer = false;
-    JsVar *timerPtr = jsvObjectIteratorGetValue(&it);
-    JsSysTime timerTime = (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timerPtr, "time", 0));
-    JsSysTime timeUntilNext = timerTime - timePassed;
-
-    if (timeUntilNext<=0) {
-      // we're now doing work
-      jsiSetBusy(BUSY_INTERACTIVE, true);
-      wasBusy = true;
-      JsVar *timerCallback = jsvObjectGetChild(timerPtr, "callback", 0);
-      JsVar *watchPtr = jsvObjectGetChild(timerPtr, "watch", 0); // for debounce - may be undefined
-      bool exec = true;
-      JsVar *data = 0;
-      if (watchPtr) {
-        data = jsvNewObject();
-        // if we were from a watch then we were delayed by the debounce time...
-        if (data) {
-          JsVarInt delay = jsvGetIntegerAndUnLock(jsvObjectGetChild(watchPtr, "debounce", 0));
-          // Create the 'time' variable that will be passed to the user
-          JsVar *timePtr = jsvNewFromFloat(jshGetMillisecondsFromTime(jsiLastIdleTime+timeUntilNext-delay)/1000);
-          // if it was a watch, set the last state up
-          bool state = jsvGetBoolAndUnLock(jsvObjectSetChild(data, "state", jsvObjectGetChild(watchPtr, "state", 0)));
-          exec = jsiShouldExecuteWatch(watchPtr, state);
-          // set up the lastTime variable of data to what was in the watch
-          jsvObjectSetChildAndUnLock(data, "lastTime", jsvObjectGetChild(watchPtr, "lastTime", 0));
-          // set up the watches lastTime to this one
-          jsvObjectSetChild(watchPtr, "lastTime", timePtr); // don't unlock
-          jsvObjectSetChildAndUnLock(data, "time", timePtr);
-        }
+  while (timerHeapCount && timersToRun && !(jsiStatus & JSIS_TIMERS_CHANGED)) {
+    JsSysTime timerTime = timerHeap[0].time;
+    if (timerTime > timerNow) break; // the first timer isn't due - so none of them are
+    timersToRun--;
+    // Keep the name locked, so its ref can't be reused if the timer gets removed while executing
+    JsVar *timerName = jsvLock(timerHeap[0].name);
+    JsVar *timerPtr = jsvSkipName(timerName);
+    JsSysTime timeUntilNext = timerTime - timerNow;
+    // we're now doing work
+    jsiSetBusy(BUSY_INTERACTIVE, true);
+    wasBusy = true;
+    JsVar *timerCallback = jsvObjectGetChild(timerPtr, "callback", 0);
+    JsVar *watchPtr = jsvObjectGetChild(timerPtr, "watch", 0); // for debounce - may be undefined
+    bool exec = true;
+    JsVar *data = 0;
+    if (watchPtr) {
+      data = jsvNewObject();
+      // if we were from a watch then we were delayed by the debounce time...
+      if (data) {
+        JsVarInt delay = jsvGetIntegerAndUnLock(jsvObjectGetChild(watchPtr, "debounce", 0));
+        // Create the 'time' variable that will be passed to the user
+        JsVar *timePtr = jsvNewFromFloat(jshGetMillisecondsFromTime(jsiLastIdleTime+timeUntilNext-delay)/1000);
+        // if it was a watch, set the last state up
+        bool state = jsvGetBoolAndUnLock(jsvObjectSetChild(data, "state", jsvObjectGetChild(watchPtr, "state", 0)));
+        exec = jsiShouldExecuteWatch(watchPtr, state);
+        // set up the lastTime variable of data to what was in the watch
+        jsvObjectSetChildAndUnLock(data, "lastTime", jsvObjectGetChild(watchPtr, "lastTime", 0));
+        // set up the watches lastTime to this one
+        jsvObjectSetChild(watchPtr, "lastTime", timePtr); // don't unlock
+        jsvObjectSetChildAndUnLock(data, "time", timePtr);
       }
-      bool removeTimer = false;
-      if (exec) {
-        bool execResult;
-        if (data) {
-          execResult = jsiExecuteEventCallback(0, timerCallback, 1, &data);
-        } else {
-          JsVar *argsArray = jsvObjectGetChild(timerPtr, "args", 0);
-          execResult = jsiExecuteEventCallbackArgsArray(0, timerCallback, argsArray);
-          jsvUnLock(argsArray);
-        }
-        if (!execResult) {
-          JsVar *interval = jsvObjectGetChild(timerPtr, "interval", 0);
-          if (interval) { // if interval then it's setInterval not setTimeout
-            jsvUnLock(interval);
-            jsError("Ctrl-C while processing interval - removing it.");
-            jsErrorFlags |= JSERR_CALLBACK;
-            removeTimer = true;
-          }
+    }
+    bool removeTimer = false;
+    if (exec) {
+      bool execResult;
+      if (data) {
+        execResult = jsiExecuteEventCallback(0, timerCallback, 1, &data);
+      } else {
+        JsVar *argsArray = jsvObjectGetChild(timerPtr, "args", 0);
+        execResult = jsiExecuteEventCallbackArgsArray(0, timerCallback, argsArray);
+        jsvUnLock(argsArray);
+      }
+      if (!execResult) {
+        JsVar *interval = jsvObjectGetChild(timerPtr, "interval", 0);
+        if (interval) { // if interval then it's setInterval not setTimeout
+          jsvUnLock(interval);
+          jsError("Ctrl-C while processing interval - removing it.");
+          jsErrorFlags |= JSERR_CALLBACK;
+          removeTimer = true;
         }
       }
-      jsvUnLock(data);
-      if (watchPtr) { // if we had a watch pointer, be sure to remove us from it
-        jsvObjectRemoveChild(watchPtr, "timeout");
-        // Deal with non-recurring watches
-        if (exec) {
-          bool watchRecurring = jsvGetBoolAndUnLock(jsvObjectGetChild(watchPtr,  "recur", 0));
-          if (!watchRecurring) {
-            JsVar *watchArrayPtr = jsvLock(watchArray);
-            JsVar *watchNamePtr = jsvGetIndexOf(watchArrayPtr, watchPtr, true);
-            if (watchNamePtr) {
-              jsvRemoveChild(watchArrayPtr, watchNamePtr);
-              jsvUnLock(watchNamePtr);
-            }
-            jsvUnLock(watchArrayPtr);
-            Pin pin = jshGetPinFromVarAndUnLock(jsvObjectGetChild(watchPtr, "pin", 0));
-            if (!jsiIsWatchingPin(pin))
-              jshPinWatch(pin, false);
+    }
+    jsvUnLock(data);
+    if (watchPtr) { // if we had a watch pointer, be sure to remove us from it
+      jsvObjectRemoveChild(watchPtr, "timeout");
+      // Deal with non-recurring watches
+      if (exec) {
+        bool watchRecurring = jsvGetBoolAndUnLock(jsvObjectGetChild(watchPtr,  "recur", 0));
+        if (!watchRecurring) {
+          JsVar *watchArrayPtr = jsvLock(watchArray);
+          JsVar *watchNamePtr = jsvGetIndexOf(watchArrayPtr, watchPtr, true);
+          if (watchNamePtr) {
+            jsvRemoveChild(watchArrayPtr, watchNamePtr);
+            jsvUnLock(watchNamePtr);
           }
+          jsvUnLock(watchArrayPtr);
+          Pin pin = jshGetPinFromVarAndUnLock(jsvObjectGetChild(watchPtr, "pin", 0));
+          if (!jsiIsWatchingPin(pin))
+            jshPinWatch(pin, false);
         }
-        jsvUnLock(watchPtr);
       }
-      // Load interval *after* executing code, in case it has changed
-      JsVar *interval = jsvObjectGetChild(timerPtr, "interval", 0);
+      jsvUnLock(watchPtr);
+    }
+    // Load interval *after* executing code, in case it has changed
+    JsVar *interval = jsvObjectGetChild(timerPtr, "interval", 0);
+    // Find the timer again - it may have moved or have been removed by the callback
+    int heapIdx = jsiTimerHeapFind(jsvGetRef(timerName));
+    if (heapIdx>=0) {
       if (!removeTimer && interval) {
-        timeUntilNext = timeUntilNext + jsvGetLongInteger(interval);
+        timerTime += jsvGetLongInteger(interval);
+        jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger(timerTime));
+        jsiTimerHeapSetTime((unsigned int)heapIdx, timerTime);
       } else {
-        // free
-        // Beware... may have already been removed!
-        jsvObjectIteratorRemoveAndGotoNext(&it, timerArrayPtr);
-        hasDeletedTimer = true;
-        timeUntilNext = -1;
+        jsiTimerHeapRemove((unsigned int)heapIdx);
+        jsvRemoveChild(timerArrayPtr, timerName);
       }
-      jsvUnLock2(timerCallback,interval);
-
-    }
-    // update the time until the next timer
-    if (timeUntilNext>=0 && timeUntilNext < minTimeUntilNext)
-      minTimeUntilNext = timeUntilNext;
-    // update the timer's time
-    if (!hasDeletedTimer) {
-      jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger(timeUntilNext));
-      jsvObjectIteratorNext(&it);
     }
-    jsvUnLock(timerPtr);
+    jsvUnLock2(timerCallback,interval);
+    jsvUnLock2(timerPtr, timerName);
   }
-  jsvObjectIteratorFree(&it);
   jsvUnLock(timerArrayPtr);
+  // The first timer in the heap is always the next one due
+  if (timerHeapCount) {
+    minTimeUntilNext = timerHeap[0].time - timerNow;
+    if (minTimeUntilNext<0) minTimeUntilNext = 0;
+  }
   /* We might have left the timers loop with stuff to do because the contents of it
    * changed. It's not a big deal because it could only have changed because a timer
    * got executed - so `wasBusy` got set and we know we're going to go around the
@@ -2136,7 +2468,7 @@ void jsiIdle() {
   if (jswIdle()) wasBusy = true;
 
   // Just in case we got any events to do and didn't clear loopsIdling before
-  if (wasBusy || !jsvArrayIsEmpty(events) )
+  if (wasBusy || jsiHasEvents())
     loopsIdling = 0;
 
   if (wasBusy)
@@ -2206,6 +2538,21 @@ void jsiIdle() {
   }
 
 
+#ifndef SAVE_ON_FLASH
+  /* If memory is getting low, do some Garbage Collection. This is done
+   * incrementally - a small amount each time around the loop - so it never
+   * holds up the handling of events for long. We start when we've been around
+   * the loop with nothing to do, or straight away if the last collection
+   * found garbage (as the program is obviously creating some). */
+  if (jsvGarbageCollectInProgress() ||
+      ((loopsIdling==1 || jsvGCStats.lastFreed) &&
+       !jsvMoreFreeVariablesThan(JS_VARS_BEFORE_INCREMENTAL_GC))) {
+    jsiSetBusy(BUSY_INTERACTIVE, true);
+    jsvGarbageCollectStep();
+    loopsIdling = 0;
+    jsiSetBusy(BUSY_INTERACTIVE, false);
+  }
+#else
   /* if we've been around this loop, there is nothing to do, and
    * we have a spare 10ms then let's do some Garbage Collection
    * if we think we need to */
@@ -2217,6 +2564,7 @@ void jsiIdle() {
     loopsIdling = 0;
     jsiSetBusy(BUSY_INTERACTIVE, false);
   }
+#endif
 
   // Kick the WatchDog if needed
   if (jsiStatus & JSIS_WATCHDOG_AUTO)
@@ -2346,7 +2694,7 @@ void jsiDumpState(vcbprintf_callback user_callback, void *user_data) {
     JsVar *timerInterval = jsvObjectGetChild(timer, "interval", 0);
     user_callback(timerInterval ? "setInterval(" : "setTimeout(", user_data);
     jsiDumpJSON(user_callback, user_data, timerCallback, 0);
-    cbprintf(user_callback, user_data, ", %f); // %v\n", jshGetMillisecondsFromTime(timerInterval ? jsvGetLongInteger(timerInterval) : jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timer, "time", 0))), timerNumber);
+    cbprintf(user_callback, user_data, ", %f); // %v\n", jshGetMillisecondsFromTime(timerInterval ? jsvGetLongInteger(timerInterval) : (jsiTimerBaseTime + jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timer, "time", 0)) - jsiLastIdleTime)), timerNumber);
     jsvUnLock3(timerInterval, timerCallback, timerNumber);
     // next
     jsvUnLock(timer);
@@ -2393,10 +2741,31 @@ void jsiDumpState(vcbprintf_callback user_callback, void *user_data) {
 JsVarInt jsiTimerAdd(JsVar *timerPtr) {
   JsVar *timerArrayPtr = jsvLock(timerArray);
   JsVarInt itemIndex = jsvArrayAddToEnd(timerArrayPtr, timerPtr, 1) - 1;
+  JsVarRef timerName = itemIndex>=0 ? jsvGetLastChild(timerArrayPtr) : 0;
   jsvUnLock(timerArrayPtr);
+  if (timerName)
+    jsiTimerHeapPush(timerName, (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timerPtr, "time", 0)));
   return itemIndex;
 }
 
+void jsiTimerUpdated(JsVar *timerPtr) {
+  JsVarRef timerRef = jsvGetRef(timerPtr);
+  for (unsigned int i=0;i<timerHeapCount;i++) {
+    JsVar *timerName = jsvLock(timerHeap[i].name);
+    bool found = jsvGetFirstChild(timerName) == timerRef;
+    jsvUnLock(timerName);
+    if (found) {
+      jsiTimerHeapSetTime(i, (JsSysTime)jsvGetLongIntegerAndUnLock(jsvObjectGetChild(timerPtr, "time", 0)));
+      return;
+    }
+  }
+}
+
+void jsiTimerRemoved(JsVar *timerName) {
+  int i = jsiTimerHeapFind(jsvGetRef(timerName));
+  if (i>=0) jsiTimerHeapRemove((unsigned int)i);
+}
+
 void jsiTimersChanged() {
   jsiStatus |= JSIS_TIMERS_CHANGED;
 }
@@ -2444,8 +2813,11 @@ void jsiDebuggerLoop() {
     while (jshGetEventsUsed()>IOBUFFERMASK*1/2 &&
            !(jsiStatus & JSIS_EXIT_DEBUGGER) &&
            !(execInfo.execute & EXEC_CTRL_C_MASK)) {
-      if (jshPopIOEvent(&event) && IOEVENTFLAGS_GETTYPE(event.flags)==consoleDevice)
-        jsiHandleIOEventForConsole(&event);
+      if (jshPopIOEvent(&event)) {
+        if (IOEVENTFLAGS_GETTYPE(event.flags)==consoleDevice)
+          jsiHandleIOEventForConsole(&event);
+        jshFreeIOEventChars(&event);
+      }
     }
     // otherwise grab the remaining console events
     while (jshPopIOEventOfType(consoleDevice, &event) &&
@@ -47,6 +47,28 @@ bool jsiIsWatchingPin(Pin pin); // are there any watches for the given pin?
 
 void jsiCtrlC(); // Ctrl-C - force interrupt of execution
 
+#ifndef SAVE_ON_FLASH
+#ifndef JSI_EVENT_RING_SIZE // normally set for each board in build_platform_config.py
+#define JSI_EVENT_RING_SIZE 16 ///< Number of events that can be queued without allocating JsVars
+#endif
+#define JSI_EVENT_RING_ARGS 3 ///< Events with more arguments than this are stored as JsVars
+
+typedef struct {
+  unsigned int queued; ///< Total number of events queued
+  unsigned int maxDepth; ///< The most events that have been waiting at once
+  unsigned int overflows; ///< Events that were stored as JsVars because they didn't fit in the ring
+  unsigned int dropped; ///< Events that were lost because we were out of memory
+} JsiEventStats;
+extern JsiEventStats jsiEventStats;
+
+/// The number of events waiting to be executed
+unsigned int jsiGetEventQueueDepth();
+/// Mark everything in the event queue as used (called by the garbage collector)
+void jsiGarbageCollectMarkEvents();
+/// A var has been moved from one ref to another (called when defragmenting)
+void jsiEventsRefMoved(JsVarRef from, JsVarRef to);
+#endif
+
 /// Queue a function, string, or array (of funcs/strings) to be executed next time around the idle loop
 void jsiQueueEvents(JsVar *object, JsVar *callback, JsVar **args, int argCount);
 /// Return true if the object has callbacks...
@@ -167,6 +189,7 @@ extern Pin pinBusyIndicator;
 extern Pin pinSleepIndicator;
 #endif
 extern JsSysTime jsiLastIdleTime; ///< The last time we went around the idle loop - use this for timers
+extern JsSysTime jsiTimerBaseTime; ///< Timers' 'time' values are relative to this
 
 void jsiDumpJSON(vcbprintf_callback user_callback, void *user_data, JsVar *data, JsVar *existing);
 void jsiDumpState(vcbprintf_callback user_callback, void *user_data);
@@ -176,6 +199,9 @@ extern JsVarRef timerArray; // Linked List of timers to check and run
 extern JsVarRef watchArray; // Linked List of input watches to check and run
 
 extern JsVarInt jsiTimerAdd(JsVar *timerPtr);
+extern void jsiTimerUpdated(JsVar *timerPtr); // Call after changing a timer's 'time'
+extern void jsiTimerRemoved(JsVar *timerName); // Call before removing a timer's name from timerArray
+extern void jsiTimerHeapRebuild(); // Call if timers' refs may have changed (eg. after defrag)
 extern void jsiTimersChanged(); // Flag timers changed so we can skip out of the loop if needed
 // end for jswrap_interactive/io.c ------------------------------------------------
 
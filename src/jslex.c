@@ -337,6 +337,48 @@ static void jslLexRegex() {
   jsvStringIteratorFree(&it);
 }
 
+#ifndef SAVE_ON_FLASH
+/// Read the 14 bit value stored after a LEX_RAW_* token
+static unsigned int jslGetRawValue() {
+  unsigned int v = (unsigned int)(lex->currCh&0x7F) << 7;
+  jslGetNextCh();
+  v |= (unsigned int)(lex->currCh&0x7F);
+  jslGetNextCh();
+  return v;
+}
+
+/// Lex a token that has already been parsed when the function was pretokenised (see jslNewTokenisedStringFromLexer)
+static void jslLexRaw() {
+  size_t tokenPos = jsvStringIteratorGetIndex(&lex->it)-1;
+  unsigned char rawTk = (unsigned char)lex->currCh;
+  jslGetNextCh();
+  unsigned int value = jslGetRawValue();
+  if (rawTk == LEX_RAW_INT) {
+    lex->tk = LEX_INT;
+    itostr((JsVarInt)value, lex->token, 10);
+    lex->tokenl = (unsigned char)strlen(lex->token);
+  } else if (rawTk == LEX_RAW_STRING) {
+    lex->tk = LEX_STR;
+    lex->tokenValue = jsvNewStringOfLength(value, NULL);
+    if (!lex->tokenValue) {
+      lex->tk = LEX_EOF;
+      return;
+    }
+    JsvStringIterator it;
+    jsvStringIteratorNew(&it, lex->tokenValue, 0);
+    while (value--) {
+      jslTokenAppendChar(lex->currCh);
+      jsvStringIteratorSetCharAndNext(&it, lex->currCh);
+      jslGetNextCh();
+    }
+    jsvStringIteratorFree(&it);
+  } else { // LEX_RAW_BLOCK
+    lex->tk = '{';
+    if (value) lex->blockEnd = tokenPos + value;
+  }
+}
+#endif
+
 void jslGetNextToken() {
   jslGetNextToken_start:
   // Skip whitespace
@@ -369,6 +411,10 @@ void jslGetNextToken() {
   int lastToken = lex->tk;
   lex->tk = LEX_EOF;
   lex->tokenl = 0; // clear token string
+#ifndef SAVE_ON_FLASH
+  lex->lastBlockEnd = lex->blockEnd;
+  lex->blockEnd = 0;
+#endif
   if (lex->tokenValue) {
     jsvUnLock(lex->tokenValue);
     lex->tokenValue = 0;
@@ -382,6 +428,13 @@ void jslGetNextToken() {
   // tokens
   if (((unsigned char)lex->currCh) < jslJumpTableStart ||
       ((unsigned char)lex->currCh) > jslJumpTableEnd) {
+#ifndef SAVE_ON_FLASH
+    if (((unsigned char)lex->currCh) >= _LEX_RAW_START &&
+        ((unsigned char)lex->currCh) <= _LEX_RAW_END) {
+      jslLexRaw();
+      return;
+    }
+#endif
     // if unhandled by the jump table, just pass it through as a single character
     jslSingleChar();
   } else {
@@ -661,6 +714,9 @@ void jslInit(JsVar *var) {
   lex->tokenl = 0;
   lex->tokenValue = 0;
   lex->lineNumberOffset = 0;
+#ifndef SAVE_ON_FLASH
+  lex->blockEnd = 0;
+#endif
   // set up iterator
   jsvStringIteratorNew(&lex->it, lex->sourceVar, 0);
   jsvUnLock(lex->it.var); // see jslGetNextCh
@@ -687,6 +743,9 @@ void jslSeekTo(size_t seekToChar) {
   jsvUnLock(lex->it.var); // see jslGetNextCh
   lex->tokenStart.it.var = 0;
   lex->tokenStart.currCh = 0;
+#ifndef SAVE_ON_FLASH
+  lex->blockEnd = 0;
+#endif
   jslPreload();
 }
 
@@ -698,6 +757,9 @@ void jslSeekToP(JslCharPos *seekToChar) {
   lex->currCh = seekToChar->currCh;
   lex->tokenStart.it.var = 0;
   lex->tokenStart.currCh = 0;
+#ifndef SAVE_ON_FLASH
+  lex->blockEnd = 0;
+#endif
   jslGetNextToken();
 }
 
@@ -885,56 +947,123 @@ bool jslMatch(int expected_tk) {
   return true;
 }
 
-JsVar *jslNewTokenisedStringFromLexer(JslCharPos *charFrom, size_t charTo) {
-  // New method - tokenise functions
-  // save old lex
-  JsLex *oldLex = lex;
-  JsLex newLex;
-  lex = &newLex;
-  // work out length
+bool jslSkipBlock() {
+#ifndef SAVE_ON_FLASH
+  if (lex->lastBlockEnd) {
+    jslSeekTo(lex->lastBlockEnd);
+    assert(lex->tk=='}');
+    return true;
+  }
+#endif
+  return false;
+}
+
+#ifndef SAVE_ON_FLASH
+/// How deeply nested blocks can be before we stop storing their length
+#define JSLEX_BLOCK_STACK_SIZE 16
+
+/** Can the current token be stored pre-parsed (see LEX_RAW_START)? If so,
+ * return the LEX_RAW_ token to use and set 'value', otherwise return 0 */
+static int jslGetRawToken(unsigned int *value) {
+  if (lex->tk==LEX_INT) {
+    /* Only simple decimal numbers - anything else wouldn't print out the same
+     * when we reconstruct the function's code */
+    if (lex->tokenl>5 || (lex->token[0]=='0' && lex->tokenl>1)) return 0;
+    unsigned int v = 0;
+    int i;
+    for (i=0;i<lex->tokenl;i++) {
+      if (!isNumeric(lex->token[i])) return 0;
+      v = v*10 + (unsigned int)(lex->token[i]-'0');
+    }
+    if (v>JSLEX_RAW_VALUE_MAX) return 0;
+    *value = v;
+    return LEX_RAW_INT;
+  } else if (lex->tk==LEX_STR && lex->tokenValue) {
+    size_t l = jsvGetStringLength(lex->tokenValue);
+    /* Line numbers are worked out by counting newlines in the function's code,
+     * so we can't store strings that contain them without escaping */
+    if (l>JSLEX_RAW_VALUE_MAX || jsvGetStringIndexOf(lex->tokenValue, '\n')>=0) return 0;
+    *value = (unsigned int)l;
+    return LEX_RAW_STRING;
+  } else if (lex->tk=='{') {
+    *value = 0; // filled in when we find the matching '}'
+    return LEX_RAW_BLOCK;
+  }
+  return 0;
+}
+#endif
+
+/** Tokenise the code between charFrom and charTo into dst (or just count
+ * the characters needed if dst==0). Returns the length */
+static size_t jslTokeniseFromLexer(JslCharPos *charFrom, size_t charTo, JsVar *dst) {
+  JsvStringIterator dstit;
+  if (dst) jsvStringIteratorNew(&dstit, dst, 0);
   size_t length = 0;
-  jslInit(oldLex->sourceVar);
+#ifndef SAVE_ON_FLASH
+  size_t blockStart[JSLEX_BLOCK_STACK_SIZE];
+  int blockDepth = 0;
+#endif
   jslSeekToP(charFrom);
   int lastTk = LEX_EOF;
   while (lex->tk!=LEX_EOF && jsvStringIteratorGetIndex(&lex->it)<=charTo+1) {
-    if ((lex->tk==LEX_ID || lex->tk==LEX_FLOAT || lex->tk==LEX_INT) &&
-        ( lastTk==LEX_ID ||  lastTk==LEX_FLOAT ||  lastTk==LEX_INT)) {
-      length++; // we need to insert a space
+    int tk = lex->tk;
+#ifndef SAVE_ON_FLASH
+    unsigned int rawValue = 0;
+    int rawTk = jslGetRawToken(&rawValue);
+    if (rawTk) tk = rawTk;
+    if (lex->tk=='}' && blockDepth>0) {
+      blockDepth--;
+      // we now know where the '}' is, so write the length of the block after the '{'
+      if (dst && blockDepth<JSLEX_BLOCK_STACK_SIZE &&
+          length-blockStart[blockDepth] <= JSLEX_RAW_VALUE_MAX) {
+        size_t offset = length-blockStart[blockDepth];
+        jsvSetCharInString(dst, blockStart[blockDepth]+1, (char)(0x80|(offset>>7)), false);
+        jsvSetCharInString(dst, blockStart[blockDepth]+2, (char)(0x80|(offset&0x7F)), false);
+      }
     }
-    if (lex->tk==LEX_ID ||
-        lex->tk==LEX_INT ||
-        lex->tk==LEX_FLOAT ||
-        lex->tk==LEX_STR ||
-        lex->tk==LEX_TEMPLATE_LITERAL ||
-        lex->tk==LEX_REGEX) {
-      length += jsvStringIteratorGetIndex(&lex->it)-jsvStringIteratorGetIndex(&lex->tokenStart.it);
-    } else {
-      length++; // for single token
+#endif
+    if ((tk==LEX_ID || tk==LEX_FLOAT || tk==LEX_INT) &&
+        ( lastTk==LEX_ID ||  lastTk==LEX_FLOAT ||  lastTk==LEX_INT)) {
+      // we need to insert a space
+      if (dst) jsvStringIteratorSetCharAndNext(&dstit, ' ');
+      length++;
     }
-    lastTk = lex->tk;
-    jslGetNextToken();
-  }
-
-  // Try and create a flat string first
-  JsVar *var = jsvNewStringOfLength((unsigned int)length, NULL);
-  if (var) { // out of memory
-    JsvStringIterator dstit;
-    jsvStringIteratorNew(&dstit, var, 0);
-    // now start appending
-    jslSeekToP(charFrom);
-    lastTk = LEX_EOF;
-    while (lex->tk!=LEX_EOF && jsvStringIteratorGetIndex(&lex->it)<=charTo+1) {
-      if ((lex->tk==LEX_ID || lex->tk==LEX_FLOAT || lex->tk==LEX_INT) &&
-          ( lastTk==LEX_ID ||  lastTk==LEX_FLOAT ||  lastTk==LEX_INT)) {
-        jsvStringIteratorSetCharAndNext(&dstit, ' ');
+#ifndef SAVE_ON_FLASH
+    if (rawTk) {
+      if (rawTk==LEX_RAW_BLOCK) {
+        if (blockDepth<JSLEX_BLOCK_STACK_SIZE)
+          blockStart[blockDepth] = length;
+        blockDepth++;
+      }
+      length += 3;
+      if (dst) {
+        jsvStringIteratorSetCharAndNext(&dstit, (char)rawTk);
+        jsvStringIteratorSetCharAndNext(&dstit, (char)(0x80|(rawValue>>7)));
+        jsvStringIteratorSetCharAndNext(&dstit, (char)(0x80|(rawValue&0x7F)));
       }
-      if (lex->tk==LEX_ID ||
-          lex->tk==LEX_INT ||
-          lex->tk==LEX_FLOAT ||
-          lex->tk==LEX_STR ||
-          lex->tk==LEX_TEMPLATE_LITERAL ||
-          lex->tk==LEX_REGEX) {
-        // copy in string verbatim
+      if (rawTk==LEX_RAW_STRING) {
+        length += rawValue;
+        if (dst) {
+          JsvStringIterator it;
+          jsvStringIteratorNew(&it, lex->tokenValue, 0);
+          while (jsvStringIteratorHasChar(&it)) {
+            jsvStringIteratorSetCharAndNext(&dstit, jsvStringIteratorGetChar(&it));
+            jsvStringIteratorNext(&it);
+          }
+          jsvStringIteratorFree(&it);
+        }
+      }
+    } else
+#endif
+    if (tk==LEX_ID ||
+        tk==LEX_INT ||
+        tk==LEX_FLOAT ||
+        tk==LEX_STR ||
+        tk==LEX_TEMPLATE_LITERAL ||
+        tk==LEX_REGEX) {
+      // copy in string verbatim
+      length += jsvStringIteratorGetIndex(&lex->it)-jsvStringIteratorGetIndex(&lex->tokenStart.it);
+      if (dst) {
         jsvStringIteratorSetCharAndNext(&dstit, lex->tokenStart.currCh);
         JsvStringIterator it;
         jsvStringIteratorClone(&it, &lex->tokenStart.it);
@@ -943,14 +1072,31 @@ JsVar *jslNewTokenisedStringFromLexer(JslCharPos *charFrom, size_t charTo) {
           jsvStringIteratorNext(&it);
         }
         jsvStringIteratorFree(&it);
-      } else { // single char for the token
-        jsvStringIteratorSetCharAndNext(&dstit, (char)lex->tk);
       }
-      lastTk = lex->tk;
-      jslGetNextToken();
+    } else { // single char for the token
+      if (dst) jsvStringIteratorSetCharAndNext(&dstit, (char)tk);
+      length++;
     }
-    jsvStringIteratorFree(&dstit);
+    lastTk = tk;
+    jslGetNextToken();
   }
+  if (dst) jsvStringIteratorFree(&dstit);
+  return length;
+}
+
+JsVar *jslNewTokenisedStringFromLexer(JslCharPos *charFrom, size_t charTo) {
+  // New method - tokenise functions
+  // save old lex
+  JsLex *oldLex = lex;
+  JsLex newLex;
+  lex = &newLex;
+  jslInit(oldLex->sourceVar);
+  // work out length
+  size_t length = jslTokeniseFromLexer(charFrom, charTo, 0);
+  // Try and create a flat string first
+  JsVar *var = jsvNewStringOfLength((unsigned int)length, NULL);
+  if (var) // out of memory
+    jslTokeniseFromLexer(charFrom, charTo, var);
   // restore lex
   jslKill();
   lex = oldLex;
@@ -1035,6 +1181,53 @@ bool jslNeedSpaceBetween(unsigned char lastch, unsigned char ch) {
          (ch>=_LEX_R_LIST_START || isAlpha((char)ch) || isNumeric((char)ch));
 }
 
+size_t jslPrintTokenisedChar(JsvStringIterator *it, unsigned char *lastch, vcbprintf_callback user_callback, void *user_data) {
+  unsigned char ch = (unsigned char)jsvStringIteratorGetChar(it);
+  jsvStringIteratorNext(it);
+  size_t chars = 0;
+#ifndef SAVE_ON_FLASH
+  if (ch>=_LEX_RAW_START && ch<=_LEX_RAW_END) {
+    unsigned int value = (unsigned int)(jsvStringIteratorGetChar(it)&0x7F) << 7;
+    jsvStringIteratorNext(it);
+    value |= (unsigned int)(jsvStringIteratorGetChar(it)&0x7F);
+    jsvStringIteratorNext(it);
+    if (ch==LEX_RAW_INT) {
+      char buf[8];
+      if (jslNeedSpaceBetween(*lastch, '0')) {
+        user_callback(" ", user_data);
+        chars++;
+      }
+      itostr((JsVarInt)value, buf, 10);
+      user_callback(buf, user_data);
+      *lastch = '0';
+      return chars + strlen(buf);
+    } else if (ch==LEX_RAW_STRING) {
+      user_callback("\"", user_data);
+      chars += 2;
+      while (value-- && jsvStringIteratorHasChar(it)) {
+        const char *s = escapeCharacter(jsvStringIteratorGetChar(it), false);
+        user_callback(s, user_data);
+        chars += strlen(s);
+        jsvStringIteratorNext(it);
+      }
+      user_callback("\"", user_data);
+      *lastch = '"';
+      return chars;
+    }
+    ch = '{'; // LEX_RAW_BLOCK
+  }
+#endif
+  if (jslNeedSpaceBetween(*lastch, ch)) {
+    user_callback(" ", user_data);
+    chars++;
+  }
+  char buf[32];
+  jslFunctionCharAsString(ch, buf, sizeof(buf));
+  user_callback(buf, user_data);
+  *lastch = ch;
+  return chars + strlen(buf);
+}
+
 void jslPrintPosition(vcbprintf_callback user_callback, void *user_data, size_t tokenPos) {
   size_t line,col;
   jsvGetLineAndCol(lex->sourceVar, tokenPos, &line, &col);
@@ -1074,18 +1267,12 @@ void jslPrintTokenLineMarker(vcbprintf_callback user_callback, void *user_data,
   while (jsvStringIteratorHasChar(&it) && chars<60) {
     unsigned char ch = (unsigned char)jsvStringIteratorGetChar(&it);
     if (ch == '\n') break;
-    if (jslNeedSpaceBetween(lastch, ch)) {
-      col++;
-      user_callback(" ", user_data);
-    }
-    char buf[32];
-    jslFunctionCharAsString(ch, buf, sizeof(buf));
-    size_t len = strlen(buf);
-    col += len-1;
-    user_callback(buf, user_data);
+    size_t pos = jsvStringIteratorGetIndex(&it);
+    size_t len = jslPrintTokenisedChar(&it, &lastch, user_callback, user_data);
+    // tokens may print out longer than they are in the source, so adjust our column
+    if (pos < tokenPos)
+      col += len - (jsvStringIteratorGetIndex(&it) - pos);
     chars++;
-    lastch = ch;
-    jsvStringIteratorNext(&it);
   }
   jsvStringIteratorFree(&it);
 
@@ -99,9 +99,19 @@ _LEX_R_LIST_START,
     LEX_R_SUPER,
     LEX_R_STATIC,
     LEX_R_OF,
-_LEX_R_LIST_END = LEX_R_OF /* always the last entry */
+_LEX_R_LIST_END = LEX_R_OF, /* always the last entry */
+
+_LEX_RAW_START, /* Only found in pretokenised function code. These are followed
+                   by a 14 bit value stored as 2 bytes with the top bit set */
+    LEX_RAW_INT = _LEX_RAW_START, ///< An integer literal
+    LEX_RAW_STRING, ///< A string literal - value is the length, and it is followed by the string's characters
+    LEX_RAW_BLOCK, ///< A '{' - value is the offset to the matching '}' (or 0 if not known)
+_LEX_RAW_END = LEX_RAW_BLOCK
 } LEX_TYPES;
 
+/// The largest value that can be stored after a LEX_RAW_* token
+#define JSLEX_RAW_VALUE_MAX 0x3FFF
+
 
 typedef struct JslCharPos {
   JsvStringIterator it;
@@ -122,6 +132,10 @@ typedef struct JsLex
   char token[JSLEX_MAX_TOKEN_LENGTH]; ///< Data contained in the token we have here
   JsVar *tokenValue; ///< JsVar containing the current token - used only for strings/regex
   unsigned char tokenl; ///< the current length of token
+#ifndef SAVE_ON_FLASH
+  size_t blockEnd; ///< If the current token is a pretokenised '{', the position of the matching '}' (or 0)
+  size_t lastBlockEnd; ///< blockEnd for the previous token - used to skip whole blocks with jslSkipBlock
+#endif
 
   /** Amount we add to the line number when we're reporting to the user
    * 1-based, so 0 means NO LINE NUMBER KNOWN */
@@ -150,6 +164,10 @@ void jslSeekToP(JslCharPos *seekToChar);
 
 bool jslMatch(int expected_tk); ///< Match, and return true on success, false on failure
 
+/** If the last token was a pretokenised '{' that we know the length of,
+ * jump straight to the matching '}' and return true. */
+bool jslSkipBlock();
+
 /** When printing out a function, with pretokenise a
  * character could end up being a special token. This
  * handles that case. */
@@ -167,7 +185,7 @@ void jslGetNextToken(); ///< Get the text token from our text string
 /// Create a new STRING from part of the lexer
 JsVar *jslNewStringFromLexer(JslCharPos *charFrom, size_t charTo);
 
-/// Create a new STRING from part of the lexer - keywords get tokenised
+/// Create a new STRING from part of the lexer - keywords get tokenised, and literals/blocks are pre-parsed
 JsVar *jslNewTokenisedStringFromLexer(JslCharPos *charFrom, size_t charTo);
 
 /// Return the line number at the current character position (this isn't fast as it searches the string)
@@ -176,6 +194,11 @@ unsigned int jslGetLineNumber();
 /// Do we need a space between these two characters when printing a function's text?
 bool jslNeedSpaceBetween(unsigned char lastch, unsigned char ch);
 
+/** Print the character at `it` in a function's (possibly pretokenised) code, expanding
+ * tokens and literals back out, and move `it` on. Adds a space after `lastch` if
+ * needed, and updates it. Returns the number of characters written */
+size_t jslPrintTokenisedChar(JsvStringIterator *it, unsigned char *lastch, vcbprintf_callback user_callback, void *user_data);
+
 /// Print position in the form 'line X col Y'
 void jslPrintPosition(vcbprintf_callback user_callback, void *user_data, size_t tokenPos);
 
@@ -141,6 +141,47 @@ JsVar *jspeiFindNameOnTop(JsVar *childName, bool createIfNotFound) {
   return result;
 }
 
+#ifndef SAVE_ON_FLASH
+/// The maximum number of parameters+local variables in a function that get slots
+#define JSP_MAX_LOCAL_SLOTS 16
+
+/** Return the slot number of 'name' in a function's comma-separated
+ * JSPARSE_FUNCTION_LOCALS_NAME list, or -1 if it isn't there */
+static int jspGetLocalSlot(JsVar *names, const char *name) {
+  JsvStringIterator it;
+  jsvStringIteratorNew(&it, names, 0);
+  int slot = 0;
+  const char *n = name;
+  bool match = true;
+  while (true) {
+    char ch = jsvStringIteratorHasChar(&it) ? jsvStringIteratorGetChar(&it) : 0;
+    if (ch==',' || !ch) {
+      if (match && !*n) break;
+      if (!ch) {
+        slot = -1;
+        break;
+      }
+      slot++;
+      n = name;
+      match = true;
+    } else if (match) {
+      if (*n==ch) n++;
+      else match = false;
+    }
+    jsvStringIteratorNext(&it);
+  }
+  jsvStringIteratorFree(&it);
+  return slot;
+}
+
+/// Add 'name' to a function's list of local variables (if it's not there already and there's space)
+static void jspAddLocalName(JsVar *names, const char *name, int *count) {
+  if (*count >= JSP_MAX_LOCAL_SLOTS || jspGetLocalSlot(names, name)>=0) return;
+  if ((*count)++) jsvAppendCharacter(names, ',');
+  jsvAppendString(names, name);
+}
+#endif
+
 JsVar *jspFindPrototypeFor(const char *className) {
   JsVar *obj = jsvObjectGetChild(execInfo.root, className, 0);
   if (!obj) return 0;
@@ -350,9 +391,68 @@ NO_INLINE bool jspeFunctionDefinitionInternal(JsVar *funcVar, bool expressionOnl
   JslCharPos funcBegin;
   jslCharPosClone(&funcBegin, &lex->tokenStart);
   int lastTokenEnd = -1;
+#ifndef SAVE_ON_FLASH
+  /* Work out the names of parameters and local variables. When the function is
+   * called these are given numbered slots, so we don't have to search the
+   * scope for them each time they're used (see jspGetLocalVariable). Like the
+   * other pre-parsing, this is only done for pretokenised functions so that
+   * normal functions don't use any more memory. */
+  JsVar *localNames = 0;
+  int localCount = 0;
+  if (funcVar && jsfGetFlag(JSF_PRETOKENISE)) {
+    localNames = jsvNewFromEmptyString();
+    JsvObjectIterator it;
+    jsvObjectIteratorNew(&it, funcVar);
+    while (localNames && jsvObjectIteratorHasValue(&it)) {
+      JsVar *param = jsvObjectIteratorGetKey(&it);
+      if (jsvIsFunctionParameter(param)) {
+        char buf[JSLEX_MAX_TOKEN_LENGTH+1];
+        jsvGetString(param, buf, sizeof(buf));
+        jspAddLocalName(localNames, &buf[1], &localCount);
+      }
+      jsvUnLock(param);
+      jsvObjectIteratorNext(&it);
+    }
+    jsvObjectIteratorFree(&it);
+  }
+  /* Only 'var' declarations in this function (not functions inside it) matter.
+   * We may pick up some extra names or miss some, but as slots are only
+   * filled in if the variable is found in the function's scope that's fine */
+  int nestedBrackets = -1; // if >=0, we're in a nested function
+  bool nestedPending = false; // we've seen 'function'/'=>' and will be nested at the next '{'
+  int varState = 0; // 1 = expecting a variable name, 2 = in its initialiser
+  int varBrackets = 0;
+#endif
   if (!expressionOnly) {
     int brackets = 0;
     while (lex->tk && (brackets || lex->tk != '}')) {
+#ifndef SAVE_ON_FLASH
+      if (localNames) {
+        int tk = lex->tk;
+        if (nestedBrackets>=0) {
+          if (tk=='}' && brackets-1==nestedBrackets) nestedBrackets = -1;
+        } else if (tk=='{' && nestedPending) {
+          nestedBrackets = brackets;
+          nestedPending = false;
+        } else {
+          if (varState==1) {
+            if (tk==LEX_ID) jspAddLocalName(localNames, jslGetTokenValueAsString(), &localCount);
+            varState = (tk==LEX_ID) ? 2 : 0;
+            varBrackets = 0;
+          } else if (varState==2) {
+            if (tk=='(' || tk=='[' || tk=='{') varBrackets++;
+            else if (tk==')' || tk==']' || tk=='}') {
+              if (varBrackets) varBrackets--;
+              else varState = 0;
+            } else if (!varBrackets && tk==',') varState = 1;
+            else if (!varBrackets && tk==';') varState = 0;
+          }
+          if (tk==LEX_R_VAR || tk==LEX_R_LET || tk==LEX_R_CONST) varState = 1;
+          if (tk==LEX_R_FUNCTION || tk==LEX_ARROW_FUNCTION || tk==LEX_R_CLASS) nestedPending = true;
+          if (tk==';') nestedPending = false;
+        }
+      }
+#endif
       if (lex->tk == '{') brackets++;
       if (lex->tk == '}') brackets--;
       lastTokenEnd = (int)jsvStringIteratorGetIndex(&lex->it)-1;
@@ -401,7 +501,15 @@ NO_INLINE bool jspeFunctionDefinitionInternal(JsVar *funcVar, bool expressionOnl
         jsvUnLock2(jsvAddNamedChild(funcVar, funcLineNumber, JSPARSE_FUNCTION_LINENUMBER_NAME), funcLineNumber);
       }
     }
+#ifndef SAVE_ON_FLASH
+    // Add the names of the local variables if there were any
+    if (localCount)
+      jsvUnLock(jsvAddNamedChild(funcVar, localNames, JSPARSE_FUNCTION_LOCALS_NAME));
+#endif
   }
+#ifndef SAVE_ON_FLASH
+  jsvUnLock(localNames);
+#endif
 
   jslCharPosFree(&funcBegin);
   if (!expressionOnly) JSP_MATCH('}');
@@ -622,6 +730,9 @@ NO_INLINE JsVar *jspeFunctionCall(JsVar *function, JsVar *functionName, JsVar *t
       JsVar *functionCode = 0;
       JsVar *functionInternalName = 0;
       uint16_t functionLineNumber = 0;
+#ifndef SAVE_ON_FLASH
+      JsVar *localNames = 0;
+#endif
 
       /** NOTE: We expect that the function object will have:
        *
@@ -688,6 +799,9 @@ NO_INLINE JsVar *jspeFunctionCall(JsVar *function, JsVar *functionName, JsVar *t
             jsvUnLock(thisVar);
             thisVar = jsvSkipName(param);
           } else if (jsvIsStringEqual(param, JSPARSE_FUNCTION_LINENUMBER_NAME)) functionLineNumber = (uint16_t)jsvGetIntegerAndUnLock(jsvSkipName(param));
+#ifndef SAVE_ON_FLASH
+          else if (jsvIsStringEqual(param, JSPARSE_FUNCTION_LOCALS_NAME)) localNames = jsvSkipName(param);
+#endif
           else if (jsvIsFunctionParameter(param)) {
             JsVar *defaultVal = jsvSkipName(param);
             jsvAddFunctionParameter(functionRoot, jsvNewFromStringVar(param,1,JSVAPPENDSTRINGVAR_MAXLENGTH), defaultVal);
@@ -726,6 +840,15 @@ NO_INLINE JsVar *jspeFunctionCall(JsVar *function, JsVar *functionName, JsVar *t
             execInfo.thisVar = jsvRef(thisVar);
           else
             execInfo.thisVar = jsvRef(execInfo.root); // 'this' should always default to root
+#ifndef SAVE_ON_FLASH
+          // Set up slots for this function's local variables
+          JsVar *oldLocalNames = execInfo.localNames;
+          JsVar **oldLocalSlots = execInfo.localSlots;
+          JsVar *localSlots[JSP_MAX_LOCAL_SLOTS];
+          if (localNames) memset(localSlots, 0, sizeof(localSlots));
+          execInfo.localNames = localNames;
+          execInfo.localSlots = localNames ? localSlots : 0;
+#endif
 
 
           /* we just want to execute the block, but something could
@@ -822,6 +945,16 @@ NO_INLINE JsVar *jspeFunctionCall(JsVar *function, JsVar *functionName, JsVar *t
           /* Return to old 'this' var. No need to unlock as we never locked before */
           if (execInfo.thisVar) jsvUnRef(execInfo.thisVar);
           execInfo.thisVar = oldThisVar;
+#ifndef SAVE_ON_FLASH
+          if (localNames) {
+            // slots keep their names locked so they can't be moved by E.defrag()
+            int i;
+            for (i=0;i<JSP_MAX_LOCAL_SLOTS;i++)
+              jsvUnLock(localSlots[i]);
+          }
+          execInfo.localNames = oldLocalNames;
+          execInfo.localSlots = oldLocalSlots;
+#endif
 
           jspeiRemoveScope();
         }
@@ -832,6 +965,9 @@ NO_INLINE JsVar *jspeFunctionCall(JsVar *function, JsVar *functionName, JsVar *t
       }
       jsvUnLock(functionCode);
       jsvUnLock(functionRoot);
+#ifndef SAVE_ON_FLASH
+      jsvUnLock(localNames);
+#endif
     }
 
     jsvUnLock(thisVar);
@@ -873,8 +1009,82 @@ JsVar *jspGetNamedVariable(const char *tokenName) {
   return a;
 }
 
-/// Used by jspGetNamedField / jspGetVarNamedField
-static NO_INLINE JsVar *jspGetNamedFieldInParents(JsVar *object, const char* name, bool returnName) {
+#ifndef SAVE_ON_FLASH
+/** Cache of which slot (in execInfo.localSlots) the identifier at a certain
+ * position in a function's code refers to. This means we only have to search
+ * the function's list of locals the first time an identifier is used, and the
+ * function's scope the first time it is used in each call. */
+typedef struct {
+  JsVarRef code;      ///< The code (lex->sourceVar) the identifier was in (0 = unused)
+  JsVarRef names;     ///< The function's list of local names (execInfo.localNames)
+  unsigned short nameHash; ///< Hash of the identifier, in case 'code' has been freed and reused
+  unsigned char nameLength; ///< Length of the identifier
+  signed char slot;   ///< The slot number, or -1 if it's not a local variable
+  size_t pos;         ///< Position of the identifier in the code
+} JspLocalCacheEntry;
+#ifndef JSP_LOCAL_CACHE_SIZE // normally set for each board in build_platform_config.py
+#define JSP_LOCAL_CACHE_SIZE 64 // POWER OF 2
+#endif
+static JspLocalCacheEntry jspLocalCache[JSP_LOCAL_CACHE_SIZE];
+
+/// Forget all cached slot numbers - must be called if vars are moved (eg. E.defrag)
+void jspClearLocalCache() {
+  memset(jspLocalCache, 0, sizeof(jspLocalCache));
+}
+
+/// Like jspGetNamedVariable for the identifier at the current token, but using local variable slots if possible
+static JsVar *jspGetLocalVariable(const char *tokenName) {
+  if (!JSP_SHOULD_EXECUTE) return 0;
+  JsVarRef code = jsvGetRef(lex->sourceVar);
+  JsVarRef names = jsvGetRef(execInfo.localNames);
+  size_t pos = jsvStringIteratorGetIndex(&lex->tokenStart.it);
+  unsigned short nameHash = 0;
+  const char *n = tokenName;
+  while (*n) nameHash = (unsigned short)((nameHash*31) + (unsigned char)*(n++));
+  unsigned char nameLength = (unsigned char)(n - tokenName);
+  JspLocalCacheEntry *lc = &jspLocalCache[(pos + code*7) & (JSP_LOCAL_CACHE_SIZE-1)];
+  if (lc->code!=code || lc->pos!=pos || lc->names!=names ||
+      lc->nameHash!=nameHash || lc->nameLength!=nameLength) {
+    lc->code = code;
+    lc->pos = pos;
+    lc->names = names;
+    lc->nameHash = nameHash;
+    lc->nameLength = nameLength;
+    lc->slot = (signed char)jspGetLocalSlot(execInfo.localNames, tokenName);
+  }
+  if (lc->slot<0) return jspGetNamedVariable(tokenName);
+  JsVar **slot = &execInfo.localSlots[lc->slot];
+  if (*slot) return jsvLockAgain(*slot);
+  // First use in this call - look in the function's scope
+  JsVar *a = jspeiFindOnTop(tokenName, false);
+  if (a) {
+    *slot = jsvLockAgain(a); // unlocked when the function returns
+    return a;
+  }
+  // Not defined (yet?) so it could be in an outer scope
+  return jspGetNamedVariable(tokenName);
+}
+#endif
+
+/** Create a new name (which unlocks and references 'child') that will add itself
+ * to 'object' if it is assigned to. Used for fields that aren't in the object itself */
+static JsVar *jspNewFieldName(JsVar *object, const char* name, JsVar *child) {
+  // Get rid of existing name
+  if (jsvIsName(child)) {
+    JsVar *t = jsvGetValueOfName(child);
+    jsvUnLock(child);
+    child = t;
+  }
+  // create a new name
+  JsVar *nameVar = jsvNewFromString(name);
+  JsVar *newChild = jsvCreateNewChild(object, nameVar, child);
+  jsvUnLock2(nameVar, child);
+  return newChild;
+}
+
+/** Used by jspGetNamedField / jspGetVarNamedField. If isBuiltIn is set, it is
+ * set to whether the result came from a built-in function */
+static NO_INLINE JsVar *jspGetNamedFieldInParents(JsVar *object, const char* name, bool returnName, bool *isBuiltIn) {
   // Now look in prototypes
   JsVar * child = jspeiFindChildFromStringInParents(object, name);
 
@@ -882,6 +1092,7 @@ static NO_INLINE JsVar *jspGetNamedFieldInParents(JsVar *object, const char* nam
    * This way we save on RAM for built-ins because everything comes out of program code */
   if (!child) {
     child = jswFindBuiltInFunction(object, name);
+    if (isBuiltIn) *isBuiltIn = child!=0;
   }
 
   /* We didn't get here if we found a child in the object itself, so
@@ -893,19 +1104,8 @@ static NO_INLINE JsVar *jspGetNamedFieldInParents(JsVar *object, const char* nam
    * a new name that references the object we actually requested the
    * member from..
    */
-  if (child && returnName) {
-    // Get rid of existing name
-    if (jsvIsName(child)) {
-      JsVar *t = jsvGetValueOfName(child);
-      jsvUnLock(child);
-      child = t;
-    }
-    // create a new name
-    JsVar *nameVar = jsvNewFromString(name);
-    JsVar *newChild = jsvCreateNewChild(object, nameVar, child);
-    jsvUnLock2(nameVar, child);
-    child = newChild;
-  }
+  if (child && returnName)
+    child = jspNewFieldName(object, name, child);
 
   // If not found and is the prototype, create it
   if (!child) {
@@ -943,7 +1143,7 @@ JsVar *jspGetNamedField(JsVar *object, const char* name, bool returnName) {
     child = jsvFindChildFromString(object, name, false);
 
   if (!child) {
-    child = jspGetNamedFieldInParents(object, name, returnName);
+    child = jspGetNamedFieldInParents(object, name, returnName, 0);
 
     // If not found and is the prototype, create it
     if (!child && jsvIsFunction(object) && strcmp(name, JSPARSE_PROTOTYPE_VAR)==0) {
@@ -957,6 +1157,107 @@ JsVar *jspGetNamedField(JsVar *object, const char* name, bool returnName) {
   else return jsvSkipNameAndUnLock(child);
 }
 
+#ifndef SAVE_ON_FLASH
+/** Inline cache for `object.field` lookups in jspeFactorMember. Entries are
+ * picked by the position of the field name in the code, and remember what was
+ * found on the object that was used last time. This means that something like
+ * `g.setPixel(...)` or `Math.sin(...)` in a loop doesn't have to search the
+ * object, its prototypes and the built-in symbol tables every time.
+ *
+ * Entries are only valid while jsvGetPropertyEpoch() hasn't changed, which
+ * means that the object still exists and no children have been added/removed
+ * that could change the result. */
+typedef struct {
+  JsVarRef code;      ///< The code (lex->sourceVar) the lookup was in (0 = unused)
+  size_t object;      ///< The object the field was looked up on - see jspInlineCacheKey
+  JsVarRef child;     ///< The NAME found in the object itself, or 0 if a built-in function was found
+  unsigned short objectType; ///< The object's type - see jspInlineCacheKey
+  unsigned short argTypes; ///< For built-in functions, the argument types
+  unsigned short nameHash; ///< Hash of the field name, in case 'code' has been freed and reused
+  void (*functionPtr)(void); ///< For built-in functions, the function itself
+  size_t pos;         ///< Position of the field name in the code
+  unsigned int epoch; ///< jsvGetPropertyEpoch() when the lookup was made
+} JspInlineCacheEntry;
+#ifndef JSP_INLINE_CACHE_SIZE // normally set for each board in build_platform_config.py
+#define JSP_INLINE_CACHE_SIZE 64 // POWER OF 2
+#endif
+static JspInlineCacheEntry jspInlineCache[JSP_INLINE_CACHE_SIZE];
+
+/* Built-in objects like `Math` and simple values like strings are created
+ * again each time they are used, so we can't use their ref to identify them.
+ * If they have no children they just get their fields from the symbol tables,
+ * so we use the native function pointer, or just the type in the case of
+ * simple values. */
+#define JSP_INLINE_CACHE_BY_VALUE 0x8000
+static size_t jspInlineCacheKey(JsVar *object, unsigned short *objectType) {
+  *objectType = (unsigned short)(object->flags&JSV_VARTYPEMASK);
+  if (jsvIsNativeFunction(object) && !jsvGetFirstChild(object)) {
+    *objectType |= JSP_INLINE_CACHE_BY_VALUE;
+    return (size_t)object->varData.native.ptr;
+  }
+  if (jsvIsString(object) || jsvIsNumeric(object) || jsvIsBoolean(object)) {
+    *objectType |= JSP_INLINE_CACHE_BY_VALUE;
+    return 0;
+  }
+  return jsvGetRef(object);
+}
+
+/// Like jspGetNamedField(object, name, true) for the field name at the current token, but using jspInlineCache
+static JsVar *jspGetNamedFieldCached(JsVar *object, const char* name) {
+  JsVarRef code = jsvGetRef(lex->sourceVar);
+  unsigned short objectType;
+  size_t objectKey = jspInlineCacheKey(object, &objectType);
+  size_t pos = jsvStringIteratorGetIndex(&lex->tokenStart.it);
+  unsigned short nameHash = 0;
+  const char *n = name;
+  while (*n) nameHash = (unsigned short)((nameHash*31) + (unsigned char)*(n++));
+  JspInlineCacheEntry *ic = &jspInlineCache[(pos + code*7) & (JSP_INLINE_CACHE_SIZE-1)];
+  if (ic->code==code && ic->pos==pos && ic->object==objectKey && ic->nameHash==nameHash &&
+      ic->objectType==objectType && ic->epoch==jsvGetPropertyEpoch()) {
+    if (ic->child)
+      return jsvLock(ic->child);
+    JsVar *fn = jsvNewNativeFunction(ic->functionPtr, ic->argTypes);
+    // If we're just calling the function we don't need a name to assign to
+    if (!fn || lex->currCh=='(') return fn;
+    return jspNewFieldName(object, name, fn);
+  }
+
+  JsVar *child = 0;
+  if (jsvHasChildren(object))
+    child = jsvFindChildFromString(object, name, false);
+  if (child) {
+    if (jsvIsObject(object) || jsvIsFunction(object) || jsvIsRoot(object)) {
+      ic->child = jsvGetRef(child);
+    } else
+      return child;
+  } else {
+    bool isBuiltIn = false;
+    child = jspGetNamedFieldInParents(object, name, true, &isBuiltIn);
+    // Array buffers aren't cached as the functions available depend on the type of array
+    if (!isBuiltIn || jsvIsArrayBuffer(object)) return child;
+    JsVar *fn = jsvSkipName(child);
+    bool isFunction = jsvIsNativeFunction(fn);
+    if (isFunction) {
+      ic->child = 0;
+      ic->functionPtr = fn->varData.native.ptr;
+      ic->argTypes = fn->varData.native.argTypes;
+    }
+    jsvUnLock(fn);
+    // Getters (eg. Math.PI) return a value, which we can't cache
+    if (!isFunction) return child;
+  }
+  ic->code = code;
+  ic->pos = pos;
+  ic->nameHash = nameHash;
+  ic->object = objectKey;
+  ic->objectType = objectType;
+  ic->epoch = jsvGetPropertyEpoch();
+  if (!(objectType & JSP_INLINE_CACHE_BY_VALUE))
+    jsvPropertyEpochWatch(object);
+  return child;
+}
+#endif
+
 /// see jspGetNamedField - note that nameVar should have had jsvAsArrayIndex called on it first
 JsVar *jspGetVarNamedField(JsVar *object, JsVar *nameVar, bool returnName) {
 
@@ -983,7 +1284,7 @@ JsVar *jspGetVarNamedField(JsVar *object, JsVar *nameVar, bool returnName) {
       char name[JSLEX_MAX_TOKEN_LENGTH];
       jsvGetString(nameVar, name, JSLEX_MAX_TOKEN_LENGTH);
       // try and find it in parents
-      child = jspGetNamedFieldInParents(object, name, returnName);
+      child = jspGetNamedFieldInParents(object, name, returnName, 0);
 
       // If not found and is the prototype, create it
       if (!child && jsvIsFunction(object) && jsvIsStringEqual(nameVar, JSPARSE_PROTOTYPE_VAR)) {
@@ -1023,7 +1324,11 @@ NO_INLINE JsVar *jspeFactorMember(JsVar *a, JsVar **parentResult) {
           JsVar *aVar = jsvSkipNameWithParent(a,true,parent);
           JsVar *child = 0;
           if (aVar)
+#ifndef SAVE_ON_FLASH
+            child = jspGetNamedFieldCached(aVar, name);
+#else
             child = jspGetNamedField(aVar, name, true);
+#endif
           if (!child) {
             if (!jsvIsUndefined(aVar)) {
               // if no child found, create a pointer to where it could be
@@ -1566,7 +1871,13 @@ NO_INLINE JsVar *jspeClassDefinition(bool parseNamedClass) {
 
 NO_INLINE JsVar *jspeFactor() {
   if (lex->tk==LEX_ID) {
+#ifndef SAVE_ON_FLASH
+    JsVar *a = execInfo.localSlots ?
+        jspGetLocalVariable(jslGetTokenValueAsString()) :
+        jspGetNamedVariable(jslGetTokenValueAsString());
+#else
     JsVar *a = jspGetNamedVariable(jslGetTokenValueAsString());
+#endif
     JSP_ASSERT_MATCH(LEX_ID);
 #ifndef SAVE_ON_FLASH
     if (lex->tk==LEX_TEMPLATE_LITERAL)
@@ -2042,6 +2353,8 @@ NO_INLINE JsVar *jspeExpression() {
 
 /** Parse a block `{ ... }` */
 NO_INLINE void jspeSkipBlock() {
+  // pretokenised code knows where the block ends, so we can jump right there
+  if (jslSkipBlock()) return;
   // fast skip of blocks
   int brackets = 1;
   while (lex->tk && brackets) {
@@ -2598,8 +2911,16 @@ NO_INLINE JsVar *jspeStatementTry() {
       JSP_RESTORE_EXECUTE();
     } else {
       if (!scope || jspeiAddScope(scope)) {
+#ifndef SAVE_ON_FLASH
+        // The exception variable could hide a local variable, so don't use slots
+        JsVar **oldLocalSlots = execInfo.localSlots;
+        if (scope) execInfo.localSlots = 0;
+#endif
         jspeBlock();
         if (scope) jspeiRemoveScope();
+#ifndef SAVE_ON_FLASH
+        execInfo.localSlots = oldLocalSlots;
+#endif
       }
     }
     jsvUnLock(scope);
@@ -2900,6 +3221,9 @@ void jspSoftInit() {
   // Root now has a lock and a ref
   execInfo.hiddenRoot = jsvObjectGetChild(execInfo.root, JS_HIDDEN_CHAR_STR, JSV_OBJECT);
   execInfo.execute = EXEC_YES;
+#ifndef SAVE_ON_FLASH
+  jspClearLocalCache();
+#endif
 }
 
 void jspSoftKill() {
@@ -2958,6 +3282,10 @@ JsVar *jspEvaluateVar(JsVar *str, JsVar *scope, uint16_t lineNumberOffset) {
     // if we're adding a scope, make sure it's the *only* scope
     execInfo.scopesVar = 0;
     jspeiAddScope(scope);
+#ifndef SAVE_ON_FLASH
+    execInfo.localNames = 0;
+    execInfo.localSlots = 0;
+#endif
   }
 
   // actually do the parsing
@@ -3009,6 +3337,10 @@ JsVar *jspExecuteFunction(JsVar *func, JsVar *thisArg, int argCount, JsVar **arg
   execInfo.scopesVar = 0;
   execInfo.execute = EXEC_YES;
   execInfo.thisVar = 0;
+#ifndef SAVE_ON_FLASH
+  execInfo.localNames = 0;
+  execInfo.localSlots = 0;
+#endif
   JsVar *result = jspeFunctionCall(func, 0, thisArg, false, argCount, argPtr);
   // clean up
   jspeiClearScopes();
@@ -23,6 +23,10 @@ void jspKill();
 // jspSoft* - 'release' or 'claim' anything we are using, but ensure that it doesn't get freed
 void jspSoftInit(); ///< used when recovering from or saving to flash
 void jspSoftKill(); ///< used when recovering from or saving to flash
+#ifndef SAVE_ON_FLASH
+/// Forget cached local variable slots - must be called if vars are moved (eg. E.defrag)
+void jspClearLocalCache();
+#endif
 /** Returns true if the constructor function given is the same as that
  * of the object with the given name. */
 bool jspIsConstructor(JsVar *constructor, const char *constructorName);
@@ -138,6 +142,12 @@ typedef struct {
   JsVar *scopesVar;
   /// Value of 'this' reserved word
   JsVar *thisVar;
+#ifndef SAVE_ON_FLASH
+  /// The executing function's JSPARSE_FUNCTION_LOCALS_NAME (or 0 if local slots aren't used)
+  JsVar *localNames;
+  /// For each name in localNames, its variable in the function's scope, locked (or 0 if not found yet)
+  JsVar **localSlots;
+#endif
 
   volatile JsExecFlags execute;
 } JsExecInfo;
@@ -17,6 +17,9 @@
 typedef JshUSARTInfo serial_sender_data; // the larger of JshSPIInfo or IOEventFlags
 typedef void (*serial_sender)(unsigned char data, serial_sender_data *info);
 
+/// Send function used for hardware serial devices - info is really an IOEventFlags
+void jsserialHardwareFunc(unsigned char data, serial_sender_data *info);
+
 bool jsserialPopulateUSARTInfo(JshUSARTInfo *inf, JsVar *baud,  JsVar *options);
 
 // Get the correct Serial send function (and the data to send to it).
@@ -247,6 +247,12 @@ typedef int64_t JsSysTime;
 #else
 #define JS_VARS_BEFORE_IDLE_GC 32
 #endif
+/* Incremental garbage collection (see jsvGarbageCollectStep) takes a while to
+ * complete, so start it before memory gets as low as JS_VARS_BEFORE_IDLE_GC */
+#define JS_VARS_BEFORE_INCREMENTAL_GC (JS_VARS_BEFORE_IDLE_GC*4)
+/* How many blocks an incremental garbage collection step will look at before
+ * returning */
+#define JS_VARS_GC_STEP 512
 
 
 #define JSPARSE_MAX_SCOPES  8
@@ -268,6 +274,7 @@ typedef int64_t JsSysTime;
 #define JSPARSE_FUNCTION_THIS_NAME JS_HIDDEN_CHAR_STR"ths" // the 'this' variable - for bound functions
 #define JSPARSE_FUNCTION_NAME_NAME JS_HIDDEN_CHAR_STR"nam" // for named functions (a = function foo() { foo(); })
 #define JSPARSE_FUNCTION_LINENUMBER_NAME JS_HIDDEN_CHAR_STR"lin" // The line number offset of the function
+#define JSPARSE_FUNCTION_LOCALS_NAME JS_HIDDEN_CHAR_STR"lcl" // comma-separated names of the function's parameters and local variables
 #define JS_EVENT_PREFIX "#on"
 #define JS_TIMEZONE_VAR "tz"
 #define JS_GRAPHICS_VAR "gfx"
@@ -61,6 +61,182 @@ volatile bool touchedFreeList = false;
 volatile JsVarRef jsVarFirstEmpty; ///< reference of first unused variable (variables are in a linked list)
 volatile MemBusyType isMemoryBusy; ///< Are we doing garbage collection or similar, so can't access memory?
 
+#ifndef SAVE_ON_FLASH
+/* State for the incremental garbage collector - see jsvGarbageCollectStep */
+typedef enum {
+  GC_IDLE,
+  GC_FLAG, ///< Flagging every var for GC, a few at a time
+  GC_MARK, ///< Marking vars reachable from locked vars, a few at a time
+  GC_SWEEP ///< Freeing vars that weren't marked, a few at a time
+} JsvGarbageCollectState;
+static JsvGarbageCollectState gcState = GC_IDLE;
+static JsVarRef gcCursor; ///< The next var to look at in GC_FLAG/GC_MARK/GC_SWEEP
+static JsVarRef gcFreedFirst, gcFreedLast; ///< In-order list of vars freed by the sweep, added to the free list when it finishes
+static unsigned int gcWork; ///< Vars looked at/marked so far in this step
+static unsigned int gcFreedCount; ///< Vars freed so far by this cycle
+bool jsvGarbageCollectMarking = false;
+JsvGarbageCollectStats jsvGCStats;
+static void jsvGarbageCollectMarkUsed(JsVar *var);
+
+/// Stop any incremental garbage collection that's in progress (vars it freed are only reclaimed by the next full GC)
+static void jsvGarbageCollectAbort() {
+  gcState = GC_IDLE;
+  jsvGarbageCollectMarking = false;
+  gcFreedFirst = gcFreedLast = 0;
+}
+
+/* As well as the free list, we keep a bitmap with a bit set for every var
+ * that is in it, and the free list is doubly linked (using prevSibling).
+ * This means jsvNewFlatStringOfLength can quickly find a run of free blocks
+ * wherever they are in the free list, and can remove them without having
+ * to search it. */
+#if defined(RESIZABLE_JSVARS) || defined(JSVAR_MALLOC)
+static uint32_t *jsvFreeBitmap = 0;
+static unsigned int jsvFreeBitmapWords = 0;
+#else
+static uint32_t jsvFreeBitmap[(JSVAR_CACHE_SIZE+31)>>5];
+#define jsvFreeBitmapWords ((JSVAR_CACHE_SIZE+31)>>5)
+#endif
+
+static ALWAYS_INLINE void jsvFreeBitmapSet(JsVarRef ref) {
+  jsvFreeBitmap[(ref-1)>>5] |= 1U<<((ref-1)&31);
+}
+static ALWAYS_INLINE void jsvFreeBitmapClear(JsVarRef ref) {
+  jsvFreeBitmap[(ref-1)>>5] &= ~(1U<<((ref-1)&31));
+}
+static ALWAYS_INLINE bool jsvFreeBitmapGet(JsVarRef ref) {
+  return (jsvFreeBitmap[(ref-1)>>5] >> ((ref-1)&31)) & 1;
+}
+static void jsvFreeBitmapClearAll() {
+  if (jsvFreeBitmapWords) memset(jsvFreeBitmap, 0, jsvFreeBitmapWords*sizeof(uint32_t));
+}
+/// Make sure the bitmap is big enough for jsVarsSize vars
+static void jsvFreeBitmapResize() {
+#if defined(RESIZABLE_JSVARS) || defined(JSVAR_MALLOC)
+  unsigned int words = (jsVarsSize+31)>>5;
+  if (words <= jsvFreeBitmapWords) return;
+  jsvFreeBitmap = realloc(jsvFreeBitmap, words*sizeof(uint32_t));
+  memset(&jsvFreeBitmap[jsvFreeBitmapWords], 0, (words-jsvFreeBitmapWords)*sizeof(uint32_t));
+  jsvFreeBitmapWords = words;
+#endif
+}
+
+/** Find the first run of 'count' free blocks, or return 0. This doesn't touch
+ * the free list, so can be done with interrupts on (but check the blocks are
+ * still free before using them). */
+static JsVarRef jsvFreeBitmapFindRun(unsigned int count) {
+  unsigned int words = (jsVarsSize+31)>>5;
+  unsigned int runStart = 0, runLength = 0;
+  for (unsigned int w=0;w<words;w++) {
+#ifdef RESIZABLE_JSVARS
+    // vars in different blocks aren't next to each other in memory
+    if (!(w & ((JSVAR_BLOCK_SIZE>>5)-1))) runLength = 0;
+#endif
+    uint32_t bits = jsvFreeBitmap[w];
+    if (bits==0) {
+      runLength = 0;
+    } else if (bits==0xFFFFFFFF) {
+      if (!runLength) runStart = w<<5;
+      runLength += 32;
+    } else {
+      for (unsigned int b=0;b<32;b++) {
+        if (bits & (1U<<b)) {
+          if (!runLength) runStart = (w<<5)+b;
+          if (++runLength >= count) return (JsVarRef)(runStart+1);
+        } else
+          runLength = 0;
+      }
+    }
+    if (runLength >= count) return (JsVarRef)(runStart+1);
+  }
+  return 0;
+}
+#endif
+
+
+#ifndef SAVE_ON_FLASH
+/** Arrays are stored as linked lists of NAMEs, so finding an element means
+ * walking the list. For each of a few arrays (picked by the array's ref) we
+ * remember the last element that jsvGetArrayIndex found, so the common
+ * `for (i=0;i<a.length;i++) a[i]` pattern only has to step one element
+ * rather than search from the start or end of the array.
+ *
+ * The cached element doesn't have to have the same index when we next use it
+ * (eg. after a shift or reverse) - it only has to still be in the array - so
+ * entries are invalidated whenever a NAME may have been unlinked. */
+typedef struct {
+  JsVarRef arr;   ///< The array (or 0 if this entry is unused)
+  JsVarRef child; ///< The NAME of the element in the array we last found
+} JsvArrayIndexCacheEntry;
+#define JSV_ARRAY_INDEX_CACHE_SIZE 8 // POWER OF 2
+static JsvArrayIndexCacheEntry jsvArrayIndexCache[JSV_ARRAY_INDEX_CACHE_SIZE];
+#define jsvArrayIndexCacheFor(ARRREF) (&jsvArrayIndexCache[(ARRREF)&(JSV_ARRAY_INDEX_CACHE_SIZE-1)])
+
+/// An element may have been removed from this array (or it has been freed)
+static void jsvArrayIndexCacheInvalidate(JsVarRef arr) {
+  JsvArrayIndexCacheEntry *e = jsvArrayIndexCacheFor(arr);
+  if (e->arr == arr) e->arr = 0;
+}
+
+/// Refs may have been freed or moved - invalidate all entries
+static void jsvArrayIndexCacheClear() {
+  memset(jsvArrayIndexCache, 0, sizeof(jsvArrayIndexCache));
+}
+
+/** The result of looking up a property can only change if a child is added
+ * to or removed from an object, or a var is freed and its ref reused. This
+ * counter changes whenever that could have happened, so jsparse.c can cache
+ * lookups and check them cheaply. Adding children to objects that aren't
+ * referenced from anywhere (function scopes, objects being constructed) is
+ * very common, so that only counts if the object has been 'watched' - we
+ * keep a few bits of each watched object's ref, so some changes may happen
+ * needlessly but none will be missed. */
+static unsigned int jsvPropertyEpoch;
+#define JSV_PROPERTY_EPOCH_WATCH_BITS 1024 // POWER OF 2
+static uint32_t jsvPropertyEpochWatched[JSV_PROPERTY_EPOCH_WATCH_BITS/32];
+#define jsvPropertyEpochIsWatched(REF) (jsvPropertyEpochWatched[((REF)>>5)&((JSV_PROPERTY_EPOCH_WATCH_BITS/32)-1)] & (1U<<((REF)&31)))
+
+unsigned int jsvGetPropertyEpoch() {
+  return jsvPropertyEpoch;
+}
+
+void jsvPropertyEpochWatch(JsVar *obj) {
+  JsVarRef ref = jsvGetRef(obj);
+  jsvPropertyEpochWatched[(ref>>5)&((JSV_PROPERTY_EPOCH_WATCH_BITS/32)-1)] |= 1U<<(ref&31);
+}
+
+void jsvPropertyEpochChanged() {
+  jsvPropertyEpoch++;
+  memset(jsvPropertyEpochWatched, 0, sizeof(jsvPropertyEpochWatched));
+}
+
+/** Objects with lots of children get a hash index so that jsvFindChildFromString
+ * doesn't have to compare against every child. It's stored as a flat string in
+ * a hidden child (which is always the object's first child) so it is saved
+ * along with everything else and counted by E.getSizeOf. The flat string
+ * contains a JsvHashIndexHeader, followed by an open-addressed table of the
+ * refs of the object's child NAMEs.
+ *
+ * Children that are appended after 'lastIndexed' are added to the table lazily
+ * when a lookup misses. Removed children leave a 'tombstone' in the table,
+ * which is the ref of the object itself (as that can't ever be a child). */
+#define JSV_HASH_INDEX_NAME JS_HIDDEN_CHAR_STR"hsh"
+#define JSV_HASH_INDEX_MIN_CHILDREN 24 ///< Create an index after a search had to look at more children than this
+
+typedef struct {
+  JsVarRef owner;       ///< The object this is an index for. If it's not the parent (eg. after jsvCopy) the index is ignored
+  JsVarRef lastIndexed; ///< The last child that was added to the table (or 0 if none)
+  JsVarRef used;        ///< How many table slots are used (including tombstones)
+  JsVarRef size;        ///< How many slots are in the table (a power of 2)
+} JsvHashIndexHeader;
+
+/// Is this the NAME of a hash index? Quick check as this is called for every lookup
+static bool jsvIsHashIndexName(const JsVar *v) {
+  return (v->flags&JSV_VARTYPEMASK)==JSV_NAME_STRING_0+4 &&
+         *(int*)v->varData.str == *(int*)JSV_HASH_INDEX_NAME;
+}
+#endif
+
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
 
@@ -161,10 +337,12 @@ JsVarRefSigned jsvGetFirstChildSigned(const JsVar *v) {
 JsVarRef jsvGetNextSibling(const JsVar *v) { return (JsVarRef)(v->varData.ref.nextSibling | (((v->varData.ref.pack >> (JSVARREF_PACKED_BITS*2))&JSVARREF_PACKED_BIT_MASK))<<8); }
 JsVarRef jsvGetPrevSibling(const JsVar *v) { return (JsVarRef)(v->varData.ref.prevSibling | (((v->varData.ref.pack >> (JSVARREF_PACKED_BITS*3))&JSVARREF_PACKED_BIT_MASK))<<8); }
 void jsvSetFirstChild(JsVar *v, JsVarRef r) {
+  JSV_GC_BARRIER_CHILD(v,r);
   v->varData.ref.firstChild = (unsigned char)(r & 0xFF);
   v->varData.ref.pack = (unsigned char)((v->varData.ref.pack & ~JSVARREF_PACKED_BIT_MASK) | ((r >> 8) & JSVARREF_PACKED_BIT_MASK));
 }
 void jsvSetNextSibling(JsVar *v, JsVarRef r) {
+  JSV_GC_BARRIER(v,r);
   v->varData.ref.nextSibling = (unsigned char)(r & 0xFF);
   v->varData.ref.pack = (unsigned char)((v->varData.ref.pack & ~(JSVARREF_PACKED_BIT_MASK<<(JSVARREF_PACKED_BITS*2))) | (((r >> 8) & JSVARREF_PACKED_BIT_MASK) << (JSVARREF_PACKED_BITS*2)));
 }
@@ -177,6 +355,7 @@ JsVarRef jsvGetLastChild(const JsVar *v) {
   return (JsVarRef)(v->varData.ref.lastChild | (((v->flags >> JSV_LASTCHILD_BIT_SHIFT)&JSVARREF_PACKED_BIT_MASK))<<8);
 }
 void jsvSetLastChild(JsVar *v, JsVarRef r) {
+  JSV_GC_BARRIER(v,r);
   v->varData.ref.lastChild = (unsigned char)(r & 0xFF);
   v->flags = (v->flags & ~JSV_LASTCHILD_BIT_MASK) | ((r >> 8) << JSV_LASTCHILD_BIT_SHIFT);
 }
@@ -193,21 +372,52 @@ void jsvSetMaxVarsUsed(unsigned int size) {
   jsVarsSize = size;
 }
 
+/// Call when 'var' (with the given ref) has been linked into the free list after 'prev'
+static ALWAYS_INLINE void jsvFreeListAdded(JsVar *var, JsVarRef ref, JsVarRef prev) {
+#ifndef SAVE_ON_FLASH
+  jsvSetPrevSibling(var, prev);
+  jsvFreeBitmapSet(ref);
+#else
+  NOT_USED(var);
+  NOT_USED(ref);
+  NOT_USED(prev);
+#endif
+}
+
+/// Call when var 'next' in the free list now comes after 'prev'
+static ALWAYS_INLINE void jsvFreeListSetPrev(JsVarRef next, JsVarRef prev) {
+#ifndef SAVE_ON_FLASH
+  if (next) jsvSetPrevSibling(jsvGetAddressOf(next), prev);
+#else
+  NOT_USED(next);
+  NOT_USED(prev);
+#endif
+}
+
 // maps the empty variables in...
 void jsvCreateEmptyVarList() {
   assert(!isMemoryBusy);
+#ifndef SAVE_ON_FLASH
+  jsvGarbageCollectAbort();
+#endif
   isMemoryBusy = MEMBUSY_SYSTEM;
   jsVarFirstEmpty = 0;
+#ifndef SAVE_ON_FLASH
+  jsvFreeBitmapClearAll();
+#endif
   JsVar firstVar; // temporary var to simplify code in the loop below
   jsvSetNextSibling(&firstVar, 0);
   JsVar *lastEmpty = &firstVar;
+  JsVarRef lastEmptyRef = 0;
 
   JsVarRef i;
   for (i=1;i<=jsVarsSize;i++) {
     JsVar *var = jsvGetAddressOf(i);
     if ((var->flags&JSV_VARTYPEMASK) == JSV_UNUSED) {
       jsvSetNextSibling(lastEmpty, i);
+      jsvFreeListAdded(var, i, lastEmptyRef);
       lastEmpty = var;
+      lastEmptyRef = i;
     } else if (jsvIsFlatString(var)) {
       // skip over used blocks for flat strings
       i = (JsVarRef)(i+jsvGetFlatStringBlocks(var));
@@ -223,8 +433,14 @@ void jsvCreateEmptyVarList() {
  for storage. */
 void jsvClearEmptyVarList() {
   assert(!isMemoryBusy);
+#ifndef SAVE_ON_FLASH
+  jsvGarbageCollectAbort();
+#endif
   isMemoryBusy = MEMBUSY_SYSTEM;
   jsVarFirstEmpty = 0;
+#ifndef SAVE_ON_FLASH
+  jsvFreeBitmapClearAll();
+#endif
   JsVarRef i;
   for (i=1;i<=jsVarsSize;i++) {
     JsVar *var = jsvGetAddressOf(i);
@@ -240,6 +456,10 @@ void jsvClearEmptyVarList() {
 }
 
 void jsvSoftInit() {
+#ifndef SAVE_ON_FLASH
+  jsvArrayIndexCacheClear();
+  jsvPropertyEpochChanged();
+#endif
   jsvCreateEmptyVarList();
 }
 
@@ -257,6 +477,7 @@ static JsVarRef jsvInitJsVars(JsVarRef start, unsigned int count) {
     v->flags = JSV_UNUSED;
     // v->locks = 0; // locks is 0 anyway because it is stored in flags
     jsvSetNextSibling(v, (JsVarRef)(i+1)); // link to next
+    jsvFreeListAdded(v, i, (JsVarRef)(i==start ? 0 : i-1));
   }
   jsvSetNextSibling(jsvGetAddressOf((JsVarRef)(start+count-1)), (JsVarRef)0); // set the final one to 0
   return start;
@@ -274,6 +495,9 @@ void jsvInit(unsigned int size) {
 #else
   assert(size==0);
 #endif
+#ifndef SAVE_ON_FLASH
+  jsvFreeBitmapResize();
+#endif
 
   jsVarFirstEmpty = jsvInitJsVars(1/*first*/, jsVarsSize);
   jsvSoftInit();
@@ -287,6 +511,11 @@ void jsvKill() {
   free(jsVarBlocks);
   jsVarBlocks = 0;
   jsVarsSize = 0;
+#ifndef SAVE_ON_FLASH
+  free(jsvFreeBitmap);
+  jsvFreeBitmap = 0;
+  jsvFreeBitmapWords = 0;
+#endif
 #endif
 }
 
@@ -344,6 +573,9 @@ void jsvSetMemoryTotal(unsigned int jsNewVarCount) {
   /** and now reset all the newly allocated vars. We know jsVarFirstEmpty
    * is 0 (because jsiFreeMoreMemory returned 0) so we can just assign it.  */
   assert(!jsVarFirstEmpty);
+#ifndef SAVE_ON_FLASH
+  jsvFreeBitmapResize();
+#endif
   jsVarFirstEmpty = jsvInitJsVars(oldSize+1, jsVarsSize-oldSize);
   // jsiConsolePrintf("Resized memory from %d blocks to %d\n", oldBlockCount, newBlockCount);
   touchedFreeList = true;
@@ -488,7 +720,11 @@ JsVar *jsvNewWithFlags(JsVarFlags flags) {
   jshInterruptOff(); // to allow this to be used from an IRQ
   if (jsVarFirstEmpty!=0) {
     v = jsvGetAddressOf(jsVarFirstEmpty); // jsvResetVariable will lock
+#ifndef SAVE_ON_FLASH
+    jsvFreeBitmapClear(jsVarFirstEmpty);
+#endif
     jsVarFirstEmpty = jsvGetNextSibling(v); // move our reference to the next in the free list
+    jsvFreeListSetPrev(jsVarFirstEmpty, 0);
     touchedFreeList = true;
   }
   jshInterruptOn();
@@ -505,6 +741,10 @@ JsVar *jsvNewWithFlags(JsVarFlags flags) {
       touchedFreeList = true;
     } while (!__sync_bool_compare_and_swap(&jsVarFirstEmpty, empty, next));
     assert(v->flags == JSV_UNUSED);*/
+#ifndef SAVE_ON_FLASH
+    // if the GC is still flagging vars, this one must be flagged too so it's marked properly
+    if (gcState==GC_FLAG) flags |= JSV_GARBAGE_COLLECT;
+#endif
     jsvResetVariable(v, flags); // setup variable, and add one lock
     // return pointer
     return v;
@@ -541,8 +781,45 @@ static NO_INLINE void jsvFreePtrInternal(JsVar *var) {
   var->flags = JSV_UNUSED;
   // add this to our free list
   jshInterruptOff(); // to allow this to be used from an IRQ
+  JsVarRef ref = jsvGetRef(var);
   jsvSetNextSibling(var, jsVarFirstEmpty);
-  jsVarFirstEmpty = jsvGetRef(var);
+  jsvFreeListSetPrev(jsVarFirstEmpty, ref);
+  jsvFreeListAdded(var, ref, 0);
+  jsVarFirstEmpty = ref;
+  touchedFreeList = true;
+  jshInterruptOn();
+}
+
+/// Free 'count' contiguous blocks, ending with 'last' - used for the data in flat strings
+static void jsvFreeFlatStringBlocks(JsVarRef last, size_t count) {
+  JsVarRef i = last;
+  // Because this is a whole bunch of blocks, try
+  // and insert it in the right place in the free list
+  // So, iterate along free list to figure out where we
+  // need to insert the free items
+  jshInterruptOff(); // to allow this to be used from an IRQ
+  JsVarRef insertBefore = jsVarFirstEmpty;
+  JsVarRef insertAfter = 0;
+  while (insertBefore && insertBefore<i) {
+    insertAfter = insertBefore;
+    insertBefore = jsvGetNextSibling(jsvGetAddressOf(insertBefore));
+  }
+  // free in reverse, so the free list ends up in kind of the right order
+  while (count--) {
+    JsVarRef pRef = i--;
+    JsVar *p = jsvGetAddressOf(pRef);
+    p->flags = JSV_UNUSED; // set locks to 0 so the assert in jsvFreePtrInternal doesn't get fed up
+    // add this to our free list
+    jsvSetNextSibling(p, insertBefore);
+    jsvFreeListSetPrev(insertBefore, pRef);
+    jsvFreeListAdded(p, pRef, insertAfter);
+    insertBefore = pRef;
+  }
+  // patch up jsVarFirstEmpty/rejoin the list
+  if (insertAfter)
+    jsvSetNextSibling(jsvGetAddressOf(insertAfter), insertBefore);
+  else
+    jsVarFirstEmpty = insertBefore;
   touchedFreeList = true;
   jshInterruptOn();
 }
@@ -589,33 +866,7 @@ ALWAYS_INLINE void jsvFreePtr(JsVar *var) {
     if (jsvIsFlatString(var)) {
       // in which case we need to free all the blocks.
       size_t count = jsvGetFlatStringBlocks(var);
-      JsVarRef i = (JsVarRef)(jsvGetRef(var)+count);
-      // Because this is a whole bunch of blocks, try
-      // and insert it in the right place in the free list
-      // So, iterate along free list to figure out where we
-      // need to insert the free items
-      jshInterruptOff(); // to allow this to be used from an IRQ
-      JsVarRef insertBefore = jsVarFirstEmpty;
-      JsVarRef insertAfter = 0;
-      while (insertBefore && insertBefore<i) {
-        insertAfter = insertBefore;
-        insertBefore = jsvGetNextSibling(jsvGetAddressOf(insertBefore));
-      }
-      // free in reverse, so the free list ends up in kind of the right order
-      while (count--) {
-        JsVar *p = jsvGetAddressOf(i--);
-        p->flags = JSV_UNUSED; // set locks to 0 so the assert in jsvFreePtrInternal doesn't get fed up
-        // add this to our free list
-        jsvSetNextSibling(p, insertBefore);
-        insertBefore = jsvGetRef(p);
-      }
-      // patch up jsVarFirstEmpty/rejoin the list
-      if (insertAfter)
-        jsvSetNextSibling(jsvGetAddressOf(insertAfter), insertBefore);
-      else
-        jsVarFirstEmpty = insertBefore;
-      touchedFreeList = true;
-      jshInterruptOn();
+      jsvFreeFlatStringBlocks((JsVarRef)(jsvGetRef(var)+count), count);
     } else if (jsvIsBasicString(var)) {
 #ifdef CLEAR_MEMORY_ON_FREE
       jsvSetFirstChild(var, 0); // firstchild could have had string data in
@@ -627,6 +878,11 @@ ALWAYS_INLINE void jsvFreePtr(JsVar *var) {
     can be ints or strings */
 
   if (jsvHasChildren(var)) {
+#ifndef SAVE_ON_FLASH
+    jsvArrayIndexCacheInvalidate(jsvGetRef(var));
+    if (jsvPropertyEpochIsWatched(jsvGetRef(var)))
+      jsvPropertyEpochChanged();
+#endif
     JsVarRef childref = jsvGetFirstChild(var);
 #ifdef CLEAR_MEMORY_ON_FREE
     jsvSetFirstChild(var, 0);
@@ -692,6 +948,11 @@ ALWAYS_INLINE JsVar *jsvLock(JsVarRef ref) {
     jsError("Too many locks to Variable!");
     //jsPrint("Var #");jsPrintInt(ref);jsPrint("\n");
   }
+#endif
+#ifndef SAVE_ON_FLASH
+  // The incremental GC may already have gone past this var when it wasn't locked
+  if (jsvGarbageCollectMarking && (var->flags & JSV_GARBAGE_COLLECT))
+    jsvGarbageCollectMarkUsed(var);
 #endif
   return var;
 }
@@ -810,6 +1071,36 @@ JsVar *jsvNewFlatStringOfLength(unsigned int byteLength) {
     return 0;
   }
   while (true) {
+#ifndef SAVE_ON_FLASH
+    /* Find a contiguous set of 'requiredBlocks' blocks using the free bitmap,
+    then unlink them from the (doubly linked) free list. An IRQ could have
+    allocated one of them in the mean time, so check they're all still free
+    with interrupts off - and if not, try again. */
+    JsVarRef startBlock;
+    while (!flatString && (startBlock = jsvFreeBitmapFindRun((unsigned int)requiredBlocks))) {
+      jshInterruptOff();
+      JsVarRef i, endBlock = (JsVarRef)(startBlock+requiredBlocks);
+      for (i=startBlock;i<endBlock;i++)
+        if (!jsvFreeBitmapGet(i)) break;
+      if (i==endBlock) {
+        for (i=startBlock;i<endBlock;i++) {
+          JsVar *v = jsvGetAddressOf(i);
+          JsVarRef next = jsvGetNextSibling(v);
+          JsVarRef prev = jsvGetPrevSibling(v);
+          if (prev) jsvSetNextSibling(jsvGetAddressOf(prev), next);
+          else jsVarFirstEmpty = next;
+          jsvFreeListSetPrev(next, prev);
+          jsvFreeBitmapClear(i);
+        }
+        touchedFreeList = true;
+        flatString = jsvGetAddressOf(startBlock);
+        // Set up the header block (including one lock)
+        jsvResetVariable(flatString, JSV_FLAT_STRING);
+        flatString->varData.integer = (JsVarInt)byteLength;
+      }
+      jshInterruptOn();
+    }
+#else
     /* Now try and find a contiguous set of 'requiredBlocks' blocks by
     searching the free list. This can be done as long as nobody's
     messed with the free list in the mean time (which we check for with
@@ -865,6 +1156,7 @@ JsVar *jsvNewFlatStringOfLength(unsigned int byteLength) {
         memoryTouched = true;
       }
     }
+#endif
 
     // all good
     if (flatString || !firstRun)
@@ -879,6 +1171,15 @@ JsVar *jsvNewFlatStringOfLength(unsigned int byteLength) {
   /* We now have the string! All that's left is to clear it */
   // clear data
   memset((char*)&flatString[1], 0, sizeof(JsVar)*(requiredBlocks-1));
+#ifndef SAVE_ON_FLASH
+  /* If an incremental GC is part way through, make sure it doesn't try
+   * and look at the blocks holding our data as if they were vars */
+  if (gcState!=GC_IDLE) {
+    JsVarRef flatStringRef = jsvGetRef(flatString);
+    if (gcCursor>flatStringRef && gcCursor<flatStringRef+requiredBlocks)
+      gcCursor = (JsVarRef)(flatStringRef+requiredBlocks);
+  }
+#endif
   /* We did mess with the free list - set it here in case we
   are trying to create a flat string in an IRQ while trying to
   make one outside the IRQ too */
@@ -1507,6 +1808,15 @@ size_t jsvGetFlatStringBlocks(const JsVar *v) {
   return ((size_t)v->varData.integer+sizeof(JsVar)-1) / sizeof(JsVar);
 }
 
+void jsvTruncateFlatString(JsVar *v, size_t length) {
+  assert(jsvIsFlatString(v) && length<=(size_t)v->varData.integer);
+  size_t oldBlocks = jsvGetFlatStringBlocks(v);
+  v->varData.integer = (JsVarInt)length;
+  size_t blocks = jsvGetFlatStringBlocks(v);
+  if (blocks < oldBlocks)
+    jsvFreeFlatStringBlocks((JsVarRef)(jsvGetRef(v)+oldBlocks), oldBlocks-blocks);
+}
+
 char *jsvGetFlatStringPointer(JsVar *v) {
   assert(jsvIsFlatString(v));
   if (!jsvIsFlatString(v)) return 0;
@@ -2044,6 +2354,10 @@ void jsvReplaceWith(JsVar *dst, JsVar *src) {
     return;
   }
   jsvUnLock(v);
+  // Changing an object's prototype changes what property lookups will return
+  if (jsvIsString(dst) &&
+      (jsvIsStringEqual(dst, JSPARSE_INHERITS_VAR) || jsvIsStringEqual(dst, JSPARSE_PROTOTYPE_VAR)))
+    jsvPropertyEpochChanged();
 #endif
   jsvSetValueOfName(dst, src);
   /* If dst is flagged as a new child, it means that
@@ -2521,6 +2835,13 @@ JsVar *jsvCopy(JsVar *src, bool copyChildren) {
       vr = jsvGetFirstChild(src);
       while (vr) {
         JsVar *name = jsvLock(vr);
+#ifndef SAVE_ON_FLASH
+        if (jsvIsHashIndexName(name)) { // the hash index refers to src's children - don't copy it
+          vr = jsvGetNextSibling(name);
+          jsvUnLock(name);
+          continue;
+        }
+#endif
         JsVar *child = jsvCopyNameOnly(name, true/*link children*/, true/*keep as name*/); // NO DEEP COPY!
         if (child) { // could have been out of memory
           jsvAddName(dst, child);
@@ -2540,6 +2861,13 @@ JsVar *jsvCopy(JsVar *src, bool copyChildren) {
 void jsvAddName(JsVar *parent, JsVar *namedChild) {
   namedChild = jsvRef(namedChild); // ref here VERY important as adding to structure!
   assert(jsvIsName(namedChild));
+#ifndef SAVE_ON_FLASH
+  // A new child could hide one in a prototype (array elements can't hide anything)
+  if (jsvIsArray(parent) ?
+      (!jsvIsInt(namedChild) && jsvPropertyEpochIsWatched(jsvGetRef(parent))) :
+      (jsvGetRefs(parent) || jsvIsRoot(parent) || jsvPropertyEpochIsWatched(jsvGetRef(parent))))
+    jsvPropertyEpochChanged();
+#endif
 
   // update array length
   if (jsvIsArray(parent) && jsvIsInt(namedChild)) {
@@ -2647,6 +2975,186 @@ JsVar *jsvSetValueOfName(JsVar *name, JsVar *src) {
   return name;
 }
 
+#ifndef SAVE_ON_FLASH
+static unsigned int jsvHashIndexHashString(const char *str) {
+  unsigned int hash = 5381;
+  while (*str) hash = (hash*33) ^ (unsigned char)*(str++);
+  return hash;
+}
+
+static unsigned int jsvHashIndexHashInt(JsVarInt v) {
+  return (unsigned int)v * 2654435761U;
+}
+
+/// Get the hash of a NAME (or 0 if it's a type of name we don't handle)
+static unsigned int jsvHashIndexHashVar(JsVar *v) {
+  if (jsvIsString(v)) {
+    unsigned int hash = 5381;
+    JsvStringIterator it;
+    jsvStringIteratorNew(&it, v, 0);
+    while (jsvStringIteratorHasChar(&it)) {
+      hash = (hash*33) ^ (unsigned char)jsvStringIteratorGetChar(&it);
+      jsvStringIteratorNext(&it);
+    }
+    jsvStringIteratorFree(&it);
+    return hash;
+  }
+  return jsvHashIndexHashInt(v->varData.integer);
+}
+
+static JsVarRef *jsvHashIndexGetTable(JsvHashIndexHeader *h) {
+  return (JsVarRef*)&h[1];
+}
+
+/// Get the (locked) hash index for this object, or 0. Removes the index if it's invalid
+static JsVar *jsvHashIndexGet(JsVar *parent) {
+  JsVarRef nameRef = jsvGetFirstChild(parent);
+  if (!nameRef || !jsvIsHashIndexName(jsvGetAddressOf(nameRef)))
+    return 0;
+  JsVar *name = jsvLock(nameRef);
+  JsVar *index = jsvLockSafe(jsvGetFirstChild(name));
+  if (jsvIsFlatString(index) &&
+      ((JsvHashIndexHeader*)jsvGetFlatStringPointer(index))->owner == jsvGetRef(parent)) {
+    jsvUnLock(name);
+    return index;
+  }
+  // The index belongs to another object (it was copied) - remove it
+  jsvRemoveChild(parent, name);
+  jsvUnLock2(name, index);
+  return 0;
+}
+
+/// Add a child to the table - return false if the table is too full
+static bool jsvHashIndexInsert(JsvHashIndexHeader *h, JsVarRef childRef, unsigned int hash) {
+  if ((unsigned int)(h->used+1)*4 > (unsigned int)h->size*3)
+    return false;
+  JsVarRef *table = jsvHashIndexGetTable(h);
+  unsigned int mask = (unsigned int)h->size-1;
+  unsigned int i = hash & mask;
+  while (table[i]) i = (i+1) & mask;
+  table[i] = childRef;
+  h->used++;
+  return true;
+}
+
+/// Create (or recreate) the hash index for the given object
+static void jsvHashIndexCreate(JsVar *parent) {
+  JsVar *oldName = jsvGetFirstChild(parent) && jsvIsHashIndexName(jsvGetAddressOf(jsvGetFirstChild(parent))) ?
+      jsvLock(jsvGetFirstChild(parent)) : 0;
+  if (oldName) {
+    jsvRemoveChild(parent, oldName);
+    jsvUnLock(oldName);
+  }
+  unsigned int size = 16;
+  unsigned int children = (unsigned int)jsvGetChildren(parent);
+  while (size < children*2) size <<= 1;
+  if (size > JSVARREF_MAX) return; // too big to store
+  JsVar *index = jsvNewFlatStringOfLength((unsigned int)(sizeof(JsvHashIndexHeader) + size*sizeof(JsVarRef)));
+  if (!index) return; // out of memory or too fragmented
+  JsvHashIndexHeader *h = (JsvHashIndexHeader*)jsvGetFlatStringPointer(index);
+  h->owner = jsvGetRef(parent);
+  h->size = (JsVarRef)size;
+  // Flat strings are zeroed, so used/lastIndexed/table are already 0
+  JsVarRef childref = jsvGetFirstChild(parent);
+  while (childref) {
+    JsVar *child = jsvGetAddressOf(childref);
+    jsvHashIndexInsert(h, childref, jsvHashIndexHashVar(child));
+    h->lastIndexed = childref;
+    childref = jsvGetNextSibling(child);
+  }
+  JsVar *name = jsvMakeIntoVariableName(jsvNewFromString(JSV_HASH_INDEX_NAME), index);
+  jsvUnLock(index);
+  if (!name) return; // out of memory
+  // Add as the first child
+  jsvRef(name);
+  JsVarRef nameRef = jsvGetRef(name);
+  if (jsvGetFirstChild(parent)) {
+    JsVar *first = jsvLock(jsvGetFirstChild(parent));
+    jsvSetPrevSibling(first, nameRef);
+    jsvUnLock(first);
+    jsvSetNextSibling(name, jsvGetFirstChild(parent));
+  } else {
+    jsvSetLastChild(parent, nameRef);
+  }
+  jsvSetFirstChild(parent, nameRef);
+  jsvUnLock(name);
+}
+
+/** Search using the hash index. If 'name' is set it is used to find the child,
+ * otherwise 'nameVar' is. Returns a locked NAME, or 0 */
+static JsVar *jsvHashIndexFind(JsVar *parent, JsVar *index, unsigned int hash, const char *name, JsVar *nameVar) {
+  JsvHashIndexHeader *h = (JsvHashIndexHeader*)jsvGetFlatStringPointer(index);
+  JsVarRef *table = jsvHashIndexGetTable(h);
+  unsigned int mask = (unsigned int)h->size-1;
+  unsigned int i = hash & mask;
+  while (table[i]) {
+    if (table[i] != h->owner) { // not a tombstone
+      JsVar *child = jsvGetAddressOf(table[i]);
+      if (name ? jsvIsStringEqual(child, name) : jsvIsBasicVarEqual(child, nameVar))
+        return jsvLockAgain(child);
+    }
+    i = (i+1) & mask;
+  }
+  // Not found - now add and check any children that were added since we last looked
+  bool full = false;
+  JsVar *found = 0;
+  JsVarRef childref = h->lastIndexed ? jsvGetNextSibling(jsvGetAddressOf(h->lastIndexed)) : jsvGetFirstChild(parent);
+  while (childref && !found) {
+    JsVar *child = jsvGetAddressOf(childref);
+    if (!jsvIsHashIndexName(child)) {
+      if (!full) {
+        full = !jsvHashIndexInsert(h, childref, jsvHashIndexHashVar(child));
+        if (!full) h->lastIndexed = childref;
+      }
+      if (name ? jsvIsStringEqual(child, name) : jsvIsBasicVarEqual(child, nameVar))
+        found = jsvLockAgain(child);
+    }
+    childref = jsvGetNextSibling(child);
+  }
+  if (full) jsvHashIndexCreate(parent); // make a bigger one
+  return found;
+}
+
+/// Called before a child is removed from an object
+static void jsvHashIndexRemove(JsVar *parent, JsVar *child) {
+  if (jsvIsHashIndexName(child)) return;
+  JsVar *index = jsvHashIndexGet(parent);
+  if (!index) return;
+  JsvHashIndexHeader *h = (JsvHashIndexHeader*)jsvGetFlatStringPointer(index);
+  JsVarRef *table = jsvHashIndexGetTable(h);
+  JsVarRef childRef = jsvGetRef(child);
+  unsigned int mask = (unsigned int)h->size-1;
+  unsigned int i = jsvHashIndexHashVar(child) & mask;
+  while (table[i]) {
+    if (table[i] == childRef) {
+      table[i] = h->owner; // tombstone
+      break;
+    }
+    i = (i+1) & mask;
+  }
+  if (h->lastIndexed == childRef)
+    h->lastIndexed = jsvGetPrevSibling(child);
+  jsvUnLock(index);
+}
+
+/// Remove all hash indexes - used when refs are about to change
+static void jsvHashIndexRemoveAll() {
+  unsigned int i;
+  for (i=1;i<=jsvGetMemoryTotal();i++) {
+    JsVar *v = _jsvGetAddressOf((JsVarRef)i);
+    if (jsvIsObject(v) && jsvGetFirstChild(v) &&
+        jsvIsHashIndexName(_jsvGetAddressOf(jsvGetFirstChild(v)))) {
+      JsVar *obj = jsvLock((JsVarRef)i);
+      JsVar *name = jsvLock(jsvGetFirstChild(obj));
+      jsvRemoveChild(obj, name);
+      jsvUnLock2(name, obj);
+    } else if (jsvIsFlatString(v)) {
+      i += (unsigned int)jsvGetFlatStringBlocks(v); // skip forward
+    }
+  }
+}
+#endif
+
 JsVar *jsvFindChildFromString(JsVar *parent, const char *name, bool addIfNotFound) {
   /* Pull out first 4 bytes, and ensure that everything
    * is 0 padded so that we can do a nice speedy check. */
@@ -2672,6 +3180,15 @@ JsVar *jsvFindChildFromString(JsVar *parent, const char *name, bool addIfNotFoun
   }
 
   assert(jsvHasChildren(parent));
+#ifndef SAVE_ON_FLASH
+  JsVar *index = jsvIsObject(parent) ? jsvHashIndexGet(parent) : 0;
+  if (index) {
+    JsVar *child = jsvHashIndexFind(parent, index, jsvHashIndexHashString(name), name, 0);
+    jsvUnLock(index);
+    if (child) return child;
+  } else {
+    unsigned int searched = 0;
+#endif
   JsVarRef childref = jsvGetFirstChild(parent);
   while (childref) {
     // Don't Lock here, just use GetAddressOf - to try and speed up the finding
@@ -2680,10 +3197,23 @@ JsVar *jsvFindChildFromString(JsVar *parent, const char *name, bool addIfNotFoun
     if (*(int*)fastCheck==*(int*)child->varData.str && // speedy check of first 4 bytes
         jsvIsStringEqual(child, name)) {
       // found it! unlock parent but leave child locked
-      return jsvLockAgain(child);
+      child = jsvLockAgain(child);
+#ifndef SAVE_ON_FLASH
+      if (searched > JSV_HASH_INDEX_MIN_CHILDREN && jsvIsObject(parent))
+        jsvHashIndexCreate(parent);
+#endif
+      return child;
     }
     childref = jsvGetNextSibling(child);
+#ifndef SAVE_ON_FLASH
+    searched++;
+#endif
   }
+#ifndef SAVE_ON_FLASH
+    if (searched > JSV_HASH_INDEX_MIN_CHILDREN && jsvIsObject(parent))
+      jsvHashIndexCreate(parent);
+  }
+#endif
 
   JsVar *child = 0;
   if (addIfNotFound) {
@@ -2746,15 +3276,45 @@ JsVar *jsvFindChildFromVar(JsVar *parent, JsVar *childName, bool addIfNotFound)
   JsVar *child;
   JsVarRef childref = jsvGetFirstChild(parent);
 
+  if (jsvIsArray(parent) && jsvIsInt(childName) && !jsvIsPin(childName)) {
+    // Integer array keys are sorted, so we can use the faster search
+    child = jsvGetArrayIndex(parent, childName->varData.integer);
+    if (child) return child;
+    childref = 0; // it wasn't found - don't search again
+  }
+#ifndef SAVE_ON_FLASH
+  unsigned int searched = 0;
+  if (childref && jsvIsObject(parent) && (jsvIsString(childName) || jsvIsSimpleInt(childName))) {
+    JsVar *index = jsvHashIndexGet(parent);
+    if (index) {
+      child = jsvHashIndexFind(parent, index, jsvHashIndexHashVar(childName), 0, childName);
+      jsvUnLock(index);
+      if (child) return child;
+      childref = 0; // it wasn't found - don't search again
+    }
+  }
+#endif
+
   while (childref) {
     child = jsvLock(childref);
     if (jsvIsBasicVarEqual(child, childName)) {
       // found it! unlock parent but leave child locked
+#ifndef SAVE_ON_FLASH
+      if (searched > JSV_HASH_INDEX_MIN_CHILDREN && jsvIsObject(parent))
+        jsvHashIndexCreate(parent);
+#endif
       return child;
     }
     childref = jsvGetNextSibling(child);
     jsvUnLock(child);
+#ifndef SAVE_ON_FLASH
+    searched++;
+#endif
   }
+#ifndef SAVE_ON_FLASH
+  if (searched > JSV_HASH_INDEX_MIN_CHILDREN && jsvIsObject(parent))
+    jsvHashIndexCreate(parent);
+#endif
 
   child = 0;
   if (addIfNotFound && childName) {
@@ -2769,6 +3329,11 @@ void jsvRemoveChild(JsVar *parent, JsVar *child) {
   assert(jsvIsName(child));
   JsVarRef childref = jsvGetRef(child);
   bool wasChild = false;
+#ifndef SAVE_ON_FLASH
+  jsvArrayIndexCacheInvalidate(jsvGetRef(parent));
+  if (jsvIsObject(parent)) jsvHashIndexRemove(parent, child);
+  if (!jsvIsArray(parent) || !jsvIsInt(child)) jsvPropertyEpochChanged();
+#endif
   // unlink from parent
   if (jsvGetFirstChild(parent) == childref) {
     jsvSetFirstChild(parent, jsvGetNextSibling(child));
@@ -3044,32 +3609,56 @@ JsVar *jsvGetArrayIndex(const JsVar *arr, JsVarInt index) {
   // it's not in this array - don't search the whole lot...
   if (index > lastArrayIndex)
     return 0;
-  // otherwise is it more than halfway through?
-  if (index > lastArrayIndex/2) {
-    // it's in the final half of the array (probably) - search backwards
-    while (childref) {
-      JsVar *child = jsvLock(childref);
-
-      assert(jsvIsInt(child));
-      if (child->varData.integer == index) {
-        return child;
-      }
-      childref = jsvGetPrevSibling(child);
-      jsvUnLock(child);
-    }
-  } else {
+  /* Work out where the nearest place to start searching from is. Assume
+   * the array is dense, so the distance in elements is the difference in index */
+  bool forwards = false;
+  JsVarInt distance = lastArrayIndex - index;
+  if (index < distance) {
     // it's in the first half of the array (probably) - search forwards
     childref = jsvGetFirstChild(arr);
-    while (childref) {
-      JsVar *child = jsvLock(childref);
-
-      assert(jsvIsInt(child));
-      if (child->varData.integer == index) {
-        return child;
-      }
-      childref = jsvGetNextSibling(child);
+    forwards = true;
+    distance = index;
+  }
+#ifndef SAVE_ON_FLASH
+  JsVarRef arrRef = jsvGetRef((JsVar*)arr);
+  JsvArrayIndexCacheEntry *cache = jsvArrayIndexCacheFor(arrRef);
+  if (cache->arr == arrRef) {
+    JsVar *cached = jsvLock(cache->child);
+    assert(jsvIsInt(cached));
+    JsVarInt cachedIndex = cached->varData.integer;
+    if (cachedIndex == index) return cached;
+    if (cachedIndex < index && index-cachedIndex < distance) {
+      childref = cache->child;
+      forwards = true;
+    } else if (cachedIndex > index && cachedIndex-index < distance) {
+      childref = cache->child;
+      forwards = false;
+    }
+    jsvUnLock(cached);
+  }
+#endif
+  while (childref) {
+    JsVar *child = jsvLock(childref);
+    if (!jsvIsInt(child)) {
+      // string keys come after all the integer ones
       jsvUnLock(child);
+      break;
     }
+    JsVarInt childIndex = child->varData.integer;
+    if (childIndex == index) {
+#ifndef SAVE_ON_FLASH
+      cache->arr = arrRef;
+      cache->child = childref;
+#endif
+      return child;
+    }
+    // keys are sorted, so if we've gone past it it's not here
+    if (forwards ? (childIndex > index) : (childIndex < index)) {
+      jsvUnLock(child);
+      break;
+    }
+    childref = forwards ? jsvGetNextSibling(child) : jsvGetPrevSibling(child);
+    jsvUnLock(child);
   }
   return 0; // undefined
 }
@@ -3245,6 +3834,9 @@ JsVar *jsvArrayPop(JsVar *arr) {
 JsVar *jsvArrayPopFirst(JsVar *arr) {
   assert(jsvIsArray(arr));
   if (jsvGetFirstChild(arr)) {
+#ifndef SAVE_ON_FLASH
+    jsvArrayIndexCacheInvalidate(jsvGetRef(arr));
+#endif
     JsVar *child = jsvLock(jsvGetFirstChild(arr));
     if (jsvGetFirstChild(arr) == jsvGetLastChild(arr))
       jsvSetLastChild(arr, 0); // if 1 item in array
@@ -3712,6 +4304,9 @@ void jsvTrace(JsVar *var, int indent) {
 /** Recursively mark the variable */
 static void jsvGarbageCollectMarkUsed(JsVar *var) {
   var->flags &= (JsVarFlags)~JSV_GARBAGE_COLLECT;
+#ifndef SAVE_ON_FLASH
+  gcWork++;
+#endif
 
   if (jsvHasCharacterData(var)) {
     // non-recursively scan strings
@@ -3745,6 +4340,10 @@ static void jsvGarbageCollectMarkUsed(JsVar *var) {
 /** Run a garbage collection sweep - return nonzero if things have been freed */
 int jsvGarbageCollect() {
   if (isMemoryBusy) return false;
+#ifndef SAVE_ON_FLASH
+  // a full GC does everything an incremental one would have
+  jsvGarbageCollectAbort();
+#endif
   isMemoryBusy = MEMBUSY_GC;
   JsVarRef i;
   // Add GC flags to anything that is currently used
@@ -3767,6 +4366,10 @@ int jsvGarbageCollect() {
     if (jsvIsFlatString(var))
       i = (JsVarRef)(i+jsvGetFlatStringBlocks(var));
   }
+#ifndef SAVE_ON_FLASH
+  // queued events are only referenced from native code
+  jsiGarbageCollectMarkEvents();
+#endif
   /* now sweep for things that we can GC!
    * Also update the free list - this means that every new variable that
    * gets allocated gets allocated towards the start of memory, which
@@ -3774,6 +4377,10 @@ int jsvGarbageCollect() {
   unsigned int freedCount = 0;
   jsVarFirstEmpty = 0;
   JsVar *lastEmpty = 0;
+  JsVarRef lastEmptyRef = 0;
+#ifndef SAVE_ON_FLASH
+  jsvFreeBitmapClearAll();
+#endif
   for (i=1;i<=jsVarsSize;i++)  {
     JsVar *var = jsvGetAddressOf(i);
     if (var->flags & JSV_GARBAGE_COLLECT) {
@@ -3786,7 +4393,9 @@ int jsvGarbageCollect() {
         // add this to our free list
         if (lastEmpty) jsvSetNextSibling(lastEmpty, i);
         else jsVarFirstEmpty = i;
+        jsvFreeListAdded(var, i, lastEmptyRef);
         lastEmpty = var;
+        lastEmptyRef = i;
         // free subsequent blocks
         while (count-- > 0) {
           i++;
@@ -3795,7 +4404,9 @@ int jsvGarbageCollect() {
           // add this to our free list
           if (lastEmpty) jsvSetNextSibling(lastEmpty, i);
           else jsVarFirstEmpty = i;
+          jsvFreeListAdded(var, i, lastEmptyRef);
           lastEmpty = var;
+          lastEmptyRef = i;
         }
       } else {
         // otherwise just free 1 block
@@ -3837,7 +4448,9 @@ int jsvGarbageCollect() {
         // add this to our free list
         if (lastEmpty) jsvSetNextSibling(lastEmpty, i);
         else jsVarFirstEmpty = i;
+        jsvFreeListAdded(var, i, lastEmptyRef);
         lastEmpty = var;
+        lastEmptyRef = i;
         freedCount++;
       }
     } else if (jsvIsFlatString(var)) {
@@ -3847,15 +4460,211 @@ int jsvGarbageCollect() {
       // this is already free - add it to the free list
       if (lastEmpty) jsvSetNextSibling(lastEmpty, i);
       else jsVarFirstEmpty = i;
+      jsvFreeListAdded(var, i, lastEmptyRef);
       lastEmpty = var;
+      lastEmptyRef = i;
     }
   }
   if (lastEmpty) jsvSetNextSibling(lastEmpty, 0);
+#ifndef SAVE_ON_FLASH
+  if (freedCount) {
+    jsvArrayIndexCacheClear();
+    jsvPropertyEpochChanged();
+  }
+#endif
   isMemoryBusy = MEM_NOT_BUSY;
   return (int)freedCount;
 }
 
+#ifndef SAVE_ON_FLASH
+void jsvGarbageCollectMarkRef(JsVarRef r) {
+  if (!r || r>jsVarsSize) return;
+  JsVar *var = jsvGetAddressOf(r);
+  if (var->flags & JSV_GARBAGE_COLLECT)
+    jsvGarbageCollectMarkUsed(var);
+}
+
+void jsvGarbageCollectBarrier(JsVar *v, JsVarRef r) {
+  // If 'v' hasn't been marked yet, 'r' will get marked when it is
+  if ((v->flags & JSV_GARBAGE_COLLECT) || r>jsVarsSize) return;
+  JsVar *target = jsvGetAddressOf(r);
+  if (target->flags & JSV_GARBAGE_COLLECT)
+    jsvGarbageCollectMarkUsed(target);
+}
+
+void jsvGarbageCollectBarrierChild(JsVar *v, JsVarRef r) {
+  // names with values store the value itself, not a reference
+  if (!jsvIsNameWithValue(v))
+    jsvGarbageCollectBarrier(v, r);
+}
+
+/// Flag vars for GC. Returns false if we ran out of work for this step
+static bool jsvGarbageCollectFlag(unsigned int maxWork) {
+  while (gcCursor<=jsVarsSize) {
+    if (gcWork>=maxWork) return false;
+    JsVar *var = jsvGetAddressOf(gcCursor);
+    if ((var->flags&JSV_VARTYPEMASK) != JSV_UNUSED) {
+      var->flags |= (JsVarFlags)JSV_GARBAGE_COLLECT;
+      if (jsvIsFlatString(var))
+        gcCursor = (JsVarRef)(gcCursor+jsvGetFlatStringBlocks(var));
+    }
+    gcCursor++;
+    gcWork++;
+  }
+  return true;
+}
+
+/// Mark anything that is locked (and everything it references). Returns false if we ran out of work for this step
+static bool jsvGarbageCollectMarkLocked(unsigned int maxWork) {
+  while (gcCursor<=jsVarsSize) {
+    if (gcWork>=maxWork) return false;
+    JsVar *var = jsvGetAddressOf(gcCursor);
+    if ((var->flags & JSV_GARBAGE_COLLECT) && jsvGetLocks(var)>0)
+      jsvGarbageCollectMarkUsed(var);
+    if (jsvIsFlatString(var))
+      gcCursor = (JsVarRef)(gcCursor+jsvGetFlatStringBlocks(var));
+    gcCursor++;
+    gcWork++;
+  }
+  return true;
+}
+
+/// Free a var that the GC found wasn't used, adding it to the list of freed vars
+static void jsvGarbageCollectFree(JsVar *var, JsVarRef ref) {
+  var->flags = JSV_UNUSED;
+  jsvSetNextSibling(var, 0);
+  jsvSetPrevSibling(var, gcFreedLast);
+  if (gcFreedLast) jsvSetNextSibling(jsvGetAddressOf(gcFreedLast), ref);
+  else gcFreedFirst = ref;
+  gcFreedLast = ref;
+}
+
+/// Free unmarked vars. Returns false if we ran out of work for this step
+static bool jsvGarbageCollectSweep(unsigned int maxWork, unsigned int *freedCount) {
+  while (gcCursor<=jsVarsSize) {
+    if (gcWork>=maxWork) return false;
+    JsVarRef i = gcCursor;
+    JsVar *var = jsvGetAddressOf(i);
+    if (var->flags & JSV_GARBAGE_COLLECT) {
+      if (jsvIsFlatString(var)) {
+        unsigned int count = (unsigned int)jsvGetFlatStringBlocks(var);
+        jsvGarbageCollectFree(var, i);
+        (*freedCount)++;
+        while (count-- > 0) {
+          i++;
+          jsvGarbageCollectFree(jsvGetAddressOf(i), i);
+          (*freedCount)++;
+        }
+      } else {
+        // See jsvGarbageCollect - children not marked for GC are in use elsewhere
+        if (jsvHasSingleChild(var)) {
+          JsVarRef ch = jsvGetFirstChild(var);
+          if (ch) {
+            JsVar *child = jsvGetAddressOf(ch);
+            if (child->flags!=JSV_UNUSED && !(child->flags&JSV_GARBAGE_COLLECT))
+              jsvUnRef(child);
+          }
+        }
+        jsvGarbageCollectFree(var, i);
+        (*freedCount)++;
+      }
+    } else if (jsvIsFlatString(var)) {
+      i = (JsVarRef)(i+jsvGetFlatStringBlocks(var));
+    }
+    gcCursor = (JsVarRef)(i+1);
+    gcWork++;
+  }
+  return true;
+}
+
+/* Incremental GC works like jsvGarbageCollect, but a little at a time:
+ *
+ * 1. GC_FLAG: Walk through memory a few vars at a time flagging every var for
+ *    GC. Nothing is marked yet, so vars created meanwhile are just flagged too
+ *    (flat strings we've gone past aren't - but they can't reference anything).
+ * 2. GC_MARK: Walk through memory a few vars at a time, marking anything locked
+ *    and everything it references. While this happens, jsvGarbageCollectBarrier
+ *    marks anything newly linked from a marked var, jsvLock marks anything
+ *    that becomes locked (we may have gone past it already), and new vars are
+ *    created without the GC flag - so they're treated as marked.
+ * 3. GC_SWEEP: Walk through memory a few vars at a time freeing anything that
+ *    is still flagged. Nothing can reach these vars any more, so it doesn't
+ *    matter that the program runs in between. The freed vars are kept in order
+ *    and only added to the free list at the end, so they can't be reused
+ *    before we're done (and flat strings can still be allocated from them).
+ */
+bool jsvGarbageCollectStep() {
+  if (isMemoryBusy) return gcState!=GC_IDLE;
+  JsSysTime startTime = jshGetSystemTime();
+  isMemoryBusy = MEMBUSY_GC;
+  gcWork = 0;
+  unsigned int freedCount = 0;
+  if (gcState==GC_IDLE) {
+    gcState = GC_FLAG;
+    gcCursor = 1;
+    gcFreedFirst = gcFreedLast = 0;
+    gcFreedCount = 0;
+  }
+  if (gcState==GC_FLAG) {
+    if (jsvGarbageCollectFlag(JS_VARS_GC_STEP)) {
+      gcState = GC_MARK;
+      gcCursor = 1;
+      jsvGarbageCollectMarking = true;
+    }
+  } else if (gcState==GC_MARK) {
+    if (jsvGarbageCollectMarkLocked(JS_VARS_GC_STEP)) {
+      // anything locked since we went past it was marked by jsvLock
+      jsiGarbageCollectMarkEvents();
+      jsvGarbageCollectMarking = false;
+      gcState = GC_SWEEP;
+      gcCursor = 1;
+    }
+  } else if (gcState==GC_SWEEP) {
+    if (jsvGarbageCollectSweep(JS_VARS_GC_STEP, &freedCount)) {
+      if (gcFreedLast) {
+        for (JsVarRef r=gcFreedFirst; r; r=jsvGetNextSibling(jsvGetAddressOf(r)))
+          jsvFreeBitmapSet(r);
+        jshInterruptOff();
+        jsvSetNextSibling(jsvGetAddressOf(gcFreedLast), jsVarFirstEmpty);
+        jsvFreeListSetPrev(jsVarFirstEmpty, gcFreedLast);
+        jsVarFirstEmpty = gcFreedFirst;
+        touchedFreeList = true;
+        jshInterruptOn();
+      }
+      gcFreedFirst = gcFreedLast = 0;
+      gcState = GC_IDLE;
+      jsvGCStats.cycles++;
+      jsvGCStats.lastFreed = gcFreedCount + freedCount;
+    }
+  }
+  if (freedCount) {
+    gcFreedCount += freedCount;
+    jsvGCStats.freed += freedCount;
+    jsvArrayIndexCacheClear();
+    jsvPropertyEpochChanged();
+  }
+  isMemoryBusy = MEM_NOT_BUSY;
+  jsvGCStats.steps++;
+  if (gcWork > jsvGCStats.maxWork)
+    jsvGCStats.maxWork = gcWork;
+  jsvGCStats.lastPause = jshGetSystemTime() - startTime;
+  if (jsvGCStats.lastPause > jsvGCStats.maxPause)
+    jsvGCStats.maxPause = jsvGCStats.lastPause;
+  return gcState!=GC_IDLE;
+}
+
+bool jsvGarbageCollectInProgress() {
+  return gcState!=GC_IDLE;
+}
+#endif
+
 void jsvDefragment() {
+#ifndef SAVE_ON_FLASH
+  // hash indexes contain refs that we'd have to update - just remove them and they'll be recreated
+  jsvHashIndexRemoveAll();
+  // cached local variable slots are keyed on refs too
+  jspClearLocalCache();
+#endif
   // garbage collect - removes cruft
   // also puts free list in order
   jsvGarbageCollect();
@@ -3923,6 +4732,10 @@ void jsvDefragment() {
         }
       }
     }
+#ifndef SAVE_ON_FLASH
+    // queued events have refs that aren't stored in vars
+    jsiEventsRefMoved(defragFromRef, defragToRef);
+#endif
     // zero element and move to next...
     defragVars[defragVarIdx] = 0;
     defragVarIdx--;
@@ -3930,7 +4743,13 @@ void jsvDefragment() {
   }
   // rebuild free var list
   jsvCreateEmptyVarList();
+#ifndef SAVE_ON_FLASH
+  jsvArrayIndexCacheClear(); // refs have moved
+  jsvPropertyEpochChanged();
+#endif
   jshInterruptOn();
+  // the timer heap contains refs of timers, which may have moved
+  jsiTimerHeapRebuild();
 }
 
 // Dump any locked variables that aren't referenced from `global` - for debugging memory leaks
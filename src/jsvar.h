@@ -272,15 +272,31 @@ typedef struct {
  * contains the device number. See jsiGetDeviceFromClass/jspNewObject
  */
 
+#ifndef SAVE_ON_FLASH
+/* Write barrier for the incremental garbage collector. While it is marking,
+ * anything that gets linked from a var that has already been marked must be
+ * marked too, or it could be freed while still in use. */
+extern bool jsvGarbageCollectMarking;
+/// Mark the var with the given ref (and everything it references) as used if a GC is in progress
+void jsvGarbageCollectMarkRef(JsVarRef r);
+void jsvGarbageCollectBarrier(JsVar *v, JsVarRef r);
+void jsvGarbageCollectBarrierChild(JsVar *v, JsVarRef r);
+#define JSV_GC_BARRIER(v,r) if (jsvGarbageCollectMarking && (r)) jsvGarbageCollectBarrier(v,r)
+#define JSV_GC_BARRIER_CHILD(v,r) if (jsvGarbageCollectMarking && (r)) jsvGarbageCollectBarrierChild(v,r)
+#else
+#define JSV_GC_BARRIER(v,r)
+#define JSV_GC_BARRIER_CHILD(v,r)
+#endif
+
 #ifndef JSVARREF_PACKED_BITS
 static ALWAYS_INLINE JsVarRef jsvGetFirstChild(const JsVar *v) { return v->varData.ref.firstChild; }
 static ALWAYS_INLINE JsVarRefSigned jsvGetFirstChildSigned(const JsVar *v) { return (JsVarRefSigned)v->varData.ref.firstChild; }
 static ALWAYS_INLINE JsVarRef jsvGetLastChild(const JsVar *v) { return v->varData.ref.lastChild; }
 static ALWAYS_INLINE JsVarRef jsvGetNextSibling(const JsVar *v) { return v->varData.ref.nextSibling; }
 static ALWAYS_INLINE JsVarRef jsvGetPrevSibling(const JsVar *v) { return v->varData.ref.prevSibling; }
-static ALWAYS_INLINE void jsvSetFirstChild(JsVar *v, JsVarRef r) { v->varData.ref.firstChild = r; }
-static ALWAYS_INLINE void jsvSetLastChild(JsVar *v, JsVarRef r) { v->varData.ref.lastChild = r; }
-static ALWAYS_INLINE void jsvSetNextSibling(JsVar *v, JsVarRef r) { v->varData.ref.nextSibling = r; }
+static ALWAYS_INLINE void jsvSetFirstChild(JsVar *v, JsVarRef r) { JSV_GC_BARRIER_CHILD(v,r); v->varData.ref.firstChild = r; }
+static ALWAYS_INLINE void jsvSetLastChild(JsVar *v, JsVarRef r) { JSV_GC_BARRIER(v,r); v->varData.ref.lastChild = r; }
+static ALWAYS_INLINE void jsvSetNextSibling(JsVar *v, JsVarRef r) { JSV_GC_BARRIER(v,r); v->varData.ref.nextSibling = r; }
 static ALWAYS_INLINE void jsvSetPrevSibling(JsVar *v, JsVarRef r) { v->varData.ref.prevSibling = r; }
 #else
 // for packed bits, functions are not inlined to save space
@@ -494,6 +510,7 @@ JsVar *jsvAsFlatString(JsVar *var); ///< Create a flat string from the given var
 bool jsvIsEmptyString(JsVar *v); ///< Returns true if the string is empty - faster than jsvGetStringLength(v)==0
 size_t jsvGetStringLength(const JsVar *v); ///< Get the length of this string, IF it is a string
 size_t jsvGetFlatStringBlocks(const JsVar *v); ///< return the number of blocks used by the given flat string - EXCLUDING the first data block
+void jsvTruncateFlatString(JsVar *v, size_t length); ///< Shorten a flat string, freeing any blocks it no longer needs
 char *jsvGetFlatStringPointer(JsVar *v); ///< Get a pointer to the data in this flat string
 JsVar *jsvGetFlatStringFromPointer(char *v); ///< Given a pointer to the first element of a flat string, return the flat string itself (DANGEROUS!)
 char *jsvGetDataPointer(JsVar *v, size_t *len); ///< If the variable points to a *flat* area of memory, return a pointer (and set length). Otherwise return 0.
@@ -667,6 +684,16 @@ JsVar *jsvFindChildFromVar(JsVar *parent, JsVar *childName, bool addIfNotFound);
 void jsvRemoveChild(JsVar *parent, JsVar *child);
 void jsvRemoveAllChildren(JsVar *parent);
 
+#ifndef SAVE_ON_FLASH
+/** Returns a number that changes whenever children are added/removed in a way that could
+ * change the result of looking up a property. Used to validate jsparse.c's inline caches */
+unsigned int jsvGetPropertyEpoch();
+/// Make sure the property epoch changes if children are added to this object, or it is freed
+void jsvPropertyEpochWatch(JsVar *obj);
+/// Something has changed that could alter the result of a property lookup
+void jsvPropertyEpochChanged();
+#endif
+
 /// Get the named child of an object. If createChild!=0 then create the child
 JsVar *jsvObjectGetChild(JsVar *obj, const char *name, JsVarFlags createChild);
 /// Get the named child of an object using a case-insensitive search
@@ -719,6 +746,27 @@ void jsvTrace(JsVar *var, int indent);
 /** Run a garbage collection sweep - return nonzero if things have been freed */
 int jsvGarbageCollect();
 
+#ifndef SAVE_ON_FLASH
+/// Statistics for the incremental garbage collector
+typedef struct {
+  unsigned int cycles; ///< Number of incremental GC cycles completed
+  unsigned int steps; ///< Number of incremental GC steps run
+  unsigned int freed; ///< Total blocks freed by incremental GC
+  unsigned int lastFreed; ///< Blocks freed by the last completed cycle
+  JsSysTime lastPause; ///< Time taken by the last step
+  JsSysTime maxPause; ///< Longest time taken by a step
+  unsigned int maxWork; ///< Most vars looked at/marked by a step
+} JsvGarbageCollectStats;
+extern JsvGarbageCollectStats jsvGCStats;
+
+/** Do a small, bounded amount of garbage collection work (starting a new
+ * collection if none is in progress). Return true if a collection is
+ * still in progress afterwards. */
+bool jsvGarbageCollectStep();
+/// Is an incremental garbage collection in progress?
+bool jsvGarbageCollectInProgress();
+#endif
+
 /** Defragement memory - this could take a while with interrupts turned off! */
 void jsvDefragment();
 
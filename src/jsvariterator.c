@@ -726,7 +726,8 @@ JsVar *jsvIteratorSetValue(JsvIterator *it, JsVar *value) {
   case JSVI_FULLARRAY:  if (jsvIsIntegerish(it->it.obj.it.var) &&
                              jsvGetInteger(it->it.obj.it.var) == it->it.obj.index)
                           jsvObjectIteratorSetValue(&it->it.obj.it, value);
-                        jsvSetArrayItem(it->it.obj.var, it->it.obj.index, value);
+                        else // no element here yet (sparse array)
+                          jsvSetArrayItem(it->it.obj.var, it->it.obj.index, value);
                         break;
   case JSVI_OBJECT : jsvObjectIteratorSetValue(&it->it.obj.it, value); break;
   case JSVI_STRING : jsvStringIteratorSetChar(&it->it.str, (char)(jsvIsString(value) ? value->varData.str[0] : (char)jsvGetInteger(value))); break;
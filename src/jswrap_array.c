@@ -721,91 +721,135 @@ Returns true if the provided object is an array
  */
 
 
-NO_INLINE static JsVarInt _jswrap_array_sort_compare(JsVar *a, JsVar *b, JsVar *compareFn) {
-  if (compareFn) {
+/// How are we comparing values for Array.sort?
+typedef enum {
+  SORT_COMPARE_STRING,      ///< no compare function - compare as strings
+  SORT_COMPARE_FUNCTION,    ///< call the compare function
+  SORT_COMPARE_ASCENDING,   ///< compare function is (a,b)=>a-b and all values are numbers
+  SORT_COMPARE_DESCENDING,  ///< compare function is (a,b)=>b-a and all values are numbers
+  SORT_COMPARE_NUMERIC,     ///< typed array with no compare function - numbers, with NaN at the end
+} SortCompareType;
+
+typedef struct {
+  SortCompareType type;
+  JsVar *compareFn;
+} SortInfo;
+
+/** The values being sorted are kept locked, so they can't be freed or moved
+ * by the compare function. If a value was already locked too many times (it's
+ * in the array lots of times) we lock a name that points to it instead. */
+static JsVar *_jswrap_array_sort_lock(JsVar *v) {
+  if (jsvGetLocks(v) < JSV_LOCK_MAX/2) return jsvLockAgain(v);
+  return jsvMakeIntoVariableName(jsvNewFromEmptyString(), v);
+}
+
+/// Get the value of an entry from _jswrap_array_sort_lock
+static JsVar *_jswrap_array_sort_value(JsVar *entry) {
+  return jsvIsName(entry) ? jsvSkipName(entry) : jsvLockAgain(entry);
+}
+
+NO_INLINE static JsVarInt _jswrap_array_sort_compare(JsVar *aEntry, JsVar *bEntry, SortInfo *info) {
+  if (jspIsInterrupted() || jspHasError()) return 0; // just finish as quickly as we can
+  JsVar *a = _jswrap_array_sort_value(aEntry);
+  JsVar *b = _jswrap_array_sort_value(bEntry);
+  JsVarFloat f = 0;
+  if (info->type==SORT_COMPARE_ASCENDING) {
+    f = jsvGetFloat(a) - jsvGetFloat(b);
+  } else if (info->type==SORT_COMPARE_DESCENDING) {
+    f = jsvGetFloat(b) - jsvGetFloat(a);
+  } else if (info->type==SORT_COMPARE_NUMERIC) {
+    JsVarFloat fa = jsvGetFloat(a), fb = jsvGetFloat(b);
+    if (isnan(fa) || isnan(fb)) f = (JsVarFloat)isnan(fa) - (JsVarFloat)isnan(fb);
+    else f = fa - fb;
+  } else if (info->type==SORT_COMPARE_FUNCTION) {
     JsVar *args[2] = {a,b};
-    JsVarFloat f = jsvGetFloatAndUnLock(jspeFunctionCall(compareFn, 0, 0, false, 2, args));
-    if (f==0) return 0;
-    return (f<0)?-1:1;
+    f = jsvGetFloatAndUnLock(jspeFunctionCall(info->compareFn, 0, 0, false, 2, args));
+  } else if (jsvIsNumeric(a) && jsvIsNumeric(b)) {
+    // Numbers are compared as strings, but we can do that without allocating any variables
+    char sa[32], sb[32];
+    jsvGetString(a, sa, sizeof(sa));
+    jsvGetString(b, sb, sizeof(sb));
+    f = (JsVarFloat)strcmp(sa, sb);
   } else {
     JsVar *sa = jsvAsString(a);
     JsVar *sb = jsvAsString(b);
-    JsVarInt r = jsvCompareString(sa,sb, 0, 0, false);
+    f = (JsVarFloat)jsvCompareString(sa,sb, 0, 0, false);
     jsvUnLock2(sa, sb);
-    return r;
   }
+  jsvUnLock2(a, b);
+  if (f==0) return 0;
+  return (f<0)?-1:1;
 }
 
-NO_INLINE static void _jswrap_array_sort(JsvIterator *head, int n, JsVar *compareFn) {
-  if (n < 2) return; // sort done!
-
-  JsvIterator pivot;
-  jsvIteratorClone(&pivot, head);
-  bool pivotLowest = true; // is the pivot the lowest value in here?
-  JsVar *pivotValue = jsvIteratorGetValue(&pivot);
-  /* We're just going to use the first entry (head) as the pivot...
-   * We'll move along with our iterator 'it', and if it < pivot then we'll
-   * swap the values over (hence moving pivot forwards)  */
-
-  int nlo = 0, nhigh = 0;
-  JsvIterator it;
-  jsvIteratorClone(&it, head); //
-  jsvIteratorNext(&it);
-
-
-  /* Partition and count sizes. */
-  while (--n && !jspIsInterrupted()) {
-    JsVar *itValue = jsvIteratorGetValue(&it);
-    JsVarInt cmp = _jswrap_array_sort_compare(itValue, pivotValue, compareFn);
-    if (cmp<=0) {
-      if (cmp<0) pivotLowest = false;
-      nlo++;
-      /* 'it' <= 'pivot', so we need to move it behind.
-         In this diagram, P=pivot, L=it
-
-               l l l l l P h h h h h L
-                         |  \       /
-                          \  \_____/_
-                          _\______/  \
-                         / |         |
-                         | |         |
-               l l l l l L P h h h h h
-
-         It makes perfect sense now...
-       */
-      // first, get the old pivot value and overwrite it with the iterator value
-      jsvIteratorSetValue(&pivot, itValue); // no unlock needed
-      // now move pivot forwards, and set 'it' to the value the new pivot has
-      jsvIteratorNext(&pivot);
-      jsvUnLock(jsvIteratorSetValue(&it, jsvIteratorGetValue(&pivot)));
-      // finally set the pivot iterator to the pivot's value again
-      jsvIteratorSetValue(&pivot, pivotValue); // no unlock needed
-    } else {
-      nhigh++;
-      // Great, 'it' > 'pivot' so it's in the right place
+/** Stable merge sort of 'n' variables in 'refs', using 'tmp' (also 'n' long)
+ * as workspace. Worst case O(n log n) comparisons, and recursion depth is only
+ * log2(n) */
+NO_INLINE static void _jswrap_array_sort(JsVar **refs, JsVar **tmp, int n, SortInfo *info) {
+  if (n <= 8) {
+    // insertion sort for small runs - fewer comparisons on nearly sorted data
+    int i,j;
+    for (i=1;i<n;i++) {
+      JsVar *r = refs[i];
+      for (j=i; j>0 && _jswrap_array_sort_compare(refs[j-1], r, info)>0; j--)
+        refs[j] = refs[j-1];
+      refs[j] = r;
     }
-    jsvUnLock(itValue);
-    jsvIteratorNext(&it);
-  }
-  jsvIteratorFree(&it);
-  jsvUnLock(pivotValue);
-
-  if (jspIsInterrupted()) {
-    jsvIteratorFree(&pivot);
     return;
   }
+  int nlo = n/2;
+  _jswrap_array_sort(refs, tmp, nlo, info);
+  _jswrap_array_sort(&refs[nlo], tmp, n-nlo, info);
+  // already in order? (common for sorted data) then there's nothing to merge
+  if (_jswrap_array_sort_compare(refs[nlo-1], refs[nlo], info)<=0) return;
+  memcpy(tmp, refs, sizeof(JsVar*)*(size_t)nlo);
+  int i=0, j=nlo, k=0;
+  while (i<nlo && j<n) {
+    // take from the left on ties so the sort is stable
+    if (_jswrap_array_sort_compare(tmp[i], refs[j], info)<=0)
+      refs[k++] = tmp[i++];
+    else
+      refs[k++] = refs[j++];
+  }
+  while (i<nlo) refs[k++] = tmp[i++];
+}
 
-  // now recurse. Do RHS first because we can
-  // free the pivot early if we do this
-  jsvIteratorNext(&pivot);
-  _jswrap_array_sort(&pivot, nhigh, compareFn);
-  jsvIteratorFree(&pivot);
-  // LHS
-  /* If the pivot is the lowest number in this chunk of numbers, then
-   * we know that anything to the left of it must be joint equal to it.
-   * In that casem there's no need to sort it. */
-  if (!pivotLowest)
-    _jswrap_array_sort(head, nlo, compareFn);
+/** If compareFn is just (a,b)=>a-b return 1, or for (a,b)=>b-a return -1 (so
+ * numbers can be compared without calling into JS). Otherwise return 0 */
+int jswrap_array_getNumericSortOrder(JsVar *compareFn) {
+  if (!jsvIsFunctionReturn(compareFn)) return 0;
+  char params[2][16];
+  int paramCount = 0;
+  JsvObjectIterator it;
+  jsvObjectIteratorNew(&it, compareFn);
+  while (jsvObjectIteratorHasValue(&it)) {
+    JsVar *param = jsvObjectIteratorGetKey(&it);
+    if (jsvIsFunctionParameter(param)) {
+      if (paramCount<2) jsvGetString(param, params[paramCount], sizeof(params[0]));
+      paramCount++;
+    }
+    jsvUnLock(param);
+    jsvObjectIteratorNext(&it);
+  }
+  jsvObjectIteratorFree(&it);
+  if (paramCount!=2) return 0;
+  // get the code without whitespace or the final semicolon
+  char code[40], expr[40];
+  JsVar *codeVar = jsvObjectGetChild(compareFn, JSPARSE_FUNCTION_CODE_NAME, 0);
+  bool codeFits = jsvIsString(codeVar) && jsvGetStringLength(codeVar)<sizeof(code);
+  if (codeFits) jsvGetString(codeVar, code, sizeof(code));
+  jsvUnLock(codeVar);
+  if (!codeFits) return 0;
+  size_t i, l = 0;
+  for (i=0;code[i];i++)
+    if (!isWhitespace(code[i])) code[l++] = code[i];
+  while (l && code[l-1]==';') l--;
+  code[l] = 0;
+  // parameter names start with JS_HIDDEN_CHAR, so skip it
+  espruino_snprintf(expr, sizeof(expr), "%s-%s", &params[0][1], &params[1][1]);
+  if (!strcmp(code, expr)) return 1;
+  espruino_snprintf(expr, sizeof(expr), "%s-%s", &params[1][1], &params[0][1]);
+  if (!strcmp(code, expr)) return -1;
+  return 0;
 }
 
 /*JSON{
@@ -819,7 +863,11 @@ NO_INLINE static void _jswrap_array_sort(JsvIterator *head, int n, JsVar *compar
   ],
   "return" : ["JsVar","This array object"]
 }
-Do an in-place quicksort of the array
+Do an in-place sort of the array. The sort is stable, and takes O(n log n) time
+even for arrays that are already sorted.
+
+If `var` is the common `(a,b)=>a-b` (or `(a,b)=>b-a`) and every element is a
+number, the numbers are compared directly without calling into JavaScript.
  */
 JsVar *jswrap_array_sort (JsVar *array, JsVar *compareFn) {
   if (!jsvIsUndefined(compareFn) && !jsvIsFunction(compareFn)) {
@@ -830,13 +878,8 @@ JsVar *jswrap_array_sort (JsVar *array, JsVar *compareFn) {
 
   /* Arrays can be sparse and the iterators don't handle this
     (we're not going to mess with indices) so we have to count
-     up the number of elements manually.
-
-     FIXME: sort is broken for sparse arrays anyway (it basically
-     ignores all the 'undefined' entries). I wonder whether just
-     compacting the array down to start from 0 before we start would
-     fix this?
-   */
+     up the number of elements manually. Missing elements are treated
+     as undefined, so get moved to the end. */
   int n=0;
   if (jsvIsArray(array) || jsvIsObject(array)) {
     jsvIteratorNew(&it, array, JSIF_EVERY_ARRAY_ELEMENT);
@@ -849,9 +892,78 @@ JsVar *jswrap_array_sort (JsVar *array, JsVar *compareFn) {
     n = (int)jsvGetLength(array);
   }
 
+  /* Lock every value and sort them in a buffer, rather than swapping elements
+   * in the array itself (which is slow, as each access has to search the
+   * array). Keeping them locked means the compare function can't cause them to
+   * be freed (by a GC) or moved (by E.defrag) */
+  size_t bufferSize = sizeof(JsVar*)*(size_t)n*2; // values, and workspace for the merge
+  JsVar *buffer = 0;
+  JsVar **refs = 0;
+  if (bufferSize <= 256) {
+    refs = (JsVar**)alloca(bufferSize);
+  } else {
+    buffer = jsvNewFlatStringOfLength((unsigned int)bufferSize);
+    if (buffer)
+      refs = (JsVar**)jsvGetFlatStringPointer(buffer);
+    else if (bufferSize+4096 < jsuGetFreeStack())
+      refs = (JsVar**)alloca(bufferSize);
+  }
+  if (!refs) {
+    jsExceptionHere(JSET_ERROR, "Not enough memory to sort %d elements", n);
+    return 0;
+  }
+
+  int count = 0, undefinedCount = 0;
+  bool allNumbers = true, outOfMemory = false;
   jsvIteratorNew(&it, array, JSIF_EVERY_ARRAY_ELEMENT);
-  _jswrap_array_sort(&it, n, compareFn);
+  while (jsvIteratorHasElement(&it) && count+undefinedCount<n && !outOfMemory) {
+    JsVar *v = jsvIteratorGetValue(&it);
+    if (jsvIsUndefined(v)) {
+      undefinedCount++; // always sorted to the end without being compared
+    } else {
+      if (!jsvIsNumeric(v)) allNumbers = false;
+      JsVar *entry = _jswrap_array_sort_lock(v);
+      if (entry) refs[count++] = entry;
+      else outOfMemory = true;
+    }
+    jsvUnLock(v);
+    jsvIteratorNext(&it);
+  }
+  jsvIteratorFree(&it);
+  if (outOfMemory) {
+    while (count) jsvUnLock(refs[--count]);
+    jsvUnLock(buffer);
+    jsExceptionHere(JSET_ERROR, "Not enough memory to sort %d elements", n);
+    return 0;
+  }
+
+  SortInfo info;
+  info.compareFn = compareFn;
+  if (jsvIsUndefined(compareFn)) // typed arrays sort numerically
+    info.type = jsvIsArrayBuffer(array) ? SORT_COMPARE_NUMERIC : SORT_COMPARE_STRING;
+  else {
+    int order = allNumbers ? jswrap_array_getNumericSortOrder(compareFn) : 0;
+    info.type = order ? ((order>0) ? SORT_COMPARE_ASCENDING : SORT_COMPARE_DESCENDING) : SORT_COMPARE_FUNCTION;
+  }
+  _jswrap_array_sort(refs, &refs[n], count, &info);
+
+  // Now write the sorted values back
+  int i = 0;
+  jsvIteratorNew(&it, array, JSIF_EVERY_ARRAY_ELEMENT);
+  while (jsvIteratorHasElement(&it) && i<count+undefinedCount) {
+    if (i<count) {
+      JsVar *v = _jswrap_array_sort_value(refs[i]);
+      jsvIteratorSetValue(&it, v);
+      jsvUnLock2(v, refs[i]);
+    } else
+      jsvIteratorSetValue(&it, 0);
+    i++;
+    jsvIteratorNext(&it);
+  }
   jsvIteratorFree(&it);
+  // if the compare function made the array shorter, release what's left
+  while (i<count) jsvUnLock(refs[i++]);
+  jsvUnLock(buffer);
   return jsvLockAgain(array);
 }
 
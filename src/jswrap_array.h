@@ -32,6 +32,8 @@ JsVar *jswrap_array_some(JsVar *parent, JsVar *funcVar, JsVar *thisVar);
 JsVar *jswrap_array_every(JsVar *parent, JsVar *funcVar, JsVar *thisVar);
 JsVar *jswrap_array_reduce(JsVar *parent, JsVar *funcVar, JsVar *initialValue);
 JsVar *jswrap_array_sort (JsVar *array, JsVar *compareFn);
+/// Returns 1 if compareFn is (a,b)=>a-b, -1 if it's (a,b)=>b-a, or 0 otherwise
+int jswrap_array_getNumericSortOrder(JsVar *compareFn);
 JsVar *jswrap_array_concat(JsVar *parent, JsVar *args);
 JsVar *jswrap_array_fill(JsVar *parent, JsVar *value, JsVarInt start, JsVar *endVar);
 JsVar *jswrap_array_reverse(JsVar *parent);
@@ -14,6 +14,7 @@
  * ----------------------------------------------------------------------------
  */
 #include "jswrap_arraybuffer.h"
+#include "jswrap_array.h"
 #include "jsparse.h"
 #include "jsinteractive.h"
 
@@ -583,6 +584,277 @@ JsVar *jswrap_arraybufferview_map(JsVar *parent, JsVar *funcVar, JsVar *thisVar)
 }
 
 
+// -----------------------------------------------------------------------------------------------------
+//                                          Native kernels working directly on a typed array's memory
+// -----------------------------------------------------------------------------------------------------
+#ifndef SAVE_ON_FLASH
+
+/** If the elements of this typed array are stored in one flat area of memory,
+ * return a pointer to them and set the number of elements and the type.
+ * Otherwise return 0 (and we'll have to use the slower iterators). If
+ * 'aligned' then the elements must also be native endian and aligned, so
+ * they can be accessed as their C types */
+static char *jswrap_arraybufferview_getElements(JsVar *arr, bool aligned, size_t *count, JsVarDataArrayBufferViewType *type) {
+  if (!jsvIsArrayBuffer(arr)) return 0;
+  *type = arr->varData.arraybuffer.type;
+  if (*type == ARRAYBUFFERVIEW_ARRAYBUFFER) return 0;
+  size_t size = JSV_ARRAYBUFFER_GET_SIZE(*type);
+  size_t len;
+  char *ptr = jsvGetDataPointer(arr, &len);
+  if (!ptr) return 0;
+  if (aligned && ((*type & ARRAYBUFFERVIEW_BIG_ENDIAN) || (size&(size-1)) ||
+                  ((size_t)ptr & (size-1))))
+    return 0;
+  *count = jsvGetArrayBufferLength(arr);
+  return ptr;
+}
+
+/* Introsort (quicksort, falling back to heapsort if we recurse too much) for
+ * the types that are too big to radix sort. Ends with an insertion sort. */
+#define TYPEDARRAY_INTROSORT(NAME, TYPE)                                     \
+static void NAME##_heapSift(TYPE *a, size_t root, size_t n) {                \
+  TYPE v = a[root];                                                          \
+  size_t child;                                                              \
+  while ((child = root*2+1) < n) {                                           \
+    if (child+1<n && a[child]<a[child+1]) child++;                           \
+    if (!(v<a[child])) break;                                                \
+    a[root] = a[child];                                                      \
+    root = child;                                                            \
+  }                                                                          \
+  a[root] = v;                                                               \
+}                                                                            \
+static void NAME(TYPE *a, size_t n, int depth) {                             \
+  while (n > 16) {                                                           \
+    if (depth-- <= 0) { /* heapsort */                                       \
+      size_t i;                                                              \
+      for (i=n/2;i>0;i--) NAME##_heapSift(a, i-1, n);                        \
+      for (i=n-1;i>0;i--) {                                                  \
+        TYPE t = a[0]; a[0] = a[i]; a[i] = t;                                \
+        NAME##_heapSift(a, 0, i);                                            \
+      }                                                                      \
+      return;                                                                \
+    }                                                                        \
+    /* median of three as the pivot, which also stops i and j running off */ \
+    size_t mid = n/2;                                                        \
+    TYPE t;                                                                  \
+    if (a[mid]<a[0]) { t = a[mid]; a[mid] = a[0]; a[0] = t; }                \
+    if (a[n-1]<a[mid]) { t = a[n-1]; a[n-1] = a[mid]; a[mid] = t; }          \
+    if (a[mid]<a[0]) { t = a[mid]; a[mid] = a[0]; a[0] = t; }                \
+    TYPE pivot = a[mid];                                                     \
+    size_t i = 0, j = n-1;                                                   \
+    while (true) {                                                           \
+      while (a[i]<pivot) i++;                                                \
+      while (pivot<a[j]) j--;                                                \
+      if (i>=j) break;                                                       \
+      t = a[i]; a[i] = a[j]; a[j] = t;                                       \
+      i++; j--;                                                              \
+    }                                                                        \
+    /* recurse into the smaller half and loop on the bigger one */           \
+    size_t nlo = j+1;                                                        \
+    if (nlo < n-nlo) {                                                       \
+      NAME(a, nlo, depth);                                                   \
+      a += nlo; n -= nlo;                                                    \
+    } else {                                                                 \
+      NAME(a+nlo, n-nlo, depth);                                             \
+      n = nlo;                                                               \
+    }                                                                        \
+  }                                                                          \
+  size_t i, j;                                                               \
+  for (i=1;i<n;i++) {                                                        \
+    TYPE v = a[i];                                                           \
+    for (j=i; j>0 && v<a[j-1]; j--) a[j] = a[j-1];                           \
+    a[j] = v;                                                                \
+  }                                                                          \
+}
+TYPEDARRAY_INTROSORT(jswrap_arraybufferview_sortInt32, int32_t)
+TYPEDARRAY_INTROSORT(jswrap_arraybufferview_sortUint32, uint32_t)
+TYPEDARRAY_INTROSORT(jswrap_arraybufferview_sortUint16, uint16_t)
+TYPEDARRAY_INTROSORT(jswrap_arraybufferview_sortInt16, int16_t)
+TYPEDARRAY_INTROSORT(jswrap_arraybufferview_sortFloat32, float)
+TYPEDARRAY_INTROSORT(jswrap_arraybufferview_sortFloat64, double)
+
+/// Move NaNs to the end of a float array (where JS puts them), returning how many elements aren't NaN
+#define TYPEDARRAY_PARTITION_NAN(NAME, TYPE)                                 \
+static size_t NAME(TYPE *a, size_t n) {                                      \
+  size_t i, count = 0;                                                       \
+  for (i=0;i<n;i++) {                                                        \
+    if (!isnan(a[i])) {                                                      \
+      TYPE t = a[count]; a[count++] = a[i]; a[i] = t;                        \
+    }                                                                        \
+  }                                                                          \
+  return count;                                                              \
+}
+TYPEDARRAY_PARTITION_NAN(jswrap_arraybufferview_nanToEndFloat32, float)
+TYPEDARRAY_PARTITION_NAN(jswrap_arraybufferview_nanToEndFloat64, double)
+
+/// Counting sort for 8 bit arrays
+static void jswrap_arraybufferview_sort8(unsigned char *a, size_t n, bool isSigned) {
+  unsigned int counts[256];
+  memset(counts, 0, sizeof(counts));
+  unsigned char bias = isSigned ? 0x80 : 0; // so signed values sort in the right order
+  size_t i;
+  for (i=0;i<n;i++) counts[(unsigned char)(a[i]^bias)]++;
+  unsigned int v;
+  for (v=0;v<256;v++) {
+    unsigned int c = counts[v];
+    memset(a, (unsigned char)(v^bias), c);
+    a += c;
+  }
+}
+
+/// Two pass radix sort for 16 bit arrays. Returns false if there wasn't enough memory
+static bool jswrap_arraybufferview_sort16(uint16_t *a, size_t n, bool isSigned) {
+  size_t bytes = n*sizeof(uint16_t);
+  JsVar *tmpVar = 0;
+  uint16_t *tmp = 0;
+  if (bytes+1024 < jsuGetFreeStack()/2) {
+    tmp = (uint16_t*)alloca(bytes);
+  } else {
+    tmpVar = jsvNewFlatStringOfLength((unsigned int)bytes);
+    if (tmpVar) tmp = (uint16_t*)jsvGetFlatStringPointer(tmpVar);
+  }
+  if (!tmp) return false;
+  uint16_t bias = isSigned ? 0x8000 : 0;
+  unsigned int countLo[256], countHi[256];
+  memset(countLo, 0, sizeof(countLo));
+  memset(countHi, 0, sizeof(countHi));
+  size_t i;
+  for (i=0;i<n;i++) {
+    uint16_t v = a[i]^bias;
+    countLo[v&255]++;
+    countHi[v>>8]++;
+  }
+  // turn counts into offsets
+  unsigned int sumLo = 0, sumHi = 0, c;
+  for (i=0;i<256;i++) {
+    c = countLo[i]; countLo[i] = sumLo; sumLo += c;
+    c = countHi[i]; countHi[i] = sumHi; sumHi += c;
+  }
+  for (i=0;i<n;i++) tmp[countLo[(a[i]^bias)&255]++] = a[i];
+  for (i=0;i<n;i++) a[countHi[(uint16_t)(tmp[i]^bias)>>8]++] = tmp[i];
+  jsvUnLock(tmpVar);
+  return true;
+}
+
+/// Reverse the order of the elements in memory
+static void jswrap_arraybufferview_reverseElements(char *ptr, size_t count, size_t size) {
+  char *a = ptr, *b = ptr + (count-1)*size;
+  while (a < b) {
+    size_t i;
+    for (i=0;i<size;i++) {
+      char t = a[i]; a[i] = b[i]; b[i] = t;
+    }
+    a += size;
+    b -= size;
+  }
+}
+
+/** Sort a typed array numerically in place, without creating any variables.
+ * Returns false if the data isn't stored in a way we can do this. */
+static bool jswrap_arraybufferview_sortNative(JsVar *arr, bool descending) {
+  size_t n;
+  JsVarDataArrayBufferViewType type;
+  char *ptr = jswrap_arraybufferview_getElements(arr, true, &n, &type);
+  if (!ptr) return false;
+  if (n<2) return true;
+  int depth = 0; // allow 2*log2(n) levels of quicksort before using heapsort
+  size_t i;
+  for (i=n;i;i>>=1) depth+=2;
+  switch (type & ~ARRAYBUFFERVIEW_CLAMPED) {
+    case ARRAYBUFFERVIEW_UINT8:
+    case ARRAYBUFFERVIEW_INT8:
+      jswrap_arraybufferview_sort8((unsigned char*)ptr, n, JSV_ARRAYBUFFER_IS_SIGNED(type));
+      break;
+    case ARRAYBUFFERVIEW_UINT16:
+    case ARRAYBUFFERVIEW_INT16:
+      if (!jswrap_arraybufferview_sort16((uint16_t*)ptr, n, JSV_ARRAYBUFFER_IS_SIGNED(type))) {
+        // not enough memory for radix sort - sort in place
+        if (JSV_ARRAYBUFFER_IS_SIGNED(type)) jswrap_arraybufferview_sortInt16((int16_t*)ptr, n, depth);
+        else jswrap_arraybufferview_sortUint16((uint16_t*)ptr, n, depth);
+      }
+      break;
+    case ARRAYBUFFERVIEW_UINT32:
+      jswrap_arraybufferview_sortUint32((uint32_t*)ptr, n, depth);
+      break;
+    case ARRAYBUFFERVIEW_INT32:
+      jswrap_arraybufferview_sortInt32((int32_t*)ptr, n, depth);
+      break;
+    case ARRAYBUFFERVIEW_FLOAT32: {
+      size_t count = jswrap_arraybufferview_nanToEndFloat32((float*)ptr, n);
+      jswrap_arraybufferview_sortFloat32((float*)ptr, count, depth);
+      if (descending) { // keep NaNs at the end
+        jswrap_arraybufferview_reverseElements(ptr, count, sizeof(float));
+        descending = false;
+      }
+      break;
+    }
+    case ARRAYBUFFERVIEW_FLOAT64: {
+      size_t count = jswrap_arraybufferview_nanToEndFloat64((double*)ptr, n);
+      jswrap_arraybufferview_sortFloat64((double*)ptr, count, depth);
+      if (descending) {
+        jswrap_arraybufferview_reverseElements(ptr, count, sizeof(double));
+        descending = false;
+      }
+      break;
+    }
+    default:
+      return false;
+  }
+  if (descending)
+    jswrap_arraybufferview_reverseElements(ptr, n, JSV_ARRAYBUFFER_GET_SIZE(type));
+  return true;
+}
+
+/** Search a typed array for a number without creating any variables. Returns
+ * the index, -1 if not found, or -2 if we can't search this array natively.
+ * If 'sameValueZero' (for 'includes') NaN matches NaN. */
+static JsVarInt jswrap_arraybufferview_indexOfNative(JsVar *arr, JsVar *value, JsVarInt startIdx, bool sameValueZero) {
+  if (!jsvIsInt(value) && !jsvIsFloat(value)) return -2;
+  size_t n;
+  JsVarDataArrayBufferViewType type;
+  char *ptr = jswrap_arraybufferview_getElements(arr, true, &n, &type);
+  if (!ptr) return -2;
+  if (startIdx<0) startIdx += (JsVarInt)n;
+  if (startIdx<0) startIdx = 0;
+  if ((size_t)startIdx >= n) return -1;
+  size_t i = (size_t)startIdx;
+  JsVarFloat f = jsvGetFloat(value);
+  if (JSV_ARRAYBUFFER_IS_FLOAT(type)) {
+    bool findNaN = isnan(f);
+    if (findNaN && !sameValueZero) return -1; // NaN is never equal to anything
+    if (type==ARRAYBUFFERVIEW_FLOAT32) {
+      float *a = (float*)ptr, v = (float)f;
+      if (!findNaN && (JsVarFloat)v!=f) return -1; // can't be stored in a Float32Array
+      for (;i<n;i++) if (a[i]==v || (findNaN && isnan(a[i]))) return (JsVarInt)i;
+    } else {
+      double *a = (double*)ptr;
+      for (;i<n;i++) if (a[i]==f || (findNaN && isnan(a[i]))) return (JsVarInt)i;
+    }
+    return -1;
+  }
+  // Integer array - if the number can't be stored in it, it's not there
+  size_t size = JSV_ARRAYBUFFER_GET_SIZE(type);
+  bool isSigned = JSV_ARRAYBUFFER_IS_SIGNED(type);
+  long long bits = (long long)1 << (size*8);
+  long long lo = isSigned ? -bits/2 : 0;
+  long long hi = isSigned ? bits/2-1 : bits-1;
+  if (isnan(f) || f!=floor(f) || f<(JsVarFloat)lo || f>(JsVarFloat)hi) return -1;
+  long long v = (long long)f;
+  if (size==1) {
+    char *found = memchr(&ptr[i], (unsigned char)v, n-i);
+    return found ? (JsVarInt)(found-ptr) : -1;
+  } else if (size==2) {
+    uint16_t *a = (uint16_t*)ptr, v16 = (uint16_t)v;
+    for (;i<n;i++) if (a[i]==v16) return (JsVarInt)i;
+  } else {
+    uint32_t *a = (uint32_t*)ptr, v32 = (uint32_t)v;
+    for (;i<n;i++) if (a[i]==v32) return (JsVarInt)i;
+  }
+  return -1;
+}
+#endif
+
+
 // -----------------------------------------------------------------------------------------------------
 //                                                                      Steal Array's methods for this
 // -----------------------------------------------------------------------------------------------------
@@ -591,7 +863,7 @@ JsVar *jswrap_arraybufferview_map(JsVar *parent, JsVar *funcVar, JsVar *thisVar)
   "type" : "method",
   "class" : "ArrayBufferView",
   "name" : "indexOf",
-  "generate" : "jswrap_array_indexOf",
+  "generate" : "jswrap_arraybufferview_indexOf",
   "params" : [
     ["value","JsVar","The value to check for"],
     ["startIndex","int","(optional) the index to search from, or 0 if not specified"]
@@ -600,12 +872,19 @@ JsVar *jswrap_arraybufferview_map(JsVar *parent, JsVar *funcVar, JsVar *thisVar)
 }
 Return the index of the value in the array, or `-1`
  */
+JsVar *jswrap_arraybufferview_indexOf(JsVar *parent, JsVar *value, JsVarInt startIdx) {
+#ifndef SAVE_ON_FLASH
+  JsVarInt idx = jswrap_arraybufferview_indexOfNative(parent, value, startIdx, false);
+  if (idx!=-2) return jsvNewFromInteger(idx);
+#endif
+  return jswrap_array_indexOf(parent, value, startIdx);
+}
 /*JSON{
   "type" : "method",
   "class" : "ArrayBufferView",
   "name" : "includes",
   "ifndef" : "SAVE_ON_FLASH",
-  "generate" : "jswrap_array_includes",
+  "generate" : "jswrap_arraybufferview_includes",
   "params" : [
     ["value","JsVar","The value to check for"],
     ["startIndex","int","(optional) the index to search from, or 0 if not specified"]
@@ -614,6 +893,13 @@ Return the index of the value in the array, or `-1`
 }
 Return `true` if the array includes the value, `false` otherwise
  */
+#ifndef SAVE_ON_FLASH
+bool jswrap_arraybufferview_includes(JsVar *parent, JsVar *value, JsVarInt startIdx) {
+  JsVarInt idx = jswrap_arraybufferview_indexOfNative(parent, value, startIdx, true);
+  if (idx!=-2) return idx>=0;
+  return jswrap_array_includes(parent, value, startIdx);
+}
+#endif
 /*JSON{
   "type" : "method",
   "class" : "ArrayBufferView",
@@ -631,15 +917,25 @@ Join all elements of this array together into one string, using 'separator' betw
   "class" : "ArrayBufferView",
   "name" : "sort",
   "ifndef" : "SAVE_ON_FLASH",
-  "generate" : "jswrap_array_sort",
+  "generate" : "jswrap_arraybufferview_sort",
   "params" : [
     ["var","JsVar","A function to use to compare array elements (or undefined)"]
   ],
   "return" : ["JsVar","This array object"],
   "return_object" : "ArrayBufferView"
 }
-Do an in-place quicksort of the array
+Do an in-place sort of the array. With no compare function (or with
+`(a,b)=>a-b` or `(a,b)=>b-a`) the elements are sorted numerically without
+calling into JavaScript.
  */
+#ifndef SAVE_ON_FLASH
+JsVar *jswrap_arraybufferview_sort(JsVar *parent, JsVar *compareFn) {
+  int order = jsvIsUndefined(compareFn) ? 1 : jswrap_array_getNumericSortOrder(compareFn);
+  if (order && jswrap_arraybufferview_sortNative(parent, order<0))
+    return jsvLockAgain(parent);
+  return jswrap_array_sort(parent, compareFn);
+}
+#endif
 /*JSON{
   "type" : "method",
   "class" : "ArrayBufferView",
@@ -671,7 +967,7 @@ Execute `previousValue=initialValue` and then `previousValue = callback(previous
   "class" : "ArrayBufferView",
   "name" : "fill",
   "ifndef" : "SAVE_ON_FLASH",
-  "generate" : "jswrap_array_fill",
+  "generate" : "jswrap_arraybufferview_fill",
   "params" : [
     ["value","JsVar","The value to fill the array with"],
     ["start","int","Optional. The index to start from (or 0). If start is negative, it is treated as length+start where length is the length of the array"],
@@ -682,6 +978,42 @@ Execute `previousValue=initialValue` and then `previousValue = callback(previous
 }
 Fill this array with the given value, for every index `>= start` and `< end`
  */
+#ifndef SAVE_ON_FLASH
+JsVar *jswrap_arraybufferview_fill(JsVar *parent, JsVar *value, JsVarInt start, JsVar *endVar) {
+  size_t n;
+  JsVarDataArrayBufferViewType type;
+  char *ptr = jswrap_arraybufferview_getElements(parent, false, &n, &type);
+  if (!ptr) return jswrap_array_fill(parent, value, start, endVar);
+  JsVarInt length = (JsVarInt)n;
+  if (start < 0) start = start + length;
+  if (start < 0) return 0;
+  JsVarInt end = jsvIsNumeric(endVar) ? jsvGetInteger(endVar) : length;
+  if (end < 0) end = end + length;
+  if (end < 0) return 0;
+  if (end > length) end = length;
+  if (start < end) {
+    // Write the first element normally (to convert the value), then copy its bytes
+    JsvArrayBufferIterator it;
+    jsvArrayBufferIteratorNew(&it, parent, (size_t)start);
+    jsvArrayBufferIteratorSetValue(&it, value);
+    jsvArrayBufferIteratorFree(&it);
+    size_t size = JSV_ARRAYBUFFER_GET_SIZE(type);
+    char *dst = &ptr[(size_t)start*size];
+    size_t bytes = (size_t)(end-start)*size;
+    if (size==1) {
+      memset(dst, dst[0], bytes);
+    } else { // double the amount filled each time
+      size_t filled = size;
+      while (filled < bytes) {
+        size_t l = (filled < bytes-filled) ? filled : bytes-filled;
+        memcpy(&dst[filled], dst, l);
+        filled += l;
+      }
+    }
+  }
+  return jsvLockAgain(parent);
+}
+#endif
 /*JSON{
   "type" : "method",
   "class" : "ArrayBufferView",
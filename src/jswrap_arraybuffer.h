@@ -17,3 +17,7 @@ JsVar *jswrap_arraybuffer_constructor(JsVarInt byteLength);
 JsVar *jswrap_typedarray_constructor(JsVarDataArrayBufferViewType type, JsVar *arr, JsVarInt byteOffset, JsVarInt length);
 void jswrap_arraybufferview_set(JsVar *parent, JsVar *arr, int offset);
 JsVar *jswrap_arraybufferview_map(JsVar *parent, JsVar *funcVar, JsVar *thisVar);
+JsVar *jswrap_arraybufferview_indexOf(JsVar *parent, JsVar *value, JsVarInt startIdx);
+bool jswrap_arraybufferview_includes(JsVar *parent, JsVar *value, JsVarInt startIdx);
+JsVar *jswrap_arraybufferview_sort(JsVar *parent, JsVar *compareFn);
+JsVar *jswrap_arraybufferview_fill(JsVar *parent, JsVar *value, JsVarInt start, JsVar *endVar);
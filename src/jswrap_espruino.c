@@ -738,7 +738,7 @@ JsVar *jswrap_espruino_getErrorFlags() {
 Get Espruino's interpreter flags that control the way it handles your JavaScript code.
 
 * `deepSleep` - Allow deep sleep modes (also set by setDeepSleep)
-* `pretokenise` - When adding functions, pre-minify them and tokenise reserved words
+* `pretokenise` - When adding functions, pre-minify them, tokenise reserved words and pre-parse literals, block lengths and the names of local variables (which are then looked up by number when called) so they execute faster. Functions added without this flag don't get local variable slots
 * `unsafeFlash` - Some platforms stop writes/erases to interpreter memory to stop you bricking the device accidentally - this removes that protection
 * `unsyncFiles` - When writing files, *don't* flush all data to the SD card after each command (the default is *to* flush). This is much faster, but can cause filesystem damage if power is lost without the filesystem unmounted.
 */
@@ -106,6 +106,9 @@ void jswrap_flash_erasePage(JsVar *addr) {
     return;
   }
   jshFlashErasePage((uint32_t)jsvGetInteger(addr));
+#ifndef SAVE_ON_FLASH
+  jsfIndexClear(); // we may have erased Storage
+#endif
 }
 
 /*JSON{
@@ -134,8 +137,12 @@ void jswrap_flash_write(JsVar *data, int addr) {
 
   JSV_GET_AS_CHAR_ARRAY(flashData, flashDataLen, data);
 
-  if (flashData && flashDataLen)
+  if (flashData && flashDataLen) {
     jshFlashWriteAligned(flashData, (unsigned int)addr, (unsigned int)flashDataLen);
+#ifndef SAVE_ON_FLASH
+    jsfIndexClear(); // we may have written into Storage
+#endif
+  }
 }
 
 /*JSON{
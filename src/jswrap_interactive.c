@@ -392,6 +392,8 @@ void jswrap_interactive_setTime(JsVarFloat time) {
   JsSysTime stime = jshGetTimeFromMilliseconds(time*1000);
   jsiLastIdleTime = stime;
   JsSysTime oldtime = jshGetSystemTime();
+  // move timers along with the clock, so they still fire after the same delay
+  jsiTimerBaseTime += stime - oldtime;
   // set system time
   jshSetSystemTime(stime);
   // update any currently running timers so they don't get broken
@@ -514,7 +516,7 @@ JsVar *_jswrap_interface_setTimeoutOrInterval(JsVar *func, JsVarFloat interval,
   // Create a new timer
   JsVar *timerPtr = jsvNewObject();
   JsSysTime intervalInt = jshGetTimeFromMilliseconds(interval);
-  jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger((jshGetSystemTime() - jsiLastIdleTime) + intervalInt));
+  jsvObjectSetChildAndUnLock(timerPtr, "time", jsvNewFromLongInteger((jshGetSystemTime() - jsiTimerBaseTime) + intervalInt));
   if (!isTimeout) {
     jsvObjectSetChildAndUnLock(timerPtr, "interval", jsvNewFromLongInteger(intervalInt));
   }
@@ -581,9 +583,12 @@ void _jswrap_interface_clearTimeoutOrInterval(JsVar *idVarArr, bool isTimeout) {
     while (jsvObjectIteratorHasValue(&it)) {
       JsVar *timerPtr = jsvObjectIteratorGetValue(&it);
       JsVar *watchPtr = jsvObjectGetChild(timerPtr, "watch", 0);
-      if (!watchPtr)
+      if (!watchPtr) {
+        JsVar *timerName = jsvObjectIteratorGetKey(&it);
+        jsiTimerRemoved(timerName);
+        jsvUnLock(timerName);
         jsvObjectIteratorRemoveAndGotoNext(&it, timerArrayPtr);
-      else
+      } else
         jsvObjectIteratorNext(&it); 
       jsvUnLock2(watchPtr, timerPtr);
     }
@@ -596,6 +601,7 @@ void _jswrap_interface_clearTimeoutOrInterval(JsVar *idVarArr, bool isTimeout) {
     } else {
       JsVar *child = jsvIsBasic(idVar) ? jsvFindChildFromVar(timerArrayPtr, idVar, false) : 0;
       if (child) {
+        jsiTimerRemoved(child);
         jsvRemoveChild(timerArrayPtr, child);
         jsvUnLock(child);
       }
@@ -639,7 +645,8 @@ void jswrap_interface_changeInterval(JsVar *idVar, JsVarFloat interval) {
     JsVar *timer = jsvSkipNameAndUnLock(timerName);
     JsSysTime intervalInt = jshGetTimeFromMilliseconds(interval);
     jsvObjectSetChildAndUnLock(timer, "interval", jsvNewFromLongInteger(intervalInt));
-    jsvObjectSetChildAndUnLock(timer, "time", jsvNewFromLongInteger((jshGetSystemTime()-jsiLastIdleTime) + intervalInt));
+    jsvObjectSetChildAndUnLock(timer, "time", jsvNewFromLongInteger((jshGetSystemTime()-jsiTimerBaseTime) + intervalInt));
+    jsiTimerUpdated(timer);
     jsvUnLock(timer);
     // timerName already unlocked
     jsiTimersChanged(); // mark timers as changed
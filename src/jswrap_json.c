@@ -76,83 +76,262 @@ JsVar *jswrap_json_stringify(JsVar *v, JsVar *replacer, JsVar *space) {
 }
 
 
-JsVar *jswrap_json_parse_internal() {
-  switch (lex->tk) {
-  case LEX_R_TRUE:  jslGetNextToken(); return jsvNewFromBool(true);
-  case LEX_R_FALSE: jslGetNextToken(); return jsvNewFromBool(false);
-  case LEX_R_NULL:  jslGetNextToken(); return jsvNewWithFlags(JSV_NULL);
-  case '-': {
-    jslGetNextToken();
-    if (lex->tk!=LEX_INT && lex->tk!=LEX_FLOAT) return 0;
-    JsVar *v = jswrap_json_parse_internal();
-    JsVar *zero = jsvNewFromInteger(0);
-    JsVar *r = jsvMathsOp(zero, v, '-');
-    jsvUnLock2(v, zero);
-    return r;
+/* JSON.parse doesn't use the lexer - it reads characters straight out of
+ * the string (which could be a flat string or a memory-mapped flash
+ * string) and builds values directly, which is a lot faster. */
+typedef struct {
+  JsvStringIterator it;
+  char ch; ///< The current character, or 0 at the end of the input
+} JsonParser;
+
+static ALWAYS_INLINE void jsonGetCh(JsonParser *p) {
+  p->ch = jsvStringIteratorHasChar(&p->it) ? jsvStringIteratorGetChar(&p->it) : 0;
+}
+
+static ALWAYS_INLINE void jsonNextCh(JsonParser *p) {
+  jsvStringIteratorNextInline(&p->it);
+  jsonGetCh(p);
+}
+
+static void jsonSkipWhitespace(JsonParser *p) {
+  while (isWhitespace(p->ch))
+    jsonNextCh(p);
+}
+
+static void jsonError(JsonParser *p, const char *expecting) {
+  size_t pos = jsvStringIteratorGetIndex(&p->it);
+  if (p->ch)
+    jsExceptionHere(JSET_SYNTAXERROR, "Expecting %s, got '%c' at position %d", expecting, p->ch, (int)pos);
+  else
+    jsExceptionHere(JSET_SYNTAXERROR, "Expecting %s, got end of input", expecting);
+}
+
+/// Match the rest of a word like 'true' (the first char has already been checked)
+static bool jsonMatchWord(JsonParser *p, const char *word) {
+  while (*word) {
+    if (p->ch != *word) {
+      jsonError(p, "a valid value");
+      return false;
+    }
+    jsonNextCh(p);
+    word++;
+  }
+  return true;
+}
+
+/// Handle an escape character in a string (after the '\'). This matches what the lexer does
+static char jsonParseEscape(JsonParser *p) {
+  char ch = p->ch;
+  jsonNextCh(p);
+  switch (ch) {
+  case 'n': return 0x0A;
+  case 'b': return 0x08;
+  case 'f': return 0x0C;
+  case 'r': return 0x0D;
+  case 't': return 0x09;
+  case 'v': return 0x0B;
+  case 'u': // We don't support unicode, so we just take the bottom 8 bits
+    jsonNextCh(p);
+    jsonNextCh(p);
+    // fall through
+  case 'x': {
+    int hi = chtod(p->ch);
+    jsonNextCh(p);
+    int lo = chtod(p->ch);
+    jsonNextCh(p);
+    return (char)((hi<<4) | lo);
+  }
+  default:
+    if (ch>='0' && ch<='7') { // octal digits
+      int v = ch-'0';
+      if (p->ch>='0' && p->ch<='7') {
+        v = v*8 + p->ch-'0'; jsonNextCh(p);
+        if (p->ch>='0' && p->ch<='7') {
+          v = v*8 + p->ch-'0'; jsonNextCh(p);
+        }
+      }
+      return (char)v;
+    }
+    return ch; // for anything else, just push the character through
+  }
+}
+
+static JsVar *jsonParseString(JsonParser *p) {
+  char delim = p->ch;
+  jsonNextCh(p);
+  // Most strings are short, so build them in a buffer and allocate once
+  char buf[64];
+  size_t len = 0;
+  JsVar *str = 0;
+  JsvStringIterator dst;
+  while (p->ch && p->ch!=delim && p->ch!='\n') {
+    char ch = p->ch;
+    jsonNextCh(p);
+    if (ch=='\\') ch = jsonParseEscape(p);
+    if (str) {
+      jsvStringIteratorAppend(&dst, ch);
+    } else if (len<sizeof(buf)) {
+      buf[len++] = ch;
+    } else { // too big for the buffer - move to a real string
+      str = jsvNewStringOfLength((unsigned int)len, buf);
+      if (!str) return 0;
+      jsvStringIteratorNew(&dst, str, 0);
+      jsvStringIteratorGotoEnd(&dst);
+      jsvStringIteratorAppend(&dst, ch);
+    }
   }
-  case LEX_INT: {
-    long long v = stringToInt(jslGetTokenValueAsString());
-    jslGetNextToken();
-    return jsvNewFromLongInteger(v);
+  if (str) jsvStringIteratorFree(&dst);
+  if (p->ch!=delim) {
+    jsvUnLock(str);
+    jsonError(p, "end of string");
+    return 0;
   }
-  case LEX_FLOAT: {
-    JsVarFloat v = stringToFloat(jslGetTokenValueAsString());
-    jslGetNextToken();
-    return jsvNewFromFloat(v);
+  jsonNextCh(p);
+  if (!str) str = jsvNewStringOfLength((unsigned int)len, buf);
+  return str;
+}
+
+static JsVar *jsonParseNumber(JsonParser *p) {
+  // Integers are worked out as we go. Floats are put in a buffer for stringToFloat
+  char buf[32];
+  size_t len = 0;
+  long long v = 0;
+  int digits = 0;
+  bool isFloat = false;
+  bool negate = p->ch=='-';
+#define JSON_NUMBER_CH() { if (len<sizeof(buf)-1) buf[len++]=p->ch; jsonNextCh(p); }
+  if (negate) JSON_NUMBER_CH();
+  if (p->ch=='0') {
+    JSON_NUMBER_CH();
+    digits++;
+    if (p->ch=='x' || p->ch=='X') { // hex, which the lexer also allowed
+      jsonNextCh(p);
+      int d;
+      while ((d=chtod(p->ch))>=0 && d<16) {
+        v = v*16 + d;
+        jsonNextCh(p);
+      }
+      return jsvNewFromLongInteger(negate ? -v : v);
+    }
+  }
+  while (isNumeric(p->ch)) {
+    v = v*10 + (p->ch-'0');
+    digits++;
+    JSON_NUMBER_CH();
+  }
+  if (!digits) {
+    jsonError(p, "a number");
+    return 0;
   }
-  case LEX_STR: {
-    JsVar *a = jslGetTokenValueAsVar();
-    jslGetNextToken();
-    return a;
+  if (p->ch=='.') {
+    isFloat = true;
+    JSON_NUMBER_CH();
+    while (isNumeric(p->ch)) JSON_NUMBER_CH();
   }
+  if (p->ch=='e' || p->ch=='E') {
+    isFloat = true;
+    JSON_NUMBER_CH();
+    if (p->ch=='-' || p->ch=='+') JSON_NUMBER_CH();
+    while (isNumeric(p->ch)) JSON_NUMBER_CH();
+  }
+#undef JSON_NUMBER_CH
+  if (isFloat || digits>18) { // too big to fit in a long long
+    buf[len] = 0;
+    return jsvNewFromFloat(stringToFloat(buf));
+  }
+  return jsvNewFromLongInteger(negate ? -v : v);
+}
+
+static JsVar *jsonParseValue(JsonParser *p) {
+  jsonSkipWhitespace(p);
+  switch (p->ch) {
+  case 't': jsonNextCh(p); return jsonMatchWord(p, "rue") ? jsvNewFromBool(true) : 0;
+  case 'f': jsonNextCh(p); return jsonMatchWord(p, "alse") ? jsvNewFromBool(false) : 0;
+  case 'n': jsonNextCh(p); return jsonMatchWord(p, "ull") ? jsvNewWithFlags(JSV_NULL) : 0;
+  case '"':
+  case '\'': return jsonParseString(p);
   case '[': {
+    if (!jspCheckStackPosition()) return 0;
     JsVar *arr = jsvNewEmptyArray(); if (!arr) return 0;
-    jslGetNextToken(); // [
-    while (lex->tk != ']' && !jspHasError()) {
-      JsVar *value = jswrap_json_parse_internal();
-      if (!value ||
-          (lex->tk!=']' && !jslMatch(','))) {
-        jsvUnLock2(value, arr);
+    jsonNextCh(p); // [
+    jsonSkipWhitespace(p);
+    JsVarInt index = 0;
+    while (p->ch != ']' && !jspHasError()) {
+      JsVar *value = jsonParseValue(p);
+      // append to the end - no need to look up the array's length each time
+      JsVar *name = value ? jsvMakeIntoVariableName(jsvNewFromInteger(index++), value) : 0;
+      jsvUnLock(value);
+      if (!name) {
+        jsvUnLock(arr);
+        return 0;
+      }
+      jsvAddName(arr, name);
+      jsvUnLock(name);
+      jsonSkipWhitespace(p);
+      if (p->ch==',') {
+        jsonNextCh(p);
+        jsonSkipWhitespace(p);
+      } else if (p->ch!=']') {
+        jsonError(p, "',' or ']'");
+        jsvUnLock(arr);
         return 0;
       }
-      jsvArrayPush(arr, value);
-      jsvUnLock(value);
     }
-    if (!jslMatch(']')) {
+    if (p->ch!=']') { // error or interrupted
       jsvUnLock(arr);
       return 0;
     }
+    jsonNextCh(p);
     return arr;
   }
   case '{': {
+    if (!jspCheckStackPosition()) return 0;
     JsVar *obj = jsvNewObject(); if (!obj) return 0;
-    jslGetNextToken(); // {
-    while (lex->tk == LEX_STR && !jspHasError()) {
-      JsVar *key = jsvAsArrayIndexAndUnLock(jslGetTokenValueAsVar());
-      jslGetNextToken();
+    jsonNextCh(p); // {
+    jsonSkipWhitespace(p);
+    while (p->ch != '}' && !jspHasError()) {
+      if (p->ch!='"' && p->ch!='\'') {
+        jsonError(p, "a string key");
+        jsvUnLock(obj);
+        return 0;
+      }
+      JsVar *key = jsvAsArrayIndexAndUnLock(jsonParseString(p));
       JsVar *value = 0;
-      if (!jslMatch(':') ||
-          !(value=jswrap_json_parse_internal()) ||
-          (lex->tk!='}' && !jslMatch(','))) {
-        jsvUnLock3(key, value, obj);
+      jsonSkipWhitespace(p);
+      if (key && p->ch!=':') jsonError(p, "':'");
+      else if (key) {
+        jsonNextCh(p);
+        value = jsonParseValue(p);
+      }
+      if (!value) {
+        jsvUnLock2(key, obj);
         return 0;
       }
       jsvAddName(obj, jsvMakeIntoVariableName(key, value));
       jsvUnLock2(value, key);
+      jsonSkipWhitespace(p);
+      if (p->ch==',') {
+        jsonNextCh(p);
+        jsonSkipWhitespace(p);
+      } else if (p->ch!='}') {
+        jsonError(p, "',' or '}'");
+        jsvUnLock(obj);
+        return 0;
+      }
     }
-    if (!jslMatch('}')) {
+    if (p->ch!='}') { // error or interrupted
       jsvUnLock(obj);
       return 0;
     }
+    jsonNextCh(p);
     return obj;
   }
-  default: {
-    char buf[32];
-    jslTokenAsString(lex->tk, buf, 32);
-    jsExceptionHere(JSET_SYNTAXERROR, "Expecting a valid value, got %s", buf);
+  default:
+    if (p->ch=='-' || isNumeric(p->ch))
+      return jsonParseNumber(p);
+    jsonError(p, "a valid value");
     return 0; // undefined = error
   }
-  }
 }
 
 /*JSON{
@@ -167,17 +346,18 @@ JsVar *jswrap_json_parse_internal() {
 }
 Parse the given JSON string into a JavaScript object
 
-NOTE: This implementation uses eval() internally, and as such it is unsafe as it can allow arbitrary JS commands to be executed.
+**Note:** As well as standard JSON, single-quoted strings, hexadecimal numbers
+and trailing commas are accepted.
  */
 JsVar *jswrap_json_parse(JsVar *v) {
-  JsLex lex;
   JsVar *str = jsvAsString(v);
-  JsLex *oldLex = jslSetLex(&lex);
-  jslInit(str);
+  if (!str) return 0;
+  JsonParser p;
+  jsvStringIteratorNew(&p.it, str, 0);
+  jsonGetCh(&p);
+  JsVar *res = jsonParseValue(&p);
+  jsvStringIteratorFree(&p.it);
   jsvUnLock(str);
-  JsVar *res = jswrap_json_parse_internal();
-  jslKill();
-  jslSetLex(oldLex);
   return res;
 }
 
@@ -222,19 +402,11 @@ void jsfGetJSONForFunctionWithCallback(JsVar *var, JSONFlags flags, vcbprintf_ca
         if (jsvIsFunctionReturn(var))
           user_callback("return ", user_data);
         // reconstruct the tokenised output into something more readable
-        char buf[32];
         unsigned char lastch = 0;
         JsvStringIterator it;
         jsvStringIteratorNew(&it, codeVar, 0);
-        while (jsvStringIteratorHasChar(&it)) {
-          unsigned char ch = (unsigned char)jsvStringIteratorGetChar(&it);
-          if (jslNeedSpaceBetween(lastch, ch))
-            user_callback(" ", user_data);
-          jslFunctionCharAsString(ch, buf, sizeof(buf));
-          user_callback(buf, user_data);
-          jsvStringIteratorNext(&it);
-          lastch = ch;
-        }
+        while (jsvStringIteratorHasChar(&it))
+          jslPrintTokenisedChar(&it, &lastch, user_callback, user_data);
         jsvStringIteratorFree(&it);
 
         user_callback(hasNewLine?"\n}":"}", user_data);
@@ -561,6 +561,9 @@ JsVar *jswrap_object_setPrototypeOf(JsVar *object, JsVar *proto) {
     jsExceptionHere(JSET_TYPEERROR, "Can't extend %t\n", v);
   } else {
     jsvSetValueOfName(v, proto);
+#ifndef SAVE_ON_FLASH
+    jsvPropertyEpochChanged();
+#endif
   }
   jsvUnLock(v);
   return jsvLockAgainSafe(object);
@@ -147,6 +147,15 @@ Run a Garbage Collection pass, and return an object containing information on me
 * `history` : Memory used for command history - that is freed if memory is low. Note that this is INCLUDED in the figure for 'free'
 * `gc`      : Memory freed during the GC pass
 * `gctime`  : Time taken for GC pass (in milliseconds)
+* `gccycles` : Number of incremental GC cycles that have been completed while idle
+* `gcfreed`  : Total memory freed by incremental GC (in blocks)
+* `gcpause`  : Time taken by the last incremental GC step (in milliseconds)
+* `gcmaxpause` : Longest time taken by an incremental GC step (in milliseconds)
+* `gcmaxwork` : Most memory blocks looked at by an incremental GC step
+* `eventqueue` : Number of events currently waiting to be executed
+* `eventmax`   : The most events that have been waiting to be executed at once
+* `eventoverflow` : Number of events that didn't fit in the event queue's fixed-size buffer (because it was full or they had more than 3 arguments), and had to be stored in variables instead
+* `eventdropped`  : Number of events that were lost because there was no memory to store them
 * `blocksize` : Size of a block (variable) in bytes
 * `stackEndAddress` : (on ARM) the address (that can be used with peek/poke/etc) of the END of the stack. The stack grows down, so unless you do a lot of recursion the bytes above this can be used.
 * `flash_start`      : (on ARM) the address of the start of flash memory (usually `0x8000000`)
@@ -178,6 +187,17 @@ JsVar *jswrap_process_memory() {
     jsvObjectSetChildAndUnLock(obj, "history", jsvNewFromInteger((JsVarInt)history));
     jsvObjectSetChildAndUnLock(obj, "gc", jsvNewFromInteger((JsVarInt)gc));
     jsvObjectSetChildAndUnLock(obj, "gctime", jsvNewFromFloat(jshGetMillisecondsFromTime(time2-time1)));
+#ifndef SAVE_ON_FLASH
+    jsvObjectSetChildAndUnLock(obj, "gccycles", jsvNewFromInteger((JsVarInt)jsvGCStats.cycles));
+    jsvObjectSetChildAndUnLock(obj, "gcfreed", jsvNewFromInteger((JsVarInt)jsvGCStats.freed));
+    jsvObjectSetChildAndUnLock(obj, "gcpause", jsvNewFromFloat(jshGetMillisecondsFromTime(jsvGCStats.lastPause)));
+    jsvObjectSetChildAndUnLock(obj, "gcmaxpause", jsvNewFromFloat(jshGetMillisecondsFromTime(jsvGCStats.maxPause)));
+    jsvObjectSetChildAndUnLock(obj, "gcmaxwork", jsvNewFromInteger((JsVarInt)jsvGCStats.maxWork));
+    jsvObjectSetChildAndUnLock(obj, "eventqueue", jsvNewFromInteger((JsVarInt)jsiGetEventQueueDepth()));
+    jsvObjectSetChildAndUnLock(obj, "eventmax", jsvNewFromInteger((JsVarInt)jsiEventStats.maxDepth));
+    jsvObjectSetChildAndUnLock(obj, "eventoverflow", jsvNewFromInteger((JsVarInt)jsiEventStats.overflows));
+    jsvObjectSetChildAndUnLock(obj, "eventdropped", jsvNewFromInteger((JsVarInt)jsiEventStats.dropped));
+#endif
     jsvObjectSetChildAndUnLock(obj, "blocksize", jsvNewFromInteger(sizeof(JsVar)));
 
 #ifdef ARM
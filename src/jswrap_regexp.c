@@ -19,241 +19,637 @@
 #include "jslex.h"
 #include "jsinteractive.h"
 
-/* TODO:
- *
- * Handling of 'global' flag especially
- * lastIndex support?
+/* Regular expressions are compiled into a small program (stored on the RegExp
+ * object so it only happens once) which is then run by a 'Pike VM'. This
+ * steps through the string just once, keeping track of every place in the
+ * program that could match - so unlike a backtracking matcher the time taken
+ * is proportional to the length of the string, and there's no recursion per
+ * character.
  */
 
 #define MAX_GROUPS 9
-#define NO_RANGE  256
+#define REGEXP_PROGRAM_NAME JS_HIDDEN_CHAR_STR"prg" // compiled program, on the RegExp object
+#define REGEXP_CLASS_BYTES 32 // bitmap of 256 characters
+#define REGEXP_NO_POS ((size_t)-1) // group didn't match
+
+/// Opcodes for a compiled regular expression. Jump offsets are relative to the start of the instruction
+typedef enum {
+  RE_CHAR,   ///< [RE_CHAR, ch] match one character (lowercase if ignoring case)
+  RE_ANY,    ///< [RE_ANY] match any character
+  RE_CLASS,  ///< [RE_CLASS, 32 byte bitmap] match any character in the bitmap
+  RE_SPLIT,  ///< [RE_SPLIT, offset lo, hi] continue with both the next instruction (preferred) and offset
+  RE_SPLITL, ///< [RE_SPLITL, offset lo, hi] continue with both offset (preferred) and the next instruction
+  RE_JMP,    ///< [RE_JMP, offset lo, hi] continue at offset
+  RE_SAVE,   ///< [RE_SAVE, slot] store the current position as the start/end of a group
+  RE_BOL,    ///< [RE_BOL] only continue at the start of the string
+  RE_EOL,    ///< [RE_EOL] only continue at the end of the string
+  RE_WORDB,  ///< [RE_WORDB] only continue at a word boundary
+  RE_NWORDB, ///< [RE_NWORDB] only continue if not at a word boundary
+  RE_MATCH,  ///< [RE_MATCH] the whole expression has matched
+} RegExpOp;
 
+/// Header for a compiled regular expression, followed by the code itself
 typedef struct {
-  JsVar *sourceStr;
-  size_t startIndex;
+  unsigned short codeLen;      ///< length of the code in bytes
+  unsigned short instructions; ///< number of instructions (so the most threads we could need)
+  short firstChar;             ///< if >=0, every match must start with this character
+  unsigned char groups;        ///< number of capturing groups
   bool ignoreCase;
-  bool rangeMatch;
-  short rangeFirstChar;
-  int groups;
-  size_t groupStart[MAX_GROUPS];
-  size_t groupEnd[MAX_GROUPS];
-} matchInfo;
-
-static JsVar *matchhere(char *regexp, JsvStringIterator *txtIt, matchInfo info);
-
-static JsVar *matchfound(JsvStringIterator *txtIt, matchInfo info) {
-  JsVar *rmatch = jsvNewEmptyArray();
-  size_t endIndex = jsvStringIteratorGetIndex(txtIt);
-  JsVar *matchStr = jsvNewFromStringVar(info.sourceStr, info.startIndex, endIndex-info.startIndex);
-  jsvSetArrayItem(rmatch, 0, matchStr);
-  jsvUnLock(matchStr);
-  int i;
-  for (i=0;i<info.groups;i++) {
-    matchStr = jsvNewFromStringVar(info.sourceStr, info.groupStart[i], info.groupEnd[i]-info.groupStart[i]);
-    jsvSetArrayItem(rmatch, i+1, matchStr);
-    jsvUnLock(matchStr);
-  }
-  jsvObjectSetChildAndUnLock(rmatch, "index", jsvNewFromInteger((JsVarInt)info.startIndex));
-  jsvObjectSetChild(rmatch, "input", info.sourceStr);
+  bool anchored;               ///< the expression starts with '^', so can only match at the start
+} RegExpProgram;
 
-  return rmatch;
+typedef struct {
+  const char *re;       ///< where we are in the regex's source
+  unsigned char *code;  ///< where to write the code, or 0 if we're just working out how big it is
+  int len;              ///< length of the code so far
+  int instructions;     ///< instructions so far
+  int groups;           ///< capturing groups so far
+  bool ignoreCase;
+  bool error;
+} RegExpCompiler;
+
+static void reCompileAlternation(RegExpCompiler *c);
+
+static void reError(RegExpCompiler *c, const char *message) {
+  if (!c->error) jsExceptionHere(JSET_SYNTAXERROR, "%s in RegEx", message);
+  c->error = true;
 }
 
-// No match found, so search to end of regex to see if there's an '|'
-static JsVar *nomatchfound(char *regexp, matchInfo info) {
-  if (!jspCheckStackPosition()) return 0;
-  // TODO: | inside a group?
-  while (*regexp && *regexp!='|') {
-    if (*regexp=='\\') {
-      regexp++; // end of regex after escape char!
-      if (!*regexp) return 0;
-    }
-    regexp++;
-  }
-  if (*regexp != '|') return 0;
-  regexp++;
+static void reEmit(RegExpCompiler *c, int byte) {
+  if (c->code) c->code[c->len] = (unsigned char)byte;
+  c->len++;
+}
 
-  JsvStringIterator txtIt;
-  jsvStringIteratorNew(&txtIt,  info.sourceStr, info.startIndex);
-  JsVar *rmatch = matchhere(regexp, &txtIt, info);
-  jsvStringIteratorFree(&txtIt);
-  return rmatch;
+static void reEmitOp(RegExpCompiler *c, RegExpOp op) {
+  reEmit(c, op);
+  c->instructions++;
 }
 
-/* match: search for regexp anywhere in text */
-static JsVar *match(char *regexp, JsVar *str, size_t startIndex, bool ignoreCase) {
-  matchInfo info;
-  info.sourceStr = str;
-  info.startIndex = startIndex;
-  info.ignoreCase = ignoreCase;
-  info.rangeMatch = false;
-  info.rangeFirstChar = NO_RANGE;
-  info.groups = 0;
-
-  JsVar *rmatch;
-  JsvStringIterator txtIt, txtIt2;
-  jsvStringIteratorNew(&txtIt, str, startIndex);
-  /* must look even if string is empty */
-  jsvStringIteratorClone(&txtIt2, &txtIt);
-  rmatch = matchhere(regexp, &txtIt2, info);
-  jsvStringIteratorFree(&txtIt2);
-  jsvStringIteratorNext(&txtIt);
-  while (!rmatch && jsvStringIteratorHasChar(&txtIt)) {
-    info.startIndex++;
-    jsvStringIteratorClone(&txtIt2, &txtIt);
-    rmatch = matchhere(regexp, &txtIt2, info);
-    jsvStringIteratorFree(&txtIt2);
-    jsvStringIteratorNext(&txtIt);
+static void reSetOffset(RegExpCompiler *c, int at, int target) {
+  if (!c->code) return;
+  int offset = target - at;
+  c->code[at+1] = (unsigned char)(offset&255);
+  c->code[at+2] = (unsigned char)((offset>>8)&255);
+}
+
+static void reEmitJump(RegExpCompiler *c, RegExpOp op, int target) {
+  int at = c->len;
+  reEmitOp(c, op);
+  reEmit(c, 0);
+  reEmit(c, 0);
+  reSetOffset(c, at, target);
+}
+
+/** Insert a split/jump instruction at 'at' (the start of the code for the last
+ * thing we compiled) pointing to 'target' (after the insertion). Jumps inside
+ * the code that moves are relative, so they stay correct. */
+static void reInsertJump(RegExpCompiler *c, int at, RegExpOp op, int target) {
+  if (c->code) memmove(&c->code[at+3], &c->code[at], (size_t)(c->len-at));
+  c->len += 3;
+  c->instructions++;
+  if (c->code) c->code[at] = (unsigned char)op;
+  reSetOffset(c, at, target);
+}
+
+static bool reIsClassEscape(char ch) {
+  return ch=='d' || ch=='D' || ch=='s' || ch=='S' || ch=='w' || ch=='W';
+}
+
+static bool reIsWordChar(int ch) {
+  return ch>=0 && (isNumeric((char)ch) || isAlpha((char)ch));
+}
+
+/// Add the characters matched by \d, \s, \w (or their inverse) to a class bitmap
+static void reClassAddEscape(unsigned char *bits, char esc) {
+  int ch;
+  for (ch=0;ch<256;ch++) {
+    bool m;
+    if (esc=='d' || esc=='D') m = isNumeric((char)ch);
+    else if (esc=='s' || esc=='S') m = isWhitespace((char)ch);
+    else m = reIsWordChar(ch);
+    if (esc>='A' && esc<='Z') m = !m;
+    if (m) bits[ch>>3] |= (unsigned char)(1<<(ch&7));
+  }
+}
+
+/// Parse a character escape code (after the '\'), returning the character
+static int reParseEscapeChar(RegExpCompiler *c) {
+  char ch = *(c->re++);
+  switch (ch) {
+    case 'f': return 0x0C;
+    case 'n': return 0x0A;
+    case 'r': return 0x0D;
+    case 't': return 0x09;
+    case 'v': return 0x0B;
+    case 'x':
+      if (isHexadecimal(c->re[0]) && isHexadecimal(c->re[1])) {
+        c->re += 2;
+        return hexToByte(c->re[-2], c->re[-1]);
+      }
+      return 'x';
+    default:
+      if (ch>='0' && ch<='9') return ch-'0';
+      return (unsigned char)ch;
   }
-  jsvStringIteratorFree(&txtIt);
-  return rmatch;
 }
 
-/* Match one character. Doesn't modify txtIt, returns length of regexp char in *length  */
-bool matchcharacter(char *regexp, JsvStringIterator *txtIt, int *length, matchInfo *info) {
-  *length = 1;
-  char ch = jsvStringIteratorGetChar(txtIt);
-  if (regexp[0]=='.') return true;
-  if (regexp[0]=='[') { // Character set (any char inside '[]')
-    info->rangeMatch = true;
-    bool inverted = regexp[1]=='^';
-    if (inverted) (*length)++;
-    bool matchAny = false;
-    while (regexp[*length] && regexp[*length]!=']') {
-      int matchLen;
-      matchAny |= matchcharacter(&regexp[*length], txtIt, &matchLen, info);
-      (*length) += matchLen;
+/// Character set, eg. [a-z\d_]
+static void reCompileClass(RegExpCompiler *c) {
+  unsigned char bits[REGEXP_CLASS_BYTES];
+  memset(bits, 0, sizeof(bits));
+  bool inverted = *c->re=='^';
+  if (inverted) c->re++;
+  while (*c->re && *c->re!=']') {
+    int lo, hi;
+    if (*c->re=='\\') {
+      c->re++;
+      if (!*c->re) break;
+      if (reIsClassEscape(*c->re)) {
+        reClassAddEscape(bits, *(c->re++));
+        continue;
+      }
+      if (*c->re=='b') { // backspace inside a character set
+        c->re++;
+        lo = 8;
+      } else lo = reParseEscapeChar(c);
+    } else lo = (unsigned char)*(c->re++);
+    hi = lo;
+    if (c->re[0]=='-' && c->re[1] && c->re[1]!=']' &&
+        !(c->re[1]=='\\' && reIsClassEscape(c->re[2]))) { // range
+      c->re++;
+      if (*c->re=='\\') {
+        c->re++;
+        hi = reParseEscapeChar(c);
+      } else hi = (unsigned char)*(c->re++);
     }
-    if (regexp[*length]==']') {
-      (*length)++;
-    } else {
-      jsExceptionHere(JSET_ERROR, "Unfinished character set in RegEx");
-      return false;
+    int ch;
+    for (ch=lo;ch<=hi;ch++)
+      bits[ch>>3] |= (unsigned char)(1<<(ch&7));
+  }
+  if (*c->re!=']') {
+    reError(c, "Unfinished character set");
+    return;
+  }
+  c->re++;
+  int ch;
+  if (c->ignoreCase) {
+    for (ch=0;ch<256;ch++) {
+      if (bits[ch>>3] & (1<<(ch&7))) {
+        int l = (unsigned char)jsvStringCharToLower((char)ch);
+        int u = (unsigned char)jsvStringCharToUpper((char)ch);
+        bits[l>>3] |= (unsigned char)(1<<(l&7));
+        bits[u>>3] |= (unsigned char)(1<<(u&7));
+      }
     }
-    info->rangeMatch = false;
-    return matchAny != inverted;
   }
-  char cH = regexp[0];
-  if (cH=='\\') { // escape character
-    *length = 2;
-    // fallback to the quoted character (e.g. /,-,? etc.)
-    cH = regexp[1];
-    // missing quite a few here
-    // https://developer.mozilla.org/en-US/docs/Web/JavaScript/Guide/Regular_Expressions
-    if (cH=='d') return isNumeric(ch);
-    if (cH=='D') return !isNumeric(ch);
-    if (cH=='f') { cH=0x0C; goto haveCode; }
-    if (cH=='n') { cH=0x0A; goto haveCode; }
-    if (cH=='r') { cH=0x0D; goto haveCode; }
-    if (cH=='s') return isWhitespace(ch);
-    if (cH=='S') return !isWhitespace(ch);
-    if (cH=='t') { cH=0x09; goto haveCode; }
-    if (cH=='v') { cH=0x0B; goto haveCode; }
-    if (cH=='w') return isNumeric(ch) || isAlpha(ch) || ch=='_';
-    if (cH=='W') return !(isNumeric(ch) || isAlpha(ch) || ch=='_');
-    if (cH>='0' && cH<='9') { cH-='0'; goto haveCode; }
-    if (cH=='x' && regexp[2] && regexp[3]) {
-      *length = 4;
-      cH = (char)hexToByte(regexp[2],regexp[3]);
-      goto haveCode;
+  reEmitOp(c, RE_CLASS);
+  for (ch=0;ch<REGEXP_CLASS_BYTES;ch++)
+    reEmit(c, inverted ? ~bits[ch] : bits[ch]);
+}
+
+/// Compile one thing that a quantifier could apply to. Returns false if there wasn't one
+static bool reCompileAtom(RegExpCompiler *c) {
+  char ch = *c->re;
+  switch (ch) {
+    case 0: case '|': case ')':
+      return false;
+    case '*': case '+': case '?':
+      reError(c, "Nothing to repeat");
+      return false;
+    case '(': {
+      c->re++;
+      int group = -1;
+      if (c->re[0]=='?') {
+        if (c->re[1]!=':') {
+          reError(c, "Unsupported group type");
+          return false;
+        }
+        c->re += 2; // non-capturing
+      } else group = c->groups++;
+      if (group>=0 && group<MAX_GROUPS) {
+        reEmitOp(c, RE_SAVE);
+        reEmit(c, 2+group*2);
+      }
+      reCompileAlternation(c);
+      if (*c->re!=')') {
+        reError(c, "Unfinished group");
+        return false;
+      }
+      c->re++;
+      if (group>=0 && group<MAX_GROUPS) {
+        reEmitOp(c, RE_SAVE);
+        reEmit(c, 3+group*2);
+      }
+      return true;
     }
+    case '[':
+      c->re++;
+      reCompileClass(c);
+      return true;
+    case '.':
+      c->re++;
+      reEmitOp(c, RE_ANY);
+      return true;
+    case '^':
+      c->re++;
+      reEmitOp(c, RE_BOL);
+      return true;
+    case '$':
+      c->re++;
+      reEmitOp(c, RE_EOL);
+      return true;
+    case '\\': {
+      c->re++;
+      char esc = *c->re;
+      if (!esc) {
+        reError(c, "Escape at end");
+        return false;
+      }
+      if (esc=='b' || esc=='B') {
+        c->re++;
+        reEmitOp(c, esc=='b' ? RE_WORDB : RE_NWORDB);
+        return true;
+      }
+      if (reIsClassEscape(esc)) {
+        c->re++;
+        unsigned char bits[REGEXP_CLASS_BYTES];
+        memset(bits, 0, sizeof(bits));
+        reClassAddEscape(bits, esc);
+        reEmitOp(c, RE_CLASS);
+        int i;
+        for (i=0;i<REGEXP_CLASS_BYTES;i++) reEmit(c, bits[i]);
+        return true;
+      }
+      int code = reParseEscapeChar(c);
+      reEmitOp(c, RE_CHAR);
+      reEmit(c, c->ignoreCase ? (unsigned char)jsvStringCharToLower((char)code) : code);
+      return true;
+    }
+    default:
+      c->re++;
+      reEmitOp(c, RE_CHAR);
+      reEmit(c, c->ignoreCase ? (unsigned char)jsvStringCharToLower(ch) : (unsigned char)ch);
+      return true;
   }
-haveCode:
-  if (info->rangeMatch && regexp[*length] == '-') { // Character set range start
-    info->rangeFirstChar = cH;
-    (*length)++;
-    int matchLen;
-    bool match = matchcharacter(&regexp[*length], txtIt, &matchLen, info);
-    (*length)+=matchLen;
-    return match;
+}
+
+/// Parse the '{n}', '{n,}' or '{n,m}' at c->re. Returns false (and leaves c->re alone) if it isn't valid
+static bool reParseRepeat(RegExpCompiler *c, int *min, int *max) {
+  const char *re = c->re+1;
+  if (!isNumeric(*re)) return false;
+  *min = 0;
+  while (isNumeric(*re)) *min = (*min)*10 + (*(re++)-'0');
+  *max = *min;
+  if (*re==',') {
+    re++;
+    if (isNumeric(*re)) {
+      *max = 0;
+      while (isNumeric(*re)) *max = (*max)*10 + (*(re++)-'0');
+    } else *max = -1; // no limit
   }
-  if (info->ignoreCase) {
-    ch = jsvStringCharToLower(ch);
-    cH = jsvStringCharToLower(cH);
+  if (*re!='}') return false;
+  c->re = re+1;
+  return true;
+}
+
+/// Compile an atom followed by an optional quantifier
+static bool reCompileTerm(RegExpCompiler *c) {
+  const char *atomSource = c->re;
+  int atomGroups = c->groups;
+  int start = c->len;
+  if (!reCompileAtom(c)) return false;
+  char q = *c->re;
+  int min, max; // max<0 for no limit
+  if (q=='*') { min = 0; max = -1; }
+  else if (q=='+') { min = 1; max = -1; }
+  else if (q=='?') { min = 0; max = 1; }
+  else if (q!='{' || !reParseRepeat(c, &min, &max))
+    return true; // no quantifier
+  if (q!='{') c->re++;
+  bool lazy = *c->re=='?';
+  if (lazy) c->re++;
+  if (max>=0 && max<min) {
+    reError(c, "Numbers out of order in {} quantifier");
+    return false;
   }
-  if (info->rangeFirstChar != NO_RANGE) { // Character set range
-    char cL = (char)info->rangeFirstChar;
-    if (info->ignoreCase) {
-      cL = jsvStringCharToLower(cL);
-    }
-    info->rangeFirstChar = NO_RANGE;
-    return (ch >= cL && ch <= cH && cL < cH);
+  const char *afterQuantifier = c->re;
+  int atomLen = c->len - start;
+  int copies = (max<0) ? (min ? min : 1) : max;
+  if ((copies+1)*(atomLen+3) > 0x7FFF) {
+    reError(c, "Too many repeats");
+    return false;
   }
-  return cH==ch;
-}
-
-/* matchhere: search for regexp at beginning of text. Only handles up to '|' character. Modifies txtIt */
-static JsVar *matchhere(char *regexp, JsvStringIterator *txtIt, matchInfo info) {
-  if (jspIsInterrupted()) return 0;
-  if (regexp[0] == '\0' || // end of regex
-      regexp[0] == '|') // end of this 'or' section of regex
-    return matchfound(txtIt, info);
-  if (regexp[0] == '^') { // must be beginning of String
-    if (jsvStringIteratorGetIndex(txtIt)!=0)
-      return 0; // no match
-    if (!jspCheckStackPosition()) return 0;
-    return matchhere(regexp+1, txtIt, info);
+  if (copies==0) { // x{0} - just drop it
+    c->len = start;
+    return true;
   }
-  // Marker for end of String
-  if (regexp[0] == '$') {
-    if (!jsvStringIteratorHasChar(txtIt))
-      return matchhere(regexp+1, txtIt, info);
-    else
-      return nomatchfound(regexp+1, info); // not the end, it's a fail
+  /* Optional copies are a split to the end followed by the atom, and
+   * they're all the same size so we know where the end will be */
+  int optional = (max<0) ? 0 : max-min;
+  int optionalStart = start + (min ? min*atomLen : 0);
+  int end = optionalStart + optional*(atomLen+3);
+  RegExpOp splitOp = lazy ? RE_SPLITL : RE_SPLIT; // normally prefer to match the atom again
+  if (min==0) // the copy we've already compiled is optional
+    reInsertJump(c, start, splitOp, (max<0) ? start+3+atomLen+3 : end);
+  int i;
+  for (i=1;i<copies && !c->error;i++) {
+    // we've already compiled the atom once, so go back and compile it again
+    c->re = atomSource;
+    c->groups = atomGroups; // the same groups, so the last repeat sets them
+    if (i>=min) reEmitJump(c, splitOp, end);
+    reCompileAtom(c);
   }
-  if (regexp[0] == '(') {
-    info.groupStart[info.groups] = jsvStringIteratorGetIndex(txtIt);
-    info.groupEnd[info.groups] = info.groupStart[info.groups];
-    if (info.groups<MAX_GROUPS) info.groups++;
-    if (!jspCheckStackPosition()) return 0;
-    return matchhere(regexp+1, txtIt, info);
+  c->re = afterQuantifier;
+  if (max<0) {
+    int lastStart = c->len - atomLen;
+    if (min==0) // x* : jump back to the split before the atom
+      reEmitJump(c, RE_JMP, start);
+    else // x+ : split back to the start of the last copy
+      reEmitJump(c, lazy ? RE_SPLIT : RE_SPLITL, lastStart);
   }
-  if (regexp[0] == ')') {
-    if (info.groups>0)
-      info.groupEnd[info.groups-1] = jsvStringIteratorGetIndex(txtIt);
-    if (!jspCheckStackPosition()) return 0;
-    return matchhere(regexp+1, txtIt, info);
+  return true;
+}
+
+/// Compile terms up until the end of the expression, a '|' or a ')'
+static void reCompileSequence(RegExpCompiler *c) {
+  while (!c->error && reCompileTerm(c));
+}
+
+/// Compile alternatives separated by '|' up until the end of the expression or a ')'
+static void reCompileAlternation(RegExpCompiler *c) {
+  int start = c->len;
+  reCompileSequence(c);
+  if (c->error || *c->re!='|') return;
+  c->re++;
+  // split between this alternative and the next (which starts after the jump we add)
+  reInsertJump(c, start, RE_SPLIT, c->len+3+3);
+  int jump = c->len;
+  reEmitJump(c, RE_JMP, 0);
+  reCompileAlternation(c);
+  reSetOffset(c, jump, c->len);
+}
+
+/** Compile the regex source into 'code' (which can be 0 if we just want the
+ * size). Returns the length of the code, or -1 on error */
+static int reCompile(const char *source, bool ignoreCase, unsigned char *code, RegExpProgram *prog) {
+  RegExpCompiler c;
+  c.re = source;
+  c.code = code;
+  c.len = 0;
+  c.instructions = 0;
+  c.groups = 0;
+  c.ignoreCase = ignoreCase;
+  c.error = false;
+  reCompileAlternation(&c);
+  if (!c.error && *c.re) reError(&c, "Unmatched ')'");
+  reEmitOp(&c, RE_MATCH);
+  if (c.len > 0xFFFF) reError(&c, "Expression too large");
+  if (c.error) return -1;
+  prog->codeLen = (unsigned short)c.len;
+  prog->instructions = (unsigned short)c.instructions;
+  prog->groups = (unsigned char)((c.groups>MAX_GROUPS) ? MAX_GROUPS : c.groups);
+  prog->ignoreCase = ignoreCase;
+  prog->anchored = false;
+  prog->firstChar = -1;
+  if (code) {
+    // Work out if matches have to start with a certain character, so we can skip to it
+    int pc = 0;
+    while (code[pc]==RE_SAVE) pc+=2;
+    if (code[pc]==RE_BOL) prog->anchored = true;
+    else if (code[pc]==RE_CHAR) prog->firstChar = code[pc+1];
+  }
+  return c.len;
+}
+
+// -----------------------------
+
+typedef struct {
+  int count;
+  unsigned short *pc;
+  size_t *caps; // 'slots' entries for each thread
+} RegExpThreadList;
+
+typedef struct {
+  const unsigned char *code;
+  int slots;              ///< 2 for each group, plus 2 for the whole match
+  unsigned short *marks;  ///< for each instruction, the generation it was last added in
+  unsigned short gen;
+  size_t pos;             ///< position in the string we're adding threads for
+  int prevCh, ch;         ///< characters before and at 'pos' (-1 if none)
+} RegExpVM;
+
+static void reNextGeneration(RegExpVM *vm, int codeLen) {
+  if (++vm->gen == 0) { // wrapped - clear out old marks
+    memset(vm->marks, 0, sizeof(unsigned short)*(size_t)codeLen);
+    vm->gen = 1;
   }
-  int charLength;
-  bool charMatched = matchcharacter(regexp, txtIt, &charLength, &info);
-  if (regexp[charLength] == '*' || regexp[charLength] == '+') {
-    char op = regexp[charLength];
-    if (!charMatched && op=='+') {
-      // with '+' operator it has to match at least once
-      return nomatchfound(&regexp[charLength+1], info);
+}
+
+static int reOffset(const unsigned char *code, int pc) {
+  return pc + (short)(code[pc+1] | (code[pc+2]<<8));
+}
+
+/// Add a thread at 'pc' to the list, following any jumps/splits/etc to get to instructions that consume characters
+static void reAddThread(RegExpVM *vm, RegExpThreadList *list, int pc, size_t *caps) {
+  if (vm->marks[pc]==vm->gen) return; // already there
+  vm->marks[pc] = vm->gen;
+  const unsigned char *code = vm->code;
+  switch (code[pc]) {
+    case RE_JMP:
+      reAddThread(vm, list, reOffset(code,pc), caps);
+      return;
+    case RE_SPLIT:
+      reAddThread(vm, list, pc+3, caps);
+      reAddThread(vm, list, reOffset(code,pc), caps);
+      return;
+    case RE_SPLITL:
+      reAddThread(vm, list, reOffset(code,pc), caps);
+      reAddThread(vm, list, pc+3, caps);
+      return;
+    case RE_SAVE: {
+      int slot = code[pc+1];
+      size_t old = caps[slot];
+      caps[slot] = vm->pos;
+      reAddThread(vm, list, pc+2, caps);
+      caps[slot] = old;
+      return;
     }
-    char *regexpAfterStar = regexp+charLength+1;
-    JsvStringIterator txtIt2;
-    // Try and match everything after right now
-    jsvStringIteratorClone(&txtIt2, txtIt);
-    JsVar *lastrmatch = matchhere(regexpAfterStar, &txtIt2, info);
-    jsvStringIteratorFree(&txtIt2);
-    // Otherwise try and match more than one
-    while (jsvStringIteratorHasChar(txtIt) && charMatched) {
-      // We had this character matched, so move on and see if we can match with the new one
-      jsvStringIteratorNext(txtIt);
-      charMatched = matchcharacter(regexp, txtIt, &charLength, &info);
-      // See if we can match after the character...
-      jsvStringIteratorClone(&txtIt2, txtIt);
-      JsVar *rmatch = matchhere(regexpAfterStar, &txtIt2, info);
-      jsvStringIteratorFree(&txtIt2);
-      // can't match with this - use the last one
-      if (rmatch) {
-        jsvUnLock(lastrmatch);
-        lastrmatch = rmatch;
+    case RE_BOL:
+      if (vm->pos==0) reAddThread(vm, list, pc+1, caps);
+      return;
+    case RE_EOL:
+      if (vm->ch<0) reAddThread(vm, list, pc+1, caps);
+      return;
+    case RE_WORDB:
+    case RE_NWORDB:
+      if ((reIsWordChar(vm->prevCh) != reIsWordChar(vm->ch)) == (code[pc]==RE_WORDB))
+        reAddThread(vm, list, pc+1, caps);
+      return;
+    default: // something that needs a character, or a match
+      list->pc[list->count] = (unsigned short)pc;
+      memcpy(&list->caps[list->count*vm->slots], caps, sizeof(size_t)*(size_t)vm->slots);
+      list->count++;
+      return;
+  }
+}
+
+/** Run a compiled regex on 'str', looking for the first match at or after
+ * startIndex. On success returns true and fills in 'caps' (start and end of
+ * the whole match, then of each group - REGEXP_NO_POS if a group didn't match) */
+static bool reExecute(const RegExpProgram *prog, const unsigned char *code, JsVar *str, size_t startIndex, size_t *caps) {
+  int slots = 2 + prog->groups*2;
+  int maxThreads = prog->instructions;
+  size_t stackNeeded = (sizeof(unsigned short)+sizeof(size_t)*(size_t)slots)*(size_t)maxThreads*2 +
+                       sizeof(unsigned short)*prog->codeLen +
+                       (size_t)prog->instructions*64/*recursion in reAddThread*/ + 256;
+  if (stackNeeded > jsuGetFreeStack()) {
+    jsExceptionHere(JSET_ERROR, "Not enough free stack to run this RegEx");
+    return false;
+  }
+  RegExpThreadList lists[2], *clist = &lists[0], *nlist = &lists[1];
+  int i;
+  for (i=0;i<2;i++) {
+    lists[i].count = 0;
+    lists[i].pc = (unsigned short*)alloca(sizeof(unsigned short)*(size_t)maxThreads);
+    lists[i].caps = (size_t*)alloca(sizeof(size_t)*(size_t)(slots*maxThreads));
+  }
+  size_t *threadCaps = (size_t*)alloca(sizeof(size_t)*(size_t)slots);
+  RegExpVM vm;
+  vm.code = code;
+  vm.slots = slots;
+  vm.marks = (unsigned short*)alloca(sizeof(unsigned short)*prog->codeLen);
+  memset(vm.marks, 0, sizeof(unsigned short)*prog->codeLen);
+  vm.gen = 1;
+
+  bool matched = false;
+  size_t pos = startIndex;
+  int prevCh = pos ? (unsigned char)jsvGetCharInString(str, pos-1) : -1;
+  JsvStringIterator it;
+  jsvStringIteratorNew(&it, str, startIndex);
+  int ch = jsvStringIteratorHasChar(&it) ? (unsigned char)jsvStringIteratorGetChar(&it) : -1;
+  while (!jspIsInterrupted()) {
+    if (!matched && (!prog->anchored || pos==0)) {
+      if (clist->count==0 && prog->firstChar>=0) {
+        // nothing in progress, so skip to the next place that a match could start
+        bool skipped = false;
+        while (ch>=0 && (prog->ignoreCase ? (unsigned char)jsvStringCharToLower((char)ch) : ch) != prog->firstChar) {
+          prevCh = ch;
+          jsvStringIteratorNext(&it);
+          pos++;
+          ch = jsvStringIteratorHasChar(&it) ? (unsigned char)jsvStringIteratorGetChar(&it) : -1;
+          skipped = true;
+        }
+        if (ch<0) break;
+        if (skipped) reNextGeneration(&vm, prog->codeLen);
       }
+      // start a new thread here (lowest priority, as matches that started earlier win)
+      for (i=0;i<slots;i++) threadCaps[i] = REGEXP_NO_POS;
+      threadCaps[0] = pos;
+      vm.pos = pos;
+      vm.prevCh = prevCh;
+      vm.ch = ch;
+      reAddThread(&vm, clist, 0, threadCaps);
+    }
+    if (clist->count==0 && (matched || (prog->anchored && pos>0)))
+      break; // nothing left that could match
+    // Work out the next character, so we know what assertions like '$' will do there
+    int nextCh = -1;
+    if (ch>=0) {
+      jsvStringIteratorNext(&it);
+      if (jsvStringIteratorHasChar(&it))
+        nextCh = (unsigned char)jsvStringIteratorGetChar(&it);
     }
-    return lastrmatch;
+    reNextGeneration(&vm, prog->codeLen);
+    vm.pos = pos+1;
+    vm.prevCh = ch;
+    vm.ch = nextCh;
+    int foldedCh = (ch>=0 && prog->ignoreCase) ? (unsigned char)jsvStringCharToLower((char)ch) : ch;
+    nlist->count = 0;
+    for (i=0;i<clist->count;i++) {
+      int pc = clist->pc[i];
+      size_t *tcaps = &clist->caps[i*slots];
+      switch (code[pc]) {
+        case RE_CHAR:
+          if (foldedCh>=0 && foldedCh==code[pc+1])
+            reAddThread(&vm, nlist, pc+2, tcaps);
+          break;
+        case RE_ANY:
+          if (ch>=0) reAddThread(&vm, nlist, pc+1, tcaps);
+          break;
+        case RE_CLASS:
+          if (ch>=0 && (code[pc+1+(ch>>3)] & (1<<(ch&7))))
+            reAddThread(&vm, nlist, pc+1+REGEXP_CLASS_BYTES, tcaps);
+          break;
+        case RE_MATCH:
+          // This is the best match so far, and lower priority threads can't beat it
+          matched = true;
+          memcpy(caps, tcaps, sizeof(size_t)*(size_t)slots);
+          caps[1] = pos;
+          i = clist->count;
+          break;
+      }
+    }
+    RegExpThreadList *t = clist;
+    clist = nlist;
+    nlist = t;
+    if (ch<0) break; // end of string
+    pos++;
+    prevCh = ch;
+    ch = nextCh;
   }
+  jsvStringIteratorFree(&it);
+  return matched;
+}
 
-  // This character is matched
-  if (jsvStringIteratorHasChar(txtIt) && charMatched) {
-    jsvStringIteratorNext(txtIt);
-    if (!jspCheckStackPosition()) return 0;
-    return matchhere(regexp+charLength, txtIt, info);
+/** Get the compiled program for this RegExp, compiling it if needed. Returns
+ * a locked flat string (or 0 on error) and sets *prog and *code */
+static JsVar *reGetProgram(JsVar *regexp, RegExpProgram *prog, const unsigned char **code) {
+  JsVar *compiled = jsvObjectGetChild(regexp, REGEXP_PROGRAM_NAME, 0);
+  if (!compiled) {
+    JsVar *source = jsvObjectGetChild(regexp, "source", 0);
+    if (!jsvIsString(source)) {
+      jsvUnLock(source);
+      return 0;
+    }
+    size_t sourceLen = jsvGetStringLength(source);
+    char *sourcePtr = (char *)alloca(sourceLen+1);
+    jsvGetString(source, sourcePtr, sourceLen+1);
+    jsvUnLock(source);
+    bool ignoreCase = jswrap_regexp_hasFlag(regexp,'i');
+    int len = reCompile(sourcePtr, ignoreCase, 0, prog); // work out the size
+    if (len<0) return 0;
+    compiled = jsvNewFlatStringOfLength((unsigned int)(sizeof(RegExpProgram)+(size_t)len));
+    if (!compiled) return 0; // out of memory
+    unsigned char *data = (unsigned char*)jsvGetFlatStringPointer(compiled);
+    reCompile(sourcePtr, ignoreCase, data+sizeof(RegExpProgram), prog);
+    memcpy(data, prog, sizeof(RegExpProgram));
+    jsvObjectSetChild(regexp, REGEXP_PROGRAM_NAME, compiled);
   }
-  // No match
-  return nomatchfound(&regexp[charLength], info);
+  const unsigned char *data = (const unsigned char*)jsvGetFlatStringPointer(compiled);
+  memcpy(prog, data, sizeof(RegExpProgram));
+  *code = data+sizeof(RegExpProgram);
+  return compiled;
+}
+
+/// Match the regex against the string, starting at startIndex. Fills in 'caps' as for reExecute
+static bool reMatch(JsVar *regexp, JsVar *str, size_t startIndex, size_t *caps, int *groups) {
+  if (startIndex > jsvGetStringLength(str)) return false; // can't even match an empty string
+  RegExpProgram prog;
+  const unsigned char *code;
+  JsVar *compiled = reGetProgram(regexp, &prog, &code);
+  if (!compiled) return false;
+  bool matched = reExecute(&prog, code, str, startIndex, caps);
+  if (groups) *groups = prog.groups;
+  jsvUnLock(compiled);
+  return matched;
+}
+
+bool jswrap_regexp_matchRange(JsVar *regexp, JsVar *str, size_t startIndex, size_t *matchStart, size_t *matchEnd) {
+  size_t caps[2+MAX_GROUPS*2];
+  if (!reMatch(regexp, str, startIndex, caps, 0)) return false;
+  *matchStart = caps[0];
+  *matchEnd = caps[1];
+  return true;
 }
 
 /*JSON{
@@ -337,34 +733,32 @@ Or with groups `/W(o)rld/.exec("Hello World")` returns:
 JsVar *jswrap_regexp_exec(JsVar *parent, JsVar *arg) {
   JsVar *str = jsvAsString(arg);
   JsVarInt lastIndex = jsvGetIntegerAndUnLock(jsvObjectGetChild(parent, "lastIndex", 0));
-  JsVar *regex = jsvObjectGetChild(parent, "source", 0);
-  if (!jsvIsString(regex)) {
-    jsvUnLock2(str,regex);
-    return 0;
-  }
-  size_t regexLen = jsvGetStringLength(regex);
-  char *regexPtr = (char *)alloca(regexLen+1);
-  if (!regexPtr) {
-    jsvUnLock2(str,regex);
-    return 0;
+  size_t caps[2+MAX_GROUPS*2];
+  int groups = 0;
+  JsVar *rmatch = 0;
+  if (str && lastIndex>=0 && reMatch(parent, str, (size_t)lastIndex, caps, &groups)) {
+    rmatch = jsvNewEmptyArray();
   }
-  jsvGetString(regex, regexPtr, regexLen+1);
-  jsvUnLock(regex);
-  JsVar *rmatch = match(regexPtr, str, (size_t)lastIndex, jswrap_regexp_hasFlag(parent,'i'));
-  jsvUnLock(str);
-  if (!rmatch) {
-    rmatch = jsvNewWithFlags(JSV_NULL);
-    lastIndex = 0;
-  } else {
+  if (rmatch) {
+    int i;
+    for (i=0;i<=groups;i++) {
+      if (caps[i*2]!=REGEXP_NO_POS && caps[i*2+1]!=REGEXP_NO_POS)
+        jsvArrayPushAndUnLock(rmatch, jsvNewFromStringVar(str, caps[i*2], caps[i*2+1]-caps[i*2]));
+      else
+        jsvArrayPush(rmatch, 0); // undefined - group didn't match
+    }
+    jsvObjectSetChildAndUnLock(rmatch, "index", jsvNewFromInteger((JsVarInt)caps[0]));
+    jsvObjectSetChild(rmatch, "input", str);
     // if it's global, set lastIndex
-    if (jswrap_regexp_hasFlag(parent,'g')) {
-      JsVar *matchStr = jsvGetArrayItem(rmatch,0);
-      lastIndex = jsvGetIntegerAndUnLock(jsvObjectGetChild(rmatch, "index", 0)) +
-                  (JsVarInt)jsvGetStringLength(matchStr);
-      jsvUnLock(matchStr);
-    } else
+    if (jswrap_regexp_hasFlag(parent,'g'))
+      lastIndex = (JsVarInt)caps[1];
+    else
       lastIndex = 0;
+  } else {
+    rmatch = jsvNewWithFlags(JSV_NULL);
+    lastIndex = 0;
   }
+  jsvUnLock(str);
   jsvObjectSetChildAndUnLock(parent, "lastIndex", jsvNewFromInteger(lastIndex));
   return rmatch;
 }
@@ -382,10 +776,15 @@ JsVar *jswrap_regexp_exec(JsVar *parent, JsVar *arg) {
 }
 Test this regex on a string - returns `true` on a successful match, or `false` otherwise
  */
-bool jswrap_regexp_test(JsVar *parent, JsVar *str) {
-  JsVar *v = jswrap_regexp_exec(parent, str);
-  bool r = v && !jsvIsNull(v);
-  jsvUnLock(v);
+bool jswrap_regexp_test(JsVar *parent, JsVar *arg) {
+  // Like exec, but we don't need to create the result array
+  JsVar *str = jsvAsString(arg);
+  JsVarInt lastIndex = jsvGetIntegerAndUnLock(jsvObjectGetChild(parent, "lastIndex", 0));
+  size_t matchStart, matchEnd;
+  bool r = str && lastIndex>=0 && jswrap_regexp_matchRange(parent, str, (size_t)lastIndex, &matchStart, &matchEnd);
+  jsvUnLock(str);
+  lastIndex = (r && jswrap_regexp_hasFlag(parent,'g')) ? (JsVarInt)matchEnd : 0;
+  jsvObjectSetChildAndUnLock(parent, "lastIndex", jsvNewFromInteger(lastIndex));
   return r;
 }
 
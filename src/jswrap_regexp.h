@@ -17,5 +17,9 @@ JsVar *jswrap_regexp_constructor(JsVar *str, JsVar *flags);
 JsVar *jswrap_regexp_exec(JsVar *parent, JsVar *str);
 bool jswrap_regexp_test(JsVar *parent, JsVar *str);
 
+/** Match a RegExp against a string from startIndex without creating a result
+ * array. On success returns true and sets the start and end of the whole match */
+bool jswrap_regexp_matchRange(JsVar *regexp, JsVar *str, size_t startIndex, size_t *matchStart, size_t *matchEnd);
+
 /// Does this regex have the given flag?
 bool jswrap_regexp_hasFlag(JsVar *parent, char flag);
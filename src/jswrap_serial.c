@@ -385,6 +385,10 @@ bool jswrap_serial_idle() {
 #endif
 }
 
+static void _jswrap_serial_print_buffer(unsigned char *data, unsigned int len, void *callbackData) {
+  jshTransmitBuffer(*(IOEventFlags*)callbackData, data, len);
+}
+
 void _jswrap_serial_print(JsVar *parent, JsVar *arg, bool isPrint, bool newLine) {
   serial_sender serialSend;
   serial_sender_data serialSendData;
@@ -392,7 +396,11 @@ void _jswrap_serial_print(JsVar *parent, JsVar *arg, bool isPrint, bool newLine)
     return;
 
   if (isPrint) arg = jsvAsString(arg);
-  jsvIterateCallback(arg, (void (*)(int,  void *))serialSend, (void*)&serialSendData);
+  if (serialSend == jsserialHardwareFunc) {
+    // hardware devices can take whole blocks of data at once
+    jsvIterateBufferCallback(arg, _jswrap_serial_print_buffer, (void*)&serialSendData);
+  } else
+    jsvIterateCallback(arg, (void (*)(int,  void *))serialSend, (void*)&serialSendData);
   if (isPrint) jsvUnLock(arg);
   if (newLine) {
     serialSend((unsigned char)'\r', &serialSendData);
@@ -326,6 +326,46 @@ int jswrap_storage_getFree() {
   return (int)jsfGetFreeSpace(0,true);
 }
 
+/*JSON{
+  "type" : "staticmethod",
+  "ifndef" : "SAVE_ON_FLASH",
+  "class" : "Storage",
+  "name" : "getStats",
+  "generate" : "jswrap_storage_getStats",
+  "return" : ["JsVar","An object containing info about the file index"]
+}
+Return statistics about the index that Storage keeps in RAM
+to find files without scanning all of flash:
+
+```
+{
+  indexSize,   // how many entries the index can hold
+  indexUsed,   // how many files are in the index
+  indexHits,   // how many file lookups found the file using the index
+  indexNotFound, // how many file lookups used the index to find there was no such file
+  indexMisses, // how many file lookups had to scan flash
+}
+```
+
+The index is rebuilt the first time a file is looked up after
+`compact` or `eraseAll`. If there are too many files to fit in
+it, all lookups scan flash.
+ */
+#ifndef SAVE_ON_FLASH
+JsVar *jswrap_storage_getStats() {
+  JsfIndexStats stats;
+  jsfGetIndexStats(&stats);
+  JsVar *o = jsvNewObject();
+  if (!o) return 0;
+  jsvObjectSetChildAndUnLock(o, "indexSize", jsvNewFromInteger((JsVarInt)stats.size));
+  jsvObjectSetChildAndUnLock(o, "indexUsed", jsvNewFromInteger((JsVarInt)stats.used));
+  jsvObjectSetChildAndUnLock(o, "indexHits", jsvNewFromInteger((JsVarInt)stats.hits));
+  jsvObjectSetChildAndUnLock(o, "indexNotFound", jsvNewFromInteger((JsVarInt)stats.notFound));
+  jsvObjectSetChildAndUnLock(o, "indexMisses", jsvNewFromInteger((JsVarInt)stats.misses));
+  return o;
+}
+#endif
+
 /*JSON{
   "type" : "staticmethod",
   "ifndef" : "SAVE_ON_FLASH",
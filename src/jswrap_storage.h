@@ -26,6 +26,7 @@ void jswrap_storage_compact();
 JsVar *jswrap_storage_list();
 void jswrap_storage_debug();
 int jswrap_storage_getFree();
+JsVar *jswrap_storage_getStats();
 
 JsVar *jswrap_storage_open(JsVar *name, JsVar *mode);
 JsVar *jswrap_storagefile_read(JsVar *f, int len);
@@ -253,22 +253,21 @@ JsVar *jswrap_string_match(JsVar *parent, JsVar *subStr) {
       return match;
     }
 
-    // global
+    // global - we only need the matched ranges, not the groups
+    jsvUnLock(match);
     JsVar *array = jsvNewEmptyArray();
     if (!array) return 0; // out of memory
-    while (match && !jsvIsNull(match)) {
-      // get info about match
-      JsVar *matchStr = jsvGetArrayItem(match,0);
-      JsVarInt idx = jsvGetIntegerAndUnLock(jsvObjectGetChild(match,"index",0));
-      JsVarInt len = (JsVarInt)jsvGetStringLength(matchStr);
-      int last = idx+len;
-      jsvArrayPushAndUnLock(array, matchStr);
-      // search again
-      jsvUnLock(match);
-      jsvObjectSetChildAndUnLock(subStr, "lastIndex", jsvNewFromInteger(last));
-      match = jswrap_regexp_exec(subStr, parent);
+    size_t idx = 0, matchStart, matchEnd;
+    size_t len = jsvGetStringLength(parent);
+    while (idx<=len && jswrap_regexp_matchRange(subStr, parent, idx, &matchStart, &matchEnd)) {
+      jsvArrayPushAndUnLock(array, jsvNewFromStringVar(parent, matchStart, matchEnd-matchStart));
+      // search again - stepping on if the match was empty
+      idx = (matchEnd>matchStart) ? matchEnd : matchEnd+1;
+    }
+    if (jsvGetArrayLength(array)==0) {
+      jsvUnLock(array);
+      array = jsvNewNull();
     }
-    jsvUnLock(match);
     jsvObjectSetChildAndUnLock(subStr, "lastIndex", jsvNewFromInteger(0));
     return array;
   }
@@ -334,9 +333,12 @@ JsVar *jswrap_string_replace(JsVar *parent, JsVar *subStr, JsVar *newSubStr) {
         unsigned int argCount = 0;
         JsVar *args[13];
         args[argCount++] = jsvLockAgain(matchStr);
-        JsVar *v;
-        while ((v = jsvGetArrayItem(match, (JsVarInt)argCount)))
-          args[argCount++] = v;
+        // groups that didn't match are undefined, but still passed as arguments
+        JsVarInt groups = jsvGetArrayLength(match);
+        while ((JsVarInt)argCount < groups && argCount < 11) {
+          args[argCount] = jsvGetArrayItem(match, (JsVarInt)argCount);
+          argCount++;
+        }
         args[argCount++] = jsvObjectGetChild(match,"index",0);
         args[argCount++] = jsvObjectGetChild(match,"input",0);
         JsVar *result = jsvAsStringAndUnLock(jspeFunctionCall(replace, 0, 0, false, (JsVarInt)argCount, args));
@@ -351,11 +353,10 @@ JsVar *jswrap_string_replace(JsVar *parent, JsVar *subStr, JsVar *newSubStr) {
           if (ch=='$') {
             jsvStringIteratorNext(&src);
             ch = jsvStringIteratorGetChar(&src);
-            JsVar *group = 0;
-            if (ch>'0' && ch<='9')
-              group = jsvGetArrayItem(match, ch-'0');
-            if (group) {
-              jsvStringIteratorAppendString(&dst, group, 0);
+            if (ch>'0' && ch<='9' && ch-'0' < jsvGetArrayLength(match)) {
+              // group is undefined (so we add nothing) if it didn't match
+              JsVar *group = jsvGetArrayItem(match, ch-'0');
+              if (group) jsvStringIteratorAppendString(&dst, group, 0);
               jsvUnLock(group);
             } else {
               jsvStringIteratorAppend(&dst, '$');
@@ -369,6 +370,7 @@ JsVar *jswrap_string_replace(JsVar *parent, JsVar *subStr, JsVar *newSubStr) {
         jsvStringIteratorFree(&src);
       }
       JsVarInt lastIndex = 1+(JsVarInt)jsvStringIteratorGetIndex(&dst);
+      if (len==0) lastIndex++; // empty match - step past the next character or we'd match here forever
       jsvStringIteratorAppendString(&dst, str, (size_t)(idx+len));
       jsvStringIteratorFree(&dst);
       jsvUnLock2(str,matchStr);
@@ -512,26 +514,21 @@ JsVar *jswrap_string_split(JsVar *parent, JsVar *split) {
 #ifndef SAVE_ON_FLASH
   // Use RegExp if one is passed in
   if (jsvIsInstanceOf(split, "RegExp")) {
-    unsigned int last = 0;
-    JsVar *match;
-    jsvObjectSetChildAndUnLock(split, "lastIndex", jsvNewFromInteger(0));
-    match = jswrap_regexp_exec(split, parent);
-    while (match && !jsvIsNull(match)) {
-      // get info about match
-      JsVar *matchStr = jsvGetArrayItem(match,0);
-      JsVarInt idx = jsvGetIntegerAndUnLock(jsvObjectGetChild(match,"index",0));
-      JsVarInt len = (JsVarInt)jsvGetStringLength(matchStr);
-      jsvUnLock(matchStr);
-      // do the replacement
-      jsvArrayPushAndUnLock(array, jsvNewFromStringVar(parent, (size_t)last, (size_t)(idx-last)));
-      last = idx+len;
+    size_t last = 0, idx = 0, matchStart, matchEnd;
+    size_t len = jsvGetStringLength(parent);
+    while (idx<len && jswrap_regexp_matchRange(split, parent, idx, &matchStart, &matchEnd)) {
+      if (matchEnd==matchStart) { // empty match - split between characters
+        if (matchStart>=len) break;
+        if (matchStart==last) {
+          idx = matchStart+1;
+          continue;
+        }
+      }
+      jsvArrayPushAndUnLock(array, jsvNewFromStringVar(parent, last, matchStart-last));
+      last = matchEnd;
       // search again
-      jsvUnLock(match);
-      jsvObjectSetChildAndUnLock(split, "lastIndex", jsvNewFromInteger(last));
-      match = jswrap_regexp_exec(split, parent);
+      idx = (matchEnd>matchStart) ? matchEnd : matchEnd+1;
     }
-    jsvUnLock(match);
-    jsvObjectSetChildAndUnLock(split, "lastIndex", jsvNewFromInteger(0));
     // add remaining string after last match
     if (last<=jsvGetStringLength(parent))
       jsvArrayPushAndUnLock(array, jsvNewFromStringVar(parent, (size_t)last, JSVAPPENDSTRINGVAR_MAXLENGTH));
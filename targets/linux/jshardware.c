@@ -31,12 +31,21 @@
 #include "jsutils.h"
 #include "jsparse.h"
 #include "jsinteractive.h"
+#ifdef USE_NET
+#include "network_linux.h"
+#endif
 
 #include <pthread.h>
 
 #define FAKE_FLASH_FILENAME  "espruino.flash"
 #define FAKE_FLASH_BLOCKSIZE FLASH_PAGE_SIZE
 #define FAKE_FLASH_BLOCKS    (FLASH_TOTAL/FLASH_PAGE_SIZE)
+#ifndef __MINGW32__
+#define FAKE_FLASH_MMAP // memory-map the flash file rather than reading/writing it each time
+#include <sys/mman.h>
+static unsigned char *jshFlashMapping = 0; ///< The flash file, memory-mapped
+static bool jshFlashMappingFailed = false;
+#endif
 
 #ifdef DEBUG
 #define FAKE_FLASH_DBG(...) jsiConsolePrintf(__VA_ARGS__)
@@ -277,7 +286,7 @@ void jshInputThread() {
       int i;
       for (i=0;i<=EV_DEVICE_MAX;i++) {
         if (ioDevices[i]) {
-          char buf[32];
+          char buf[256];
           // read can return -1 (EAGAIN) because O_NONBLOCK is set
           int bytes = (int)read(ioDevices[i], buf, sizeof(buf));
           if (bytes>0) {
@@ -291,10 +300,14 @@ void jshInputThread() {
     // Write any data we have
     IOEventFlags device = jshGetDeviceToTransmit();
     while (device != EV_NONE) {
-      char ch = (char)jshGetCharToTransmit(device);
-      //printf("[[ '%c'\r\n", ch);
+      // gather everything waiting for this device so it goes out in one write
+      char buf[TXBUFFERMASK+1];
+      int bytes = 0;
+      while (bytes<(int)sizeof(buf) && jshGetDeviceToTransmit()==device)
+        buf[bytes++] = (char)jshGetCharToTransmit(device);
+      //printf("[[ %d bytes\r\n", bytes);
       if (ioDevices[device]) {
-        write(ioDevices[device], &ch, 1);
+        write(ioDevices[device], buf, (size_t)bytes);
         shortSleep = true;
       }
       device = jshGetDeviceToTransmit();
@@ -393,6 +406,13 @@ void jshKill() {
     if (gpioState[i] != JSHPINSTATE_UNDEFINED)
       sysfs_write_int(SYSFS_GPIO_DIR"/unexport", i);
 #endif
+#ifdef FAKE_FLASH_MMAP
+  if (jshFlashMapping) {
+    munmap(jshFlashMapping, FLASH_TOTAL);
+    jshFlashMapping = 0;
+  }
+  jshFlashMappingFailed = false;
+#endif
 }
 
 void jshIdle() {
@@ -811,8 +831,13 @@ bool jshSleep(JsSysTime timeUntilWake) {
     usecs=1000; // don't sleep much if we have watches - we need to keep polling them
   if (usecs > 50000)
     usecs = 50000; // don't want to sleep too much (user input/HTTP/etc)
-  if (usecs >= 1000)  
-    jshDelayMicroseconds(usecs);
+  if (usecs >= 1000) {
+#ifdef USE_NET
+    // If we have sockets open, wait on them so we wake as soon as there's I/O
+    if (!net_linux_wait((int)(usecs/1000)))
+#endif
+      jshDelayMicroseconds(usecs);
+  }
   return true;
 }
 
@@ -882,8 +907,34 @@ static FILE *jshFlashOpenFile(bool dontCreate) {
   }
   return f;
 }
+
+#ifdef FAKE_FLASH_MMAP
+/// Memory-map the flash file (creating it if 'create' is set). Returns 0 if there's no file or it can't be mapped
+static unsigned char *jshFlashGetMapping(bool create) {
+  if (jshFlashMapping || jshFlashMappingFailed) return jshFlashMapping;
+  FILE *f = jshFlashOpenFile(!create);
+  if (!f) return 0;
+  void *p = mmap(NULL, FLASH_TOTAL, PROT_READ|PROT_WRITE, MAP_SHARED, fileno(f), 0);
+  fclose(f); // the mapping stays valid after the file is closed
+  if (p==MAP_FAILED) {
+    jshFlashMappingFailed = true; // fall back to file accesses
+    return 0;
+  }
+  jshFlashMapping = (unsigned char*)p;
+  return jshFlashMapping;
+}
+#endif
 void jshFlashErasePage(uint32_t addr) {
   FAKE_FLASH_DBG("FlashErasePage 0x%08x\n", addr);
+#ifdef FAKE_FLASH_MMAP
+  unsigned char *flash = jshFlashGetMapping(false);
+  if (flash) {
+    uint32_t startAddr, pageSize;
+    if (jshFlashGetPage(addr, &startAddr, &pageSize))
+      memset(&flash[startAddr-FLASH_START], 0xFF, pageSize);
+    return;
+  }
+#endif
   FILE *f = jshFlashOpenFile(true);
   if (!f) return; // if no file and we're erasing, we don't have to do anything
   uint32_t startAddr, pageSize;
@@ -906,6 +957,13 @@ void jshFlashRead(void *buf, uint32_t addr, uint32_t len) {
     return;
   }
   addr -= FLASH_START;
+#ifdef FAKE_FLASH_MMAP
+  unsigned char *flash = jshFlashGetMapping(false);
+  if (flash) {
+    memcpy(buf, &flash[addr], len);
+    return;
+  }
+#endif
 
   FILE *f = jshFlashOpenFile(true);
   if (!f) { // no file, so it's all 0xFF
@@ -935,6 +993,15 @@ void jshFlashWrite(void *buf, uint32_t addr, uint32_t len) {
     return;
   }
   addr -= FLASH_START;
+#ifdef FAKE_FLASH_MMAP
+  unsigned char *flash = jshFlashGetMapping(true);
+  if (flash) {
+    // like NOR flash, writing can only clear bits
+    for (i=0;i<len;i++)
+      flash[addr+i] &= ((unsigned char*)buf)[i];
+    return;
+  }
+#endif
 
   FILE *f = jshFlashOpenFile(false);
   if (!f) return;
@@ -956,8 +1023,14 @@ void jshFlashWrite(void *buf, uint32_t addr, uint32_t len) {
   fclose(f);
 }
 
-// No - we can't memory-map the flash memory under Linux (well, we could but for testing it's handy not to)
 size_t jshFlashGetMemMapAddress(size_t ptr) {
+#ifdef FAKE_FLASH_MMAP
+  if (ptr>=FLASH_START && ptr<FLASH_START+FLASH_TOTAL) {
+    unsigned char *flash = jshFlashGetMapping(false);
+    if (flash) return (size_t)&flash[ptr-FLASH_START];
+  }
+#endif
+  // If we couldn't map the flash file we can't return a pointer to it
   return 0;
 }
 
@@ -0,0 +1,46 @@
+// Indexed access to arrays while they're being modified
+
+Array.prototype.equals = function(arr) {
+  if (this.length != arr.length) return false;
+  for (var i=0;i<this.length;i++)
+    if (this[i]!==arr[i]) return false;
+  return true;
+}
+
+var fails = 0;
+var a = [];
+for (var i=0;i<200;i++) a.push(i*2);
+// forwards, backwards and strided access
+var sum = 0;
+for (var i=0;i<a.length;i++) sum += a[i];
+if (sum!=39800) fails |= 1;
+sum = 0;
+for (var i=a.length-1;i>=0;i--) sum += a[i];
+if (sum!=39800) fails |= 2;
+if (a[150]!=300 || a[20]!=40 || a[149]!=298 || a[21]!=42) fails |= 4;
+// renumbering keeps indices right
+a[100]; a.shift();
+if (a[100]!=202 || a[99]!=200) fails |= 8;
+a[50]; a.splice(50,2);
+if (a[50]!=106 || a[49]!=100) fails |= 16;
+a[10]; a.reverse();
+if (a[0]!=398 || a[a.length-1]!=2) fails |= 32;
+// removing the element we last accessed
+var b = [0,1,2,3,4,5];
+b[3]; b.splice(3,1);
+if (!b.equals([0,1,2,4,5])) fails |= 64;
+b[1]; delete b[1];
+if (b[1]!==undefined || b[2]!=2) fails |= 128;
+// sparse arrays and non-integer keys
+var c = [];
+c[5] = 5; c[100] = 100; c.foo = "bar";
+if (c[5]!=5 || c[50]!==undefined || c[100]!=100 || c[99]!==undefined || c.foo!="bar") fails |= 256;
+// assign through index
+for (var i=0;i<c.length;i++) c[i] = i;
+if (c[5]!=5 || c[50]!=50 || c.length!=101) fails |= 512;
+// arrays that get freed and reallocated
+for (var j=0;j<10;j++) {
+  var d = [j,j+1,j+2];
+  if (d[1]!=j+1) fails |= 1024;
+}
+result = fails==0;
@@ -0,0 +1,47 @@
+// Array.sort should be stable, cope with sorted/reversed data, put undefined
+// at the end and give the same results on the numeric fast path
+
+// stable
+var o = [];
+for (var i=0;i<50;i++) o.push({k:i%4, i:i});
+o.sort(function(a,b) { return a.k-b.k; });
+var stable = true;
+for (i=1;i<o.length;i++)
+  if (o[i-1].k>o[i].k || (o[i-1].k==o[i].k && o[i-1].i>o[i].i)) stable = false;
+
+// already sorted and reversed (worst cases for a naive quicksort)
+var sorted = [], reversed = [];
+for (i=0;i<1000;i++) { sorted.push(i); reversed.push(1000-i); }
+sorted.sort((a,b)=>a-b);
+reversed.sort((a,b)=>a-b);
+var bigOk = sorted[0]==0 && sorted[999]==999 && reversed[0]==1 && reversed[999]==1000;
+
+// the numeric fast path only applies to numbers
+var mixed = [3,"10",1,"2"].sort((a,b)=>a-b).join(",");
+var desc = [1,5,3].sort(function(x, y) { return y - x; }).join(",");
+// default sort compares numbers as strings
+var strs = [10,9,1,100].sort().join(",");
+var undef = [3,undefined,1].sort();
+
+// the same object more than once
+var x = {n:1}, y = {n:2}, many = [];
+for (i=0;i<40;i++) many.push((i&1)?x:y);
+many.sort((a,b)=>a.n-b.n);
+
+// the values must survive a GC or defrag inside the compare function
+var typed = new Int16Array([5,3,9,1,7,2,8,4,6,0,11,10]);
+typed.sort(function(a,b) { process.memory(); return a-b; });
+var typedOk = typed.join(",")=="0,1,2,3,4,5,6,7,8,9,10,11";
+var objs = [];
+for (i=0;i<12;i++) objs.push({n:(i*5)%12});
+objs.sort(function(a,b) { E.defrag(); return a.n-b.n; });
+var defragOk = objs.every((o,i)=>o.n==i);
+// ... even if the values are removed from the array
+var popped = [];
+for (i=0;i<12;i++) popped.push({n:12-i});
+popped.sort(function(a,b) { popped.pop(); process.memory(); return a.n-b.n; });
+var poppedOk = popped.length==0;
+
+result = stable && typedOk && defragOk && poppedOk && bigOk && mixed=="1,2,3,10" && desc=="5,3,1" && strs=="1,10,100,9" &&
+         undef[0]==1 && undef[1]==3 && undef[2]===undefined && undef.length==3 &&
+         many[0]===x && many[19]===x && many[20]===y;
@@ -0,0 +1,31 @@
+// Events are queued in a fixed-size native ring, falling back to JsVars when
+// it's full or an event has too many arguments. Check they still run in order,
+// and that anything only referenced from the queue survives GC and defrag
+
+var order = [];
+var ok = true;
+var o = {};
+o.on('ev', function(n, a, b, c) {
+  order.push(n);
+  // data only referenced by queued events must still be intact
+  if (a!==undefined && (a.n!=n || a.s!="data"+n)) ok = false;
+  if (c!==undefined && c!=n*3) ok = false;
+});
+
+var N = 100;
+for (var i=0;i<N;i++) {
+  if (i%10==7) o.emit('ev', i, {n:i,s:"data"+i}, i*2, i*3); // too many args for the ring
+  else o.emit('ev', i, {n:i,s:"data"+i});
+}
+var stats = process.memory(); // full GC with events queued
+E.defrag(); // move vars that are only referenced by the queue
+
+setTimeout(function() {
+  var inOrder = order.length==N;
+  for (var i=0;i<order.length;i++)
+    if (order[i]!=i) inOrder = false;
+  var after = process.memory();
+  result = ok && inOrder &&
+           stats.eventqueue==N && stats.eventmax>=N && stats.eventoverflow>0 &&
+           after.eventqueue==0;
+}, 1);
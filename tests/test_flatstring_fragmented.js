@@ -0,0 +1,18 @@
+// Test that flat strings (used for ArrayBuffers) can be allocated when the free list is out of order
+
+var live = [], bufs = [], ok = true;
+for (var r=0;r<100;r++) {
+  var tmp = [];
+  for (var i=0;i<30;i++) tmp.push("s"+i);
+  live.push({r:r});
+  tmp = undefined; // freed in reverse order, onto the front of the free list
+  var u = new Uint8Array(100+r);
+  if (!E.getAddressOf(u.buffer,true)) ok = false; // not flat
+  u.fill(r&255);
+  bufs.push(u);
+  if (bufs.length>10) bufs.shift(); // free some flat strings too
+}
+bufs.forEach(function(u) {
+  for (var i=0;i<u.length;i++) if (u[i]!=((u.length-100)&255)) ok = false;
+});
+result = ok && live.length==100 && live[99].r==99;
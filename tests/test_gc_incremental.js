@@ -0,0 +1,37 @@
+// Test that incremental garbage collection (which runs a bit at a time from idle)
+// doesn't free things that are moved around while it is running
+var A = {list:[]}, B = {list:[]};
+for (var i=0;i<30;i++) A.list.push({id:i, child:{v:"v"+i, arr:[i,i+1]}});
+var n=0;
+function check() {
+  var all = A.list.concat(B.list);
+  if (all.length!=30) return false;
+  var seen = {};
+  for (var i=0;i<all.length;i++) {
+    var o = all[i];
+    if (o.child.v!="v"+o.id || o.child.arr[1]!=o.id+1) return false;
+    seen[o.id]=1;
+  }
+  return Object.keys(seen).length==30;
+}
+function tick() {
+  // garbage: cycles, strings and flat strings
+  var g = {s:"garbage string "+n, u:new Uint8Array(40+(n%60))}; g.self = g; g.u[0]=n;
+  // move an object between the two lists, removing the only other reference
+  var from = (n&1) ? A : B, to = (n&1) ? B : A;
+  if (from.list.length) {
+    var o = from.list.shift();
+    to.list.push(o);
+    // swap children around so old (maybe unmarked) children get linked into new places
+    var j = n % to.list.length;
+    var t = to.list[j].child; to.list[j].child = o.child; o.child = t;
+    var tid = to.list[j].id; to.list[j].id = o.id; o.id = tid;
+  }
+  if (++n<10000) setTimeout(tick,0);
+  else {
+    var ok = check();
+    var m = process.memory();
+    result = ok && m.gccycles>0;
+  }
+}
+tick();
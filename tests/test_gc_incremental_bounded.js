@@ -0,0 +1,20 @@
+// Test that each step of incremental garbage collection only does a bounded
+// amount of work, rather than going through all of memory at once
+var keep = [];
+for (var i=0;i<20;i++) keep.push({id:i, s:"keep"+i});
+var total = process.memory().total;
+var n=0;
+function tick() {
+  // lots of garbage (in a cycle, so only the GC can free it)
+  var g = [];
+  for (var i=0;i<3;i++) g.push({a:i, s:"garbage"+i});
+  g.push(g);
+  if (++n<4000) setTimeout(tick,0);
+  else {
+    var m = process.memory();
+    var ok = keep.every((k,i)=>k.id==i && k.s=="keep"+i);
+    result = ok && m.gccycles>0 && m.gcmaxwork>0 && m.gcmaxwork<total/4;
+    if (!result) print(m.gccycles, m.gcmaxwork, total);
+  }
+}
+tick();
@@ -0,0 +1,59 @@
+// Unrotated drawImage writes whole rows with gfx.blit when it can get a pointer
+// to the image data (eg. a flat string). Check this draws exactly the same as
+// the pixel-by-pixel path that's used for non-flat images
+
+function imageData(w,h,bpp) {
+  var s = "";
+  for (var i=0;i<(w*h*bpp+7)>>3;i++) s += String.fromCharCode((i*73+17)&255);
+  return s;
+}
+function hdr(w,h,bpp,transparent) {
+  return String.fromCharCode(w,h,bpp|(transparent!==undefined?128:0)) +
+         (transparent!==undefined?String.fromCharCode(transparent):"");
+}
+function render(opts, img, imgOpts) {
+  var g = Graphics.createArrayBuffer(31, 16, opts.bpp, opts.flags);
+  g.setBgColor(opts.bg||0);
+  g.clear();
+  g.setColor(opts.fg===undefined?-1:opts.fg);
+  if (opts.clip) g.setClipRect(2,1,25,12);
+  g.drawImage(img, opts.x, opts.y, imgOpts);
+  return E.toString(new Uint8Array(g.buffer)) + JSON.stringify(g.getModified());
+}
+
+var fails = 0, tests = 0;
+[1,2,4,8,16].forEach(function(bpp) {
+  [{}, {msb:true}, {zigzag:true}, {vertical_byte:true}].forEach(function(flags) {
+    if (flags.vertical_byte && bpp!=1) return;
+    [1,2,4,8,16].forEach(function(ibpp) {
+      [undefined, 1].forEach(function(transparent) {
+        [[0,0],[3,2],[-3,-2],[20,13]].forEach(function(pos, n) {
+          var w = 23, h = 11;
+          var data = hdr(w,h,ibpp,transparent) + imageData(w,h,ibpp);
+          var flat = E.toString(data);
+          if (E.getAddressOf(data,true) || !E.getAddressOf(flat,true)) throw new Error("Expected non-flat/flat strings");
+          var opts = { bpp:bpp, flags:flags, x:pos[0], y:pos[1], clip:n==1, fg:3, bg:1 };
+          tests++;
+          if (render(opts, flat)!=render(opts, data)) {
+            fails++;
+            console.log("Mismatch", JSON.stringify(opts), ibpp, transparent);
+          }
+          // object form, with a palette and scale:1
+          if (ibpp<=4 && ibpp!=1) {
+            var pal = new Uint16Array(E.toArrayBuffer(E.toString(new Uint8Array(2<<ibpp)))); // must be flat
+            for (var i=0;i<pal.length;i++) pal[i] = (i*0x1234+0x55)&0xFFFF;
+            var obj = function(d) { return { width:w, height:h, bpp:ibpp, transparent:transparent, palette:pal,
+                                            buffer:E.toArrayBuffer(d) }; };
+            var idata = imageData(w,h,ibpp);
+            tests++;
+            if (render(opts, obj(E.toString(idata)), {scale:1})!=render(opts, obj(idata), {scale:1})) {
+              fails++;
+              console.log("Palette mismatch", JSON.stringify(opts), ibpp, transparent);
+            }
+          }
+        });
+      });
+    });
+  });
+});
+result = tests>500 && fails==0;
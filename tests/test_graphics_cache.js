@@ -0,0 +1,36 @@
+// Graphics state is cached natively between calls - check that state is kept
+// for more instances than the cache holds, across GC/defrag and idle
+
+var gs = [];
+for (var i=0;i<4;i++) gs.push(Graphics.createArrayBuffer(8,8,8));
+// interleave calls so instances get evicted from the cache
+for (i=0;i<4;i++) gs[i].setColor(i+1);
+for (i=0;i<4;i++) gs[i].setFontVector(10+i);
+for (i=0;i<4;i++) gs[i].setPixel(i,i);
+var ok = true;
+for (i=0;i<4;i++)
+  if (gs[i].getColor()!=i+1 || gs[i].getPixel(i,i)!=i+1) ok = false;
+
+// replace the buffer, and draw after memory has been moved about
+gs[0].buffer = new ArrayBuffer(64);
+process.memory();
+E.defrag();
+gs[0].setPixel(1,1);
+if (new Uint8Array(gs[0].buffer)[9]!=1) ok = false;
+
+// replace the buffer of an instance that's definitely cached
+var g = Graphics.createArrayBuffer(8,8,8);
+g.setPixel(0,0,1);
+g.buffer = new ArrayBuffer(64);
+g.setPixel(2,0,1);
+if (new Uint8Array(g.buffer)[2]!=1 || new Uint8Array(g.buffer)[0]!=0) ok = false;
+
+setTimeout(function() {
+  // state must still be there after the cache has been written back
+  for (var i=1;i<4;i++) {
+    var m = gs[i].getModified(true);
+    if (gs[i].getColor()!=i+1 || !m || m.x1!=i || m.y1!=i) ok = false;
+    if (gs[i].stringWidth("X")==gs[(i%3)+1].stringWidth("X") && i!=(i%3)+1) ok = false;
+  }
+  result = ok;
+}, 1);
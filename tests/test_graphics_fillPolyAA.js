@@ -0,0 +1,116 @@
+// fillPolyAA, and vector font characters drawn from the glyph cache
+
+var ok = true;
+function dump(g) {
+  var s = "";
+  for (var y=0;y<g.getHeight();y++)
+    for (var x=0;x<g.getWidth();x++)
+      s += g.getPixel(x,y)+",";
+  return s;
+}
+
+// A square with corners on pixel centres - edges are half covered, corners a quarter
+var g = Graphics.createArrayBuffer(14,14,24);
+g.setColor(1,1,1);
+g.fillPolyAA([2,2,10,2,10,10,2,10]);
+ok &= g.getPixel(1,5)==0 && g.getPixel(11,5)==0 && g.getPixel(5,1)==0 && g.getPixel(5,11)==0;
+ok &= g.getPixel(2,2)==0x3F3F3F && g.getPixel(10,2)==0x3F3F3F && g.getPixel(2,10)==0x3F3F3F && g.getPixel(10,10)==0x3F3F3F;
+ok &= g.getPixel(5,2)==0x7F7F7F && g.getPixel(5,10)==0x7F7F7F && g.getPixel(2,5)==0x7F7F7F && g.getPixel(10,5)==0x7F7F7F;
+ok &= g.getPixel(3,3)==0xFFFFFF && g.getPixel(9,9)==0xFFFFFF;
+var m = g.getModified();
+ok &= m.x1==2 && m.y1==2 && m.x2==10 && m.y2==10;
+
+// Edges blend with what's underneath, and each channel is blended separately
+g.clear();
+g.setColor("#6400C8");
+g.fillRect(0,0,13,13);
+g.setColor("#C80064");
+g.fillPolyAA([2,2,10,2,10,10,2,10]);
+ok &= g.getPixel(5,2)==0x960096 && g.getPixel(2,2)==0x7D00AF && g.getPixel(5,5)==0xC80064 && g.getPixel(1,1)==0x6400C8;
+
+// 32 bit is the same as 24 (keeping the alpha)
+g = Graphics.createArrayBuffer(14,14,32);
+g.setColor(0,0,1);
+g.fillRect(0,0,13,13);
+g.setColor(1,0,0);
+g.fillPolyAA([2,2,10,2,10,10,2,10]);
+ok &= (g.getPixel(5,2)&0xFFFFFF)==0x7F0080 && (g.getPixel(5,2)>>>24)==0xFF;
+ok &= (g.getPixel(5,5)&0xFFFFFF)==0xFF0000 && (g.getPixel(1,1)&0xFFFFFF)==0x0000FF;
+
+// 16 bit colors are blended per channel
+g = Graphics.createArrayBuffer(14,14,16);
+g.setColor(0,0,1);
+g.fillRect(0,0,13,13);
+g.setColor(1,0,0);
+g.fillPolyAA([2,2,10,2,10,10,2,10]);
+var c = g.getPixel(5,2);
+ok &= (c>>11)==15 && ((c>>5)&63)==0 && (c&31)==16;
+
+// 4 and 8 bit are paletted - edges are blended and then the nearest palette color used
+[4,8].forEach(function(bpp) {
+  g = Graphics.createArrayBuffer(14,14,bpp);
+  g.setColor(0,0,0);
+  g.fillRect(0,0,13,13);
+  g.setColor(1,1,1);
+  g.fillPolyAA([2,2,10,2,10,10,2,10]);
+  // convert to 16 bit using the palette so we can see the actual colors
+  var g16 = Graphics.createArrayBuffer(14,14,16);
+  g16.drawImage(g.asImage(),0,0);
+  var edge = g16.getPixel(5,2), inside = g16.getPixel(5,5), outside = g16.getPixel(5,1);
+  var r = edge>>11, gr = (edge>>5)&63, b = edge&31;
+  ok &= inside==0xFFFF && outside==0;
+  ok &= r>4 && r<27 && gr>8 && gr<55 && b>4 && b<27; // something grey
+});
+
+// Clipping is respected
+g = Graphics.createArrayBuffer(20,20,4);
+g.setClipRect(5,5,14,14);
+g.setColor(15);
+g.fillPolyAA([0,0,19,3,16,19,2,17]);
+for (var y=0;y<20;y++)
+  for (var x=0;x<20;x++)
+    if ((x<5 || y<5 || x>14 || y>14) && g.getPixel(x,y)) ok = false;
+ok &= g.getPixel(10,10)==15;
+
+// No anti-aliasing at 1 bit - it's the same as a normal fill
+var poly = [3,1,18,6,12,18,1,12];
+var g1 = Graphics.createArrayBuffer(20,20,1);
+var g2 = Graphics.createArrayBuffer(20,20,1);
+g1.fillPolyAA(poly.slice());
+g2.fillPoly(poly.slice());
+ok &= dump(g1)==dump(g2);
+
+// Vector text drawn again (from the glyph cache) is identical
+g = Graphics.createArrayBuffer(80,40,1);
+g.setFontVector(20);
+g.drawString("8:42",3,5);
+var first = dump(g);
+ok &= first.indexOf("1")>=0;
+g.clear();
+g.drawString("8:42",3,5);
+ok &= dump(g)==first;
+// and moving it just moves the pixels
+g.clear();
+g.drawString("8:42",4,6);
+var moved = true, px = first.split(",");
+for (var y=0;y<39;y++)
+  for (var x=0;x<79;x++)
+    if (g.getPixel(x+1,y+1)!=px[y*80+x]) moved = false;
+ok &= moved;
+// drawn a row at a time into a 16 bit buffer, over a background, and clipped on the left
+g = Graphics.createArrayBuffer(80,40,16);
+g.setBgColor(0x0F0F).clear();
+g.setColor(0x1234).setFontVector(20);
+g.drawString("8:42",3,5);
+var same = true;
+for (var i=0;i<px.length-1;i++)
+  if (g.getPixel(i%80,(i/80)|0) != (px[i]=="1" ? 0x1234 : 0x0F0F)) same = false;
+ok &= same;
+g.clear().drawString("8:42",-5,5);
+var clipped = true;
+for (var y=0;y<40;y++)
+  for (var x=0;x<72;x++)
+    if (g.getPixel(x,y) != (px[y*80+x+8]=="1" ? 0x1234 : 0x0F0F)) clipped = false;
+ok &= clipped;
+
+result = ok;
@@ -0,0 +1,58 @@
+// Graphics keeps a list of separate modified areas for partial flips
+
+function covers(rects, x, y) {
+  return rects.some(function(r) {
+    return x>=r.x1 && x<=r.x2 && y>=r.y1 && y<=r.y2;
+  });
+}
+
+var ok = true;
+var g = Graphics.createArrayBuffer(64,64,8);
+
+// nothing modified
+ok &= g.getModifiedRects(true).length==0;
+
+// two opposite corners stay separate, but getModified still covers both
+g.fillRect(1,1,4,4);
+g.setPixel(60,60);
+var r = g.getModifiedRects();
+ok &= r.length==2;
+ok &= r[0].x1==1 && r[0].y1==1 && r[0].x2==4 && r[0].y2==4;
+ok &= r[1].x1==60 && r[1].y1==60 && r[1].x2==60 && r[1].y2==60;
+var m = g.getModified();
+ok &= m.x1==1 && m.y1==1 && m.x2==60 && m.y2==60;
+
+// drawing next to an area grows it rather than adding a new one
+g.setPixel(5,2);
+r = g.getModifiedRects(true);
+ok &= r.length==2 && r[0].x2==5;
+ok &= g.getModifiedRects().length==0 && g.getModified()===undefined;
+
+// lots of scattered pixels - never more than 4 areas, and every pixel is covered
+var pts = [];
+for (var i=0;i<50;i++) {
+  var x = (i*37)&63, y = (i*23)&63;
+  g.setPixel(x,y);
+  pts.push([x,y]);
+}
+r = g.getModifiedRects(true);
+ok &= r.length>0 && r.length<=4;
+pts.forEach(function(p) { if (!covers(r,p[0],p[1])) ok = false; });
+
+// clearing the screen absorbs everything into one area
+g.setPixel(3,3);
+g.setPixel(50,50);
+g.clear();
+r = g.getModifiedRects(true);
+ok &= r.length==1 && r[0].x1==0 && r[0].y1==0 && r[0].x2==63 && r[0].y2==63;
+
+// areas are in device coordinates, and text/images are tracked too
+g.setRotation(1);
+g.drawString("Hi",0,0);
+var img = E.toString("\x04\x04\x01\xFF\xFF");
+g.drawImage(img,40,40);
+r = g.getModifiedRects(true);
+ok &= r.length==2;
+ok &= covers(r,63,0) && covers(r,23,40);
+
+result = ok;
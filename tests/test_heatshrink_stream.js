@@ -0,0 +1,37 @@
+// Check that streaming heatshrink gives the same results as compress/decompress
+var hs = require("heatshrink");
+var s = "";
+for (var i=0;i<2000;i++) s += String.fromCharCode(i%7==0 ? (i*13)%200 : 65+(i%5));
+var compressed = E.toString(hs.compress(s));
+var ok = E.toString(hs.decompress(compressed))==s;
+
+var out = "", ended = false;
+var c = hs.createCompressor();
+c.on('data', function(d) { out += d; });
+c.on('end', function() { ended = true; });
+for (i=0;i<s.length;i+=150) c.write(s.substr(i,150));
+c.end();
+ok = ok && out==compressed;
+try { c.write("x"); ok = false; } catch (e) { }
+
+var dout = "";
+var d = hs.createDecompressor();
+d.on('data', function(x) { dout += x; });
+for (i=0;i<out.length;i+=33) d.write(out.substr(i,33));
+d.end();
+ok = ok && dout==s;
+
+// with E.pipe, from a StorageFile
+var f = require("Storage");
+f.eraseAll();
+var sf = f.open("hslog","w");
+for (i=0;i<s.length;i+=100) sf.write(s.substr(i,100));
+var pout = "";
+var p = hs.createCompressor();
+p.on('data', function(x) { pout += x; });
+E.pipe(f.open("hslog","r"), p, {chunkSize:64});
+
+setTimeout(function() {
+  f.eraseAll();
+  result = ok && ended && pout==compressed;
+}, 100);
@@ -0,0 +1,49 @@
+// HTTP keep-alive - requests to the same host should reuse one socket from the pool
+
+var result = 0;
+var http = require("http");
+var net = require("net");
+
+var connections = 0;
+var requests = 0;
+var server = net.createServer(function(c) {
+  connections++;
+  var data = "";
+  c.on('data', function(d) {
+    data += d;
+    var idx;
+    while ((idx = data.indexOf("\r\n\r\n"))>=0) {
+      var req = data.substr(0,idx);
+      data = data.substr(idx+4);
+      requests++;
+      var keepAlive = req.indexOf("Connection: keep-alive")>=0;
+      var body = "Request "+requests;
+      c.write("HTTP/1.1 200 OK\r\nContent-Length: "+body.length+"\r\nConnection: "+(keepAlive?"keep-alive":"close")+"\r\n\r\n"+body);
+      if (!keepAlive) c.end();
+    }
+  });
+});
+server.listen(8080);
+
+http.setKeepAlive({ maxSockets : 1, timeout : 1000 });
+
+var bodies = [];
+function get(n) {
+  http.get("http://localhost:8080/"+n, function(res) {
+    var body = "";
+    res.on('data', function(d) { body += d; });
+    res.on('close', function() {
+      bodies.push(body);
+      if (n<3) {
+        get(n+1);
+      } else {
+        server.close();
+        http.setKeepAlive(false); // close the pooled socket
+        console.log(connections, requests, bodies);
+        result = connections==1 && requests==3 &&
+                 bodies.join(",")=="Request 1,Request 2,Request 3";
+      }
+    });
+  });
+}
+get(1);
@@ -0,0 +1,39 @@
+// HTTP keep-alive - the server should handle several requests on one socket, and
+// send responses of unknown length chunked
+
+var result = 0;
+var http = require("http");
+var net = require("net");
+
+http.setKeepAlive({ timeout : 1000 });
+
+var server = http.createServer(function (req, res) {
+  res.writeHead(200, {'Content-Type': 'text/plain'});
+  res.write("Hello ");
+  res.end(req.url);
+});
+server.listen(8080);
+
+var received = "";
+var client = net.connect({port: 8080}, function() {
+  client.write("GET /one HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  client.on('data', function(data) {
+    received += data;
+    if (received.indexOf("0\r\n\r\n")>=0 && received.indexOf("/two")<0) {
+      // first response complete - send another request on the same socket
+      client.write("GET /two HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    }
+  });
+  client.on('close', function() {
+    server.close();
+    http.setKeepAlive(false);
+    console.log(JSON.stringify(received));
+    var responses = received.split("HTTP/1.1 200 OK");
+    result = responses.length==3 &&
+             responses[1].indexOf("Connection: keep-alive")>=0 &&
+             responses[1].indexOf("Transfer-Encoding: chunked")>=0 &&
+             responses[1].indexOf("6\r\nHello \r\n4\r\n/one\r\n0\r\n\r\n")>=0 &&
+             responses[2].indexOf("Connection: close")>=0 &&
+             responses[2].indexOf("Hello /two")>=0;
+  });
+});
@@ -0,0 +1,70 @@
+// HTTP streaming test - large upload and download written with backpressure
+// ('write' returning false, then waiting for 'drain') and received in chunks
+
+var result = 0;
+var http = require("http");
+
+var CHUNK = "0123456789abcdef".repeat(16); // 256 bytes
+var UPLOAD_CHUNKS = 64; // 16kB
+var DOWNLOAD_CHUNKS = 128; // 32kB
+var wroteTrue = false, wroteFalse = false;
+
+// write 'count' chunks to 'stream', waiting for 'drain' whenever write returns false
+function writeChunks(stream, count, callback) {
+  function go() {
+    while (count>0) {
+      count--;
+      if (stream.write(CHUNK)) {
+        wroteTrue = true;
+      } else {
+        wroteFalse = true;
+        return;
+      }
+    }
+    if (callback) callback();
+    callback = undefined;
+  }
+  stream.on('drain', go);
+  go();
+}
+
+var uploadLen = 0, uploadOk = true;
+var server = http.createServer(function (req, res) {
+  req.on('data', function(data) {
+    if (data.length > 1024) uploadOk = false; // should be delivered in pieces
+    uploadLen += data.length;
+  });
+  req.on('end', function() {
+    res.writeHead(200, {'Content-Type': 'text/plain', 'Content-Length': CHUNK.length*DOWNLOAD_CHUNKS});
+    writeChunks(res, DOWNLOAD_CHUNKS, function() {
+      res.end();
+    });
+  });
+});
+server.listen(8080);
+
+var downloadLen = 0, downloadOk = true;
+var req = http.request({
+  host: 'localhost',
+  port: 8080,
+  path: '/stream',
+  method: 'POST',
+  headers: { 'Content-Length': CHUNK.length*UPLOAD_CHUNKS }
+}, function(res) {
+  res.on('data', function(data) {
+    if (data.length > 1024) downloadOk = false;
+    if (data != CHUNK.substr(downloadLen%CHUNK.length, data.length) &&
+        data[0] != CHUNK[downloadLen%CHUNK.length]) downloadOk = false;
+    downloadLen += data.length;
+  });
+  res.on('close', function() {
+    server.close();
+    console.log("up", uploadLen, uploadOk, "down", downloadLen, downloadOk, "write", wroteTrue, wroteFalse);
+    result = uploadOk && downloadOk && wroteTrue && wroteFalse &&
+             uploadLen == CHUNK.length*UPLOAD_CHUNKS &&
+             downloadLen == CHUNK.length*DOWNLOAD_CHUNKS;
+  });
+});
+writeChunks(req, UPLOAD_CHUNKS, function() {
+  req.end();
+});
@@ -0,0 +1,60 @@
+// Check that cached field lookups notice when things change
+
+var r = [];
+function get(o) { return o.foo; }
+function call(o) { return o.toString(); }
+
+// property added to/removed from an object
+var a = {};
+r.push(get(a)===undefined);
+a.foo = 1;
+r.push(get(a)===1);
+a.foo = 2;
+r.push(get(a)===2);
+delete a.foo;
+r.push(get(a)===undefined);
+
+// built-in shadowed on the object, and on the prototype
+function A() {}
+var b = new A();
+r.push(call(b)=="[object Object]");
+A.prototype.toString = function() { return "A"; };
+r.push(call(b)=="A");
+b.toString = function() { return "B"; };
+r.push(call(b)=="B");
+delete b.toString;
+delete A.prototype.toString;
+r.push(call(b)=="[object Object]");
+
+// prototype changed
+var p1 = { foo : "p1" }, p2 = { foo : "p2" };
+var c = Object.create(p1);
+r.push(get(c)=="p1");
+Object.setPrototypeOf(c, p2);
+r.push(get(c)=="p2");
+c.__proto__ = p1;
+r.push(get(c)=="p1");
+
+// objects freed and recreated in the same place
+var ok = true;
+for (var i=0;i<10;i++) {
+  var o = (i&1) ? {foo:i} : [i];
+  if (get(o) !== ((i&1)?i:undefined)) ok = false;
+}
+r.push(ok);
+
+// arrays
+var arr = [1,2,3];
+r.push(call(arr)=="1,2,3");
+arr.toString = function() { return "arr"; };
+r.push(call(arr)=="arr");
+
+// built-in objects, getters and strings
+var s = 0;
+for (var i=0;i<5;i++) s += Math.sin(0) + Math.PI + "abc".charCodeAt(i%3);
+r.push(Math.round(s*100)==Math.round((5*Math.PI+97+98+99+97+98)*100));
+Math.sin = function() { return 42; };
+r.push(Math.sin(0)==42);
+
+result = r.every(x=>x);
+if (!result) print(r);
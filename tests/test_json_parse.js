@@ -0,0 +1,47 @@
+// JSON.parse reads the string directly (not with the lexer)
+var tests=0,testsPass=0;
+function test(a,b) {
+  tests++;
+  if (a===b) testsPass++;
+  else console.log("Test "+tests+" failed - "+a+" !== "+b);
+}
+function fails(json) {
+  try { JSON.parse(json); } catch (e) { return e instanceof SyntaxError; }
+  return false;
+}
+
+test(JSON.parse("42"), 42);
+test(JSON.parse(" -17 "), -17);
+test(JSON.parse("1.5e3"), 1500);
+test(JSON.parse("-0.25"), -0.25);
+test(JSON.parse("12345678901234567890"), 1.2345678901234567e19);
+test(JSON.parse("0x1F"), 31);
+test(JSON.parse("true"), true);
+test(JSON.parse("false"), false);
+test(JSON.parse("null"), null);
+test(JSON.parse('"a\\"b\\\\c\\n\\u0041\\x42\\/"'), 'a"b\\c\nAB/');
+test(JSON.parse("'single'"), "single");
+var long = "";
+for (var i=0;i<200;i++) long += String.fromCharCode(32+(i%90));
+test(JSON.parse(JSON.stringify(long)), long);
+test(JSON.stringify(JSON.parse(' [ 1 , [ ] , { } , [2,[3]], "x" ] ')), '[1,[],{},[2,[3]],"x"]');
+test(JSON.stringify(JSON.parse('{"a":1,"b":{"c":[true,null]},"2":"two"}')), '{"a":1,"b":{"c":[true,null]},"2":"two"}');
+test(JSON.parse('{"5":"five"}')[5], "five");
+test(JSON.parse('[1,2,]').length, 2);
+var a = JSON.parse("[10,20,30]");
+a.push(40);
+test(a.length+","+a[3], "4,40");
+var o = {x:[1,2.5,-3,"four",{five:5}],y:"\x01\xFF\n",z:false};
+test(JSON.stringify(JSON.parse(JSON.stringify(o))), JSON.stringify(o));
+
+test(fails(""), true);
+test(fails("[1,2"), true);
+test(fails("[1 2]"), true);
+test(fails('{"a" 1}'), true);
+test(fails("{a:1}"), true);
+test(fails('"unterminated'), true);
+test(fails("tru"), true);
+test(fails("-"), true);
+test(fails("undefined"), true);
+
+result = tests==testsPass;
@@ -0,0 +1,85 @@
+// Check that parameters and local variables are found properly when they use slots
+
+var r = [];
+var g = "global";
+
+// slots are only used for pretokenised functions - others don't store their locals
+E.setFlags({pretokenise:0});
+var plain = function(a) { var b = a; return b; };
+r.push(plain["\xFFlcl"]===undefined);
+
+E.setFlags({pretokenise:1});
+// functions below are expressions so they are created after the flag is set (declarations are hoisted)
+
+var params = function(a,b,c) { var x = a+b; x += c; return x; };
+r.push(params(1,2,3)==6);
+r.push(params("a","b","c")=="abc");
+
+// recursion - each call has its own slots
+var fib = function(n) { var a = n; if (a<2) return a; return fib(a-1)+fib(a-2); };
+r.push(fib(6)==8);
+
+// closures share the variables
+var counter = function() { var count = 0; return function() { count++; return count; }; };
+var c1 = counter(), c2 = counter();
+c1(); c1();
+r.push(c1()==3 && c2()==1);
+
+// local declared after use/conditionally - should use the global until then
+var late = function(x) {
+  var before = g;
+  if (x) { var g = "local"; }
+  return before+","+g;
+};
+r.push(late(false)=="global,global");
+r.push(late(true)=="global,local");
+r.push(g=="global");
+
+// vars inside nested functions aren't locals of the outer function
+var nested = function() {
+  var f = function() { var g = "inner"; return g; };
+  var h = () => { var g = "arrow"; return g; };
+  return f()+h()+g;
+};
+r.push(nested()=="innerarrowglobal");
+
+// the exception in 'catch' hides a local
+var catcher = function() {
+  var e = "local";
+  var s = e;
+  try { throw "thrown"; } catch (e) { s += e; }
+  return s + e;
+};
+r.push(catcher()=="localthrownlocal");
+
+// lots of locals (more than get slots)
+var many = function(p) {
+  var a1=1,a2=2,a3=3,a4=4,a5=5,a6=6,a7=7,a8=8,a9=9,a10=10,a11=11,a12=12,a13=13,a14=14,a15=15,a16=16,a17=17,a18=18;
+  for (var i=0;i<3;i++) a18 += a1+a17+p;
+  return a18;
+};
+r.push(many(1)==75);
+
+// same code, but functions defined again each time
+var fns = [];
+for (var i=0;i<3;i++) fns.push(function(x) { var y = x*2; return y+i; });
+r.push(fns[0](1)==5 && fns[2](2)==7);
+
+// slots must still be right after variables are moved about
+var moved = function(p) {
+  var junk = [];
+  for (var i=0;i<20;i++) junk.push("x"+i);
+  var a = p;
+  a; // now in a slot
+  junk = undefined;
+  E.defrag(); // 'a' is moved down into the space junk used
+  a = 7;
+  return [a,a];
+};
+r.push(moved(1).join()=="7,7");
+// and after a garbage collect
+var collected = function(o) { var x = o; process.memory(); x.v++; return x.v; };
+r.push(collected({v:1})==2);
+
+result = r.every(x=>x);
+if (!result) print(r);
@@ -0,0 +1,50 @@
+// Lookups on objects with lots of keys (which get a hash index)
+
+var fails = 0;
+var o = {};
+for (var i=0;i<100;i++) o["key"+i] = i;
+var sum = 0;
+for (var i=0;i<100;i++) sum += o["key"+i];
+if (sum!=4950) fails |= 1;
+if (o.key0!==0 || o.key99!==99 || o.key100!==undefined) fails |= 2;
+// adding keys after the index has been made
+o.extra = "x";
+o.five = 5;
+if (o.extra!="x" || o.five!==5) fails |= 4;
+// deleting keys
+delete o.key50;
+delete o.extra;
+if (o.key50!==undefined || o.extra!==undefined || o.key51!==51) fails |= 8;
+o.key50 = "back";
+if (o.key50!="back") fails |= 16;
+// the index itself must not be visible
+var keys = Object.keys(o);
+if (keys.length!=101 || keys[0]!="key0" || keys.indexOf("key50")<0) fails |= 32;
+var n = 0;
+for (var k in o) n++;
+if (n!=101) fails |= 64;
+var j = JSON.parse(JSON.stringify(o));
+if (j.key10!==10 || j.key50!="back" || Object.keys(j).length!=101) fails |= 128;
+// copies of the object must work independently
+var c = Object.assign({}, o);
+c.key10 = "copy";
+if (o.key10!==10 || c.key10!="copy" || c.key99!==99) fails |= 256;
+// removing lots of keys and adding them back
+for (var i=0;i<100;i++) delete o["key"+i];
+if (Object.keys(o).length!=1) fails |= 512;
+for (var i=0;i<200;i++) o["k"+i] = i;
+sum = 0;
+for (var i=0;i<200;i++) sum += o["k"+i];
+if (sum!=19900 || o.key5!==undefined) fails |= 1024;
+// integer keys
+var p = {};
+for (var i=0;i<100;i++) p[i*3] = i;
+if (p[0]!==0 || p[297]!==99 || p["150"]!==50 || p[1]!==undefined) fails |= 8192;
+// globals
+for (var i=0;i<50;i++) global["g"+i] = i;
+if (g0!==0 || g49!==49) fails |= 2048;
+for (var i=0;i<50;i++) delete global["g"+i];
+// defrag rebuilds refs
+E.defrag();
+if (o.k0!==0 || o.k199!==199 || o.k200!==undefined) fails |= 4096;
+result = fails==0;
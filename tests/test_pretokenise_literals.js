@@ -0,0 +1,23 @@
+// Pretokenised functions store literals and block lengths pre-parsed
+E.setFlags({pretokenise:1});
+
+function f(a) {
+  var s = "hello\tworld", n = 1234, big = 123456, h = 0x1F, z = 0;
+  if (a>2) { s += 'big'; } else { s += "small"; }
+  for (var i=0;i<3;i++) { if (i==1) { continue; } n += i; }
+  while (n>0) { n -= 1000; if (n<100) break; }
+  var o = {a:1, b:{c:"x", d:{}}};
+  return s + n + big + h + z + o.b.c;
+}
+
+function g() { var e = ""; if (e) { return {} } return "é"+16383+16384; }
+
+var results = [
+  f(1) == "hello\tworldsmall-764123456310x",
+  f(5) == "hello\tworldbig-764123456310x",
+  f.toString() == 'function (a) {var s="hello\\tworld",n=1234,big=123456,h=0x1F,z=0;if(a>2){s+="big";}else{s+="small";}for(var i=0;i<3;i++){if(i==1){continue;}n+=i;}while(n>0){n-=1000;if(n<100)break;}var o={a:1,b:{c:"x",d:{}}};return s+n+big+h+z+o.b.c;}',
+  g() == "é1638316384",
+  eval("("+g.toString()+")")() == g()
+];
+
+result = results.reduce((a,b)=>a&&b,true);
@@ -0,0 +1,80 @@
+// RegExp features handled by the compiled matcher - quantifiers, alternation
+// inside groups, lazy matching, word boundaries and pathological patterns
+tests=0;
+testPass=0;
+
+function test(a, b) {
+  tests++;
+  if (a==b) {
+    return testPass++;
+  }
+  console.log("Test "+tests+" failed - ",a,"vs",b);
+}
+
+// quantifiers
+test(/colou?r/.exec("my color")[0], "color");
+test(/colou?r/.exec("my colour")[0], "colour");
+test(/a{2}/.exec("aaaa")[0], "aa");
+test(/a{2,3}/.exec("aaaa")[0], "aaa");
+test(/a{2,}/.exec("aaaaa")[0], "aaaaa");
+test(/a{2,3}?/.exec("aaaa")[0], "aa");
+test(/ba{0}c/.test("bc"), true);
+test(/x{/.test("x{"), true); // not a valid quantifier, so literal
+test(/<.*>/.exec("<a><b>")[0], "<a><b>");
+test(/<.*?>/.exec("<a><b>")[0], "<a>");
+test(/a+?/.exec("aaa")[0], "a");
+
+// groups and alternation
+var m = /(a|bc)+d/.exec("xbcabcd");
+test(m[0], "bcabcd");
+test(m[1], "bc");
+test(m.index, 1);
+m = /(a)|(b)/.exec("b");
+test(m.length, 3);
+test(m[1], undefined);
+test(m[2], "b");
+test(/(?:ab)+/.exec("ababx")[0], "abab");
+test(/(?:ab)+(c)/.exec("ababc")[1], "c");
+test(/^(cat|dog)$/.test("dog"), true);
+test(/^(cat|dog)$/.test("doge"), false);
+test(/gr(a|e)y/i.exec("GREY")[1], "E");
+
+// word boundaries
+test(/\bfoo\b/.test("a foo b"), true);
+test(/\bfoo\b/.test("afoob"), false);
+test(/\Boo\B/.test("afoob"), true);
+test(/[\b]/.test("\b"), true);
+
+// string functions with groups that didn't match
+test("x".replace(/(y)?x/, "[$1]"), "[]");
+test("x".replace(/(y)?x/, function(a,b) { return typeof b; }), "undefined");
+test("abc".split(/(?:)/).join(","), "a,b,c");
+test("a1b22c333".match(/\d+/g).join(","), "1,22,333");
+test("abc".match(/x/g), null);
+
+// errors
+var err = "";
+try { new RegExp("a(b").test("ab"); } catch (e) { err = e.toString(); }
+test(err.indexOf("SyntaxError")==0, true);
+err = "";
+try { /a{3,1}/.test("a"); } catch (e) { err = e.toString(); }
+test(err.indexOf("SyntaxError")==0, true);
+
+// no exponential backtracking
+var s = "";
+for (var i=0;i<40;i++) s += "a";
+test(/(a*)*c/.test(s), false);
+test(/(a|aa)+$/.test(s), true);
+
+// empty matches step on, and nothing matches past the end of the string
+test("aaa".replace(/a*?/g,"-"), "-a-a-a-");
+test("a,b".replace(/(?:)/g,"|"), "|a|,|b|");
+test("abc".replace(/x*/g,""), "abc");
+test("".replace(/(?:)/g,"-"), "-");
+test("ab".replace(/b*/g,"-"), "-a--");
+var re = /(?:)/g;
+re.lastIndex = 4;
+test(re.exec("abc"), null);
+
+result = tests==testPass;
+console.log(result?"Pass":"Fail",":",tests,"tests total");
@@ -0,0 +1,12 @@
+// Blocks of received data should be delivered in one go, with their contents intact
+var got = "", callbacks = 0;
+LoopbackB.on('data',function(d) { got += d; callbacks++; });
+var big = "";
+for (var i=0;i<200;i++) big += String.fromCharCode(32+(i*7)%90)+"-"+i+";";
+LoopbackA.write(big);
+LoopbackA.write("x");
+LoopbackA.write(E.toString(new Uint8Array([0,1,2,255])));
+
+setTimeout(function() {
+  result = got == big+"x\0\1\2\xFF" && callbacks==1;
+}, 10);
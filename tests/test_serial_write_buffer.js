@@ -0,0 +1,24 @@
+// Serial.write/print should send strings, arrays and typed arrays in order when done in blocks
+var got = "";
+LoopbackB.on('data',function(d) { got += d; });
+var big = "";
+for (var i=0;i<40;i++) big += "0123456789";
+LoopbackA.write("Hello\nWorld");
+LoopbackA.write([1,2,3], new Uint8Array([4,5]));
+LoopbackA.write({data:"ab", count:2});
+LoopbackA.print(big);
+LoopbackA.println("!");
+
+// Hardware serial goes via the transmit buffer - on Linux we can send to a file
+var fs = require("fs");
+var file = "/tmp/espruino_test_serial_write_buffer.txt";
+fs.writeFileSync(file, "");
+Serial1.setup(9600, {path:file});
+Serial1.write("Hello", [1,2,3]);
+Serial1.print(big+big); // more than fits in the buffer
+Serial1.println("!");
+
+setTimeout(function() {
+  result = got == "Hello\nWorld\x01\x02\x03\x04\x05abab"+big+"!\r\n" &&
+           fs.readFileSync(file) == "Hello\x01\x02\x03"+big+big+"!\r\n";
+}, 200);
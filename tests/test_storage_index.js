@@ -0,0 +1,34 @@
+// Check that the Storage file index stays in sync as files are created, erased and compacted
+
+var s = require("Storage");
+s.eraseAll();
+var ok = true;
+for (var i=0;i<40;i++) s.write("file"+i, "data"+i);
+var st0 = s.getStats();
+for (i=0;i<40;i++) if (s.read("file"+i)!="data"+i) ok = false;
+var st = s.getStats();
+ok = ok && st.indexUsed==40 && st.indexHits-st0.indexHits==40 && st.indexNotFound==st0.indexNotFound;
+// looking for a file that isn't there isn't a hit
+ok = ok && s.read("nofile")===undefined;
+var st2 = s.getStats();
+ok = ok && st2.indexHits==st.indexHits && st2.indexNotFound==st.indexNotFound+1;
+// files with the same first 4 chars of name, overwritten and erased
+for (i=0;i<40;i+=2) s.write("file"+i, "new"+i);
+for (i=0;i<40;i+=4) s.erase("file"+i);
+for (i=0;i<40;i++) {
+  var expected = (i%4==0) ? undefined : ((i%2==0) ? "new"+i : "data"+i);
+  if (s.read("file"+i)!==expected) ok = false;
+}
+ok = ok && s.read("nothere")===undefined;
+s.compact();
+for (i=0;i<40;i++) {
+  var expected = (i%4==0) ? undefined : ((i%2==0) ? "new"+i : "data"+i);
+  if (s.read("file"+i)!==expected) ok = false;
+}
+ok = ok && s.getStats().indexUsed==30 && s.list().length==30;
+// writing to flash directly must not leave the index out of date
+var f = require("Flash");
+f.erasePage(f.getPage(0x10000000).addr);
+ok = ok && s.list().length==0 && s.read("file1")===undefined;
+s.eraseAll();
+result = ok;
@@ -0,0 +1,29 @@
+// Check that Storage reads come straight from (memory-mapped) flash and that writes behave like NOR flash
+
+var s = require("Storage");
+s.eraseAll();
+var data = "";
+for (var i=0;i<300;i++) data += String.fromCharCode(i&255);
+s.write("a", data);
+s.write("b", "Hello World");
+var ok = s.read("a")==data && s.read("b")=="Hello World";
+ok = ok && s.read("a",10,5)==data.substr(10,5);
+// reads are zero-copy, so point right at flash and see later writes
+s.write("c", "\x01", 0, 2);
+var c = s.read("c");
+s.write("c", "\x02", 1);
+ok = ok && c=="\x01\x02";
+// writes can only clear bits, like real NOR flash
+var f = require("Flash");
+var page = f.getPage(0x10000000+256*1024-1);
+f.erasePage(page.addr);
+f.write([0xF0,0xFF,0xFF,0xFF], page.addr);
+f.write([0x3C,0x00,0xFF,0xFF], page.addr);
+ok = ok && f.read(4, page.addr).join()=="48,0,255,255";
+f.erasePage(page.addr);
+ok = ok && f.read(4, page.addr).join()=="255,255,255,255";
+s.erase("a");
+s.compact();
+ok = ok && s.read("a")===undefined && s.read("b")=="Hello World";
+s.eraseAll();
+result = ok;
@@ -0,0 +1,25 @@
+// Test that timers added in any order run in the order they're due
+
+var order = [];
+var delays = [50,10,80,30,70,20,60,40,150,0];
+delays.forEach(function(d) {
+  setTimeout(function() { order.push(d); }, d);
+});
+// clearing a timer from inside another timer
+var cleared = setTimeout(function() { order.push("cleared"); }, 65);
+setTimeout(function() { clearTimeout(cleared); }, 35);
+// changing an interval from another timer
+var ticks = 0;
+var iv = setInterval(function() {
+  ticks++;
+  if (ticks==2) clearInterval(iv);
+}, 1000);
+setTimeout(function() { changeInterval(iv, 15); }, 5);
+// a timeout added from a timeout
+setTimeout(function() {
+  setTimeout(function() { order.push("nested"); }, 1);
+}, 85);
+
+setTimeout(function() {
+  result = order.join(",")=="0,10,20,30,40,50,60,70,80,nested,150" && ticks==2;
+}, 300);
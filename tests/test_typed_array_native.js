@@ -0,0 +1,68 @@
+// Typed array sort/indexOf/includes/fill work directly on the array's memory -
+// check they give the same results as sorting with a compare function
+
+var fails = 0;
+function check(name, a, b) {
+  if (a!=b) {
+    fails++;
+    console.log("Failed", name, a, "!=", b);
+  }
+}
+// reference numeric sort, NaN at the end
+function ref(arr, desc) {
+  var a = [];
+  for (var i=0;i<arr.length;i++) a.push(arr[i]);
+  a.sort(function(x,y) {
+    if (isNaN(x)) return isNaN(y)?0:1;
+    if (isNaN(y)) return -1;
+    return desc ? y-x : x-y;
+  });
+  return a.join(",");
+}
+
+var types = [Uint8Array,Int8Array,Uint8ClampedArray,Uint16Array,Int16Array,Uint32Array,Int32Array,Float32Array,Float64Array];
+var seed = 1;
+function rnd() { seed = (seed*1103515245+12345)&0x7fffffff; return seed/0x7fffffff; }
+
+types.forEach(function(T, t) {
+  [0,1,5,17,40,300].forEach(function(n) {
+    // random, sorted, reversed, lots of duplicates
+    for (var pat=0;pat<4;pat++) {
+      var a = new T(n);
+      for (var i=0;i<n;i++)
+        a[i] = [rnd()*4000-2000, i, n-i, i%3][pat];
+      var name = t+":"+n+":"+pat;
+      check(name, new T(a).sort().join(","), ref(a,false));
+      check(name+" a-b", new T(a).sort((x,y)=>x-y).join(","), ref(a,false));
+      check(name+" b-a", new T(a).sort((x,y)=>y-x).join(","), ref(a,true));
+    }
+  });
+  var b = new T(100);
+  b.fill(7,10,20);
+  check(t+" fill", b[9]==0 && b[10]==7 && b[19]==7 && b[20]==0, true);
+  b[50] = 3;
+  check(t+" indexOf", b.indexOf(3), 50);
+  check(t+" indexOf start", b.indexOf(3,51), -1);
+  check(t+" indexOf negative start", b.indexOf(7,-95), 10);
+  check(t+" indexOf fraction", b.indexOf(1.5), -1);
+  check(t+" indexOf string", b.indexOf("3"), -1);
+  check(t+" includes", b.includes(7), true);
+});
+
+var f = new Float64Array([3,NaN,1,2,NaN,0,5,6,7,8,9,10,11,12,13,14,15,16,17,18]);
+check("NaN sort", f.sort().join(","), "0,1,2,3,5,6,7,8,9,10,11,12,13,14,15,16,17,18,NaN,NaN");
+f = new Float32Array([1,NaN,2]);
+check("NaN indexOf", f.indexOf(NaN), -1);
+check("NaN includes", f.includes(NaN), true);
+check("Int8 indexOf", new Int8Array([5,-1,3]).indexOf(-1), 1);
+check("Uint8 indexOf out of range", new Uint8Array([255]).indexOf(-1), -1);
+check("Float32 fill", new Float32Array(5).fill(1.5,1).join(","), "0,1.5,1.5,1.5,1.5");
+check("clamped fill", new Uint8ClampedArray(3).fill(300).join(","), "255,255,255");
+check("unaligned", new Int16Array(new ArrayBuffer(101),1,50).fill(-3).sort().indexOf(-3), 0);
+
+var big = new Int16Array(4096);
+for (var i=0;i<4096;i++) big[i] = (i*7919)%4096-2048;
+big.sort();
+check("big", big[0]==-2048 && big[1]==-2047 && big[4095]==2047, true);
+
+result = fails==0;